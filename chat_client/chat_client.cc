@@ -308,6 +308,7 @@ namespace chatclient {
     user_id_.clear();
     current_chat_room_.clear();
     current_client_status_ = kBeforeLogin;
+    http_requester_->ClearResponseCache();
   }
 
 } // namespace chatclient
\ No newline at end of file
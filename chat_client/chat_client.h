@@ -83,7 +83,7 @@ namespace chatclient {
     // Check whether the given chat room exists in the chat server.
     bool IsExistingChatRoom(utility::string_t chat_room) const;
 
-    // Clear user information.
+    // Clear user information, and the responses cached for the session.
     void ClearUserInformation();
 
     // Chat message input, chat message display, and
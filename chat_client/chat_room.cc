@@ -36,6 +36,8 @@ namespace chatclient {
                        current_chat_room_(current_chat_room) {
     http_requester_ = make_unique<HttpRequester>(
         web::http::uri_builder(chat_server_url).to_uri().to_string());
+    // Polled chat message lists are smaller in the CBOR columnar layout.
+    http_requester_->SetCborEncoding(true);
     chat_room_view_ = make_unique<ChatRoomView>();
   }
 
@@ -117,28 +119,27 @@ namespace chatclient {
   
   size_t ChatRoom::ComputeNewChatMessageSize(
     const vector<ChatMessage>& chat_messages) {
-    if (display_chat_message_.size() == 0) {
-      if (chat_messages.size() >= kMaxDisplayChatMessages) {
-        return kMaxDisplayChatMessages;
-      } else {
-        return chat_messages.size();
-      }
-    }
-
-    // Calculate new chat messages from the server.
+    // Ids increase in a chat room, so the new chat messages are the ones at
+    // the end with an id after the last displayed one. Repeated texts are
+    // told apart by their ids.
+    const ChatMessage* const last_displayed_chat_message =
+        display_chat_message_.empty() ? nullptr : &display_chat_message_.back();
     size_t new_chat_message_size = 0;
-    const ChatMessage last_displayed_chat_message =
-        display_chat_message_.back();
-    for (size_t i = chat_messages.size() - 1; i >= 0; i--) {
-      const ChatMessage chat_message = chat_messages.at(i);
-      if (chat_message != last_displayed_chat_message) {
-        new_chat_message_size++;
-        if (new_chat_message_size >= kMaxDisplayChatMessages) {
+    while (new_chat_message_size < chat_messages.size() &&
+           new_chat_message_size <
+               static_cast<size_t>(kMaxDisplayChatMessages)) {
+      const ChatMessage& chat_message =
+          chat_messages[chat_messages.size() - 1 - new_chat_message_size];
+      if (last_displayed_chat_message != nullptr) {
+        // Older servers send no ids, so the chat messages are compared.
+        const bool is_displayed = last_displayed_chat_message->id == 0
+            ? chat_message == *last_displayed_chat_message
+            : chat_message.id <= last_displayed_chat_message->id;
+        if (is_displayed) {
           break;
         }
-      } else {
-        break;
       }
+      new_chat_message_size++;
     }
     return new_chat_message_size;
   }
@@ -150,21 +151,18 @@ namespace chatclient {
     http_request_url.clear();
     http_request_url << "chatmessage" << UU("?session_id=") << session_id_
                      << UU("&chat_room=") << current_chat_room_;
+    // Only the chat messages after the last displayed one are sent.
+    if (!display_chat_message_.empty() &&
+        display_chat_message_.back().id != 0) {
+      http_request_url << UU("&since_id=") << display_chat_message_.back().id;
+    }
 
     // Make HTTP request to get chat messages.
     const http_response response =
         http_requester_->MakeHttpRequestForResponse(methods::GET,
                                                     http_request_url.str());
     if (response.status_code() == status_codes::OK) {
-      ::array chat_list = response.extract_json().get().as_array();
-      for (auto& i : chat_list) {
-        chat_messages.emplace_back(
-            i[UU("date")].as_number().to_uint64(),
-            i[UU("user_id")].as_string(),
-            i[UU("room")].as_string(),
-            i[UU("message")].as_string());
-      }
-      return true;
+      return http_requester_->ExtractChatMessages(response, &chat_messages);
     }
     return false;
   }
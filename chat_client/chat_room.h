@@ -55,13 +55,15 @@ namespace chatclient {
     
     // It returns the number of new chat messages to be displayed to the console
     // screen. Calculate the number of chat messages to be newly displayed by
-    // comparing the chat messages received from the server with the currently
-    // displayed chat message.
+    // comparing the ids of the chat messages received from the server with
+    // the id of the last displayed chat message, or the chat messages
+    // themselves if the server sends no ids.
     size_t ComputeNewChatMessageSize(
         const std::vector<chatserver::ChatMessage>& chat_messages);
 
     // Get chat messages from the server using HTTP request. Store the chat
-    // messages to the given vector.
+    // messages to the given vector. Once chat messages are displayed, only
+    // the ones after the last displayed id are requested.
     bool GetChatMessagesFromServer(
         std::vector<chatserver::ChatMessage>& chat_messages) const;
 
@@ -8,11 +8,17 @@
 
 using namespace std;
 using ::chatserver::ChatMessage;
+using ::chatserver::InstrumentedMutex;
+using ::chatserver::ToStringT;
 using ::utility::string_t;
 using ::utility::ostringstream_t;
 
 namespace chatclient {
 
+  ChatRoomView::ChatRoomView()
+      : mutex_console_("ChatRoomView::mutex_console_") {
+  }
+
   string_t ChatRoomView::GetUserInput(const string_t output_message) const {
     string_t user_input;
     ucout << output_message;
@@ -21,14 +27,14 @@ namespace chatclient {
   }
 
   void ChatRoomView::DisplayMessage(string_t display_message) {
-    const lock_guard<mutex> lock(mutex_console_);
+    const lock_guard<InstrumentedMutex> lock(mutex_console_);
     ucout << display_message << endl;
   }
 
   void ChatRoomView::DisplayChatMessages(const list<ChatMessage>& chat_message,
                                          string_t current_chat_room_,
                                          int max_display_chat_message) {
-    const lock_guard<mutex> lock(mutex_console_);
+    const lock_guard<InstrumentedMutex> lock(mutex_console_);
 
     // Save current cursor position.
     HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -68,15 +74,15 @@ namespace chatclient {
       localtime_s(&time, &message.date);
       char buffer[32];
       strftime(buffer, 32, "%Y-%m-%d %H:%M:%S", &time);
-      ucout << "[" << buffer << "] <" << message.user_id
-            << "> " << message.chat_message << endl;
+      ucout << "[" << buffer << "] <" << ToStringT(message.user_id)
+            << "> " << ToStringT(message.chat_message) << endl;
     }
     // Restore start cursor position.
     SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), current_cursor_position);
   }
 
   void ChatRoomView::ClearConsole() {
-    const lock_guard<mutex> lock(mutex_console_);
+    const lock_guard<InstrumentedMutex> lock(mutex_console_);
     const HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
     CONSOLE_SCREEN_BUFFER_INFO console_screen_buffer_info;
     GetConsoleScreenBufferInfo(console, &console_screen_buffer_info);
@@ -92,7 +98,7 @@ namespace chatclient {
   }
 
   void ChatRoomView::ClearConsole(const short start_y, const short end_y) {
-    const lock_guard<mutex> lock(mutex_console_);
+    const lock_guard<InstrumentedMutex> lock(mutex_console_);
     const HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
     CONSOLE_SCREEN_BUFFER_INFO console_screen_buffer_info;
     GetConsoleScreenBufferInfo(console, &console_screen_buffer_info);
@@ -114,7 +120,7 @@ namespace chatclient {
   }
 
   void ChatRoomView::SetCursorPosition(const short x, const short y) {
-    const lock_guard<mutex> lock(mutex_console_);
+    const lock_guard<InstrumentedMutex> lock(mutex_console_);
     COORD current_position;
     current_position.X = x;
     current_position.Y = y;
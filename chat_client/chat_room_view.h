@@ -6,11 +6,11 @@
 #define CHATCLIENT_CHATROOMVIEW_H_
 
 #include <list>
-#include <mutex>
 #include <windows.h>
 
 #include "chat_message.h"
 #include "cpprest/details/basic_types.h"
+#include "instrumented_mutex.h"
 
 // Process every console display and input of ChatRoom.
 // Please use this class to display a message and get user input of ChatRoom.
@@ -26,6 +26,9 @@ namespace chatclient {
 
   class ChatRoomView {
    public:
+    // Name mutex_console_ for lock profiling.
+    ChatRoomView();
+
     // Get user console input while displaying the display_message.
     utility::string_t GetUserInput(utility::string_t display_message) const;
 
@@ -55,7 +58,7 @@ namespace chatclient {
     // Mutex for control the console screen.
     // Used: ClearConsole, SetCursorPosition, DisplayChatMessages,
     //       DisplayMessage
-    std::mutex mutex_console_;
+    chatserver::InstrumentedMutex mutex_console_;
   };
 
 } // namespace chatclient
@@ -4,15 +4,23 @@
 
 #include "http_requester.h"
 
+#include <algorithm>
+
+#include "cbor_codec.h"
 #include "chat_room.h"
 
 using namespace std;
 using ::web::uri;
 using ::web::http::methods;
+using ::web::http::header_names;
+using ::web::http::http_request;
 using ::web::http::http_response;
 using ::web::http::status_codes;
 using ::web::http::status_code;
 using ::web::json::value;
+using ::chatserver::CborCodec;
+using ::chatserver::ChatMessage;
+using ::chatserver::ToChatString;
 using ::utility::string_t;
 using ::utility::conversions::to_string_t;
 
@@ -26,10 +34,16 @@ namespace chatclient {
 
   HttpRequester::HttpRequester(const string_t chat_server_url)
       : chat_server_url_(chat_server_url),
+        use_cbor_(false),
+        cache_clock_(0),
         rand_(std::random_device{}()),
         session_generator_(0, kNonceValue.size() - 1) {
+    // Advertise gzip and deflate, and let cpprestsdk decode the response.
+    web::http::client::http_client_config config;
+    config.set_request_compressed_response(
+        web::http::compression::builtin::supported());
     http_client_ = make_unique<web::http::client::http_client>(
-        web::http::uri_builder(chat_server_url).to_uri());
+        web::http::uri_builder(chat_server_url).to_uri(), config);
   }
 
   status_code HttpRequester::MakeHttpRequest(string_t http_method,
@@ -47,8 +61,7 @@ namespace chatclient {
                                              string_t query_url,
                                              const value& body_data) const {
     const http_response response =
-        http_client_->request(http_method,
-            uri::encode_uri(query_url), body_data).get();
+        SendRequestWithBody(http_method, query_url, body_data);
     if (response.status_code() != status_codes::OK) {
       ProcessHttpResponseFailure(response);
     }
@@ -58,6 +71,10 @@ namespace chatclient {
   http_response HttpRequester::MakeHttpRequestForResponse(
       string_t http_method,
       string_t query_url) const {
+    if (http_method == methods::GET) {
+      return MakeConditionalGetRequest(query_url);
+    }
+
     const http_response response = 
         http_client_->request(http_method, 
                               uri::encode_uri(query_url)).get();
@@ -71,10 +88,8 @@ namespace chatclient {
       string_t http_method,
       string_t query_url,
       const value& body_data) const {
-    const http_response response = http_client_->request(
-        http_method,
-        uri::encode_uri(query_url), 
-        body_data).get();
+    const http_response response =
+        SendRequestWithBody(http_method, query_url, body_data);
 
     if (response.status_code() != status_codes::OK) {
       ProcessHttpResponseFailure(response);
@@ -82,6 +97,119 @@ namespace chatclient {
     return response;
   }
 
+  http_response HttpRequester::MakeConditionalGetRequest(
+      const string_t& query_url) const {
+    http_request request(methods::GET);
+    request.set_request_uri(uri::encode_uri(query_url));
+    if (use_cbor_) {
+      request.headers().add(header_names::accept, CborCodec::kMediaType);
+    }
+    const auto cached_response = response_cache_.find(query_url);
+    if (cached_response != response_cache_.end()) {
+      request.headers().add(header_names::if_none_match,
+                            cached_response->second.entity_tag);
+    }
+
+    const http_response response = http_client_->request(request).get();
+    if (response.status_code() == status_codes::NotModified &&
+        cached_response != response_cache_.end()) {
+      // Nothing changed. Only headers were exchanged.
+      cached_response->second.last_used = ++cache_clock_;
+      http_response cached(status_codes::OK);
+      cached.set_body(cached_response->second.body);
+      cached.headers().set_content_type(cached_response->second.content_type);
+      cached.headers().add(header_names::etag,
+                           cached_response->second.entity_tag);
+      return cached;
+    }
+    if (response.status_code() != status_codes::OK) {
+      ProcessHttpResponseFailure(response);
+      return response;
+    }
+
+    string_t entity_tag;
+    if (!response.headers().match(header_names::etag, entity_tag)) {
+      return response;
+    }
+
+    if (cached_response == response_cache_.end() &&
+        response_cache_.size() >= kMaxCachedResponses) {
+      response_cache_.erase(min_element(
+          response_cache_.begin(), response_cache_.end(),
+          [](const auto& left, const auto& right) {
+        return left.second.last_used < right.second.last_used;
+      }));
+    }
+
+    // The body can be read only once, so return a copy of the cached body.
+    CachedResponse& new_cached_response = response_cache_[query_url];
+    new_cached_response.last_used = ++cache_clock_;
+    new_cached_response.entity_tag = entity_tag;
+    new_cached_response.content_type = response.headers().content_type();
+    new_cached_response.body = response.extract_vector().get();
+    http_response cached(status_codes::OK);
+    cached.set_body(new_cached_response.body);
+    cached.headers().set_content_type(new_cached_response.content_type);
+    cached.headers().add(header_names::etag, entity_tag);
+    return cached;
+  }
+
+  http_response HttpRequester::SendRequestWithBody(
+      const string_t& http_method,
+      const string_t& query_url,
+      const value& body_data) const {
+    if (!use_cbor_) {
+      return http_client_->request(http_method,
+                                   uri::encode_uri(query_url),
+                                   body_data).get();
+    }
+
+    http_request request(http_method);
+    request.set_request_uri(uri::encode_uri(query_url));
+    request.set_body(CborCodec::EncodeJson(body_data));
+    request.headers().set_content_type(CborCodec::kMediaType);
+    request.headers().add(header_names::accept, CborCodec::kMediaType);
+    return http_client_->request(request).get();
+  }
+
+  void HttpRequester::ClearResponseCache() {
+    response_cache_.clear();
+  }
+
+  void HttpRequester::SetCborEncoding(bool use_cbor) {
+    use_cbor_ = use_cbor;
+  }
+
+  bool HttpRequester::ExtractChatMessages(
+      const http_response& response,
+      vector<ChatMessage>* out_chat_messages) const {
+    if (CborCodec::IsCborMediaType(response.headers().content_type())) {
+      return CborCodec::DecodeChatMessages(response.extract_vector().get(),
+                                           out_chat_messages);
+    }
+
+    const value body_data = response.extract_json().get();
+    if (!body_data.is_array()) {
+      return false;
+    }
+    for (const value& chat_message : body_data.as_array()) {
+      out_chat_messages->emplace_back(
+          chat_message.at(UU("date")).as_number().to_int64(),
+          ToChatString(chat_message.at(UU("user_id")).as_string()),
+          ToChatString(chat_message.at(UU("room")).as_string()),
+          ToChatString(chat_message.at(UU("message")).as_string()));
+      // Older servers send neither, so the ids stay 0.
+      if (chat_message.has_number_field(UU("timestamp")) &&
+          chat_message.has_number_field(UU("id"))) {
+        out_chat_messages->back().timestamp =
+            chat_message.at(UU("timestamp")).as_number().to_int64();
+        out_chat_messages->back().id =
+            chat_message.at(UU("id")).as_number().to_uint64();
+      }
+    }
+    return true;
+  }
+
   string_t HttpRequester::HashString(string_t string) const {
     return to_string_t(to_string(hash<string_t>{}(string)));
   }
@@ -5,14 +5,26 @@
 #ifndef CHATCLIENT_HTTPREQUESTER_H_
 #define CHATCLIENT_HTTPREQUESTER_H_
 
+#include <map>
 #include <random>
+#include <vector>
 
 #include "cpprest/http_client.h"
+#include "chat_message.h"
 
 // This class is a utility class designed to make HTTP requests to
 // a given chat server.
 // It internally calls http_client of cpprest library to
 // generate and send HTTP requests.
+// GET responses with an entity tag are cached by query URL. The next GET
+// request for the same URL sends If-None-Match, and a 304 Not Modified
+// response is returned as 200 OK with the cached body. At most
+// kMaxCachedResponses are kept, and the least recently used one is dropped
+// for a new one.
+// Responses are requested with gzip or deflate content coding and decoded
+// transparently.
+// With SetCborEncoding(true), body data is sent as CBOR and CBOR responses are
+// requested. Use ExtractChatMessages to read chat messages in either format.
 // The class is NOT thread-safe.
 // Example:
 //   HttpRequester http_requester(chat_server_url);
@@ -21,7 +33,11 @@
 namespace chatclient {
 
   class HttpRequester {
+    friend class ChatClientTest;
    public:
+    // Most GET responses kept for revalidation.
+    static const size_t kMaxCachedResponses = 64;
+
     HttpRequester(utility::string_t chat_server_url);
 
     // Make an HTTP request to the chat server using given parameters. This
@@ -44,6 +60,7 @@ namespace chatclient {
     // Make an HTTP request to the chat server using given parameters. This
     // function process failure of HTTP request by calling
     // ProcessHttpResponseFailure. This function returns http_response.
+    // A GET request is revalidated with the cached response if any.
     web::http::http_response MakeHttpRequestForResponse(
         utility::string_t http_method,
         utility::string_t query_url) const;
@@ -57,6 +74,21 @@ namespace chatclient {
         utility::string_t query_url,
         const web::json::value& body_data) const;
 
+    // Drop every cached GET response. Their query URLs have the session ID,
+    // so they are of no use after logout.
+    void ClearResponseCache();
+
+    // Send body data as CBOR and accept CBOR responses if use_cbor is true.
+    // JSON is used by default.
+    void SetCborEncoding(bool use_cbor);
+
+    // Read the chat messages in the body of the given response, which is a
+    // JSON array or the CBOR columnar layout. Append them to
+    // out_chat_messages. Return false if the body data is malformed.
+    bool ExtractChatMessages(
+        const web::http::http_response& response,
+        std::vector<chatserver::ChatMessage>* out_chat_messages) const;
+
     // Hash string.
     utility::string_t HashString(utility::string_t string) const;
 
@@ -64,6 +96,27 @@ namespace chatclient {
     utility::string_t GenerateNonce();
 
    private:
+    // GET response kept for revalidation.
+    struct CachedResponse {
+      utility::string_t entity_tag;
+      utility::string_t content_type;
+      std::vector<unsigned char> body;
+      // Value of cache_clock_ when the response was last used.
+      uint64_t last_used = 0;
+    };
+
+    // Make an HTTP request with the given body data in the current encoding.
+    web::http::http_response SendRequestWithBody(
+        const utility::string_t& http_method,
+        const utility::string_t& query_url,
+        const web::json::value& body_data) const;
+
+    // Make a GET request with If-None-Match of the cached response for the
+    // given query URL. Update the cache with a new response, and drop the
+    // least recently used one if the cache is full.
+    web::http::http_response MakeConditionalGetRequest(
+        const utility::string_t& query_url) const;
+
     // This function print error message when an HTTP request fails
     void ProcessHttpResponseFailure(
         const web::http::http_response& response) const;
@@ -74,6 +127,15 @@ namespace chatclient {
     // Chat server URL
     utility::string_t chat_server_url_;
 
+    // Whether body data is sent and requested as CBOR.
+    bool use_cbor_;
+
+    // Cached GET responses: std::map<query URL, response>.
+    mutable std::map<utility::string_t, CachedResponse> response_cache_;
+
+    // Number of uses of response_cache_, for last_used.
+    mutable uint64_t cache_clock_;
+
     // Internal members to generate randomized identifiers.
     std::mt19937 rand_;
     std::uniform_int_distribution<> session_generator_;
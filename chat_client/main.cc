@@ -3,6 +3,7 @@
 // (https://google.github.io/styleguide/cppguide.html)
 
 #include "chat_client.h"
+#include "instrumented_mutex.h"
 
 using namespace chatclient;
 using namespace std;
@@ -22,5 +23,8 @@ int main(int argc, char* argv[]) {
 
   ChatClient chat_client(chat_server_address);
   chat_client.RunChatClient();
+#if defined(CHATSERVER_ENABLE_LOCK_PROFILING)
+  chatserver::LockProfiler::Dump();
+#endif
 	return 0;
 }
\ No newline at end of file
@@ -112,6 +112,20 @@ namespace chatclient {
       return chat_client_->current_client_status_;
     }
 
+    // Number of GET responses cached by the given HTTP requester.
+    size_t GetCachedResponseCount(const HttpRequester& http_requester) const {
+      return http_requester.response_cache_.size();
+    }
+
+    // Replace the cached body of the given query URL, so a reply made from
+    // the cache can be told from one sent by the chat server.
+    void SetCachedResponseBody(HttpRequester* http_requester,
+                               const utility::string_t& query_url,
+                               const std::string& body) const {
+      http_requester->response_cache_.at(query_url).body.assign(body.begin(),
+                                                                body.end());
+    }
+
     // Runs chat client for getting C++ standard output of chat client.
     // Make return value by intercepting C++ standard output of chat client.
     utility::string_t GetStandardOutputFromChatClient(
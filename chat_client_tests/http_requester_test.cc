@@ -0,0 +1,111 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "http_requester.h"
+
+#include <string>
+
+#include "chat_client_test_fixture.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatclient;
+using ::web::http::header_names;
+using ::web::http::http_response;
+using ::web::http::methods;
+using ::web::http::status_codes;
+using ::web::json::value;
+
+namespace {
+
+  // Log in as kaist and return the session ID.
+  string_t Login(HttpRequester* http_requester) {
+    const string_t nonce = http_requester->GenerateNonce();
+    value body_data;
+    body_data[UU("id")] = value::string(UU("kaist"));
+    body_data[UU("nonce")] = value::string(nonce);
+    body_data[UU("password")] = value::string(http_requester->HashString(
+        http_requester->HashString(UU("12345678")) + nonce));
+    const http_response response = http_requester->MakeHttpRequestForResponse(
+        methods::POST, UU("login"), body_data);
+    return response.extract_json().get().at(UU("session_id")).as_string();
+  }
+
+  // Get the entity tag of the given response, or an empty string.
+  string_t GetEntityTag(const http_response& response) {
+    string_t entity_tag;
+    response.headers().match(header_names::etag, entity_tag);
+    return entity_tag;
+  }
+
+} // namespace
+
+TEST_F(ChatClientTest, MakeHttpRequestForResponse_Success_NotModified) {
+  HttpRequester http_requester(server_address);
+  const string_t query_url =
+      UU("chatroom?session_id=") + Login(&http_requester);
+  http_response response =
+      http_requester.MakeHttpRequestForResponse(methods::GET, query_url);
+  EXPECT_EQ(status_codes::OK, response.status_code());
+  const string_t entity_tag = GetEntityTag(response);
+  EXPECT_NE(UU(""), entity_tag);
+  EXPECT_EQ(1, GetCachedResponseCount(http_requester));
+
+  // The request sends If-None-Match, and the 304 Not Modified reply is
+  // returned as 200 OK with the cached body.
+  SetCachedResponseBody(&http_requester, query_url, "[\"cached\"]");
+  response = http_requester.MakeHttpRequestForResponse(methods::GET, query_url);
+  EXPECT_EQ(status_codes::OK, response.status_code());
+  EXPECT_EQ("[\"cached\"]", response.extract_utf8string().get());
+  EXPECT_EQ(entity_tag, GetEntityTag(response));
+}
+
+TEST_F(ChatClientTest, MakeHttpRequestForResponse_Success_NewEntityTag) {
+  HttpRequester http_requester(server_address);
+  const string_t session_id = Login(&http_requester);
+  const string_t query_url = UU("chatroom?session_id=") + session_id;
+  http_response response =
+      http_requester.MakeHttpRequestForResponse(methods::GET, query_url);
+  const string_t entity_tag = GetEntityTag(response);
+
+  // A new chat room changes the list, so the chat server sends it with a
+  // new entity tag.
+  value body_data;
+  body_data[UU("chat_room")] = value::string(UU("new_room"));
+  body_data[UU("session_id")] = value::string(session_id);
+  EXPECT_EQ(status_codes::OK, http_requester.MakeHttpRequest(
+                                  methods::POST, UU("chatroom"), body_data));
+  response = http_requester.MakeHttpRequestForResponse(methods::GET, query_url);
+  EXPECT_EQ(status_codes::OK, response.status_code());
+  const string_t new_entity_tag = GetEntityTag(response);
+  EXPECT_NE(entity_tag, new_entity_tag);
+  EXPECT_NE(string::npos,
+            response.extract_utf8string().get().find("new_room"));
+
+  // The new response replaces the cached one, and is revalidated next.
+  EXPECT_EQ(1, GetCachedResponseCount(http_requester));
+  SetCachedResponseBody(&http_requester, query_url, "[\"cached\"]");
+  response = http_requester.MakeHttpRequestForResponse(methods::GET, query_url);
+  EXPECT_EQ("[\"cached\"]", response.extract_utf8string().get());
+  EXPECT_EQ(new_entity_tag, GetEntityTag(response));
+}
+
+TEST_F(ChatClientTest, ClearResponseCache_Success) {
+  HttpRequester http_requester(server_address);
+  const string_t query_url =
+      UU("chatroom?session_id=") + Login(&http_requester);
+
+  // The cache keeps the latest kMaxCachedResponses query URLs.
+  const size_t max_cached_responses = HttpRequester::kMaxCachedResponses;
+  for (size_t i = 0; i <= max_cached_responses; ++i) {
+    http_requester.MakeHttpRequestForResponse(
+        methods::GET,
+        query_url + UU("&n=") + conversions::to_string_t(to_string(i)));
+  }
+  EXPECT_EQ(max_cached_responses, GetCachedResponseCount(http_requester));
+
+  http_requester.ClearResponseCache();
+  EXPECT_EQ(0, GetCachedResponseCount(http_requester));
+}
@@ -6,19 +6,19 @@
 
 #include "spdlog/spdlog.h"
 #include "chat_database.h"
+#include "delimiter_scanner.h"
 
 using namespace std;
 using ::utility::string_t;
-using ::utility::conversions::to_string_t;
 using ::utility::conversions::to_utf8string;
 using ::spdlog::error;
 
 namespace chatserver {
 
   // Delimiter between id and password in a file database.
-  string_t kParsingDelimeterAccount = UU(",");
+  ChatString kParsingDelimeterAccount = CHATSERVER_TEXT(",");
   // Delimiter in the chat message file database.
-  string_t kParsingDelimeterChatDb = UU("|");
+  ChatString kParsingDelimeterChatDb = CHATSERVER_TEXT("|");
 
   bool AccountDatabase::Initialize(string_t account_file) {
     account_file_ = account_file;
@@ -29,9 +29,9 @@ namespace chatserver {
     return true;
   }
 
-  AccountDatabase::AuthResult AccountDatabase::Login(string_t id, 
-                                                      string_t password,
-                                                      string_t nonce) {
+  AccountDatabase::AuthResult AccountDatabase::Login(ChatString id, 
+                                                      ChatString password,
+                                                      ChatString nonce) {
     if (!IsExistAccount(id)) {
       return kIDNotExist;
     } else if (HashString(accounts_[id] + nonce) == password) {
@@ -41,12 +41,13 @@ namespace chatserver {
     }
   }
 
-  AccountDatabase::AuthResult AccountDatabase::SignUp(string_t id,
-                                                        string_t password) {
-    if (id.find(kParsingDelimeterAccount) != string_t::npos ||
-        id.find(kParsingDelimeterChatDb) != string_t::npos) {
+  AccountDatabase::AuthResult AccountDatabase::SignUp(ChatString id,
+                                                        ChatString password) {
+    if (DelimiterScanner::ContainsEither(id, kParsingDelimeterAccount[0],
+                                         kParsingDelimeterChatDb[0])) {
       return kProhibitedCharInID;
-    } else if (password.find(kParsingDelimeterAccount) != string_t::npos) {
+    } else if (DelimiterScanner::Contains(password,
+                                          kParsingDelimeterAccount[0])) {
       return kProhibitedCharInPassword;
     } else if (IsExistAccount(id)) {
       return kDuplicateID;
@@ -58,7 +59,7 @@ namespace chatserver {
   }
 
   bool AccountDatabase::ReadAccountFile(string_t account_file) {
-    wifstream file(account_file);
+    ChatInputFileStream file(account_file);
     if (!file.is_open()) {
       error("Can't open account file: {}", to_utf8string(account_file));
       return false;
@@ -73,8 +74,8 @@ namespace chatserver {
     return true;
   }
 
-  bool AccountDatabase::ParseAccountFile(wifstream file) {
-    string_t line;
+  bool AccountDatabase::ParseAccountFile(ChatInputFileStream file) {
+    ChatString line;
     while (file.good()) {
       getline(file, line);
       if (line.length() == 0) continue;
@@ -82,8 +83,8 @@ namespace chatserver {
 
       if (index == 0 ||
           index == line.length() - 1 ||
-          index == string_t::npos ||
-          line.find(kParsingDelimeterAccount, index + 1) != string_t::npos) {
+          index == ChatString::npos ||
+          line.find(kParsingDelimeterAccount, index + 1) != ChatString::npos) {
         error("Account file parsing error");
         accounts_.clear();
         return false;
@@ -96,10 +97,12 @@ namespace chatserver {
     return true;
   }
 
-  bool AccountDatabase::StoreAccountInformation(string_t id,
-                                                string_t password) {
+  bool AccountDatabase::StoreAccountInformation(ChatString id,
+                                                ChatString password) {
     // If the file exists, work with it, if no, create it
-    wofstream file(account_file_, wofstream::out | wofstream::app);
+    ChatOutputFileStream file(account_file_,
+                              ChatOutputFileStream::out |
+                              ChatOutputFileStream::app);
     if (file.is_open()) {
       file << id << kParsingDelimeterAccount << password << endl;
       file.close();
@@ -111,7 +114,7 @@ namespace chatserver {
     return true;
   }
 
-  bool AccountDatabase::IsExistAccount(string_t id) const {
+  bool AccountDatabase::IsExistAccount(ChatString id) const {
     if (accounts_.find(id) == accounts_.end()) {
       return false;
     } else {
@@ -119,7 +122,7 @@ namespace chatserver {
     }
   }
 
-  string_t AccountDatabase::HashString(string_t string) const {
-    return to_string_t(to_string(hash<string_t>{}(string)));
+  ChatString AccountDatabase::HashString(const ChatString& string) const {
+    return FromUtf8(to_string(hash<string_t>{}(ToStringT(string))));
   }
 } // namespace chatserver
@@ -9,6 +9,7 @@
 #include <string>
 
 #include "cpprest/json.h"
+#include "chat_string.h"
 
 // This class is designed to manage pairs of chat ID and password accounts.
 // It uses a file database that holds IDs and passwords.
@@ -46,33 +47,30 @@ namespace chatserver {
     bool Initialize(utility::string_t account_file);
 
     // Check if there is a given ID and password in the database.
-    AuthResult Login(utility::string_t id,
-                      utility::string_t password,
-                      utility::string_t nonce);
+    AuthResult Login(ChatString id, ChatString password, ChatString nonce);
 
     // Create a chat account on the database 
-    AuthResult SignUp(utility::string_t id,
-                        utility::string_t password);
+    AuthResult SignUp(ChatString id, ChatString password);
 
    private:
     // Read the given database file
     bool ReadAccountFile(utility::string_t account_file);
 
     // Parse file database. Parsing format: id, hash(pwd).
-    bool ParseAccountFile(std::wifstream account_file);
+    bool ParseAccountFile(ChatInputFileStream account_file);
 
     // Save account information to account database and file.
-    bool StoreAccountInformation(utility::string_t id,
-                                 utility::string_t password);
+    bool StoreAccountInformation(ChatString id, ChatString password);
 
     // Check given ID exists on database.
-    bool IsExistAccount(utility::string_t id) const;
+    bool IsExistAccount(ChatString id) const;
 
-    // Hash string.
-    utility::string_t HashString(utility::string_t string) const;
+    // Hash string. The hash is of the utility::string_t of the string in
+    // every build mode, so the nonce hash of the client matches.
+    ChatString HashString(const ChatString& string) const;
 
     // Account database: std::map<ID, pwd>
-    std::map<utility::string_t, utility::string_t> accounts_;
+    std::map<ChatString, ChatString> accounts_;
 
     // File database name.
     utility::string_t account_file_;
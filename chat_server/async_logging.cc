@@ -0,0 +1,64 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "async_logging.h"
+
+#include <memory>
+
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "spdlog/spdlog.h"
+
+using namespace std;
+using ::spdlog::async_overflow_policy;
+using ::spdlog::error;
+
+namespace chatserver {
+
+  bool AsyncLogging::Initialize(size_t queue_size,
+                                async_overflow_policy overflow_policy) {
+    try {
+      // The thread pool allocates every slot of the ring up front.
+      spdlog::init_thread_pool(queue_size, 1);
+      auto sink = make_shared<spdlog::sinks::stdout_color_sink_mt>();
+      auto logger = make_shared<spdlog::async_logger>(
+          "chat_server", move(sink), spdlog::thread_pool(), overflow_policy);
+      // Errors are rare; write them out before the process may go down.
+      logger->flush_on(spdlog::level::err);
+      spdlog::set_default_logger(move(logger));
+    } catch (const spdlog::spdlog_ex& e) {
+      error("Fail to create the asynchronous logger: {}", e.what());
+      return false;
+    }
+    return true;
+  }
+
+  bool AsyncLogging::ParseOverflowPolicy(const string& text,
+                                         async_overflow_policy* out_policy) {
+    if (out_policy == nullptr) {
+      return false;
+    }
+    if (text == "block") {
+      *out_policy = async_overflow_policy::block;
+      return true;
+    } else if (text == "overrun_oldest") {
+      *out_policy = async_overflow_policy::overrun_oldest;
+      return true;
+    }
+    return false;
+  }
+
+  size_t AsyncLogging::GetDroppedMessageCount() {
+    const shared_ptr<spdlog::details::thread_pool> thread_pool =
+        spdlog::thread_pool();
+    if (thread_pool == nullptr) {
+      return 0;
+    }
+    return thread_pool->overrun_counter();
+  }
+
+  void AsyncLogging::Shutdown() {
+    spdlog::shutdown();
+  }
+
+} // namespace chatserver
@@ -0,0 +1,52 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_ASYNCLOGGING_H_
+#define CHATSERVER_ASYNCLOGGING_H_
+
+#include <cstddef>
+#include <string>
+
+#include "spdlog/async.h"
+
+// This class replaces the default spdlog logger with an asynchronous logger,
+// so a request thread only formats a log message and pushes it into a
+// pre-allocated ring of kDefaultQueueSize slots. One background thread writes
+// the messages to the console. When the ring is full, the overflow policy
+// either blocks the request thread until a slot is free, or overwrites the
+// oldest message.
+// Example:
+//   if (!AsyncLogging::Initialize(AsyncLogging::kDefaultQueueSize,
+//                                 spdlog::async_overflow_policy::block)) {
+//     do something to keep the synchronous logger
+//   }
+//   info("Logged by the background thread");
+//   AsyncLogging::Shutdown();
+
+namespace chatserver {
+
+  class AsyncLogging {
+   public:
+    // Default number of slots in the ring.
+    static const size_t kDefaultQueueSize = 8192;
+
+    // Make the asynchronous logger the default logger. Return false if the
+    // logger can't be created; the previous default logger stays then.
+    static bool Initialize(size_t queue_size,
+                           spdlog::async_overflow_policy overflow_policy);
+
+    // Parse an overflow policy: "block" or "overrun_oldest".
+    static bool ParseOverflowPolicy(const std::string& text,
+                                    spdlog::async_overflow_policy* out_policy);
+
+    // Get the number of messages overwritten by overrun_oldest.
+    static size_t GetDroppedMessageCount();
+
+    // Write the queued messages and stop the background thread.
+    static void Shutdown();
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_ASYNCLOGGING_H_
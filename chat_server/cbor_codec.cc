@@ -0,0 +1,730 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "cbor_codec.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <set>
+#include <string>
+
+#include "cpprest/asyncrt_utils.h"
+
+using namespace std;
+using ::web::json::value;
+using ::utility::string_t;
+using ::utility::conversions::to_string_t;
+using ::utility::conversions::to_utf8string;
+
+namespace chatserver {
+
+  namespace {
+
+    // CBOR major types.
+    const unsigned char kMajorUnsigned = 0;
+    const unsigned char kMajorNegative = 1;
+    const unsigned char kMajorTextString = 3;
+    const unsigned char kMajorArray = 4;
+    const unsigned char kMajorMap = 5;
+    const unsigned char kMajorTag = 6;
+    const unsigned char kMajorSimple = 7;
+
+    // Additional information of the simple and float major type.
+    const unsigned char kSimpleFalse = 20;
+    const unsigned char kSimpleTrue = 21;
+    const unsigned char kSimpleNull = 22;
+    const unsigned char kSimpleUndefined = 23;
+    const unsigned char kHalfFloat = 25;
+    const unsigned char kSingleFloat = 26;
+    const unsigned char kDoubleFloat = 27;
+
+    // Nested arrays and maps deeper than this are rejected.
+    const int kMaxNestingDepth = 64;
+
+    // Keys of a chat message block.
+    const char kKeyRoom[] = "room";
+    const char kKeyDate[] = "date";
+    const char kKeyUserId[] = "user_id";
+    const char kKeyMessage[] = "message";
+    const char kKeyTimestamp[] = "timestamp";
+    const char kKeyId[] = "id";
+
+    // Fields of a chat message block, and of one without timestamps and ids
+    // from an older server.
+    const uint64_t kChatMessageBlockFieldSize = 6;
+    const uint64_t kChatMessageBlockFieldSizeWithoutId = 4;
+
+    // Append the initial byte and the big-endian argument of a data item.
+    void WriteHead(unsigned char major_type,
+                   uint64_t argument,
+                   vector<unsigned char>* data) {
+      const unsigned char type_bits = static_cast<unsigned char>(
+          major_type << 5);
+      size_t argument_size = 0;
+      if (argument < 24) {
+        data->push_back(type_bits | static_cast<unsigned char>(argument));
+        return;
+      } else if (argument <= 0xff) {
+        data->push_back(type_bits | 24);
+        argument_size = 1;
+      } else if (argument <= 0xffff) {
+        data->push_back(type_bits | 25);
+        argument_size = 2;
+      } else if (argument <= 0xffffffff) {
+        data->push_back(type_bits | 26);
+        argument_size = 4;
+      } else {
+        data->push_back(type_bits | 27);
+        argument_size = 8;
+      }
+      for (size_t i = argument_size; i > 0; --i) {
+        data->push_back(
+            static_cast<unsigned char>(argument >> ((i - 1) * 8)));
+      }
+    }
+
+    void WriteInteger(int64_t integer, vector<unsigned char>* data) {
+      if (integer >= 0) {
+        WriteHead(kMajorUnsigned, static_cast<uint64_t>(integer), data);
+      } else {
+        // -1 - integer without overflow.
+        WriteHead(kMajorNegative, ~static_cast<uint64_t>(integer), data);
+      }
+    }
+
+    void WriteUtf8(const char* text, size_t size, vector<unsigned char>* data) {
+      WriteHead(kMajorTextString, size, data);
+      data->insert(data->end(), text, text + size);
+    }
+
+    void WriteText(const string_t& text, vector<unsigned char>* data) {
+      const string utf8_text = to_utf8string(text);
+      WriteUtf8(utf8_text.data(), utf8_text.size(), data);
+    }
+
+    // A UTF-8 ChatString is written without a copy.
+    void WriteChatText(const ChatString& text, vector<unsigned char>* data) {
+      const auto& utf8_text = ToUtf8(text);
+      WriteUtf8(utf8_text.data(), utf8_text.size(), data);
+    }
+
+    void WriteChatText(ChatStringView text, vector<unsigned char>* data) {
+      const auto& utf8_text = ToUtf8(text);
+      WriteUtf8(utf8_text.data(), utf8_text.size(), data);
+    }
+
+    void WriteDouble(double number, vector<unsigned char>* data) {
+      uint64_t bits = 0;
+      memcpy(&bits, &number, sizeof(bits));
+      data->push_back(static_cast<unsigned char>(kMajorSimple << 5) |
+                      kDoubleFloat);
+      for (size_t i = 8; i > 0; --i) {
+        data->push_back(static_cast<unsigned char>(bits >> ((i - 1) * 8)));
+      }
+    }
+
+    void EncodeJsonItem(const value& json_value, vector<unsigned char>* data) {
+      switch (json_value.type()) {
+        case value::Boolean:
+          WriteHead(kMajorSimple,
+                    json_value.as_bool() ? kSimpleTrue : kSimpleFalse, data);
+          return;
+        case value::Number: {
+          const web::json::number& number = json_value.as_number();
+          if (number.is_uint64()) {
+            WriteHead(kMajorUnsigned, number.to_uint64(), data);
+          } else if (number.is_int64()) {
+            WriteInteger(number.to_int64(), data);
+          } else {
+            WriteDouble(number.to_double(), data);
+          }
+          return;
+        }
+        case value::String:
+          WriteText(json_value.as_string(), data);
+          return;
+        case value::Array: {
+          const web::json::array& items = json_value.as_array();
+          WriteHead(kMajorArray, items.size(), data);
+          for (const value& item : items) {
+            EncodeJsonItem(item, data);
+          }
+          return;
+        }
+        case value::Object: {
+          const web::json::object& fields = json_value.as_object();
+          WriteHead(kMajorMap, fields.size(), data);
+          for (const auto& field : fields) {
+            WriteText(field.first, data);
+            EncodeJsonItem(field.second, data);
+          }
+          return;
+        }
+        case value::Null:
+        default:
+          WriteHead(kMajorSimple, kSimpleNull, data);
+          return;
+      }
+    }
+
+    // Sequential reader of CBOR data items with bounds checks.
+    class CborReader {
+     public:
+      explicit CborReader(const vector<unsigned char>& data)
+          : data_(data),
+            position_(0) {
+      }
+
+      // Read the initial byte and the argument of a data item. For the
+      // simple and float major type, the argument is the raw float bits.
+      bool ReadHead(unsigned char* out_major_type,
+                    unsigned char* out_additional,
+                    uint64_t* out_argument) {
+        if (position_ >= data_.size()) {
+          return false;
+        }
+        const unsigned char initial_byte = data_[position_++];
+        *out_major_type = initial_byte >> 5;
+        *out_additional = initial_byte & 0x1f;
+        if (*out_additional < 24) {
+          *out_argument = *out_additional;
+          return true;
+        }
+        switch (*out_additional) {
+          case 24: return ReadBigEndian(1, out_argument);
+          case 25: return ReadBigEndian(2, out_argument);
+          case 26: return ReadBigEndian(4, out_argument);
+          case 27: return ReadBigEndian(8, out_argument);
+          default: return false;  // Reserved or indefinite length.
+        }
+      }
+
+      // Read the head of the given major type.
+      bool ReadHeadOf(unsigned char major_type, uint64_t* out_argument) {
+        unsigned char read_major_type = 0;
+        unsigned char additional = 0;
+        return ReadHead(&read_major_type, &additional, out_argument) &&
+               read_major_type == major_type;
+      }
+
+      bool ReadUtf8Payload(uint64_t size, string* out_text) {
+        if (size > Remaining()) {
+          return false;
+        }
+        const char* begin =
+            reinterpret_cast<const char*>(data_.data() + position_);
+        out_text->assign(begin, static_cast<size_t>(size));
+        position_ += static_cast<size_t>(size);
+        return true;
+      }
+
+      bool ReadUtf8(string* out_text) {
+        uint64_t size = 0;
+        return ReadHeadOf(kMajorTextString, &size) &&
+               ReadUtf8Payload(size, out_text);
+      }
+
+      bool ReadText(string_t* out_text) {
+        string utf8_text;
+        if (!ReadUtf8(&utf8_text)) {
+          return false;
+        }
+        *out_text = to_string_t(utf8_text);
+        return true;
+      }
+
+      bool ReadChatText(ChatString* out_text) {
+        string utf8_text;
+        if (!ReadUtf8(&utf8_text)) {
+          return false;
+        }
+        *out_text = FromUtf8(move(utf8_text));
+        return true;
+      }
+
+      bool ReadInteger(int64_t* out_integer) {
+        unsigned char major_type = 0;
+        unsigned char additional = 0;
+        uint64_t argument = 0;
+        if (!ReadHead(&major_type, &additional, &argument) ||
+            argument > static_cast<uint64_t>(numeric_limits<int64_t>::max())) {
+          return false;
+        }
+        if (major_type == kMajorUnsigned) {
+          *out_integer = static_cast<int64_t>(argument);
+          return true;
+        } else if (major_type == kMajorNegative) {
+          *out_integer = -1 - static_cast<int64_t>(argument);
+          return true;
+        }
+        return false;
+      }
+
+      // Read the head of an array or a map whose items fit in the rest of
+      // the data, so a bogus size cannot make a huge allocation.
+      bool ReadContainerHead(unsigned char major_type,
+                             uint64_t bytes_per_item,
+                             uint64_t* out_size) {
+        return ReadHeadOf(major_type, out_size) &&
+               *out_size <= Remaining() / bytes_per_item;
+      }
+
+      size_t Remaining() const {
+        return data_.size() - position_;
+      }
+
+     private:
+      bool ReadBigEndian(size_t size, uint64_t* out_argument) {
+        if (size > Remaining()) {
+          return false;
+        }
+        uint64_t argument = 0;
+        for (size_t i = 0; i < size; ++i) {
+          argument = (argument << 8) | data_[position_++];
+        }
+        *out_argument = argument;
+        return true;
+      }
+
+      const vector<unsigned char>& data_;
+      size_t position_;
+    };
+
+    double DecodeHalfFloat(uint64_t bits) {
+      const int exponent = static_cast<int>((bits >> 10) & 0x1f);
+      const int mantissa = static_cast<int>(bits & 0x3ff);
+      double number = 0;
+      if (exponent == 0) {
+        number = ldexp(mantissa, -24);
+      } else if (exponent != 31) {
+        number = ldexp(mantissa + 1024, exponent - 25);
+      } else {
+        number = mantissa == 0 ? numeric_limits<double>::infinity()
+                               : numeric_limits<double>::quiet_NaN();
+      }
+      return (bits & 0x8000) ? -number : number;
+    }
+
+    bool DecodeJsonItem(CborReader* reader, int depth, value* out_value) {
+      if (depth > kMaxNestingDepth) {
+        return false;
+      }
+
+      unsigned char major_type = 0;
+      unsigned char additional = 0;
+      uint64_t argument = 0;
+      if (!reader->ReadHead(&major_type, &additional, &argument)) {
+        return false;
+      }
+
+      switch (major_type) {
+        case kMajorUnsigned:
+          // Prefer a signed number like the JSON parser of cpprestsdk.
+          if (argument <=
+              static_cast<uint64_t>(numeric_limits<int64_t>::max())) {
+            *out_value = value::number(static_cast<int64_t>(argument));
+          } else {
+            *out_value = value::number(argument);
+          }
+          return true;
+        case kMajorNegative:
+          if (argument >
+              static_cast<uint64_t>(numeric_limits<int64_t>::max())) {
+            return false;
+          }
+          *out_value = value::number(-1 - static_cast<int64_t>(argument));
+          return true;
+        case kMajorTextString: {
+          string utf8_text;
+          if (!reader->ReadUtf8Payload(argument, &utf8_text)) {
+            return false;
+          }
+          *out_value = value::string(to_string_t(utf8_text));
+          return true;
+        }
+        case kMajorArray: {
+          if (argument > reader->Remaining()) {
+            return false;
+          }
+          *out_value = value::array(static_cast<size_t>(argument));
+          for (size_t i = 0; i < argument; ++i) {
+            if (!DecodeJsonItem(reader, depth + 1, &(*out_value)[i])) {
+              return false;
+            }
+          }
+          return true;
+        }
+        case kMajorMap: {
+          if (argument > reader->Remaining() / 2) {
+            return false;
+          }
+          *out_value = value::object();
+          for (size_t i = 0; i < argument; ++i) {
+            string_t key;
+            if (!reader->ReadText(&key) ||
+                !DecodeJsonItem(reader, depth + 1, &(*out_value)[key])) {
+              return false;
+            }
+          }
+          return true;
+        }
+        case kMajorTag:
+          // Tags carry no meaning in JSON, so decode the tagged item.
+          return DecodeJsonItem(reader, depth + 1, out_value);
+        case kMajorSimple:
+          switch (additional) {
+            case kSimpleFalse:
+              *out_value = value::boolean(false);
+              return true;
+            case kSimpleTrue:
+              *out_value = value::boolean(true);
+              return true;
+            case kSimpleNull:
+            case kSimpleUndefined:
+              *out_value = value::null();
+              return true;
+            case kHalfFloat:
+              *out_value = value::number(DecodeHalfFloat(argument));
+              return true;
+            case kSingleFloat: {
+              const uint32_t bits = static_cast<uint32_t>(argument);
+              float number = 0;
+              memcpy(&number, &bits, sizeof(number));
+              *out_value = value::number(static_cast<double>(number));
+              return true;
+            }
+            case kDoubleFloat: {
+              double number = 0;
+              memcpy(&number, &argument, sizeof(number));
+              *out_value = value::number(number);
+              return true;
+            }
+            default:
+              return false;
+          }
+        default:
+          return false;  // Byte strings are not supported.
+      }
+    }
+
+    // Read an array of integers, each the difference from the previous one,
+    // into values.
+    bool ReadDeltaColumn(CborReader* reader, vector<int64_t>* values) {
+      uint64_t size = 0;
+      if (!reader->ReadContainerHead(kMajorArray, 1, &size)) {
+        return false;
+      }
+      uint64_t value = 0;
+      for (size_t i = 0; i < size; ++i) {
+        int64_t delta = 0;
+        if (!reader->ReadInteger(&delta)) {
+          return false;
+        }
+        value += static_cast<uint64_t>(delta);
+        values->push_back(static_cast<int64_t>(value));
+      }
+      return true;
+    }
+
+    // Decode a chat message block and append its chat messages.
+    bool DecodeChatMessageBlock(CborReader* reader,
+                                vector<ChatMessage>* out_chat_messages) {
+      uint64_t field_size = 0;
+      if (!reader->ReadHeadOf(kMajorMap, &field_size) ||
+          (field_size != kChatMessageBlockFieldSize &&
+           field_size != kChatMessageBlockFieldSizeWithoutId)) {
+        return false;
+      }
+
+      ChatString chat_room;
+      vector<int64_t> dates;
+      vector<int64_t> timestamps;
+      vector<int64_t> ids;
+      vector<ChatString> user_ids;
+      vector<ChatString> messages;
+      bool has_room = false;
+      set<string> keys;
+      for (size_t i = 0; i < field_size; ++i) {
+        string key;
+        // A duplicate key is rejected like a missing one.
+        if (!reader->ReadUtf8(&key) || !keys.insert(key).second) {
+          return false;
+        }
+        uint64_t size = 0;
+        if (key == kKeyRoom) {
+          if (!reader->ReadChatText(&chat_room)) {
+            return false;
+          }
+          has_room = true;
+        } else if (key == kKeyDate || key == kKeyTimestamp || key == kKeyId) {
+          vector<int64_t>* values = &ids;
+          if (key == kKeyDate) {
+            values = &dates;
+          } else if (key == kKeyTimestamp) {
+            values = &timestamps;
+          }
+          if (!values->empty() || !ReadDeltaColumn(reader, values)) {
+            return false;
+          }
+        } else if (key == kKeyUserId || key == kKeyMessage) {
+          if (!reader->ReadContainerHead(kMajorArray, 1, &size)) {
+            return false;
+          }
+          vector<ChatString>& texts =
+              key == kKeyUserId ? user_ids : messages;
+          texts.resize(static_cast<size_t>(size));
+          for (ChatString& text : texts) {
+            if (!reader->ReadChatText(&text)) {
+              return false;
+            }
+          }
+        } else {
+          return false;
+        }
+      }
+      const bool has_id = field_size == kChatMessageBlockFieldSize;
+      if (!has_room || dates.size() != user_ids.size() ||
+          dates.size() != messages.size() ||
+          (has_id && (dates.size() != timestamps.size() ||
+                      dates.size() != ids.size()))) {
+        return false;
+      }
+
+      for (size_t i = 0; i < dates.size(); ++i) {
+        out_chat_messages->emplace_back(static_cast<time_t>(dates[i]),
+                                        move(user_ids[i]), chat_room,
+                                        move(messages[i]));
+        if (has_id) {
+          out_chat_messages->back().timestamp = timestamps[i];
+          out_chat_messages->back().id = static_cast<uint64_t>(ids[i]);
+        }
+      }
+      return true;
+    }
+
+    // Write the given key and an array of integers, each the difference
+    // from the previous one, so most take one byte.
+    template <typename Value>
+    void WriteDeltaColumn(const char* key,
+                          size_t key_size,
+                          const vector<Value>& values,
+                          vector<unsigned char>* data) {
+      WriteUtf8(key, key_size, data);
+      WriteHead(kMajorArray, values.size(), data);
+      uint64_t previous_value = 0;
+      for (const Value value : values) {
+        WriteInteger(
+            static_cast<int64_t>(static_cast<uint64_t>(value) - previous_value),
+            data);
+        previous_value = static_cast<uint64_t>(value);
+      }
+    }
+
+    // ChatMessages is a std::vector<ChatMessage>, a ChatRoomSnapshot or a
+    // std::pmr::vector<ChatMessageView>.
+    template <typename ChatMessages>
+    vector<unsigned char> EncodeChatMessageBlocks(
+        const ChatMessages& chat_messages) {
+      // Find blocks: runs of chat messages in the same chat room.
+      vector<size_t> block_begins;
+      for (size_t i = 0; i < chat_messages.size(); ++i) {
+        if (i == 0 ||
+            chat_messages[i].chat_room != chat_messages[i - 1].chat_room) {
+          block_begins.push_back(i);
+        }
+      }
+      block_begins.push_back(chat_messages.size());
+
+      vector<unsigned char> data;
+      data.reserve(chat_messages.size() * 32 + 16);
+      WriteHead(kMajorArray, block_begins.size() - 1, &data);
+      vector<int64_t> dates;
+      vector<int64_t> timestamps;
+      vector<uint64_t> ids;
+      for (size_t block = 0; block + 1 < block_begins.size(); ++block) {
+        const size_t begin = block_begins[block];
+        const size_t end = block_begins[block + 1];
+        WriteHead(kMajorMap, kChatMessageBlockFieldSize, &data);
+        WriteUtf8(kKeyRoom, sizeof(kKeyRoom) - 1, &data);
+        WriteChatText(chat_messages[begin].chat_room, &data);
+
+        dates.clear();
+        timestamps.clear();
+        ids.clear();
+        for (size_t i = begin; i < end; ++i) {
+          dates.push_back(static_cast<int64_t>(chat_messages[i].date));
+          timestamps.push_back(chat_messages[i].timestamp);
+          ids.push_back(chat_messages[i].id);
+        }
+        WriteDeltaColumn(kKeyDate, sizeof(kKeyDate) - 1, dates, &data);
+        WriteDeltaColumn(kKeyTimestamp, sizeof(kKeyTimestamp) - 1, timestamps,
+                         &data);
+        WriteDeltaColumn(kKeyId, sizeof(kKeyId) - 1, ids, &data);
+
+        WriteUtf8(kKeyUserId, sizeof(kKeyUserId) - 1, &data);
+        WriteHead(kMajorArray, end - begin, &data);
+        for (size_t i = begin; i < end; ++i) {
+          WriteChatText(chat_messages[i].user_id, &data);
+        }
+
+        WriteUtf8(kKeyMessage, sizeof(kKeyMessage) - 1, &data);
+        WriteHead(kMajorArray, end - begin, &data);
+        for (size_t i = begin; i < end; ++i) {
+          WriteChatText(chat_messages[i].chat_message, &data);
+        }
+      }
+      return data;
+    }
+
+    // Narrow [*start, *end) of the given text to exclude spaces and tabs
+    // at both ends.
+    void TrimRange(const string_t& text, size_t* start, size_t* end) {
+      while (*start < *end &&
+             (text[*start] == UU(' ') || text[*start] == UU('\t'))) {
+        ++*start;
+      }
+      while (*end > *start &&
+             (text[*end - 1] == UU(' ') || text[*end - 1] == UU('\t'))) {
+        --*end;
+      }
+    }
+
+    // Check the text from start equals the given lowercase string, ignoring
+    // the case of the text. The text must be long enough.
+    bool EqualsIgnoreCase(const string_t& text,
+                          size_t start,
+                          const utility::char_t* lowercase) {
+      for (size_t i = 0; lowercase[i] != UU('\0'); ++i) {
+        utility::char_t c = text[start + i];
+        if (c >= UU('A') && c <= UU('Z')) {
+          c = c - UU('A') + UU('a');
+        }
+        if (c != lowercase[i]) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Check the parameters in [start, end) of a media range, each after a
+    // ";", have a quality value of 0: "q=0", "q=0.", "q=0.000".
+    bool IsRefused(const string_t& text, size_t start, size_t end) {
+      while (start < end) {
+        size_t parameter_end = text.find(UU(';'), start + 1);
+        if (parameter_end == string_t::npos || parameter_end > end) {
+          parameter_end = end;
+        }
+        size_t parameter_start = start + 1;
+        TrimRange(text, &parameter_start, &parameter_end);
+        if (parameter_end - parameter_start >= 3 &&
+            EqualsIgnoreCase(text, parameter_start, UU("q=0"))) {
+          size_t i = parameter_start + 3;
+          if (i < parameter_end && text[i] == UU('.')) {
+            ++i;
+          }
+          while (i < parameter_end && text[i] == UU('0')) {
+            ++i;
+          }
+          return i == parameter_end;
+        }
+        start = text.find(UU(';'), start + 1);
+        if (start == string_t::npos) {
+          start = end;
+        }
+      }
+      return false;
+    }
+
+  } // namespace
+
+  const utility::char_t CborCodec::kMediaType[] = UU("application/cbor");
+
+  bool CborCodec::IsCborMediaType(const string_t& header_value) {
+    // Parse in place without a copy: it runs on every GET request.
+    // media-range: type/subtype *( ";" parameter ), separated by ","
+    const size_t media_type_size =
+        sizeof(kMediaType) / sizeof(kMediaType[0]) - 1;
+    size_t start = 0;
+    while (start < header_value.size()) {
+      size_t end = header_value.find(UU(','), start);
+      if (end == string_t::npos) {
+        end = header_value.size();
+      }
+      size_t parameter_index = header_value.find(UU(';'), start);
+      if (parameter_index == string_t::npos || parameter_index > end) {
+        parameter_index = end;
+      }
+      size_t type_start = start;
+      size_t type_end = parameter_index;
+      TrimRange(header_value, &type_start, &type_end);
+      if (type_end - type_start == media_type_size &&
+          EqualsIgnoreCase(header_value, type_start, kMediaType) &&
+          !IsRefused(header_value, parameter_index, end)) {
+        return true;
+      }
+      start = end + 1;
+    }
+    return false;
+  }
+
+  vector<unsigned char> CborCodec::EncodeJson(const value& json_value) {
+    vector<unsigned char> data;
+    EncodeJsonItem(json_value, &data);
+    return data;
+  }
+
+  bool CborCodec::DecodeJson(const vector<unsigned char>& data,
+                             value* out_json_value) {
+    if (out_json_value == nullptr) {
+      return false;
+    }
+    CborReader reader(data);
+    value json_value;
+    if (!DecodeJsonItem(&reader, 0, &json_value) || reader.Remaining() != 0) {
+      return false;
+    }
+    *out_json_value = move(json_value);
+    return true;
+  }
+
+  vector<unsigned char> CborCodec::EncodeChatMessages(
+      const vector<ChatMessage>& chat_messages) {
+    return EncodeChatMessageBlocks(chat_messages);
+  }
+
+  vector<unsigned char> CborCodec::EncodeChatRoomSnapshot(
+      const ChatRoomSnapshot& chat_messages) {
+    return EncodeChatMessageBlocks(chat_messages);
+  }
+
+  vector<unsigned char> CborCodec::EncodeChatMessageViews(
+      const pmr::vector<ChatMessageView>& chat_messages) {
+    return EncodeChatMessageBlocks(chat_messages);
+  }
+
+  bool CborCodec::DecodeChatMessages(
+      const vector<unsigned char>& data,
+      vector<ChatMessage>* out_chat_messages) {
+    if (out_chat_messages == nullptr) {
+      return false;
+    }
+
+    // Keep out_chat_messages unchanged on failure.
+    const size_t original_size = out_chat_messages->size();
+    CborReader reader(data);
+    uint64_t block_size = 0;
+    bool is_decoded = reader.ReadContainerHead(kMajorArray, 1, &block_size);
+    for (size_t i = 0; is_decoded && i < block_size; ++i) {
+      is_decoded = DecodeChatMessageBlock(&reader, out_chat_messages);
+    }
+    if (!is_decoded || reader.Remaining() != 0) {
+      out_chat_messages->resize(original_size);
+      return false;
+    }
+    return true;
+  }
+
+} // namespace chatserver
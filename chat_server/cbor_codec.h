@@ -0,0 +1,78 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CBORCODEC_H_
+#define CHATSERVER_CBORCODEC_H_
+
+#include <memory_resource>
+#include <vector>
+
+#include "cpprest/details/basic_types.h"
+#include "cpprest/json.h"
+#include "chat_message.h"
+#include "chat_room_log.h"
+
+// This class encodes and decodes the binary wire format of the chat server,
+// CBOR (RFC 7049). It is selected by "Accept: application/cbor" or
+// "Content-Type: application/cbor", and JSON stays the default.
+// 1) Generic body data: web::json::value <-> CBOR data item.
+// 2) Chat message list: a columnar layout that writes each key once.
+//    [{"room": text, "date": [int], "timestamp": [int], "id": [int],
+//      "user_id": [text], "message": [text]}, ..]
+//    Consecutive chat messages of the same chat room share one block. The
+//    first date, timestamp and id of a block are absolute and the others are
+//    the difference from the previous one, so most dates and ids take one
+//    byte. Blocks without "timestamp" and "id" from older servers are
+//    decoded as well.
+// Indefinite-length items and byte strings are not supported.
+// Example:
+//   std::vector<unsigned char> data = CborCodec::EncodeChatMessages(messages);
+//   std::vector<ChatMessage> decoded_messages;
+//   if (CborCodec::DecodeChatMessages(data, &decoded_messages)) {
+//     do something with decoded_messages
+//   }
+
+namespace chatserver {
+
+  class CborCodec {
+   public:
+    // Media type of the CBOR wire format.
+    static const utility::char_t kMediaType[];
+
+    // Check the given Accept or Content-Type header value selects CBOR: one
+    // of its comma-separated media ranges is "application/cbor", in any
+    // case, without a quality value of 0.
+    static bool IsCborMediaType(const utility::string_t& header_value);
+
+    // Encode the given JSON value as a CBOR data item.
+    static std::vector<unsigned char> EncodeJson(
+        const web::json::value& json_value);
+
+    // Decode the given CBOR data item into a JSON value. Return false if the
+    // data is malformed or unsupported.
+    static bool DecodeJson(const std::vector<unsigned char>& data,
+                           web::json::value* out_json_value);
+
+    // Encode the given chat messages in the columnar layout.
+    static std::vector<unsigned char> EncodeChatMessages(
+        const std::vector<ChatMessage>& chat_messages);
+
+    // Encode the chat messages of the given snapshot or views in the
+    // columnar layout. They are not overloads of EncodeChatMessages, so
+    // EncodeChatMessages({}) is not ambiguous.
+    static std::vector<unsigned char> EncodeChatRoomSnapshot(
+        const ChatRoomSnapshot& chat_messages);
+    static std::vector<unsigned char> EncodeChatMessageViews(
+        const std::pmr::vector<ChatMessageView>& chat_messages);
+
+    // Decode chat messages in the columnar layout and append them to
+    // out_chat_messages. Return false if the data is malformed.
+    static bool DecodeChatMessages(
+        const std::vector<unsigned char>& data,
+        std::vector<ChatMessage>* out_chat_messages);
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CBORCODEC_H_
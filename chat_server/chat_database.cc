@@ -4,8 +4,17 @@
 
 #include "chat_database.h"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <thread>
+
 #include "cpprest/asyncrt_utils.h"
+#include "chat_message_loader.h"
+#include "delimiter_scanner.h"
 #include "spdlog/spdlog.h"
+#include "tracing.h"
 
 namespace chatserver {
 
@@ -13,9 +22,141 @@ namespace chatserver {
   using ::utility::conversions::to_utf8string;
   using ::utility::string_t;
   using ::spdlog::error;
+  using ::spdlog::info;
 
   // Delimiter in the chat message file database.
-  const string_t kParsingDelimiter = UU("|");
+  const ChatString kParsingDelimiter = CHATSERVER_TEXT("|");
+
+  namespace {
+
+    // Separators of the chat room list of GET chatmessage/multi,
+    // "a:since_id,b", which a chat room name must not have.
+    const ChatChar kChatRoomListSeparators[] = CHATSERVER_TEXT(",:");
+
+    // Accesses of a chat room within this many microseconds are recorded
+    // once, so readers of a busy chat room rarely write the same cache line.
+    const int64_t kAccessTimeResolution = 1000;
+
+    // Free chunks kept for reuse take at most 1/kFreeChunkBudgetDivisor of a
+    // memory budget. The others are deleted as soon as they are freed.
+    const uint64_t kFreeChunkBudgetDivisor = 16;
+
+    // Record an access of the given chat room log now.
+    void RecordAccess(const ChatRoomLog& chat_room_log) {
+      const int64_t now = chrono::duration_cast<chrono::microseconds>(
+          chrono::steady_clock::now().time_since_epoch()).count();
+      if (now - chat_room_log.GetLastAccessTime() >= kAccessTimeResolution) {
+        chat_room_log.SetLastAccessTime(now);
+      }
+    }
+
+    // Latest chat messages of several chat rooms, added one chat room at a
+    // time. Only the snapshots the kept chat messages point into are held,
+    // so a query over many chat rooms pins at most limit + 1 of them.
+    class LatestChatMessages {
+     public:
+      LatestChatMessages(size_t limit, pmr::memory_resource* memory_resource)
+          : limit_(limit), entries_(memory_resource) {
+      }
+
+      // Merge the given chat messages of the snapshot, oldest first, by time,
+      // and drop the oldest beyond the limit.
+      void Add(shared_ptr<const ChatRoomSnapshot> snapshot,
+               const pmr::vector<ChatMessageView>& chat_messages) {
+        if (chat_messages.empty()) {
+          return;
+        }
+        const size_t snapshot_index = snapshots_.size();
+        snapshots_.push_back(move(snapshot));
+        reference_counts_.push_back(chat_messages.size());
+        const size_t middle = entries_.size();
+        for (const ChatMessageView& chat_message : chat_messages) {
+          entries_.push_back({chat_message, snapshot_index});
+        }
+        // Earlier chat rooms come first among chat messages of the same time.
+        const auto by_time = [](const Entry& left, const Entry& right) {
+          return left.chat_message.timestamp < right.chat_message.timestamp;
+        };
+        stable_sort(entries_.begin() + middle, entries_.end(), by_time);
+        inplace_merge(entries_.begin(), entries_.begin() + middle,
+                      entries_.end(), by_time);
+        if (entries_.size() <= limit_) {
+          return;
+        }
+        const auto dropped_end = entries_.end() - limit_;
+        for (auto entry = entries_.begin(); entry != dropped_end; ++entry) {
+          if (--reference_counts_[entry->snapshot_index] == 0) {
+            snapshots_[entry->snapshot_index].reset();
+          }
+        }
+        entries_.erase(entries_.begin(), dropped_end);
+      }
+
+      // Append the kept chat messages to out_chat_messages, oldest first, and
+      // return the snapshots they point into.
+      vector<shared_ptr<const ChatRoomSnapshot>> MoveTo(
+          pmr::vector<ChatMessageView>* out_chat_messages) {
+        for (const Entry& entry : entries_) {
+          out_chat_messages->push_back(entry.chat_message);
+        }
+        vector<shared_ptr<const ChatRoomSnapshot>> snapshots;
+        for (shared_ptr<const ChatRoomSnapshot>& snapshot : snapshots_) {
+          if (snapshot != nullptr) {
+            snapshots.push_back(move(snapshot));
+          }
+        }
+        return snapshots;
+      }
+
+     private:
+      // Chat message and the index of its snapshot in snapshots_.
+      struct Entry {
+        ChatMessageView chat_message;
+        size_t snapshot_index;
+      };
+
+      // Most chat messages to keep.
+      const size_t limit_;
+
+      // Kept chat messages, oldest first.
+      pmr::vector<Entry> entries_;
+
+      // Snapshot of each added chat room, or nullptr once no kept chat
+      // message points into it.
+      vector<shared_ptr<const ChatRoomSnapshot>> snapshots_;
+
+      // Number of kept chat messages of each snapshot in snapshots_.
+      vector<size_t> reference_counts_;
+    };
+
+  } // namespace
+
+  ChatDatabase::ChatDatabase()
+      : chunk_pool_(make_shared<ChatMessageChunkPool>()),
+        mutex_chat_rooms_("ChatDatabase::mutex_chat_rooms_"),
+        mutex_store_("ChatDatabase::mutex_store_"),
+        chat_room_logs_(make_shared<const ChatRoomLogMap>()),
+        chat_rooms_(make_shared<const vector<ChatString>>()),
+        chat_message_count_(0),
+        memory_usage_(0),
+        reserved_memory_(0),
+        memory_budget_(0),
+        mutex_eviction_("ChatDatabase::mutex_eviction_"),
+        mutex_evicted_callback_("ChatDatabase::mutex_evicted_callback_"),
+        load_lazily_(false),
+        mutex_hydrations_("ChatDatabase::mutex_hydrations_") {
+  }
+
+  template <typename ChatMessages>
+  void ChatDatabase::AppendToChatRoomLog(
+      ChatRoomLog* chat_room_log,
+      const ChatMessages& chat_messages) const {
+    const size_t size = chat_room_log->GetSnapshot()->size();
+    const size_t memory_usage = chat_room_log->GetMemoryUsage();
+    chat_room_log->Append(chat_messages);
+    chat_message_count_ += chat_room_log->GetSnapshot()->size() - size;
+    memory_usage_ += chat_room_log->GetMemoryUsage() - memory_usage;
+  }
 
   bool ChatDatabase::Initialize(string_t chat_message_file,
                                 string_t chat_room_file) {
@@ -33,58 +174,308 @@ namespace chatserver {
             to_utf8string(chat_room_file_));
       return false;
     }
+
+    search_index_file_ = chat_message_file_ + UU(".index");
+    IndexChatMessages();
     return true;
   }
 
-  bool ChatDatabase::StoreChatMessage(const ChatMessage& message) {
-    if(!DoesDelimiterExistInChatMessage(message)) {
-      error("Prohibited char in the chat message, chat room or user ID.");
+  bool ChatDatabase::InitializePartitioned(string_t chat_log_directory,
+                                           string_t chat_room_file,
+                                           bool load_lazily) {
+    chat_room_file_ = chat_room_file;
+    partitioned_log_ = make_unique<PartitionedChatLog>();
+    load_lazily_ = load_lazily;
+    if (!partitioned_log_->Open(chat_log_directory) ||
+        (!load_lazily_ && !ReadChatMessagesFromPartitionedLog())) {
+      error("Error to open chat log directory: {}",
+            to_utf8string(chat_log_directory));
       return false;
     }
-    
-    wofstream file(chat_message_file_, wofstream::out | wofstream::app);
-    if (file.is_open()) {
-      // File format: date|user_id|chat_room|chat_message
-      file << message.date << kParsingDelimiter
-           << message.user_id << kParsingDelimiter
-           << message.chat_room << kParsingDelimiter
-           << message.chat_message << endl;
-      file.close();
-      chat_messages_[message.chat_room].push_back(message);
-    } else {
-      error("Unable to open file: {}", to_utf8string(chat_message_file_));
+
+    if (!ReadChatRoomFromFileDatabase(chat_room_file_)) {
+      error("Error to open chat room file: {}",
+            to_utf8string(chat_room_file_));
       return false;
     }
+
+    IndexChatMessages();
+    ReadUserChatRooms();
     return true;
   }
 
-  const vector<ChatMessage>* ChatDatabase::GetAllChatMessages(
-      string_t chat_room) {
-    if (chat_messages_.find(chat_room) != chat_messages_.end()) {
-      return &chat_messages_[chat_room];
+  bool ChatDatabase::StoreChatMessage(const ChatMessage& message) {
+    CHATSERVER_TRACE_SPAN("ChatDatabase::StoreChatMessage");
+    return StoreChatMessages(vector<ChatMessage>(1, message));
+  }
+
+  bool ChatDatabase::StoreChatMessages(const vector<ChatMessage>& messages) {
+    return StoreChatMessages(messages, nullptr);
+  }
+
+  bool ChatDatabase::StoreChatMessages(
+      const vector<ChatMessage>& messages,
+      set<ChatString>* out_stored_chat_rooms) {
+    CHATSERVER_TRACE_SPAN("ChatDatabase::StoreChatMessages");
+    for (const ChatMessage& message : messages) {
+      if (!DoesDelimiterExistInChatMessage(message)) {
+        error("Prohibited char in the chat message, chat room or user ID.");
+        return false;
+      }
+      // Checked before any log file of the chat room is created.
+      if (!IsExistChatRoom(message.chat_room)) {
+        error("There is no chat room: {}", ToUtf8(message.chat_room));
+        return false;
+      }
+    }
+
+    if (partitioned_log_ != nullptr) {
+      return StorePartitionedChatMessages(messages, out_stored_chat_rooms);
+    }
+
+    // The ids written to the file are the ones the chat room logs give, as
+    // no other writer appends in between.
+    const lock_guard<InstrumentedMutex> lock(mutex_store_);
+    map<ChatStringView, uint64_t> next_ids;
+    // Format every line first, so the file is written and flushed once.
+    ChatOutputStringStream lines;
+    for (const ChatMessage& message : messages) {
+      auto next_id = next_ids.find(message.chat_room);
+      if (next_id == next_ids.end()) {
+        const uint64_t first_id = GetChatRoomVersion(message.chat_room) + 1;
+        next_id = next_ids.emplace(message.chat_room, first_id).first;
+      }
+      ChatMessageLoader::FormatLine(message, next_id->second++, &lines);
+    }
+
+    // A partial line makes the file unloadable, so a failed write is cut
+    // back to the size before it, and nothing is added to the logs.
+    error_code error_code;
+    uintmax_t file_size = filesystem::file_size(chat_message_file_,
+                                                error_code);
+    if (error_code) {
+      file_size = 0;
+    }
+    bool is_written = false;
+    {
+      ChatOutputFileStream file(chat_message_file_,
+                                ChatOutputFileStream::out |
+                                ChatOutputFileStream::app);
+      if (!file.is_open()) {
+        error("Unable to open file: {}", to_utf8string(chat_message_file_));
+        return false;
+      }
+      file << lines.str();
+      file.flush();
+      is_written = !file.fail();
+    }
+    if (!is_written) {
+      error("Unable to write file: {}", to_utf8string(chat_message_file_));
+      filesystem::resize_file(chat_message_file_, file_size, error_code);
+      if (error_code) {
+        error("Unable to truncate file: {}",
+              to_utf8string(chat_message_file_));
+      }
+      return false;
+    }
+    AppendChatMessages(messages);
+    return true;
+  }
+
+  void ChatDatabase::LoadChatRooms(const vector<ChatMessage>& messages) const {
+    if (!load_lazily_) {
+      return;
+    }
+    CHATSERVER_TRACE_SPAN("ChatDatabase::LoadChatRooms");
+    set<ChatStringView> chat_rooms;
+    for (const ChatMessage& message : messages) {
+      chat_rooms.insert(message.chat_room);
+    }
+    for (const ChatStringView chat_room_view : chat_rooms) {
+      const ChatString chat_room(chat_room_view);
+      const uint64_t reserved_bytes = EvictChatRoomsBeforeLoad(chat_room);
+      // A chat room that can't be loaded fails its store later.
+      shared_ptr<ChatRoomLog> chat_room_log;
+      FindChatRoomLog(chat_room, &chat_room_log);
+      reserved_memory_ -= reserved_bytes;
+    }
+    EvictChatRooms();
+  }
+
+  shared_ptr<const ChatRoomSnapshot> ChatDatabase::GetAllChatMessages(
+      ChatString chat_room) const {
+    LoadResult load_result = kLoadSuccess;
+    return GetAllChatMessages(chat_room, &load_result);
+  }
+
+  shared_ptr<const ChatRoomSnapshot> ChatDatabase::GetAllChatMessages(
+      ChatString chat_room,
+      LoadResult* out_load_result) const {
+    const uint64_t reserved_bytes = EvictChatRoomsBeforeLoad(chat_room);
+    shared_ptr<ChatRoomLog> chat_room_log;
+    *out_load_result = FindChatRoomLog(chat_room, &chat_room_log);
+    reserved_memory_ -= reserved_bytes;
+    EvictChatRooms();
+    if (*out_load_result != kLoadSuccess) {
+      return nullptr;
+    } else if (chat_room_log != nullptr) {
+      return chat_room_log->GetSnapshot();
     } else {
-      static vector<ChatMessage> chat_messages;
-      return &chat_messages;
+      static const shared_ptr<const ChatRoomSnapshot> chat_messages =
+          make_shared<const ChatRoomSnapshot>();
+      return chat_messages;
+    }
+  }
+
+  shared_ptr<const ChatRoomSnapshot> ChatDatabase::SearchChatMessages(
+      const ChatString& chat_room,
+      const ChatSearchQuery& query,
+      size_t limit,
+      pmr::vector<ChatMessageView>* out_chat_messages,
+      LoadResult* out_load_result) const {
+    const shared_ptr<const ChatRoomSnapshot> snapshot =
+        GetAllChatMessages(chat_room, out_load_result);
+    if (snapshot != nullptr) {
+      search_index_.Search(chat_room, query, *snapshot, limit,
+                           out_chat_messages);
+    }
+    return snapshot;
+  }
+
+  vector<shared_ptr<const ChatRoomSnapshot>>
+  ChatDatabase::SearchAllChatMessages(
+      const ChatSearchQuery& query,
+      size_t limit,
+      pmr::vector<ChatMessageView>* out_chat_messages,
+      LoadResult* out_load_result) const {
+    CHATSERVER_TRACE_SPAN("ChatDatabase::SearchAllChatMessages");
+    pmr::memory_resource* const memory_resource =
+        out_chat_messages->get_allocator().resource();
+    LatestChatMessages latest_chat_messages(limit, memory_resource);
+    pmr::vector<ChatMessageView> room_chat_messages(memory_resource);
+    if (load_lazily_) {
+      // Loading every chat room would evict the ones in use, so only the
+      // loaded ones are searched.
+      const shared_ptr<const ChatRoomLogMap> chat_room_logs =
+          atomic_load(&chat_room_logs_);
+      for (const auto& chat_room_log : *chat_room_logs) {
+        room_chat_messages.clear();
+        shared_ptr<const ChatRoomSnapshot> snapshot =
+            chat_room_log.second->GetSnapshot();
+        search_index_.Search(chat_room_log.first, query, *snapshot, limit,
+                             &room_chat_messages);
+        latest_chat_messages.Add(move(snapshot), room_chat_messages);
+      }
+      *out_load_result = kLoadSuccess;
+      return latest_chat_messages.MoveTo(out_chat_messages);
+    }
+
+    const shared_ptr<const vector<ChatString>> chat_rooms = GetChatRoomList();
+    for (const ChatString& chat_room : *chat_rooms) {
+      room_chat_messages.clear();
+      shared_ptr<const ChatRoomSnapshot> snapshot = SearchChatMessages(
+          chat_room, query, limit, &room_chat_messages, out_load_result);
+      if (snapshot == nullptr) {
+        return {};
+      }
+      latest_chat_messages.Add(move(snapshot), room_chat_messages);
     }
+    *out_load_result = kLoadSuccess;
+    return latest_chat_messages.MoveTo(out_chat_messages);
   }
 
-  bool ChatDatabase::CreateChatRoom(string_t chat_room) {
+  bool ChatDatabase::SaveSearchIndex() const {
+    CHATSERVER_TRACE_SPAN("ChatDatabase::SaveSearchIndex");
+    if (partitioned_log_ == nullptr) {
+      if (!search_index_.Save(search_index_file_)) {
+        error("Unable to save the search index: {}",
+              to_utf8string(search_index_file_));
+        return false;
+      }
+      return true;
+    }
+
+    bool is_saved = true;
+    const shared_ptr<const ChatRoomLogMap> chat_room_logs =
+        atomic_load(&chat_room_logs_);
+    for (const auto& chat_room_log : *chat_room_logs) {
+      const PartitionedChatLog::Partition* const partition =
+          partitioned_log_->GetPartition(chat_room_log.first);
+      if (partition == nullptr ||
+          !search_index_.SaveChatRoom(chat_room_log.first,
+                                      partition->index_file)) {
+        error("Unable to save the search index of chat room: {}",
+              ToUtf8(chat_room_log.first));
+        is_saved = false;
+      }
+    }
+    return is_saved;
+  }
+
+  vector<shared_ptr<const ChatRoomSnapshot>> ChatDatabase::GetUserChatMessages(
+      const ChatString& user_id,
+      size_t limit,
+      pmr::vector<ChatMessageView>* out_chat_messages,
+      LoadResult* out_load_result) const {
+    CHATSERVER_TRACE_SPAN("ChatDatabase::GetUserChatMessages");
+    pmr::memory_resource* const memory_resource =
+        out_chat_messages->get_allocator().resource();
+    LatestChatMessages latest_chat_messages(limit, memory_resource);
+    pmr::vector<ChatMessageView> room_chat_messages(memory_resource);
+    vector<uint64_t> ids;
+    for (const ChatString& chat_room : user_index_.GetChatRooms(user_id)) {
+      // A chat room that is not loaded is loaded and indexed here.
+      shared_ptr<const ChatRoomSnapshot> room_snapshot =
+          GetAllChatMessages(chat_room, out_load_result);
+      if (room_snapshot == nullptr) {
+        return {};
+      }
+      const ChatRoomSnapshot& snapshot = *room_snapshot;
+      ids.clear();
+      if (!user_index_.GetLatestIds(user_id, chat_room, limit, &ids)) {
+        // Evicted after the snapshot was taken, so the ids are found in it.
+        for (size_t i = snapshot.size(); i > 0 && ids.size() < limit; --i) {
+          if (snapshot[i - 1].user_id == user_id) {
+            ids.push_back(snapshot[i - 1].id);
+          }
+        }
+        reverse(ids.begin(), ids.end());
+      }
+      room_chat_messages.clear();
+      for (const uint64_t id : ids) {
+        if (id <= snapshot.size()) {
+          room_chat_messages.push_back(snapshot[static_cast<size_t>(id - 1)]);
+        }
+      }
+      latest_chat_messages.Add(move(room_snapshot), room_chat_messages);
+    }
+    *out_load_result = kLoadSuccess;
+    return latest_chat_messages.MoveTo(out_chat_messages);
+  }
+
+  bool ChatDatabase::CreateChatRoom(ChatString chat_room) {
+    CHATSERVER_TRACE_SPAN("ChatDatabase::CreateChatRoom");
+    const lock_guard<InstrumentedMutex> lock(mutex_chat_rooms_);
     if (chat_room.size() == 0) {
       error("Chat room name cannot be zero length.");
       return false;
     } else if (IsExistChatRoom(chat_room)) {
       error("Chat room name already exists.");
       return false;
-    } else if(chat_room.find(kParsingDelimiter) != string_t::npos) {
+    } else if (DelimiterScanner::Contains(chat_room, kParsingDelimiter[0]) ||
+               chat_room.find_first_of(kChatRoomListSeparators) !=
+                   ChatString::npos) {
       error("Prohibited char in the chat room.");
       return false;
     }
 
-    wofstream file(chat_room_file_, wofstream::out | wofstream::app);
+    ChatOutputFileStream file(chat_room_file_,
+                              ChatOutputFileStream::out |
+                              ChatOutputFileStream::app);
     if (file.is_open()) {
       file << chat_room << endl;
       file.close();
-      chat_rooms_.push_back(chat_room);
+      AppendChatRoom(chat_room);
       return true;
     } else {
       error("Unable to open file: {}", to_utf8string(chat_room_file_));
@@ -92,95 +483,303 @@ namespace chatserver {
     }
   }
 
-  bool ChatDatabase::IsExistChatRoom(string_t chat_room) const {
-    if (find(chat_rooms_.begin(), chat_rooms_.end(), chat_room) == 
-        chat_rooms_.end()) {
+  bool ChatDatabase::IsExistChatRoom(const ChatString& chat_room) const {
+    const shared_ptr<const vector<ChatString>> chat_rooms =
+        atomic_load(&chat_rooms_);
+    if (find(chat_rooms->begin(), chat_rooms->end(), chat_room) ==
+        chat_rooms->end()) {
       return false;
     } else {
       return true;
     }
   }
 
-  const vector<string_t>* ChatDatabase::GetChatRoomList() const{
-    return &chat_rooms_;
+  shared_ptr<const vector<ChatString>> ChatDatabase::GetChatRoomList() const{
+    return atomic_load(&chat_rooms_);
   }
 
-  bool ChatDatabase::ReadChatMessagesFromFileDatabase(
-      string_t chat_message_file) {
-    wifstream file(chat_message_file);
-    if (!file.is_open()) {
-      error("Can't open chat message file: {}",
-            to_utf8string(chat_message_file));
-      return false;
+  uint64_t ChatDatabase::GetChatRoomVersion(ChatString chat_room) const {
+    const shared_ptr<const ChatRoomSnapshot> chat_messages =
+        GetAllChatMessages(chat_room);
+    return chat_messages != nullptr ? chat_messages->size() : 0;
+  }
+
+  uint64_t ChatDatabase::GetChatRoomListVersion() const {
+    // A chat room is never removed, so the number of chat rooms only grows.
+    return atomic_load(&chat_rooms_)->size();
+  }
+
+  uint64_t ChatDatabase::GetChatMessageCount() const {
+    return chat_message_count_;
+  }
+
+  void ChatDatabase::SetMemoryBudget(uint64_t memory_budget) {
+    memory_budget_ = memory_budget;
+    chunk_pool_->SetMaxFreeChunkCount(
+        memory_budget == 0
+            ? numeric_limits<size_t>::max()
+            : static_cast<size_t>(memory_budget / kFreeChunkBudgetDivisor /
+                                  sizeof(ChatMessageChunk)));
+    EvictChatRooms();
+  }
+
+  uint64_t ChatDatabase::GetMemoryBudget() const {
+    return memory_budget_;
+  }
+
+  uint64_t ChatDatabase::GetMemoryUsage() const {
+    return memory_usage_ +
+           chunk_pool_->GetFreeChunkCount() * sizeof(ChatMessageChunk);
+  }
+
+  vector<ChatDatabase::ChatRoomMemoryUsage>
+  ChatDatabase::GetChatRoomMemoryUsages() const {
+    vector<ChatRoomMemoryUsage> memory_usages;
+    const shared_ptr<const ChatRoomLogMap> chat_room_logs =
+        atomic_load(&chat_room_logs_);
+    for (const auto& chat_room_log : *chat_room_logs) {
+      memory_usages.push_back({chat_room_log.first,
+                               chat_room_log.second->GetMemoryUsage() +
+                                   GetIndexMemoryUsage(chat_room_log.first)});
     }
+    return memory_usages;
+  }
+
+  void ChatDatabase::SetEvictedCallback(EvictedCallback on_evicted) {
+    const lock_guard<InstrumentedMutex> lock(mutex_evicted_callback_);
+    on_evicted_ = move(on_evicted);
+  }
 
-    if (!ParsingChatMessageFile(move(file))) {
+  bool ChatDatabase::ReadChatMessagesFromFileDatabase(
+      string_t chat_message_file) {
+    // Parse with one thread per core.
+    ChatMessageLoader::ChatMessageMap chat_messages;
+    if (!ChatMessageLoader::Load(chat_message_file, 0, &chat_messages)) {
       error("Parsing error: {}", to_utf8string(chat_message_file));
-      file.close();
       return false;
     }
-    file.close();
+    for (auto& chat_room : chat_messages) {
+      AppendToChatRoomLog(GetOrCreateChatRoomLog(chat_room.first).get(),
+                          chat_room.second);
+    }
     return true;
   }
 
-  bool ChatDatabase::DoesDelimiterExistInChatMessage(const ChatMessage& message) {
-    if (message.chat_message.find(kParsingDelimiter) != string_t::npos ||
-      message.user_id.find(kParsingDelimiter) != string_t::npos ||
-      message.chat_room.find(kParsingDelimiter) != string_t::npos) {
-      return false;
+  bool ChatDatabase::ReadChatMessagesFromPartitionedLog() {
+    CHATSERVER_TRACE_SPAN("ChatDatabase::ReadChatMessagesFromPartitionedLog");
+    const vector<ChatString> chat_rooms = partitioned_log_->GetChatRooms();
+    // Chat rooms differ in size, so threads take them one at a time.
+    atomic<size_t> next_chat_room(0);
+    atomic<bool> succeeded(true);
+    const auto load_chat_rooms = [&]() {
+      for (size_t i = next_chat_room++; i < chat_rooms.size();
+           i = next_chat_room++) {
+        vector<ChatMessage> chat_messages;
+        if (!partitioned_log_->LoadChatRoom(chat_rooms[i], &chat_messages)) {
+          error("Parsing error of chat room: {}", ToUtf8(chat_rooms[i]));
+          succeeded = false;
+          return;
+        }
+        if (!chat_messages.empty()) {
+          AppendToChatRoomLog(GetOrCreateChatRoomLog(chat_rooms[i]).get(),
+                              chat_messages);
+        }
+      }
+    };
+
+    // The first thread is the calling thread.
+    const size_t thread_count = min<size_t>(
+        max(thread::hardware_concurrency(), 1u), chat_rooms.size());
+    vector<thread> threads;
+    for (size_t i = 1; i < thread_count; ++i) {
+      threads.emplace_back(load_chat_rooms);
     }
-    return true;
+    load_chat_rooms();
+    for (thread& t : threads) {
+      t.join();
+    }
+    return succeeded;
   }
 
-  bool ChatDatabase::ParsingChatMessageFile(wifstream chat_message_file) {
-    string_t line;
-    while (chat_message_file.good()) {
-      getline(chat_message_file, line);
-      if (line.length() == 0) continue;
+  void ChatDatabase::IndexChatMessages() {
+    // Index the loaded chat messages. The user index is built from the
+    // start, and a missing or stale search index is rebuilt.
+    if (partitioned_log_ == nullptr &&
+        !search_index_.Load(search_index_file_)) {
+      info("Building the search index: {}", to_utf8string(search_index_file_));
+    }
+    const shared_ptr<const ChatRoomLogMap> chat_room_logs =
+        atomic_load(&chat_room_logs_);
+    for (const auto& chat_room_log : *chat_room_logs) {
+      IndexChatRoom(chat_room_log.first, *chat_room_log.second);
+    }
+  }
 
-      size_t end_index = 0;
-      size_t start_index = 0;
-      ChatMessage message;
+  void ChatDatabase::LoadChatRoomIndex(const ChatString& chat_room) const {
+    if (search_index_.GetIndexedCount(chat_room) > 0) {
+      return;
+    }
+    const PartitionedChatLog::Partition* const partition =
+        partitioned_log_->GetPartition(chat_room);
+    if (partition == nullptr) {
+      return;
+    }
+    // A missing or stale index is rebuilt by IndexChatRoom.
+    if (!search_index_.LoadChatRoom(chat_room, partition->index_file)) {
+      info("Building the search index of chat room: {}", ToUtf8(chat_room));
+    }
+  }
 
-      // Parsing format: date|user_id|chat_room|chat_message
-      for (auto i = 0; i < 3; i++) {
-        end_index = line.find(kParsingDelimiter, start_index);
-        if (end_index == start_index) {
-          error("Chat message file parsing error");
-          return false;
-        }
+  void ChatDatabase::ReadUserChatRooms() {
+    CHATSERVER_TRACE_SPAN("ChatDatabase::ReadUserChatRooms");
+    vector<PartitionedChatLog::UserChatRoom> user_chat_rooms;
+    if (partitioned_log_->LoadUserChatRooms(&user_chat_rooms)) {
+      for (const auto& user_chat_room : user_chat_rooms) {
+        user_index_.AddChatRoom(user_chat_room.user_id,
+                                user_chat_room.chat_room);
+      }
+      return;
+    }
 
-        if (i == 0) {
-          message.date = stoll(
-              line.substr(start_index, end_index - start_index));
-        } else if (i == 1) {
-          message.user_id = line.substr(start_index, end_index - start_index);
-        } else if (i == 2) {
-          message.chat_room = line.substr(start_index, end_index - start_index);
+    info("Building the chat rooms of users");
+    user_chat_rooms.clear();
+    bool is_complete = true;
+    for (const ChatString& chat_room : partitioned_log_->GetChatRooms()) {
+      vector<ChatString> user_ids;
+      const shared_ptr<ChatRoomLog> chat_room_log =
+          FindLoadedChatRoomLog(chat_room);
+      if (chat_room_log != nullptr) {
+        const shared_ptr<const ChatRoomSnapshot> snapshot =
+            chat_room_log->GetSnapshot();
+        for (size_t i = 0; i < snapshot->size(); ++i) {
+          user_ids.emplace_back((*snapshot)[i].user_id);
         }
-        start_index = end_index + 1;
-
-        if (start_index == line.length() || 
-            end_index == string_t::npos) {
-          error("Chat message file parsing error");
-          return false;
+      } else {
+        // Lazily loaded chat rooms are read once, and not kept.
+        vector<ChatMessage> chat_messages;
+        if (!partitioned_log_->LoadChatRoom(chat_room, &chat_messages)) {
+          error("Parsing error of chat room: {}", ToUtf8(chat_room));
+          is_complete = false;
+          continue;
+        }
+        for (ChatMessage& chat_message : chat_messages) {
+          user_ids.push_back(move(chat_message.user_id));
         }
       }
+      sort(user_ids.begin(), user_ids.end());
+      user_ids.erase(unique(user_ids.begin(), user_ids.end()),
+                     user_ids.end());
+      for (ChatString& user_id : user_ids) {
+        user_index_.AddChatRoom(user_id, chat_room);
+        user_chat_rooms.push_back({move(user_id), chat_room});
+      }
+    }
+    // Without a chat room, the next initialization builds them again.
+    if (is_complete) {
+      partitioned_log_->RewriteUserChatRooms(user_chat_rooms);
+    }
+  }
 
-      message.chat_message = line.substr(start_index);
-      // Too many delimiters in the line.
-      if (message.chat_message.find(kParsingDelimiter) != string_t::npos) {
-        error("Chat message file parsing error");
+  bool ChatDatabase::StorePartitionedChatMessages(
+      const vector<ChatMessage>& messages,
+      set<ChatString>* out_stored_chat_rooms) {
+    // Loaded before any partition lock is held, so room is made for them.
+    LoadChatRooms(messages);
+    // The views point into messages, which outlive the map.
+    map<ChatStringView, vector<const ChatMessage*>> chat_room_messages;
+    for (const ChatMessage& message : messages) {
+      chat_room_messages[message.chat_room].push_back(&message);
+    }
+    // Nothing is appended before every chat room has its partition.
+    vector<PartitionedChatLog::Partition*> partitions;
+    for (const auto& chat_room_message : chat_room_messages) {
+      PartitionedChatLog::Partition* const partition =
+          partitioned_log_->GetPartition(ChatString(chat_room_message.first));
+      if (partition == nullptr) {
         return false;
       }
-      chat_messages_[message.chat_room].push_back(message);
+      partitions.push_back(partition);
+    }
+
+    bool is_stored = true;
+    auto partition = partitions.begin();
+    for (const auto& chat_room_message : chat_room_messages) {
+      const vector<const ChatMessage*>& room_messages =
+          chat_room_message.second;
+      const ChatString chat_room(chat_room_message.first);
+      if (!StoreChatRoomMessages(chat_room, room_messages, *partition++)) {
+        is_stored = false;
+      } else if (out_stored_chat_rooms != nullptr) {
+        out_stored_chat_rooms->insert(chat_room);
+      }
+    }
+    // Every partition lock is released.
+    EvictChatRooms();
+    return is_stored;
+  }
+
+  bool ChatDatabase::StoreChatRoomMessages(
+      const ChatString& chat_room,
+      const vector<const ChatMessage*>& room_messages,
+      PartitionedChatLog::Partition* partition) {
+    // Writers of other chat rooms hold other locks. The ids written to the
+    // file are the ones the chat room log gives, as no other writer of the
+    // chat room appends in between.
+    const lock_guard<InstrumentedMutex> lock(partition->mutex_append);
+    // The file is appended only after it is loaded. StoreChatMessages loads
+    // the chat room before, unless it is evicted since.
+    shared_ptr<ChatRoomLog> chat_room_log;
+    if (load_lazily_ &&
+        HydrateChatRoom(chat_room, &chat_room_log) != kLoadSuccess) {
+      return false;
+    }
+    if (chat_room_log == nullptr) {
+      chat_room_log = GetOrCreateChatRoomLog(chat_room);
+    }
+    RecordAccess(*chat_room_log);
+    uint64_t id = chat_room_log->GetSnapshot()->size();
+    ChatOutputStringStream lines;
+    vector<PartitionedChatLog::UserChatRoom> user_chat_rooms;
+    for (const ChatMessage* message : room_messages) {
+      ChatMessageLoader::FormatLine(*message, ++id, &lines);
+      if (!user_index_.HasChatRoom(message->user_id, chat_room) &&
+          none_of(user_chat_rooms.begin(), user_chat_rooms.end(),
+                  [message](const PartitionedChatLog::UserChatRoom& added) {
+            return added.user_id == message->user_id;
+          })) {
+        user_chat_rooms.push_back({message->user_id, chat_room});
+      }
+    }
+    // A new user of the chat room is saved before the chat messages, so a
+    // failed append leaves at worst a chat room without chat messages of
+    // the user, which GetUserChatMessages skips.
+    if (!user_chat_rooms.empty() &&
+        !partitioned_log_->AppendUserChatRooms(user_chat_rooms)) {
+      return false;
+    }
+    if (!PartitionedChatLog::AppendLines(*partition, lines.str())) {
+      error("Unable to write file: {}", to_utf8string(partition->file));
+      return false;
+    }
+    AppendToChatRoomLog(chat_room_log.get(), room_messages);
+    IndexChatRoom(chat_room, *chat_room_log);
+    return true;
+  }
+
+  bool ChatDatabase::DoesDelimiterExistInChatMessage(const ChatMessage& message) {
+    const ChatChar delimiter = kParsingDelimiter[0];
+    if (DelimiterScanner::Contains(message.chat_message, delimiter) ||
+      DelimiterScanner::Contains(message.user_id, delimiter) ||
+      DelimiterScanner::Contains(message.chat_room, delimiter)) {
+      return false;
     }
     return true;
   }
 
   bool ChatDatabase::ReadChatRoomFromFileDatabase(string_t chat_room_file) {
-    string_t line;
-    wifstream file(chat_room_file);
+    const lock_guard<InstrumentedMutex> lock(mutex_chat_rooms_);
+    ChatString line;
+    ChatInputFileStream file(chat_room_file);
     if (!file.is_open()) {
       error("Can't open chat room file: {}", to_utf8string(chat_room_file));
       return false;
@@ -190,7 +789,7 @@ namespace chatserver {
       getline(file, line);
       if (line.length() == 0) continue;
       if (!IsExistChatRoom(line)) {
-        chat_rooms_.push_back(line);
+        AppendChatRoom(line);
       } else {
         error("Duplicate chat room name");
         return false;
@@ -200,4 +799,270 @@ namespace chatserver {
     return true;
   }
 
+  ChatDatabase::LoadResult ChatDatabase::FindChatRoomLog(
+      const ChatString& chat_room,
+      shared_ptr<ChatRoomLog>* out_chat_room_log) const {
+    *out_chat_room_log = FindLoadedChatRoomLog(chat_room);
+    if (!load_lazily_) {
+      return kLoadSuccess;
+    }
+    if (*out_chat_room_log == nullptr) {
+      const LoadResult load_result =
+          HydrateChatRoom(chat_room, out_chat_room_log);
+      if (load_result != kLoadSuccess) {
+        return load_result;
+      }
+    }
+    if (*out_chat_room_log != nullptr) {
+      RecordAccess(**out_chat_room_log);
+    }
+    return kLoadSuccess;
+  }
+
+  shared_ptr<ChatRoomLog> ChatDatabase::FindLoadedChatRoomLog(
+      const ChatString& chat_room) const {
+    const shared_ptr<const ChatRoomLogMap> chat_room_logs =
+        atomic_load(&chat_room_logs_);
+    const auto chat_room_log = chat_room_logs->find(chat_room);
+    if (chat_room_log == chat_room_logs->end()) {
+      return nullptr;
+    }
+    return chat_room_log->second;
+  }
+
+  shared_ptr<ChatRoomLog> ChatDatabase::GetOrCreateChatRoomLog(
+      const ChatString& chat_room) {
+    shared_ptr<ChatRoomLog> chat_room_log = FindLoadedChatRoomLog(chat_room);
+    if (chat_room_log != nullptr) {
+      return chat_room_log;
+    }
+
+    // Another writer may have created it before the lock.
+    const lock_guard<InstrumentedMutex> lock(mutex_chat_rooms_);
+    return AddChatRoomLog(chat_room, make_shared<ChatRoomLog>(chunk_pool_));
+  }
+
+  shared_ptr<ChatRoomLog> ChatDatabase::AddChatRoomLog(
+      const ChatString& chat_room,
+      shared_ptr<ChatRoomLog> chat_room_log) const {
+    const shared_ptr<ChatRoomLog> found_chat_room_log =
+        FindLoadedChatRoomLog(chat_room);
+    if (found_chat_room_log != nullptr) {
+      return found_chat_room_log;
+    }
+    auto chat_room_logs =
+        make_shared<ChatRoomLogMap>(*atomic_load(&chat_room_logs_));
+    chat_room_logs->emplace(chat_room, chat_room_log);
+    atomic_store(&chat_room_logs_,
+                 shared_ptr<const ChatRoomLogMap>(move(chat_room_logs)));
+    return chat_room_log;
+  }
+
+  ChatDatabase::LoadResult ChatDatabase::HydrateChatRoom(
+      const ChatString& chat_room,
+      shared_ptr<ChatRoomLog>* out_chat_room_log) const {
+    promise<Hydration> hydrated;
+    shared_future<Hydration> hydration;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_hydrations_);
+      const auto found_hydration = hydrations_.find(chat_room);
+      if (found_hydration != hydrations_.end()) {
+        hydration = found_hydration->second;
+      } else {
+        hydrations_.emplace(chat_room, hydrated.get_future().share());
+      }
+    }
+    if (hydration.valid()) {
+      // Loaded, or being loaded by another thread. The log is kept even if
+      // it is evicted in the meantime.
+      *out_chat_room_log = hydration.get().chat_room_log;
+      return hydration.get().load_result;
+    }
+
+    CHATSERVER_TRACE_SPAN("ChatDatabase::HydrateChatRoom");
+    // A chat room whose log file can never fit the budget is not read.
+    const uint64_t memory_budget = memory_budget_;
+    vector<ChatMessage> chat_messages;
+    LoadResult load_result = kLoadSuccess;
+    if (memory_budget != 0 &&
+        partitioned_log_->GetLogFileSize(chat_room) > memory_budget) {
+      error("Chat room is larger than the memory budget: {}",
+            ToUtf8(chat_room));
+      load_result = kLoadOverMemoryBudget;
+    } else if (!partitioned_log_->LoadChatRoom(chat_room, &chat_messages)) {
+      error("Parsing error of chat room: {}", ToUtf8(chat_room));
+      load_result = kLoadError;
+    }
+    if (load_result != kLoadSuccess) {
+      {
+        const lock_guard<InstrumentedMutex> lock(mutex_hydrations_);
+        hydrations_.erase(chat_room);
+      }
+      hydrated.set_value({load_result, nullptr});
+      return load_result;
+    }
+    shared_ptr<ChatRoomLog> chat_room_log;
+    if (!chat_messages.empty()) {
+      // The log is indexed and filled before readers can find it.
+      chat_room_log = make_shared<ChatRoomLog>(chunk_pool_);
+      AppendToChatRoomLog(chat_room_log.get(), chat_messages);
+      IndexChatRoom(chat_room, *chat_room_log);
+      const lock_guard<InstrumentedMutex> lock(mutex_chat_rooms_);
+      AddChatRoomLog(chat_room, chat_room_log);
+    }
+    hydrated.set_value({kLoadSuccess, chat_room_log});
+    *out_chat_room_log = move(chat_room_log);
+    return kLoadSuccess;
+  }
+
+  void ChatDatabase::EvictChatRooms() const {
+    EvictChatRooms(0);
+  }
+
+  uint64_t ChatDatabase::EvictChatRoomsBeforeLoad(
+      const ChatString& chat_room) const {
+    if (!load_lazily_ || memory_budget_ == 0 ||
+        FindLoadedChatRoomLog(chat_room) != nullptr) {
+      return 0;
+    }
+    // The log file size estimates the bytes of the chat room.
+    const uint64_t reserved_bytes = partitioned_log_->GetLogFileSize(chat_room);
+    EvictChatRooms(reserved_bytes);
+    return reserved_bytes;
+  }
+
+  void ChatDatabase::EvictChatRooms(uint64_t reserved_bytes) const {
+    const uint64_t memory_budget = memory_budget_;
+    if (!load_lazily_ || memory_budget == 0) {
+      reserved_memory_ += reserved_bytes;
+      return;
+    }
+    // A reservation is checked and made under the lock, so every chat room
+    // being loaded is evicted for.
+    if (reserved_bytes == 0 &&
+        GetMemoryUsage() + reserved_memory_ <= memory_budget) {
+      return;
+    }
+    vector<ChatString> evicted_chat_rooms;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_eviction_);
+      CHATSERVER_TRACE_SPAN("ChatDatabase::EvictChatRooms");
+      // The least recently accessed chat rooms first.
+      vector<pair<int64_t, ChatString>> chat_rooms;
+      const shared_ptr<const ChatRoomLogMap> chat_room_logs =
+          atomic_load(&chat_room_logs_);
+      for (const auto& chat_room_log : *chat_room_logs) {
+        chat_rooms.emplace_back(chat_room_log.second->GetLastAccessTime(),
+                                chat_room_log.first);
+      }
+      sort(chat_rooms.begin(), chat_rooms.end());
+      for (const auto& chat_room : chat_rooms) {
+        if (GetMemoryUsage() + reserved_memory_ + reserved_bytes <=
+            memory_budget) {
+          break;
+        }
+        if (EvictChatRoom(chat_room.second)) {
+          evicted_chat_rooms.push_back(chat_room.second);
+        }
+      }
+      reserved_memory_ += reserved_bytes;
+    }
+
+    // The partition locks and mutex_eviction_ are released, so the callback
+    // never takes its locks inside them.
+    const lock_guard<InstrumentedMutex> lock(mutex_evicted_callback_);
+    if (on_evicted_ != nullptr) {
+      for (const ChatString& chat_room : evicted_chat_rooms) {
+        on_evicted_(chat_room);
+      }
+    }
+  }
+
+  bool ChatDatabase::EvictChatRoom(const ChatString& chat_room) const {
+    // Writers of the chat room finish first, so the log file has every chat
+    // message of the log.
+    PartitionedChatLog::Partition* const partition =
+        partitioned_log_->GetPartition(chat_room);
+    if (partition == nullptr) {
+      return false;
+    }
+    const lock_guard<InstrumentedMutex> append_lock(partition->mutex_append);
+    const shared_ptr<ChatRoomLog> chat_room_log =
+        FindLoadedChatRoomLog(chat_room);
+    if (chat_room_log == nullptr) {
+      return false;
+    }
+
+    // The indexes are dropped before the log, so a reload loads the saved
+    // search index. Meanwhile readers of the log scan it instead.
+    const uint64_t index_memory_usage = GetIndexMemoryUsage(chat_room);
+    if (!search_index_.SaveChatRoom(chat_room, partition->index_file)) {
+      error("Unable to save the search index of chat room: {}",
+            ToUtf8(chat_room));
+    }
+    search_index_.EraseChatRoom(chat_room);
+    user_index_.EraseChatRoom(chat_room);
+    // The load is forgotten before the log, so a reader finds one of them.
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_hydrations_);
+      hydrations_.erase(chat_room);
+    }
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_chat_rooms_);
+      auto chat_room_logs =
+          make_shared<ChatRoomLogMap>(*atomic_load(&chat_room_logs_));
+      chat_room_logs->erase(chat_room);
+      atomic_store(&chat_room_logs_,
+                   shared_ptr<const ChatRoomLogMap>(move(chat_room_logs)));
+    }
+    chat_message_count_ -= chat_room_log->GetSnapshot()->size();
+    memory_usage_ -= chat_room_log->GetMemoryUsage() + index_memory_usage;
+    return true;
+  }
+
+  void ChatDatabase::IndexChatRoom(const ChatString& chat_room,
+                                   const ChatRoomLog& chat_room_log) const {
+    const shared_ptr<const ChatRoomSnapshot> snapshot =
+        chat_room_log.GetSnapshot();
+    const uint64_t index_memory_usage = GetIndexMemoryUsage(chat_room);
+    if (partitioned_log_ != nullptr) {
+      LoadChatRoomIndex(chat_room);
+    }
+    search_index_.IndexChatRoom(chat_room, *snapshot);
+    user_index_.IndexChatRoom(chat_room, *snapshot);
+    memory_usage_ += GetIndexMemoryUsage(chat_room) - index_memory_usage;
+  }
+
+  uint64_t ChatDatabase::GetIndexMemoryUsage(
+      const ChatString& chat_room) const {
+    return search_index_.GetMemoryUsage(chat_room) +
+           user_index_.GetMemoryUsage(chat_room);
+  }
+
+  void ChatDatabase::AppendChatMessages(const vector<ChatMessage>& messages) {
+    // The views point into messages, which outlive the map.
+    map<ChatStringView, vector<const ChatMessage*>> chat_room_messages;
+    for (const ChatMessage& message : messages) {
+      chat_room_messages[message.chat_room].push_back(&message);
+    }
+    for (const auto& chat_room_message : chat_room_messages) {
+      const vector<const ChatMessage*>& room_messages =
+          chat_room_message.second;
+      const ChatString chat_room(room_messages.front()->chat_room);
+      const shared_ptr<ChatRoomLog> chat_room_log =
+          GetOrCreateChatRoomLog(chat_room);
+      AppendToChatRoomLog(chat_room_log.get(), room_messages);
+      // The whole batch of the chat room is indexed at once.
+      IndexChatRoom(chat_room, *chat_room_log);
+    }
+  }
+
+  void ChatDatabase::AppendChatRoom(const ChatString& chat_room) {
+    auto chat_rooms =
+        make_shared<vector<ChatString>>(*atomic_load(&chat_rooms_));
+    chat_rooms->push_back(chat_room);
+    atomic_store(&chat_rooms_,
+                 shared_ptr<const vector<ChatString>>(move(chat_rooms)));
+  }
+
 } // namespace chatserver
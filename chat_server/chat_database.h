@@ -5,11 +5,25 @@
 #ifndef CHATSERVER_CHATDATABASE_H_
 #define CHATSERVER_CHATDATABASE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <set>
 #include <vector>
 
 #include "cpprest/details/basic_types.h"
 #include "chat_message.h"
+#include "chat_message_chunk_pool.h"
+#include "chat_room_log.h"
+#include "chat_search_index.h"
+#include "chat_user_index.h"
+#include "chat_string.h"
+#include "instrumented_mutex.h"
+#include "partitioned_chat_log.h"
 
 // This class is designed to manage chat messages and rooms. It uses two file
 // databases for chat messages and rooms.
@@ -36,55 +50,402 @@
 //     do something to fail to create the chat room
 //   }
 // The usage with GetChatList() function is similar to the above.
+// Reads are lock-free: chat messages and chat rooms are read from immutable
+// snapshots that writers replace atomically, so a reader never waits for a
+// writer. The chat messages are kept in a single file, or in a file per chat
+// room with InitializePartitioned, and are indexed for search and by user.
 
 namespace chatserver {
 
   class ChatDatabase {
    public:
-    // Read chat messages and chat rooms from given file into database.
+    // Memory usage of a loaded chat room.
+    struct ChatRoomMemoryUsage {
+      ChatString chat_room;
+      uint64_t bytes;
+    };
+
+    // Result of loading the chat messages of a chat room.
+    typedef enum {
+      kLoadSuccess,
+      // The log file of the chat room is larger than the memory budget.
+      kLoadOverMemoryBudget,
+      // The log file of the chat room can't be read or parsed.
+      kLoadError
+    } LoadResult;
+
+    // Called after a chat room is evicted.
+    typedef std::function<void(const ChatString& chat_room)> EvictedCallback;
+
+    // Name mutex_chat_rooms_, mutex_store_, mutex_eviction_,
+    // mutex_evicted_callback_ and mutex_hydrations_ for lock profiling.
+    ChatDatabase();
+
+    // Read chat messages and chat rooms from given file into database, and
+    // load the search index saved with the chat message file. Only the chat
+    // messages stored after the save are indexed again.
     bool Initialize(utility::string_t chat_message_file,
                     utility::string_t chat_room_file);
 
-    // Store chat message on the database.
+    // Read chat messages from the given partitioned directory, one thread per
+    // core, and chat rooms from the given file into database. The directory
+    // is created if there is none. Writers of different chat rooms append to
+    // different files under different locks. The search index of each chat
+    // room is saved next to its log file and loaded with the chat room.
+    // If load_lazily is true, only the manifest and the chat room file are
+    // read here, and the chat messages of a chat room are read on its first
+    // read or write instead. Concurrent first accesses wait for a single load.
+    bool InitializePartitioned(utility::string_t chat_log_directory,
+                               utility::string_t chat_room_file,
+                               bool load_lazily);
+
+    // Store chat message on the database. Its id is given by the database,
+    // and its timestamp is the date if it has none.
     bool StoreChatMessage(const ChatMessage& message);
 
-    // Get all chat messages in the given chat room.
-    const std::vector<ChatMessage>* GetAllChatMessages(
-        utility::string_t chat_room);
+    // Store the given chat messages on the database with a single append to
+    // the chat message file. Nothing is stored if any chat message has a
+    // prohibited character or a chat room that does not exist.
+    // If the database is partitioned, each chat room gets a single append to
+    // its own file, and a failed append stores nothing of its chat room only.
+    bool StoreChatMessages(const std::vector<ChatMessage>& messages);
+
+    // Store the given chat messages like the above. Return true if every
+    // chat message is stored. Otherwise, the chat rooms whose chat messages
+    // are stored anyway are added to out_stored_chat_rooms, so
+    // ChatMessageSequencer fails only the submissions of the other ones.
+    bool StoreChatMessages(const std::vector<ChatMessage>& messages,
+                           std::set<ChatString>* out_stored_chat_rooms);
+
+    // Load the chat rooms of the given chat messages if the database loads
+    // lazily, e.g. on a request thread before another thread stores them, so
+    // the storing thread rarely reads a chat room file.
+    void LoadChatRooms(const std::vector<ChatMessage>& messages) const;
+
+    // Get a snapshot of all chat messages in the given chat room. Chat
+    // messages stored later are not in it. Lock-free. Return nullptr if the
+    // chat room can't be loaded.
+    std::shared_ptr<const ChatRoomSnapshot> GetAllChatMessages(
+        ChatString chat_room) const;
 
-    // Create the chat room.
-    bool CreateChatRoom(utility::string_t chat_room);
+    // Get a snapshot like the above, and set out_load_result to kLoadSuccess,
+    // or to why the chat room can't be loaded, e.g. to tell an unreadable
+    // chat room from an empty one.
+    std::shared_ptr<const ChatRoomSnapshot> GetAllChatMessages(
+        ChatString chat_room,
+        LoadResult* out_load_result) const;
+
+    // Create the chat room. Return false if it exists, or its name is empty
+    // or has '|', ',' or ':', which separate the chat rooms of a list.
+    bool CreateChatRoom(ChatString chat_room);
 
     // Check the given chat room exists.
-    bool IsExistChatRoom(utility::string_t chat_room) const;
+    bool IsExistChatRoom(const ChatString& chat_room) const;
+
+    // Get a snapshot of every chat room list. Lock-free.
+    std::shared_ptr<const std::vector<ChatString>> GetChatRoomList() const;
+
+    // Append the latest limit chat messages of the given chat room that match
+    // the query to out_chat_messages, oldest first. Return the snapshot they
+    // point into; keep it while they are used. Return nullptr and set
+    // out_load_result if the chat room can't be loaded.
+    std::shared_ptr<const ChatRoomSnapshot> SearchChatMessages(
+        const ChatString& chat_room,
+        const ChatSearchQuery& query,
+        size_t limit,
+        std::pmr::vector<ChatMessageView>* out_chat_messages,
+        LoadResult* out_load_result) const;
+
+    // Append the latest limit chat messages of every chat room that match
+    // the query to out_chat_messages, oldest first. Return the snapshots
+    // they point into; keep them while they are used. The chat rooms are
+    // searched one at a time, and only the snapshots of the chat messages
+    // kept so far are held. If a chat room can't be loaded, nothing is
+    // appended, and out_load_result tells why. A database that loads lazily
+    // searches only its loaded chat rooms and loads none; the others are
+    // searched one at a time with SearchChatMessages.
+    std::vector<std::shared_ptr<const ChatRoomSnapshot>> SearchAllChatMessages(
+        const ChatSearchQuery& query,
+        size_t limit,
+        std::pmr::vector<ChatMessageView>* out_chat_messages,
+        LoadResult* out_load_result) const;
+
+    // Save the search index to the chat message file name plus ".index", or
+    // that of each loaded chat room to its log file name plus ".index" in the
+    // partitioned directory.
+    bool SaveSearchIndex() const;
+
+    // Append the latest limit chat messages of the given user in every chat
+    // room to out_chat_messages, oldest first. Return the snapshots they
+    // point into; keep them while they are used. The chat rooms of the user
+    // are loaded if they are not, one at a time, and only the snapshots of
+    // the chat messages kept so far are held. If a chat room can't be
+    // loaded, nothing is appended, and out_load_result tells why.
+    std::vector<std::shared_ptr<const ChatRoomSnapshot>> GetUserChatMessages(
+        const ChatString& user_id,
+        size_t limit,
+        std::pmr::vector<ChatMessageView>* out_chat_messages,
+        LoadResult* out_load_result) const;
+
+    // Get the version of the given chat room. The version increases whenever
+    // a chat message is stored in the chat room. It is the number of chat
+    // messages, so the size of a snapshot is its version. Return 0 for a
+    // chat room without chat messages, or that can't be loaded.
+    uint64_t GetChatRoomVersion(ChatString chat_room) const;
 
-    // Get every chat room list.
-    const std::vector<utility::string_t>* GetChatRoomList() const;
+    // Get the version of the chat room list. The version increases whenever
+    // a chat room is created.
+    uint64_t GetChatRoomListVersion() const;
+
+    // Get the number of chat messages in every chat room. If the database
+    // loads lazily, only the loaded chat rooms are counted.
+    uint64_t GetChatMessageCount() const;
+
+    // Set the bytes the loaded chat rooms may take, or 0 for no budget, and
+    // evict chat rooms to fit it. Only a database that loads lazily evicts:
+    // the least recently accessed chat rooms are dropped from memory while
+    // the usage is over the budget, and read from their files again on the
+    // next access. A snapshot of an evicted chat room stays valid while a
+    // reader holds it. Chat rooms are evicted before a chat room is loaded,
+    // to fit its log file size, and again after it, as the file size only
+    // estimates its bytes. A chat room whose log file is larger than the
+    // budget is not loaded: reads of it get kLoadOverMemoryBudget, and
+    // stores to it fail.
+    void SetMemoryBudget(uint64_t memory_budget);
+
+    // Get the memory budget, or 0 if there is none.
+    uint64_t GetMemoryBudget() const;
+
+    // Get the bytes of every loaded chat room: the chunks, the directories
+    // and the text arena blocks of its log, and its search and user indexes,
+    // and the bytes of the free chunks kept for reuse, at most a sixteenth
+    // of the budget. The chat rooms of every user, the snapshots readers
+    // still hold after an eviction, and the memory of callers are not
+    // counted.
+    uint64_t GetMemoryUsage() const;
+
+    // Get the bytes of each loaded chat room, with its indexes, in chat room
+    // order.
+    std::vector<ChatRoomMemoryUsage> GetChatRoomMemoryUsages() const;
+
+    // Set the function called after a chat room is evicted, or nullptr for
+    // none, e.g. to drop what a caller keeps for the chat room. It is called
+    // by one thread at a time, and never after this returns with another
+    // one. No lock of the database is held while it runs.
+    void SetEvictedCallback(EvictedCallback on_evicted);
 
     // Check whether a delimiter exists in ChatMessage.
     bool DoesDelimiterExistInChatMessage(const ChatMessage& message);
 
    private:
-    // Read chat messages from the given file into database.
+    // Read chat messages from the given file into database. The file is
+    // parsed in parallel by ChatMessageLoader.
+    // Format: timestamp|id|user_id|chat_room|chat_message, or
+    // date|user_id|chat_room|chat_message.
     bool ReadChatMessagesFromFileDatabase(utility::string_t chat_message_file);
 
-    // Parse chat message file. Format: date|user_id|chat_room|chat_message.
-    bool ParsingChatMessageFile(std::wifstream chat_message_file);
+    // Read the chat messages of every chat room of partitioned_log_ into
+    // database. Each thread takes the next chat room until none is left.
+    bool ReadChatMessagesFromPartitionedLog();
+
+    // Load the search index from search_index_file_, or that of each loaded
+    // chat room if the database is partitioned, and index the chat messages
+    // that are not in it.
+    void IndexChatMessages();
+
+    // Load the saved search index of the given chat room from its partition,
+    // unless the chat room is indexed.
+    void LoadChatRoomIndex(const ChatString& chat_room) const;
+
+    // Read the chat rooms of every user from partitioned_log_ into the user
+    // index. If none are saved, e.g. in a directory made by an older version,
+    // they are collected from every chat room and saved once.
+    void ReadUserChatRooms();
+
+    // Store the given chat messages in partitioned_log_ and the chat room
+    // logs, one chat room at a time. The partitions of every chat room are
+    // made first, so nothing is stored if one can't be made. A failed append
+    // of a chat room does not stop the others, which are added to
+    // out_stored_chat_rooms.
+    bool StorePartitionedChatMessages(
+        const std::vector<ChatMessage>& messages,
+        std::set<ChatString>* out_stored_chat_rooms);
+
+    // Append the chat messages of the given chat room to its partition and
+    // log, and index them. Return false if nothing is stored.
+    bool StoreChatRoomMessages(
+        const ChatString& chat_room,
+        const std::vector<const ChatMessage*>& room_messages,
+        PartitionedChatLog::Partition* partition);
 
     // Read chat rooms from the given file into database.
     bool ReadChatRoomFromFileDatabase(utility::string_t chat_room_file);
 
-    // Chat message database: std::map<chat room, ChatMessage>.
-    std::map<utility::string_t, std::vector<ChatMessage>> chat_messages_;
+    // Chat message logs: std::map<chat room, ChatRoomLog>.
+    typedef std::map<ChatString, std::shared_ptr<ChatRoomLog>> ChatRoomLogMap;
+
+    // Get the log of the given chat room, and load it first if the database
+    // loads lazily. Set out_chat_room_log to nullptr if the chat room has no
+    // chat messages, or can't be loaded, and return why it can't. Lock-free
+    // once the chat room is loaded. The access is recorded for eviction.
+    LoadResult FindChatRoomLog(
+        const ChatString& chat_room,
+        std::shared_ptr<ChatRoomLog>* out_chat_room_log) const;
+
+    // Get the log of the given chat room if it is in chat_room_logs_.
+    // Lock-free.
+    std::shared_ptr<ChatRoomLog> FindLoadedChatRoomLog(
+        const ChatString& chat_room) const;
+
+    // Get the log of the given chat room, and create it if there is none. If
+    // the database loads lazily, the chat room must be loaded first.
+    std::shared_ptr<ChatRoomLog> GetOrCreateChatRoomLog(
+        const ChatString& chat_room);
+
+    // Add the given log of the chat room to chat_room_logs_, unless the chat
+    // room has one, and return the chat room's log. mutex_chat_rooms_ must
+    // be held.
+    std::shared_ptr<ChatRoomLog> AddChatRoomLog(
+        const ChatString& chat_room,
+        std::shared_ptr<ChatRoomLog> chat_room_log) const;
 
-    // Store chat room list.
-    std::vector<utility::string_t> chat_rooms_;
+    // Load the chat messages of the given chat room from partitioned_log_ on
+    // its first access, and get its log, or nullptr if it has no chat
+    // messages. The first caller loads them, and the others wait for it.
+    // Return kLoadError if the log file can't be read, or
+    // kLoadOverMemoryBudget if it is larger than the memory budget; the next
+    // access tries again.
+    LoadResult HydrateChatRoom(
+        const ChatString& chat_room,
+        std::shared_ptr<ChatRoomLog>* out_chat_room_log) const;
+
+    // Append the given chat messages to the chat room log, and count them
+    // and their bytes. Writers of the chat room must be serialized.
+    template <typename ChatMessages>
+    void AppendToChatRoomLog(ChatRoomLog* chat_room_log,
+                             const ChatMessages& chat_messages) const;
+
+    // Evict the least recently accessed chat rooms until the loaded ones fit
+    // the memory budget. No lock may be held, as a chat room is evicted
+    // after its writers finish.
+    void EvictChatRooms() const;
+
+    // Evict chat rooms like the above until the loaded ones, the bytes
+    // reserved for chat rooms being loaded and the given bytes fit the memory
+    // budget, and reserve the given bytes. The caller releases them from
+    // reserved_memory_ once its chat room is loaded. Blocks while another
+    // thread evicts.
+    void EvictChatRooms(uint64_t reserved_bytes) const;
+
+    // Evict chat rooms like the above to reserve the log file size of the
+    // given chat room, unless it is loaded, so it fits the budget once it is.
+    // Return the reserved bytes.
+    uint64_t EvictChatRoomsBeforeLoad(const ChatString& chat_room) const;
+
+    // Save and drop the indexes and the log of the given chat room, so the
+    // next access loads them again. Return false if it is not loaded.
+    // mutex_eviction_ must be held.
+    bool EvictChatRoom(const ChatString& chat_room) const;
+
+    // Index the chat messages of the chat room log that are not indexed, for
+    // search and by user, and count the bytes the indexes take. If the
+    // database is partitioned, the saved search index of the chat room is
+    // loaded first. Indexers of the chat room must be serialized.
+    void IndexChatRoom(const ChatString& chat_room,
+                       const ChatRoomLog& chat_room_log) const;
+
+    // Get the bytes of the search and user indexes of the given chat room.
+    uint64_t GetIndexMemoryUsage(const ChatString& chat_room) const;
+
+    // Add the chat messages to their chat room logs. Each chat room log is
+    // locked and published once, with its chat messages in the given order.
+    void AppendChatMessages(const std::vector<ChatMessage>& messages);
+
+    // Add the chat room to chat_rooms_. mutex_chat_rooms_ must be held.
+    void AppendChatRoom(const ChatString& chat_room);
+
+    // Chunks of every chat room log.
+    const std::shared_ptr<ChatMessageChunkPool> chunk_pool_;
+
+    // Mutex for writers of chat_room_logs_ and chat_rooms_.
+    mutable InstrumentedMutex mutex_chat_rooms_;
+
+    // Mutex for writers of chat messages. The chat message file and the
+    // chat room logs get the chat messages in the same order, with the same
+    // ids.
+    InstrumentedMutex mutex_store_;
+
+    // Chat message database. The map is copied when a chat room log is
+    // added. Read and written only with std::atomic_load and
+    // std::atomic_store. It, the indexes and chat_message_count_ are mutable,
+    // as const readers load chat rooms if the database loads lazily.
+    mutable std::shared_ptr<const ChatRoomLogMap> chat_room_logs_;
+
+    // Store chat room list. The list is copied when a chat room is added.
+    // Read and written only with std::atomic_load and std::atomic_store.
+    std::shared_ptr<const std::vector<ChatString>> chat_rooms_;
+
+    // Inverted index of the chat messages in chat_room_logs_.
+    mutable ChatSearchIndex search_index_;
+
+    // Index of the chat messages in chat_room_logs_ by user. The chat rooms
+    // every user posted to stay in it when their chat rooms are evicted.
+    mutable ChatUserIndex user_index_;
+
+    // Number of chat messages in chat_room_logs_.
+    mutable std::atomic<uint64_t> chat_message_count_;
+
+    // Bytes of the chat room logs in chat_room_logs_ and of their indexes.
+    mutable std::atomic<uint64_t> memory_usage_;
+
+    // Bytes reserved for the chat rooms being loaded, by their log file
+    // sizes.
+    mutable std::atomic<uint64_t> reserved_memory_;
+
+    // Bytes chat_room_logs_ may take, or 0 if there is no budget.
+    std::atomic<uint64_t> memory_budget_;
+
+    // Mutex for evicting chat rooms. One thread evicts at a time.
+    mutable InstrumentedMutex mutex_eviction_;
+
+    // Mutex for on_evicted_, held while it is called. It is taken after the
+    // other locks of an eviction are released, so on_evicted_ may take locks
+    // of its own, e.g. the one of a cache.
+    mutable InstrumentedMutex mutex_evicted_callback_;
+
+    // Called after a chat room is evicted, or nullptr.
+    EvictedCallback on_evicted_;
 
     // Chat message file database name.
     utility::string_t chat_message_file_;
 
     // Chat room file database name.
     utility::string_t chat_room_file_;
+
+    // Search index file name, if the database is not partitioned.
+    utility::string_t search_index_file_;
+
+    // Partitioned chat message database, or nullptr if the chat messages are
+    // in chat_message_file_.
+    std::unique_ptr<PartitionedChatLog> partitioned_log_;
+
+    // Whether chat rooms of partitioned_log_ are loaded on first access.
+    bool load_lazily_;
+
+    // Result of loading a chat room, and its log, or nullptr if it has no
+    // chat messages or can't be loaded.
+    struct Hydration {
+      LoadResult load_result;
+      std::shared_ptr<ChatRoomLog> chat_room_log;
+    };
+
+    // Mutex for hydrations_.
+    mutable InstrumentedMutex mutex_hydrations_;
+
+    // chat room -> its load, if the database loads lazily. A chat room stays
+    // until it is evicted, so later accesses of a chat room without chat
+    // messages don't read its file again.
+    mutable std::map<ChatString, std::shared_future<Hydration>> hydrations_;
   };
 
 } // namespace chatserver
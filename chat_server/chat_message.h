@@ -5,24 +5,32 @@
 #ifndef CHATSERVER_CHATMESSAGE_H_
 #define CHATSERVER_CHATMESSAGE_H_
 
+#include <cstdint>
 #include <ctime>
 
-#include "cpprest/details/basic_types.h"
+#include "chat_string.h"
 
 // Chat message information structure (date, user_id, chat_room, chat_message)
+// A stored chat message also has a server timestamp in microseconds and an
+// id, its sequence number in the chat room from 1. Chat messages of a chat
+// room are totally ordered by id.
+// ChatMessageView is a chat message whose text is kept elsewhere. It is valid
+// as long as the text is.
 
 namespace chatserver {
 
   struct ChatMessage {
+    static const int64_t kMicrosecondsPerSecond = 1000000;
+
     // Constructor with no parameters.
     ChatMessage() {
     }
 
     // Constructor with all parameters.
     ChatMessage(std::time_t date, 
-                utility::string_t user_id, 
-                utility::string_t chat_room, 
-                utility::string_t chat_message)
+                ChatString user_id, 
+                ChatString chat_room, 
+                ChatString chat_message)
                 : date(date),
                   user_id(user_id),
                   chat_room(chat_room),
@@ -33,13 +41,28 @@ namespace chatserver {
     std::time_t date;
 
     // Who is generating chat message
-    utility::string_t user_id;
+    ChatString user_id;
 
     // What chat room was created in the chat room
-    utility::string_t chat_room;
+    ChatString chat_room;
 
     // Chat message contents
-    utility::string_t chat_message;
+    ChatString chat_message;
+
+    // Server time in microseconds since the Unix epoch, or 0 if it is not
+    // set. date is its seconds.
+    int64_t timestamp = 0;
+
+    // Sequence number in the chat room, or 0 until the chat message is
+    // stored.
+    uint64_t id = 0;
+
+    // Get the timestamp, or the date in microseconds if it is not set.
+    int64_t GetTimestamp() const {
+      return timestamp != 0
+          ? timestamp
+          : static_cast<int64_t>(date) * kMicrosecondsPerSecond;
+    }
 
     bool operator==(const ChatMessage& compare_chat_message) const {
       return (compare_chat_message.chat_room == chat_room &&
@@ -56,6 +79,35 @@ namespace chatserver {
     }
   };
 
+  struct ChatMessageView {
+    // Copy the text into a ChatMessage.
+    ChatMessage ToChatMessage() const {
+      ChatMessage result(date, ChatString(user_id), ChatString(chat_room),
+                         ChatString(chat_message));
+      result.timestamp = timestamp;
+      result.id = id;
+      return result;
+    }
+
+    // Chat message input time
+    std::time_t date = 0;
+
+    // Who is generating chat message
+    ChatStringView user_id;
+
+    // What chat room was created in the chat room
+    ChatStringView chat_room;
+
+    // Chat message contents
+    ChatStringView chat_message;
+
+    // Server time in microseconds since the Unix epoch.
+    int64_t timestamp = 0;
+
+    // Sequence number in the chat room.
+    uint64_t id = 0;
+  };
+
 } // namespace chatserver
 
 #endif CHATSERVER_CHATMESSAGE_H_ // CHATSERVER_CHATMESSAGE_H_
\ No newline at end of file
@@ -0,0 +1,88 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "chat_message_chunk_pool.h"
+
+#include <limits>
+#include <mutex>
+
+using namespace std;
+
+namespace chatserver {
+
+  const size_t ChatMessageChunk::kCapacity;
+
+  ChatMessageChunkPool::ChatMessageChunkPool()
+      : mutex_free_chunks_("ChatMessageChunkPool::mutex_free_chunks_"),
+        free_chunk_count_(0),
+        max_free_chunk_count_(numeric_limits<size_t>::max()) {
+  }
+
+  ChatMessageChunkPool::~ChatMessageChunkPool() {
+    while (free_chunks_ != nullptr) {
+      ChatMessageChunk* const chunk = free_chunks_;
+      free_chunks_ = chunk->next;
+      delete chunk;
+    }
+  }
+
+  ChatMessageChunk* ChatMessageChunkPool::Allocate() {
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_free_chunks_);
+      if (free_chunks_ != nullptr) {
+        ChatMessageChunk* const chunk = free_chunks_;
+        free_chunks_ = chunk->next;
+        --free_chunk_count_;
+        chunk->next = nullptr;
+        return chunk;
+      }
+    }
+    return new ChatMessageChunk();
+  }
+
+  void ChatMessageChunkPool::Free(ChatMessageChunk* chunk) {
+    // The text arena of the chat room log is released with the chunks, so
+    // no view of it is kept.
+    for (ChatMessageView& chat_message : chunk->chat_messages) {
+      chat_message = ChatMessageView();
+    }
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_free_chunks_);
+      if (free_chunk_count_ < max_free_chunk_count_) {
+        chunk->next = free_chunks_;
+        free_chunks_ = chunk;
+        ++free_chunk_count_;
+        return;
+      }
+    }
+    delete chunk;
+  }
+
+  void ChatMessageChunkPool::SetMaxFreeChunkCount(
+      size_t max_free_chunk_count) {
+    ChatMessageChunk* surplus_chunks = nullptr;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_free_chunks_);
+      max_free_chunk_count_ = max_free_chunk_count;
+      while (free_chunk_count_ > max_free_chunk_count_) {
+        ChatMessageChunk* const chunk = free_chunks_;
+        free_chunks_ = chunk->next;
+        --free_chunk_count_;
+        chunk->next = surplus_chunks;
+        surplus_chunks = chunk;
+      }
+    }
+    // Deleted without the lock.
+    while (surplus_chunks != nullptr) {
+      ChatMessageChunk* const chunk = surplus_chunks;
+      surplus_chunks = chunk->next;
+      delete chunk;
+    }
+  }
+
+  size_t ChatMessageChunkPool::GetFreeChunkCount() const {
+    return free_chunk_count_;
+  }
+
+} // namespace chatserver
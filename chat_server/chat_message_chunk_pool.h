@@ -0,0 +1,82 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CHATMESSAGECHUNKPOOL_H_
+#define CHATSERVER_CHATMESSAGECHUNKPOOL_H_
+
+#include <atomic>
+#include <cstddef>
+
+#include "chat_message.h"
+#include "instrumented_mutex.h"
+
+// ChatMessageChunkPool allocates fixed-size chunks of chat messages for
+// ChatRoomLog, and keeps freed chunks for reuse, so starting a chunk does
+// not call the allocator again. The chat messages of a chunk are views of
+// the text arena of the chat room log. Free chunks beyond the most it keeps
+// are deleted, and the others when the pool is destroyed.
+// The class is thread-safe.
+// Example:
+//   ChatMessageChunk* chunk = chunk_pool->Allocate();
+//   chunk->chat_messages[0] = chat_message;
+//   ...
+//   chunk_pool->Free(chunk);
+
+namespace chatserver {
+
+  struct ChatMessageChunk {
+    // Number of chat messages in a chunk.
+    static const size_t kCapacity = 64;
+
+    // Chat messages. The slots after the last appended one are empty.
+    ChatMessageView chat_messages[kCapacity];
+
+    // Next chunk of the chat room log, or of the free list of the pool.
+    ChatMessageChunk* next = nullptr;
+  };
+
+  class ChatMessageChunkPool {
+   public:
+    // Name mutex_free_chunks_ for lock profiling.
+    ChatMessageChunkPool();
+
+    // Delete the free chunks. Every allocated chunk must be freed before.
+    ~ChatMessageChunkPool();
+
+    ChatMessageChunkPool(const ChatMessageChunkPool&) = delete;
+    ChatMessageChunkPool& operator=(const ChatMessageChunkPool&) = delete;
+
+    // Get a chunk with empty chat messages.
+    ChatMessageChunk* Allocate();
+
+    // Empty the chat messages of the given chunk and keep it for reuse, or
+    // delete it if the pool keeps the most free chunks already.
+    void Free(ChatMessageChunk* chunk);
+
+    // Set the most free chunks kept for reuse, and delete the ones beyond
+    // it. There is no limit by default.
+    void SetMaxFreeChunkCount(size_t max_free_chunk_count);
+
+    // Get the number of chunks kept for reuse. Lock-free.
+    size_t GetFreeChunkCount() const;
+
+   private:
+    // Mutex for member variables: free_chunks_, free_chunk_count_ and
+    // max_free_chunk_count_.
+    mutable InstrumentedMutex mutex_free_chunks_;
+
+    // Chunks kept for reuse, linked by ChatMessageChunk::next.
+    ChatMessageChunk* free_chunks_ = nullptr;
+
+    // Number of chunks in free_chunks_. Written with mutex_free_chunks_ held,
+    // so GetFreeChunkCount reads it without the lock.
+    std::atomic<size_t> free_chunk_count_;
+
+    // Most chunks in free_chunks_.
+    size_t max_free_chunk_count_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CHATMESSAGECHUNKPOOL_H_
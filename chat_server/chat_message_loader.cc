@@ -0,0 +1,252 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "chat_message_loader.h"
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+#include "cpprest/asyncrt_utils.h"
+#include "delimiter_scanner.h"
+#include "mapped_file.h"
+#include "spdlog/spdlog.h"
+
+using namespace std;
+using ::utility::string_t;
+using ::utility::conversions::to_utf8string;
+using ::spdlog::error;
+
+namespace chatserver {
+
+  namespace {
+
+    // Delimiter in the chat message file database.
+    const char kParsingDelimiter = '|';
+
+    // Smaller files are not worth another thread.
+    const size_t kMinChunkSize = 1 << 20;
+
+    // Make a ChatString of the given bytes, one character per byte.
+    ChatString MakeString(const char* begin, const char* end) {
+#if defined(CHATSERVER_UTF8_STRINGS)
+      return ChatString(begin, end);
+#else
+      return ChatString(reinterpret_cast<const unsigned char*>(begin),
+                        reinterpret_cast<const unsigned char*>(end));
+#endif
+    }
+
+    // Fields of a line with a timestamp and an id.
+    const size_t kMaxFieldCount = 5;
+
+    // Parse a decimal integer with an optional minus sign: a Unix time, a
+    // timestamp or an id.
+    bool ParseInteger(const char* begin, const char* end, int64_t* out_value) {
+      bool is_negative = false;
+      if (begin != end && *begin == '-') {
+        is_negative = true;
+        ++begin;
+      }
+      if (begin == end || end - begin > 18) {
+        return false;
+      }
+      int64_t value = 0;
+      for (const char* c = begin; c != end; ++c) {
+        if (*c < '0' || *c > '9') {
+          return false;
+        }
+        value = value * 10 + (*c - '0');
+      }
+      *out_value = is_negative ? -value : value;
+      return true;
+    }
+
+    // Parse every line in [begin, end) into out_chat_messages.
+    bool ParseChunk(const char* begin,
+                    const char* end,
+                    ChatMessageLoader::ChatMessageMap* out_chat_messages) {
+      // Consecutive lines are often in the same chat room.
+      const ChatString* last_chat_room = nullptr;
+      vector<ChatMessage>* last_chat_messages = nullptr;
+
+      const char* line_begin = begin;
+      while (line_begin < end) {
+        const char* line_end = DelimiterScanner::Find(line_begin, end, '\n');
+        const char* next_line_begin = line_end != end ? line_end + 1 : end;
+        if (line_end != line_begin && line_end[-1] == '\r') {
+          --line_end;
+        }
+
+        if (line_end != line_begin) {
+          ChatMessage chat_message;
+          if (!ChatMessageLoader::ParseLine(line_begin, line_end,
+                                            &chat_message)) {
+            error("Chat message file parsing error");
+            return false;
+          }
+          if (last_chat_room == nullptr ||
+              *last_chat_room != chat_message.chat_room) {
+            auto it = out_chat_messages->find(chat_message.chat_room);
+            if (it == out_chat_messages->end()) {
+              it = out_chat_messages->emplace(
+                  chat_message.chat_room, vector<ChatMessage>()).first;
+            }
+            last_chat_room = &it->first;
+            last_chat_messages = &it->second;
+          }
+          last_chat_messages->push_back(move(chat_message));
+        }
+        line_begin = next_line_begin;
+      }
+      return true;
+    }
+
+  } // namespace
+
+  bool ChatMessageLoader::Load(const string_t& chat_message_file,
+                               size_t thread_count,
+                               ChatMessageMap* out_chat_messages) {
+    MappedFile mapped_file;
+    if (!mapped_file.Open(chat_message_file)) {
+      error("Can't map chat message file: {}",
+            to_utf8string(chat_message_file));
+      return false;
+    }
+    return Parse(mapped_file.GetData(), mapped_file.GetSize(), thread_count,
+                 out_chat_messages);
+  }
+
+  bool ChatMessageLoader::Parse(const char* data,
+                                size_t size,
+                                size_t thread_count,
+                                ChatMessageMap* out_chat_messages) {
+    if (thread_count == 0) {
+      thread_count = max(thread::hardware_concurrency(), 1u);
+    }
+    thread_count = max<size_t>(min(thread_count, size / kMinChunkSize), 1);
+
+    // Split at newlines, so every line is in one chunk.
+    vector<const char*> chunk_begins;
+    chunk_begins.push_back(data);
+    for (size_t i = 1; i < thread_count; ++i) {
+      const char* chunk_begin = max(data + size * i / thread_count,
+                                    chunk_begins.back());
+      const char* newline =
+          DelimiterScanner::Find(chunk_begin, data + size, '\n');
+      chunk_begins.push_back(newline != data + size ? newline + 1 : newline);
+    }
+    chunk_begins.push_back(data + size);
+
+    // Each thread parses into its own map. The first chunk runs on the
+    // calling thread.
+    vector<ChatMessageMap> chunk_chat_messages(thread_count);
+    vector<char> chunk_results(thread_count, 0);
+    vector<thread> threads;
+    for (size_t i = 1; i < thread_count; ++i) {
+      threads.emplace_back([&, i]() {
+        chunk_results[i] = ParseChunk(chunk_begins[i], chunk_begins[i + 1],
+                                      &chunk_chat_messages[i]);
+      });
+    }
+    chunk_results[0] = ParseChunk(chunk_begins[0], chunk_begins[1],
+                                  &chunk_chat_messages[0]);
+    for (thread& t : threads) {
+      t.join();
+    }
+    if (find(chunk_results.begin(), chunk_results.end(), 0) !=
+        chunk_results.end()) {
+      return false;
+    }
+
+    // Merge in file order to keep the order of each chat room.
+    for (ChatMessageMap& chat_messages : chunk_chat_messages) {
+      for (auto& chat_room : chat_messages) {
+        vector<ChatMessage>& merged_chat_messages =
+            (*out_chat_messages)[chat_room.first];
+        if (merged_chat_messages.empty()) {
+          merged_chat_messages = move(chat_room.second);
+        } else {
+          merged_chat_messages.insert(
+              merged_chat_messages.end(),
+              make_move_iterator(chat_room.second.begin()),
+              make_move_iterator(chat_room.second.end()));
+        }
+      }
+    }
+    return true;
+  }
+
+  bool ChatMessageLoader::ParseLine(const char* line_begin,
+                                    const char* line_end,
+                                    ChatMessage* out_chat_message) {
+    // Parsing format: timestamp|id|user_id|chat_room|chat_message, or
+    // date|user_id|chat_room|chat_message before timestamps. Every field
+    // must be non-empty, and the chat message must not have a delimiter.
+    const char* field_begins[kMaxFieldCount];
+    const char* field_ends[kMaxFieldCount];
+    size_t field_count = 0;
+    const char* field_begin = line_begin;
+    while (true) {
+      const char* delimiter =
+          DelimiterScanner::Find(field_begin, line_end, kParsingDelimiter);
+      if (delimiter == field_begin || field_count == kMaxFieldCount) {
+        return false;
+      }
+      field_begins[field_count] = field_begin;
+      field_ends[field_count] = delimiter;
+      ++field_count;
+      if (delimiter == line_end) {
+        break;
+      }
+      field_begin = delimiter + 1;
+    }
+    if (field_count < kMaxFieldCount - 1) {
+      return false;
+    }
+
+    // The fields after the time and the id.
+    size_t text_field = 1;
+    if (field_count == kMaxFieldCount) {
+      int64_t timestamp = 0;
+      int64_t id = 0;
+      if (!ParseInteger(field_begins[0], field_ends[0], &timestamp) ||
+          !ParseInteger(field_begins[1], field_ends[1], &id) || id <= 0) {
+        return false;
+      }
+      out_chat_message->timestamp = timestamp;
+      out_chat_message->date = static_cast<time_t>(
+          timestamp / ChatMessage::kMicrosecondsPerSecond);
+      out_chat_message->id = static_cast<uint64_t>(id);
+      text_field = 2;
+    } else {
+      int64_t date = 0;
+      if (!ParseInteger(field_begins[0], field_ends[0], &date)) {
+        return false;
+      }
+      out_chat_message->date = static_cast<time_t>(date);
+      out_chat_message->timestamp = 0;
+      out_chat_message->id = 0;
+    }
+    out_chat_message->user_id =
+        MakeString(field_begins[text_field], field_ends[text_field]);
+    out_chat_message->chat_room =
+        MakeString(field_begins[text_field + 1], field_ends[text_field + 1]);
+    out_chat_message->chat_message =
+        MakeString(field_begins[text_field + 2], field_ends[text_field + 2]);
+    return true;
+  }
+
+  void ChatMessageLoader::FormatLine(const ChatMessage& chat_message,
+                                     uint64_t id,
+                                     ChatOutputStringStream* out_lines) {
+    // File format: timestamp|id|user_id|chat_room|chat_message
+    *out_lines << chat_message.GetTimestamp() << kParsingDelimiter
+               << id << kParsingDelimiter
+               << chat_message.user_id << kParsingDelimiter
+               << chat_message.chat_room << kParsingDelimiter
+               << chat_message.chat_message << CHATSERVER_TEXT('\n');
+  }
+
+} // namespace chatserver
@@ -0,0 +1,68 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CHATMESSAGELOADER_H_
+#define CHATSERVER_CHATMESSAGELOADER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "cpprest/details/basic_types.h"
+#include "chat_message.h"
+#include "chat_string.h"
+
+// This class loads the chat message file database in parallel. The file is
+// memory-mapped and split into newline-aligned chunks, one per thread. Each
+// thread parses its chunk into its own map of chat rooms, and the maps are
+// merged in file order, so the chat messages of a chat room keep the order
+// of the file.
+// Line format: timestamp|id|user_id|chat_room|chat_message, where the
+// timestamp is in microseconds. Lines of older files have no id and a date
+// in seconds: date|user_id|chat_room|chat_message. Each byte becomes one
+// character, as wifstream reads the file in the default C locale, or is
+// kept as is if ChatString is UTF-8. A carriage return before the newline
+// is dropped.
+// Example:
+//   ChatMessageLoader::ChatMessageMap chat_messages;
+//   if (ChatMessageLoader::Load(UU("chat_messages.txt"), 0, &chat_messages)) {
+//     do something with chat_messages[chat_room]
+//   }
+
+namespace chatserver {
+
+  class ChatMessageLoader {
+   public:
+    // Chat messages of each chat room in file order.
+    typedef std::map<ChatString, std::vector<ChatMessage>> ChatMessageMap;
+
+    // Load the given chat message file with the given number of threads, or
+    // with one thread per core if thread_count is 0. Return false if the
+    // file can't be mapped or a line is malformed.
+    static bool Load(const utility::string_t& chat_message_file,
+                     size_t thread_count,
+                     ChatMessageMap* out_chat_messages);
+
+    // Parse the given chat message file contents like Load.
+    static bool Parse(const char* data,
+                      size_t size,
+                      size_t thread_count,
+                      ChatMessageMap* out_chat_messages);
+
+    // Parse a line without its newline. Return false if it is malformed.
+    static bool ParseLine(const char* line_begin,
+                          const char* line_end,
+                          ChatMessage* out_chat_message);
+
+    // Write the given chat message with the given id as a line of the file,
+    // with its newline. Its timestamp is the date if it has none.
+    static void FormatLine(const ChatMessage& chat_message,
+                           uint64_t id,
+                           ChatOutputStringStream* out_lines);
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CHATMESSAGELOADER_H_
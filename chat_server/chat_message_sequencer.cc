@@ -0,0 +1,163 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "chat_message_sequencer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <set>
+
+#include "tracing.h"
+
+using namespace std;
+using chrono::system_clock;
+
+namespace chatserver {
+
+  namespace {
+
+    // Longest wait of the idle sequencer thread. A wake-up is never lost, so
+    // it only bounds the wait in case of a bug.
+    const chrono::milliseconds kMaxIdleWait(100);
+
+  } // namespace
+
+  ChatMessageSequencer::ChatMessageSequencer(ChatDatabase* chat_database)
+      : chat_database_(chat_database),
+        last_timestamp_(0),
+        batch_count_(0),
+        run_thread_(false),
+        is_waiting_(false),
+        mutex_wake_up_("ChatMessageSequencer::mutex_wake_up_") {
+  }
+
+  ChatMessageSequencer::~ChatMessageSequencer() {
+    StopSequencerThread();
+  }
+
+  void ChatMessageSequencer::RunSequencerThread() {
+    if (sequencer_thread_.joinable()) {
+      return;
+    }
+    run_thread_ = true;
+    sequencer_thread_ =
+        thread(&ChatMessageSequencer::SequenceChatMessages, this);
+  }
+
+  void ChatMessageSequencer::StopSequencerThread() {
+    if (sequencer_thread_.joinable()) {
+      {
+        const lock_guard<InstrumentedMutex> lock(mutex_wake_up_);
+        run_thread_ = false;
+      }
+      wake_up_.notify_one();
+      sequencer_thread_.join();
+    }
+    // Submissions made without a running thread.
+    while (StoreNextBatch()) {
+    }
+  }
+
+  void ChatMessageSequencer::Submit(vector<ChatMessage> chat_messages,
+                                    StoredCallback on_stored) {
+    chat_database_->LoadChatRooms(chat_messages);
+    submissions_.Push({move(chat_messages), move(on_stored),
+                       Tracing::IsSampled(), 0, 0});
+    // Pairs with the fence in SequenceChatMessages: either the sequencer
+    // thread sees the submission, or this sees is_waiting_ and wakes it.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (is_waiting_.load()) {
+      const lock_guard<InstrumentedMutex> lock(mutex_wake_up_);
+      wake_up_.notify_one();
+    }
+  }
+
+  uint64_t ChatMessageSequencer::GetBatchCount() const {
+    return batch_count_.load();
+  }
+
+  void ChatMessageSequencer::SequenceChatMessages() {
+    while (run_thread_) {
+      if (StoreNextBatch()) {
+        continue;
+      }
+      unique_lock<InstrumentedMutex> lock(mutex_wake_up_);
+      is_waiting_ = true;
+      atomic_thread_fence(memory_order_seq_cst);
+      if (run_thread_ && submissions_.IsEmpty()) {
+        wake_up_.wait_for(lock, kMaxIdleWait);
+      }
+      is_waiting_ = false;
+    }
+    while (StoreNextBatch()) {
+    }
+  }
+
+  bool ChatMessageSequencer::StoreNextBatch() {
+    Submission submission;
+    bool is_popped = false;
+    while (batch_chat_messages_.size() < kMaxBatchChatMessages &&
+           submissions_.Pop(&submission)) {
+      is_popped = true;
+      const bool is_valid = all_of(
+          submission.chat_messages.begin(), submission.chat_messages.end(),
+          [this](const ChatMessage& chat_message) {
+        return chat_database_->DoesDelimiterExistInChatMessage(chat_message) &&
+               chat_database_->IsExistChatRoom(chat_message.chat_room);
+      });
+      if (!is_valid) {
+        // One bad submission must not fail the others in the batch.
+        submission.on_stored(false);
+        continue;
+      }
+      submission.batch_begin = batch_chat_messages_.size();
+      for (ChatMessage& chat_message : submission.chat_messages) {
+        batch_chat_messages_.push_back(move(chat_message));
+      }
+      submission.batch_end = batch_chat_messages_.size();
+      batch_submissions_.push_back(move(submission));
+    }
+    if (batch_submissions_.empty()) {
+      return is_popped;
+    }
+
+    // The sequencer thread starts no request, so the spans of the database
+    // belong to the batch.
+    CHATSERVER_TRACE_CONTINUED_REQUEST(
+        "ChatMessageSequencer::StoreNextBatch",
+        any_of(batch_submissions_.begin(), batch_submissions_.end(),
+               [](const Submission& batch_submission) {
+      return batch_submission.is_sampled;
+    }));
+    // Timestamps increase by at least one microsecond per chat message.
+    const int64_t now = chrono::duration_cast<chrono::microseconds>(
+        system_clock::now().time_since_epoch()).count();
+    for (ChatMessage& chat_message : batch_chat_messages_) {
+      last_timestamp_ = max(last_timestamp_ + 1, now);
+      chat_message.timestamp = last_timestamp_;
+      chat_message.date = static_cast<time_t>(
+          last_timestamp_ / ChatMessage::kMicrosecondsPerSecond);
+    }
+    set<ChatString> stored_chat_rooms;
+    const bool is_stored = chat_database_->StoreChatMessages(
+        batch_chat_messages_, &stored_chat_rooms);
+    ++batch_count_;
+    // A submission whose chat rooms are all stored succeeds, so its client
+    // does not post them again.
+    for (const Submission& batch_submission : batch_submissions_) {
+      batch_submission.on_stored(
+          is_stored ||
+          all_of(batch_chat_messages_.begin() + batch_submission.batch_begin,
+                 batch_chat_messages_.begin() + batch_submission.batch_end,
+                 [&stored_chat_rooms](const ChatMessage& chat_message) {
+        return stored_chat_rooms.count(chat_message.chat_room) != 0;
+      }));
+    }
+    batch_submissions_.clear();
+    batch_chat_messages_.clear();
+    return true;
+  }
+
+} // namespace chatserver
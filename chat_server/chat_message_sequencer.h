@@ -0,0 +1,138 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CHATMESSAGESEQUENCER_H_
+#define CHATSERVER_CHATMESSAGESEQUENCER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "chat_database.h"
+#include "chat_message.h"
+#include "instrumented_mutex.h"
+#include "mpsc_queue.h"
+
+// ChatMessageSequencer is the single writer of the chat messages posted to
+// a ChatDatabase. Request threads submit chat messages to a lock-free queue
+// and return; one sequencer thread takes every submission in the queue as a
+// batch, stamps the server timestamps, stores the batch with one append to the
+// chat message file and one publish per chat room, and then calls the
+// callback of each submission. If only some chat rooms of a partitioned
+// database are stored, a submission whose chat rooms are all stored gets its
+// callback with success, and the others get it with failure.
+// Chat messages are stored in submission order, so the order is the same in
+// the file and in every chat room log, and the index of a chat message in
+// its chat room log is its id. Timestamps increase in that order, even if
+// the system clock goes back, so no two chat messages have the same one.
+// If the database loads lazily, Submit loads the chat rooms of a submission
+// on the request thread, so the sequencer thread appends to loaded chat
+// rooms and a cold chat room doesn't stall the other submissions.
+// Example:
+//   ChatMessageSequencer sequencer(&chat_database);
+//   sequencer.RunSequencerThread();
+//   sequencer.Submit(move(chat_messages), [message](bool is_stored) {
+//     reply to message
+//   });
+
+namespace chatserver {
+
+  class ChatMessageSequencer {
+   public:
+    // Called on the sequencer thread after the chat messages of a
+    // submission are stored, or failed to be.
+    typedef std::function<void(bool is_stored)> StoredCallback;
+
+    // A batch takes no more submissions once it has this many chat
+    // messages, so a large submission may exceed it.
+    static const size_t kMaxBatchChatMessages = 4096;
+
+    // Chat messages are stored on the given database. Name mutex_wake_up_
+    // for lock profiling.
+    explicit ChatMessageSequencer(ChatDatabase* chat_database);
+
+    // Stop the sequencer thread after storing every submission.
+    ~ChatMessageSequencer();
+
+    ChatMessageSequencer(const ChatMessageSequencer&) = delete;
+    ChatMessageSequencer& operator=(const ChatMessageSequencer&) = delete;
+
+    // Execute the thread that stores the submitted chat messages.
+    void RunSequencerThread();
+
+    // Store the submissions left in the queue and join the sequencer
+    // thread. Submissions after this are stored on the next call.
+    void StopSequencerThread();
+
+    // Load the chat rooms of the given chat messages and queue them. The
+    // sequencer replaces their timestamps and dates with the server time. A
+    // submission with a prohibited character is not stored. A batch is
+    // traced if the request of any of its submissions is sampled. The queue
+    // is lock-free; safe from any thread.
+    void Submit(std::vector<ChatMessage> chat_messages,
+                StoredCallback on_stored);
+
+    // Get the number of batches stored so far.
+    uint64_t GetBatchCount() const;
+
+   private:
+    // Chat messages of one request and the callback to complete it.
+    struct Submission {
+      std::vector<ChatMessage> chat_messages;
+      StoredCallback on_stored;
+      // Whether the submitting request is sampled for tracing.
+      bool is_sampled;
+      // Range of its chat messages in batch_chat_messages_.
+      size_t batch_begin;
+      size_t batch_end;
+    };
+
+    // Store batches until the thread is stopped, and wait while the queue is
+    // empty.
+    void SequenceChatMessages();
+
+    // Take submissions from the queue up to kMaxBatchChatMessages chat
+    // messages, store them, and call their callbacks. Return false if the
+    // queue was empty. Only one thread may call it at a time.
+    bool StoreNextBatch();
+
+    // Database of the chat messages.
+    ChatDatabase* const chat_database_;
+
+    // Submitted chat messages. Only the sequencer thread pops.
+    MpscQueue<Submission> submissions_;
+
+    // Submissions and chat messages of the current batch. They are kept
+    // between batches to reuse their capacity.
+    std::vector<Submission> batch_submissions_;
+    std::vector<ChatMessage> batch_chat_messages_;
+
+    // Timestamp of the last stored chat message, in microseconds.
+    int64_t last_timestamp_;
+
+    // Number of stored batches.
+    std::atomic<uint64_t> batch_count_;
+
+    // The variable to control the sequencer thread for start and stop.
+    std::atomic<bool> run_thread_;
+
+    // Whether the sequencer thread waits for a submission. Submit takes
+    // mutex_wake_up_ only when it is set.
+    std::atomic<bool> is_waiting_;
+
+    // Mutex for waking up the sequencer thread with wake_up_.
+    InstrumentedMutex mutex_wake_up_;
+    std::condition_variable_any wake_up_;
+
+    // Thread that stores the submitted chat messages.
+    std::thread sequencer_thread_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CHATMESSAGESEQUENCER_H_
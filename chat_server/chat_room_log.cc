@@ -0,0 +1,253 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "chat_room_log.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace chatserver {
+
+  namespace {
+
+    // Entries of the first directory. The first chunk is enough for most
+    // chat rooms.
+    const size_t kInitialDirectoryCapacity = 4;
+
+    // Bytes of the first block of a text arena. The arena grows
+    // geometrically, so a large chat room takes few blocks.
+    const size_t kInitialTextArenaSize = 4096;
+
+  } // namespace
+
+  ChatMessageChunkChain::ChatMessageChunkChain(
+      shared_ptr<ChatMessageChunkPool> chunk_pool)
+      : chunk_pool_(move(chunk_pool)),
+        text_arena_(kInitialTextArenaSize, &text_blocks_) {
+  }
+
+  ChatMessageChunkChain::~ChatMessageChunkChain() {
+    while (head_ != nullptr) {
+      ChatMessageChunk* const chunk = head_;
+      head_ = chunk->next;
+      chunk_pool_->Free(chunk);
+    }
+  }
+
+  ChatMessageChunk* ChatMessageChunkChain::Append() {
+    ChatMessageChunk* const chunk = chunk_pool_->Allocate();
+    if (tail_ == nullptr) {
+      head_ = chunk;
+    } else {
+      tail_->next = chunk;
+    }
+    tail_ = chunk;
+    return chunk;
+  }
+
+  ChatStringView ChatMessageChunkChain::CopyText(ChatStringView text) {
+    if (text.empty()) {
+      return ChatStringView();
+    }
+    void* const data = text_arena_.allocate(text.size() * sizeof(ChatChar),
+                                            alignof(ChatChar));
+    memcpy(data, text.data(), text.size() * sizeof(ChatChar));
+    return ChatStringView(static_cast<const ChatChar*>(data), text.size());
+  }
+
+  void* ChatMessageChunkChain::CountingMemoryResource::do_allocate(
+      size_t bytes,
+      size_t alignment) {
+    void* const data = pmr::new_delete_resource()->allocate(bytes, alignment);
+    allocated_size_ += bytes;
+    return data;
+  }
+
+  void ChatMessageChunkChain::CountingMemoryResource::do_deallocate(
+      void* data,
+      size_t bytes,
+      size_t alignment) {
+    pmr::new_delete_resource()->deallocate(data, bytes, alignment);
+    allocated_size_ -= bytes;
+  }
+
+  ChatMessageChunkDirectory::ChatMessageChunkDirectory(
+      size_t directory_capacity,
+      shared_ptr<ChatMessageChunkChain> chunks)
+      : capacity(directory_capacity),
+        // Not value-initialized, so the allocation does not touch every
+        // entry.
+        entries(new ChatMessageChunk*[directory_capacity]),
+        first_timestamps(new int64_t[directory_capacity]),
+        chain(move(chunks)) {
+  }
+
+  ChatRoomSnapshot::ChatRoomSnapshot() : size_(0), is_time_ordered_(true) {
+  }
+
+  ChatRoomSnapshot::ChatRoomSnapshot(
+      shared_ptr<const ChatMessageChunkDirectory> directory,
+      size_t size,
+      bool is_time_ordered)
+      : directory_(move(directory)),
+        size_(size),
+        is_time_ordered_(is_time_ordered) {
+  }
+
+  size_t ChatRoomSnapshot::GetIndexAtTimestamp(int64_t timestamp) const {
+    if (size_ == 0) {
+      return 0;
+    }
+    // The chunks after the found one start at or after the timestamp, so the
+    // chat message is in the chunk before it, or is its first one.
+    const size_t chunk_count =
+        (size_ + ChatMessageChunk::kCapacity - 1) / ChatMessageChunk::kCapacity;
+    const int64_t* const first_timestamps =
+        directory_->first_timestamps.get();
+    const size_t chunk_index = static_cast<size_t>(
+        lower_bound(first_timestamps, first_timestamps + chunk_count,
+                    timestamp) - first_timestamps);
+    if (chunk_index == 0) {
+      return 0;
+    }
+    const size_t begin = (chunk_index - 1) * ChatMessageChunk::kCapacity;
+    const size_t count = min(size_ - begin, ChatMessageChunk::kCapacity);
+    const ChatMessageView* const chat_messages =
+        directory_->entries[chunk_index - 1]->chat_messages;
+    const ChatMessageView* const found = lower_bound(
+        chat_messages, chat_messages + count, timestamp,
+        [](const ChatMessageView& chat_message, int64_t value) {
+      return chat_message.timestamp < value;
+    });
+    return begin + static_cast<size_t>(found - chat_messages);
+  }
+
+  ChatRoomLog::ChatRoomLog(shared_ptr<ChatMessageChunkPool> chunk_pool)
+      : mutex_append_("ChatRoomLog::mutex_append_"),
+        chain_(make_shared<ChatMessageChunkChain>(move(chunk_pool))),
+        directory_(make_shared<ChatMessageChunkDirectory>(
+            kInitialDirectoryCapacity, chain_)),
+        snapshot_(make_shared<const ChatRoomSnapshot>()),
+        memory_usage_(0),
+        last_access_time_(0) {
+  }
+
+  shared_ptr<const ChatRoomSnapshot> ChatRoomLog::GetSnapshot() const {
+    return atomic_load(&snapshot_);
+  }
+
+  void ChatRoomLog::Append(const ChatMessage& chat_message) {
+    const lock_guard<InstrumentedMutex> lock(mutex_append_);
+    AppendChunkMessage(chat_message);
+    Publish();
+  }
+
+  void ChatRoomLog::Append(const vector<ChatMessage>& chat_messages) {
+    if (chat_messages.empty()) {
+      return;
+    }
+    const lock_guard<InstrumentedMutex> lock(mutex_append_);
+    for (const ChatMessage& chat_message : chat_messages) {
+      AppendChunkMessage(chat_message);
+    }
+    Publish();
+  }
+
+  void ChatRoomLog::Append(const vector<const ChatMessage*>& chat_messages) {
+    if (chat_messages.empty()) {
+      return;
+    }
+    const lock_guard<InstrumentedMutex> lock(mutex_append_);
+    for (const ChatMessage* chat_message : chat_messages) {
+      AppendChunkMessage(*chat_message);
+    }
+    Publish();
+  }
+
+  void ChatRoomLog::AppendChunkMessage(const ChatMessage& chat_message) {
+    const int64_t timestamp = chat_message.GetTimestamp();
+    const size_t offset = size_ % ChatMessageChunk::kCapacity;
+    if (offset == 0) {
+      AddChunk(timestamp);
+    }
+    if (chat_message.chat_room != chat_room_) {
+      chat_room_ = chain_->CopyText(chat_message.chat_room);
+    }
+    ChatMessageView& chunk_message = tail_chunk_->chat_messages[offset];
+    chunk_message.date = chat_message.date;
+    chunk_message.timestamp = timestamp;
+    // The id is the position in the log, whatever the given one is.
+    chunk_message.id = size_ + 1;
+    chunk_message.user_id = chain_->CopyText(chat_message.user_id);
+    chunk_message.chat_room = chat_room_;
+    chunk_message.chat_message = chain_->CopyText(chat_message.chat_message);
+    if (size_ > 0 && timestamp < last_timestamp_) {
+      is_time_ordered_ = false;
+    }
+    last_timestamp_ = timestamp;
+    ++size_;
+
+    // A chunk takes kCapacity appends, so the copy is complete long before
+    // directory_ is full.
+    if (copied_entry_count_ < copy_end_) {
+      CopyDirectoryEntry();
+    }
+  }
+
+  void ChatRoomLog::AddChunk(int64_t first_timestamp) {
+    if (chunk_count_ == directory_->capacity) {
+      while (copied_entry_count_ < copy_end_) {
+        CopyDirectoryEntry();
+      }
+      directory_ = move(next_directory_);
+      copied_entry_count_ = 0;
+      copy_end_ = 0;
+    }
+
+    tail_chunk_ = chain_->Append();
+    directory_->entries[chunk_count_] = tail_chunk_;
+    directory_->first_timestamps[chunk_count_] = first_timestamp;
+    if (next_directory_ != nullptr) {
+      next_directory_->entries[chunk_count_] = tail_chunk_;
+      next_directory_->first_timestamps[chunk_count_] = first_timestamp;
+    }
+    ++chunk_count_;
+
+    if (next_directory_ == nullptr &&
+        chunk_count_ * 2 >= directory_->capacity) {
+      next_directory_ = make_shared<ChatMessageChunkDirectory>(
+          directory_->capacity * 2, chain_);
+      copy_end_ = chunk_count_;
+    }
+  }
+
+  void ChatRoomLog::CopyDirectoryEntry() {
+    next_directory_->entries[copied_entry_count_] =
+        directory_->entries[copied_entry_count_];
+    next_directory_->first_timestamps[copied_entry_count_] =
+        directory_->first_timestamps[copied_entry_count_];
+    ++copied_entry_count_;
+  }
+
+  void ChatRoomLog::Publish() {
+    const shared_ptr<const ChatRoomSnapshot> snapshot =
+        make_shared<const ChatRoomSnapshot>(directory_, size_,
+                                            is_time_ordered_);
+    atomic_store(&snapshot_, snapshot);
+
+    // Snapshots of older directories are released by their readers, so
+    // only the current ones are counted.
+    size_t directory_capacity = directory_->capacity;
+    if (next_directory_ != nullptr) {
+      directory_capacity += next_directory_->capacity;
+    }
+    memory_usage_.store(
+        chunk_count_ * sizeof(ChatMessageChunk) + chain_->GetTextCapacity() +
+            directory_capacity * (sizeof(ChatMessageChunk*) + sizeof(int64_t)),
+        memory_order_relaxed);
+  }
+
+} // namespace chatserver
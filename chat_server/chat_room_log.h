@@ -0,0 +1,287 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CHATROOMLOG_H_
+#define CHATSERVER_CHATROOMLOG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "chat_message.h"
+#include "chat_message_chunk_pool.h"
+#include "instrumented_mutex.h"
+
+// ChatRoomLog keeps the chat messages of one chat room in fixed-size chunks
+// from a ChatMessageChunkPool, and publishes an immutable ChatRoomSnapshot
+// after every append. Readers take the snapshot with one atomic load and
+// never wait for writers; writers are serialized by a mutex.
+// The text of the chat messages is copied into a bump arena of the chat
+// room, so a chat message is a ChatMessageView with no string of its own.
+// The arena is released with the chunks.
+// The log numbers its chat messages: the id of a chat message is its index
+// plus one, so the chat messages after a given id are found in O(1).
+// The directory is also a sparse time index: it keeps the timestamp of the
+// first chat message of each chunk, so the first chat message at a given time
+// is found by a binary search of the chunks and then of one chunk, without
+// touching the chunks in between. It needs the timestamps of the chat room in
+// order, as the sequencer stamps them; the snapshot tells whether they are.
+// A chat message never moves, and a published one is never written again:
+// a writer fills the slot after the last published chat message and then
+// publishes a new snapshot. Append is O(1) in the worst case. The chunks are
+// found through a directory of chunk pointers. When it is half full, a
+// directory twice as large is made and the old entries are copied into it,
+// one per append, so it is complete when the old one is full.
+// The log reports its memory usage and the time of its last access, so
+// ChatDatabase can keep the chat rooms within a memory budget.
+// Example:
+//   ChatRoomLog chat_room_log(chunk_pool);
+//   chat_room_log.Append(chat_message);
+//   const auto snapshot = chat_room_log.GetSnapshot();
+//   for (size_t i = 0; i < snapshot->size(); ++i) {
+//     do something with (*snapshot)[i]
+//   }
+
+namespace chatserver {
+
+  // Chunks of a chat room log in order, linked by ChatMessageChunk::next, and
+  // the text arena of their chat messages. The directories of the log share
+  // it, and it returns the chunks to the pool and releases the text when the
+  // log and its last snapshot are released.
+  class ChatMessageChunkChain {
+   public:
+    explicit ChatMessageChunkChain(
+        std::shared_ptr<ChatMessageChunkPool> chunk_pool);
+
+    // Return every chunk to the pool.
+    ~ChatMessageChunkChain();
+
+    ChatMessageChunkChain(const ChatMessageChunkChain&) = delete;
+    ChatMessageChunkChain& operator=(const ChatMessageChunkChain&) = delete;
+
+    // Allocate a chunk and link it after the last one.
+    ChatMessageChunk* Append();
+
+    // Copy the given text into the text arena. It is never moved or freed
+    // before the chain is.
+    ChatStringView CopyText(ChatStringView text);
+
+    // Get the bytes of the blocks of the text arena. The text fills them up
+    // to the last one, which is as large as all the others.
+    size_t GetTextCapacity() const {
+      return text_blocks_.GetAllocatedSize();
+    }
+
+   private:
+    // Upstream of a text arena: allocates from new and delete, and counts
+    // the bytes of the blocks it gives.
+    class CountingMemoryResource : public std::pmr::memory_resource {
+     public:
+      size_t GetAllocatedSize() const {
+        return allocated_size_;
+      }
+
+     private:
+      void* do_allocate(size_t bytes, size_t alignment) override;
+      void do_deallocate(void* data, size_t bytes, size_t alignment) override;
+      bool do_is_equal(
+          const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+      }
+
+      // Bytes of the blocks not deallocated.
+      size_t allocated_size_ = 0;
+    };
+
+    const std::shared_ptr<ChatMessageChunkPool> chunk_pool_;
+    ChatMessageChunk* head_ = nullptr;
+    ChatMessageChunk* tail_ = nullptr;
+
+    // Blocks of text_arena_. It outlives the arena, which frees them.
+    CountingMemoryResource text_blocks_;
+
+    // Bump arena of the text. Only the writer of the log allocates from it.
+    std::pmr::monotonic_buffer_resource text_arena_;
+  };
+
+  // Chunk pointers of a chat room log in order, and the timestamp of the
+  // first chat message of each chunk. An entry is written once, before any
+  // snapshot can read it.
+  struct ChatMessageChunkDirectory {
+    ChatMessageChunkDirectory(size_t directory_capacity,
+                              std::shared_ptr<ChatMessageChunkChain> chunks);
+
+    // Number of entries.
+    const size_t capacity;
+
+    // Entries. Only the ones written so far are initialized.
+    const std::unique_ptr<ChatMessageChunk*[]> entries;
+
+    // Timestamp of the first chat message of each entry. Searched in place
+    // of the chunks, so a search reads one cache line per few entries.
+    const std::unique_ptr<int64_t[]> first_timestamps;
+
+    // Keep the chunks while a snapshot uses this directory.
+    const std::shared_ptr<ChatMessageChunkChain> chain;
+  };
+
+  class ChatRoomSnapshot {
+   public:
+    // Empty snapshot.
+    ChatRoomSnapshot();
+
+    // Snapshot of the first size chat messages in the given directory.
+    // is_time_ordered tells whether their timestamps never decrease.
+    ChatRoomSnapshot(std::shared_ptr<const ChatMessageChunkDirectory> directory,
+                     size_t size,
+                     bool is_time_ordered);
+
+    // size() and operator[] follow std::vector, so the serializers take a
+    // snapshot in place of a chat message vector.
+    size_t size() const {
+      return size_;
+    }
+
+    bool empty() const {
+      return size_ == 0;
+    }
+
+    // Whether the timestamps never decrease, so GetIndexAtTimestamp can be
+    // used. Chat messages loaded from an old file may be out of order.
+    bool is_time_ordered() const {
+      return is_time_ordered_;
+    }
+
+    // Get the index of the first chat message after the given id, or size()
+    // if there is none. O(1), since the id is the index plus one.
+    size_t GetIndexAfterId(uint64_t id) const {
+      return id < size_ ? static_cast<size_t>(id) : size_;
+    }
+
+    // Get the index of the first chat message whose timestamp is not less
+    // than the given one, or size() if there is none. O(log n). The result
+    // is meaningless unless is_time_ordered().
+    size_t GetIndexAtTimestamp(int64_t timestamp) const;
+
+    const ChatMessageView& operator[](size_t index) const {
+      return directory_->entries[index / ChatMessageChunk::kCapacity]
+          ->chat_messages[index % ChatMessageChunk::kCapacity];
+    }
+
+   private:
+    const std::shared_ptr<const ChatMessageChunkDirectory> directory_;
+    const size_t size_;
+    const bool is_time_ordered_;
+  };
+
+  class ChatRoomLog {
+   public:
+    // Name mutex_append_ for lock profiling, and publish an empty snapshot.
+    // Chunks are allocated from the given pool.
+    explicit ChatRoomLog(std::shared_ptr<ChatMessageChunkPool> chunk_pool);
+
+    ChatRoomLog(const ChatRoomLog&) = delete;
+    ChatRoomLog& operator=(const ChatRoomLog&) = delete;
+
+    // Get the chat messages appended so far. Lock-free.
+    std::shared_ptr<const ChatRoomSnapshot> GetSnapshot() const;
+
+    // Get the bytes of the chunks, the text arena blocks and the directories
+    // of the log as of the latest snapshot. Lock-free.
+    size_t GetMemoryUsage() const {
+      return memory_usage_.load(std::memory_order_relaxed);
+    }
+
+    // Record an access at the given time of std::chrono::steady_clock, in
+    // microseconds. Lock-free.
+    void SetLastAccessTime(int64_t time) const {
+      last_access_time_.store(time, std::memory_order_relaxed);
+    }
+
+    // Get the time of the last access, or 0 if there is none.
+    int64_t GetLastAccessTime() const {
+      return last_access_time_.load(std::memory_order_relaxed);
+    }
+
+    // Append the given chat message and publish it.
+    void Append(const ChatMessage& chat_message);
+
+    // Append the given chat messages and publish them at once.
+    void Append(const std::vector<ChatMessage>& chat_messages);
+
+    // Append the pointed chat messages in order and publish them at once.
+    // A batch of several chat rooms is grouped this way without copies.
+    void Append(const std::vector<const ChatMessage*>& chat_messages);
+
+   private:
+    // Append the given chat message without publishing it. mutex_append_
+    // must be held.
+    void AppendChunkMessage(const ChatMessage& chat_message);
+
+    // Add a chunk to the directory whose first chat message has the given
+    // timestamp. mutex_append_ must be held.
+    void AddChunk(int64_t first_timestamp);
+
+    // Copy the next entry of directory_ into next_directory_. mutex_append_
+    // must be held.
+    void CopyDirectoryEntry();
+
+    // Publish directory_ and size_ as a new snapshot. mutex_append_ must be
+    // held.
+    void Publish();
+
+    // Mutex for writers: every member but snapshot_, and publishing
+    // snapshot_.
+    InstrumentedMutex mutex_append_;
+
+    // Chunks of the chat room log.
+    const std::shared_ptr<ChatMessageChunkChain> chain_;
+
+    // Directory of new snapshots.
+    std::shared_ptr<ChatMessageChunkDirectory> directory_;
+
+    // Directory twice as large that replaces directory_ when it is full, or
+    // nullptr if directory_ is less than half full.
+    std::shared_ptr<ChatMessageChunkDirectory> next_directory_;
+
+    // Entries of directory_ before copy_end_ are copied into next_directory_
+    // one by one; the later ones are written to both.
+    size_t copied_entry_count_ = 0;
+    size_t copy_end_ = 0;
+
+    // Last chunk.
+    ChatMessageChunk* tail_chunk_ = nullptr;
+
+    // Number of chunks.
+    size_t chunk_count_ = 0;
+
+    // Number of chat messages.
+    size_t size_ = 0;
+
+    // Timestamp of the last chat message, and whether no chat message has
+    // a smaller timestamp than the one before it.
+    int64_t last_timestamp_ = 0;
+    bool is_time_ordered_ = true;
+
+    // Chat room of the last chat message in the text arena. The chat
+    // messages of the log share it.
+    ChatStringView chat_room_;
+
+    // Latest snapshot. Read and written only with std::atomic_load and
+    // std::atomic_store.
+    std::shared_ptr<const ChatRoomSnapshot> snapshot_;
+
+    // Bytes of the log, updated when a snapshot is published.
+    std::atomic<size_t> memory_usage_;
+
+    // Time of the last access. Mutable, as readers record their accesses.
+    mutable std::atomic<int64_t> last_access_time_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CHATROOMLOG_H_
@@ -0,0 +1,547 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "chat_search_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <type_traits>
+
+#include "mapped_file.h"
+#include "tracing.h"
+
+using namespace std;
+using ::utility::string_t;
+
+namespace chatserver {
+
+  namespace {
+
+    // First bytes of an index file, and its format version.
+    const char kIndexFileMagic[] = {'C', 'S', 'I', 'X'};
+    const uint64_t kIndexFileVersion = 1;
+
+    // Add the term to out_terms and clear it, unless it is too long.
+    void AddTerm(ChatString* term, vector<ChatString>* out_terms) {
+      if (!term->empty() && term->size() <= ChatSearchIndex::kMaxTermSize) {
+        out_terms->push_back(*term);
+      }
+      term->clear();
+    }
+
+    // Write the value as a variable-length integer: 7 bits per byte, low
+    // bits first, and the high bit set on every byte but the last.
+    void WriteVarint(uint64_t value, vector<unsigned char>* out_bytes) {
+      while (value >= 0x80) {
+        out_bytes->push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+      }
+      out_bytes->push_back(static_cast<unsigned char>(value));
+    }
+
+    // Read a variable-length integer at *data and move *data past it.
+    // Return false if it runs past end or is longer than 64 bits.
+    bool ReadVarint(const unsigned char** data,
+                    const unsigned char* end,
+                    uint64_t* out_value) {
+      uint64_t value = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+        if (*data == end) {
+          return false;
+        }
+        const unsigned char byte = *(*data)++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+          *out_value = value;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Write the text in UTF-8 after its size.
+    void WriteText(const ChatString& text, vector<unsigned char>* out_bytes) {
+      const string utf8_text = ToUtf8(text);
+      WriteVarint(utf8_text.size(), out_bytes);
+      out_bytes->insert(out_bytes->end(), utf8_text.begin(), utf8_text.end());
+    }
+
+    // Read a text written by WriteText.
+    bool ReadText(const unsigned char** data,
+                  const unsigned char* end,
+                  ChatString* out_text) {
+      uint64_t size = 0;
+      if (!ReadVarint(data, end, &size) ||
+          size > static_cast<uint64_t>(end - *data)) {
+        return false;
+      }
+      *out_text = FromUtf8(
+          string(reinterpret_cast<const char*>(*data),
+                 static_cast<size_t>(size)));
+      *data += size;
+      return true;
+    }
+
+    // Check the terms of a text have every phrase, each with its terms
+    // adjacent.
+    bool HasPhrases(const vector<ChatString>& terms,
+                    const vector<vector<ChatString>>& phrases) {
+      for (const vector<ChatString>& phrase : phrases) {
+        if (search(terms.begin(), terms.end(), phrase.begin(),
+                   phrase.end()) == terms.end()) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  } // namespace
+
+  ChatSearchIndex::ChatSearchIndex()
+      : mutex_index_("ChatSearchIndex::mutex_index_") {
+  }
+
+  void ChatSearchIndex::Tokenize(ChatStringView text,
+                                 vector<ChatString>* out_terms) {
+    ChatString term;
+    for (const ChatChar c : text) {
+      const auto code_unit = static_cast<make_unsigned<ChatChar>::type>(c);
+      if (code_unit >= 0x80 ||
+          (code_unit >= '0' && code_unit <= '9') ||
+          (code_unit >= 'a' && code_unit <= 'z')) {
+        term.push_back(c);
+      } else if (code_unit >= 'A' && code_unit <= 'Z') {
+        term.push_back(static_cast<ChatChar>(code_unit - 'A' + 'a'));
+      } else {
+        AddTerm(&term, out_terms);
+      }
+    }
+    AddTerm(&term, out_terms);
+  }
+
+  bool ChatSearchIndex::ParseQuery(ChatStringView text,
+                                   ChatSearchQuery* out_query) {
+    ChatSearchQuery query;
+    // Odd parts between double quotes are phrases. An unclosed quote runs to
+    // the end.
+    bool is_phrase = false;
+    vector<ChatString> terms;
+    while (true) {
+      const size_t quote = text.find(CHATSERVER_TEXT('"'));
+      terms.clear();
+      Tokenize(text.substr(0, quote), &terms);
+      if (is_phrase && terms.size() > 1) {
+        query.phrases.push_back(terms);
+      }
+      query.terms.insert(query.terms.end(), terms.begin(), terms.end());
+      if (quote == ChatStringView::npos) {
+        break;
+      }
+      text.remove_prefix(quote + 1);
+      is_phrase = !is_phrase;
+    }
+    if (query.terms.empty()) {
+      return false;
+    }
+    *out_query = move(query);
+    return true;
+  }
+
+  void ChatSearchIndex::IndexChatRoom(const ChatString& chat_room,
+                                      const ChatRoomSnapshot& snapshot) {
+    CHATSERVER_TRACE_SPAN("ChatSearchIndex::IndexChatRoom");
+    uint64_t indexed_count = 0;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_index_);
+      const auto room_index = rooms_.find(chat_room);
+      if (room_index != rooms_.end()) {
+        const uint64_t room_indexed_count = room_index->second.indexed_count;
+        if (room_indexed_count > snapshot.size() ||
+            (room_indexed_count > 0 &&
+             snapshot[static_cast<size_t>(room_indexed_count - 1)].timestamp !=
+                 room_index->second.last_timestamp)) {
+          rooms_.erase(room_index);
+        } else {
+          indexed_count = room_indexed_count;
+        }
+      }
+    }
+    if (indexed_count == snapshot.size()) {
+      return;
+    }
+
+    // Tokenize without mutex_index_, so searches run meanwhile.
+    unordered_map<ChatString, vector<uint64_t>> new_postings;
+    vector<ChatString> terms;
+    for (size_t i = static_cast<size_t>(indexed_count); i < snapshot.size();
+         ++i) {
+      terms.clear();
+      Tokenize(snapshot[i].chat_message, &terms);
+      sort(terms.begin(), terms.end());
+      terms.erase(unique(terms.begin(), terms.end()), terms.end());
+      for (ChatString& term : terms) {
+        new_postings[move(term)].push_back(snapshot[i].id);
+      }
+    }
+
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    ChatRoomIndex& room_index = rooms_[chat_room];
+    if (room_index.indexed_count != indexed_count) {
+      // Another caller indexed or loaded the chat room meanwhile, though
+      // indexers of a chat room must be serialized. Adding the postings
+      // again would duplicate them.
+      return;
+    }
+    for (const auto& new_posting : new_postings) {
+      const auto posting = room_index.postings.try_emplace(new_posting.first);
+      PostingList& posting_list = posting.first->second;
+      if (!posting.second) {
+        room_index.posting_memory_usage -=
+            GetPostingMemoryUsage(new_posting.first, posting_list);
+      }
+      for (const uint64_t id : new_posting.second) {
+        WriteVarint(id - posting_list.last_id, &posting_list.deltas);
+        posting_list.last_id = id;
+        ++posting_list.count;
+      }
+      room_index.posting_memory_usage +=
+          GetPostingMemoryUsage(new_posting.first, posting_list);
+    }
+    room_index.indexed_count = snapshot.size();
+    room_index.last_timestamp = snapshot[snapshot.size() - 1].timestamp;
+  }
+
+  size_t ChatSearchIndex::Search(
+      const ChatString& chat_room,
+      const ChatSearchQuery& query,
+      const ChatRoomSnapshot& snapshot,
+      size_t limit,
+      pmr::vector<ChatMessageView>* out_chat_messages) const {
+    CHATSERVER_TRACE_SPAN("ChatSearchIndex::Search");
+    vector<uint64_t> candidates;
+    bool is_indexed = true;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_index_);
+      const auto room_index = rooms_.find(chat_room);
+      if (room_index != rooms_.end()) {
+        candidates = FindCandidates(room_index->second, query);
+      } else {
+        is_indexed = false;
+      }
+    }
+
+    // The latest chat messages first, so the search stops at limit.
+    const size_t begin = out_chat_messages->size();
+    size_t count = 0;
+    vector<ChatString> terms;
+    if (!is_indexed) {
+      // Every chat message is tokenized, as there are no posting lists.
+      for (size_t i = snapshot.size(); i > 0 && count < limit; --i) {
+        const ChatMessageView& chat_message = snapshot[i - 1];
+        terms.clear();
+        Tokenize(chat_message.chat_message, &terms);
+        if (all_of(query.terms.begin(), query.terms.end(),
+                   [&terms](const ChatString& term) {
+              return find(terms.begin(), terms.end(), term) != terms.end();
+            }) &&
+            HasPhrases(terms, query.phrases)) {
+          out_chat_messages->push_back(chat_message);
+          ++count;
+        }
+      }
+    }
+    for (auto id = candidates.rbegin();
+         id != candidates.rend() && count < limit; ++id) {
+      // Indexed after the snapshot was taken, or not an id.
+      if (*id == 0 || *id > snapshot.size()) {
+        continue;
+      }
+      const ChatMessageView& chat_message =
+          snapshot[static_cast<size_t>(*id - 1)];
+      if (!query.phrases.empty()) {
+        terms.clear();
+        Tokenize(chat_message.chat_message, &terms);
+        if (!HasPhrases(terms, query.phrases)) {
+          continue;
+        }
+      }
+      out_chat_messages->push_back(chat_message);
+      ++count;
+    }
+    reverse(out_chat_messages->begin() + begin, out_chat_messages->end());
+    return count;
+  }
+
+  uint64_t ChatSearchIndex::GetIndexedCount(const ChatString& chat_room) const {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    const auto room_index = rooms_.find(chat_room);
+    if (room_index == rooms_.end()) {
+      return 0;
+    }
+    return room_index->second.indexed_count;
+  }
+
+  uint64_t ChatSearchIndex::GetMemoryUsage(const ChatString& chat_room) const {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    const auto room_index = rooms_.find(chat_room);
+    if (room_index == rooms_.end()) {
+      return 0;
+    }
+    return sizeof(ChatRoomIndexMap::value_type) +
+           room_index->second.postings.bucket_count() * sizeof(void*) +
+           room_index->second.posting_memory_usage;
+  }
+
+  void ChatSearchIndex::EraseChatRoom(const ChatString& chat_room) {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    rooms_.erase(chat_room);
+  }
+
+  bool ChatSearchIndex::Save(const string_t& index_file) const {
+    CHATSERVER_TRACE_SPAN("ChatSearchIndex::Save");
+    vector<unsigned char> bytes;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_index_);
+      WriteVarint(rooms_.size(), &bytes);
+      for (const auto& room_index : rooms_) {
+        WriteChatRoomIndex(room_index.first, room_index.second, &bytes);
+      }
+    }
+    return WriteIndexFile(index_file, bytes);
+  }
+
+  bool ChatSearchIndex::Load(const string_t& index_file) {
+    CHATSERVER_TRACE_SPAN("ChatSearchIndex::Load");
+    ChatRoomIndexMap rooms;
+    if (!ReadIndexFile(index_file, &rooms)) {
+      return false;
+    }
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    rooms_ = move(rooms);
+    return true;
+  }
+
+  bool ChatSearchIndex::SaveChatRoom(const ChatString& chat_room,
+                                     const string_t& index_file) const {
+    CHATSERVER_TRACE_SPAN("ChatSearchIndex::SaveChatRoom");
+    vector<unsigned char> bytes;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_index_);
+      const auto room_index = rooms_.find(chat_room);
+      if (room_index == rooms_.end()) {
+        return false;
+      }
+      WriteVarint(1, &bytes);
+      WriteChatRoomIndex(chat_room, room_index->second, &bytes);
+    }
+    return WriteIndexFile(index_file, bytes);
+  }
+
+  bool ChatSearchIndex::LoadChatRoom(const ChatString& chat_room,
+                                     const string_t& index_file) {
+    CHATSERVER_TRACE_SPAN("ChatSearchIndex::LoadChatRoom");
+    ChatRoomIndexMap rooms;
+    if (!ReadIndexFile(index_file, &rooms)) {
+      return false;
+    }
+    const auto room_index = rooms.find(chat_room);
+    if (room_index == rooms.end()) {
+      return false;
+    }
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    rooms_[chat_room] = move(room_index->second);
+    return true;
+  }
+
+  void ChatSearchIndex::WriteChatRoomIndex(const ChatString& chat_room,
+                                           const ChatRoomIndex& room_index,
+                                           vector<unsigned char>* out_bytes) {
+    // Format: name, indexed count, last timestamp, term count, and per term
+    // the term, id count, last id and the deltas.
+    WriteText(chat_room, out_bytes);
+    WriteVarint(room_index.indexed_count, out_bytes);
+    WriteVarint(static_cast<uint64_t>(room_index.last_timestamp), out_bytes);
+    WriteVarint(room_index.postings.size(), out_bytes);
+    for (const auto& posting : room_index.postings) {
+      const PostingList& posting_list = posting.second;
+      WriteText(posting.first, out_bytes);
+      WriteVarint(posting_list.count, out_bytes);
+      WriteVarint(posting_list.last_id, out_bytes);
+      WriteVarint(posting_list.deltas.size(), out_bytes);
+      out_bytes->insert(out_bytes->end(), posting_list.deltas.begin(),
+                        posting_list.deltas.end());
+    }
+  }
+
+  bool ChatSearchIndex::WriteIndexFile(const string_t& index_file,
+                                       const vector<unsigned char>& bytes) {
+    // Format: magic, version, and the bytes: room count and chat rooms.
+    vector<unsigned char> header(begin(kIndexFileMagic), end(kIndexFileMagic));
+    WriteVarint(kIndexFileVersion, &header);
+    ofstream file(index_file, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+      return false;
+    }
+    file.write(reinterpret_cast<const char*>(header.data()),
+               static_cast<streamsize>(header.size()));
+    file.write(reinterpret_cast<const char*>(bytes.data()),
+               static_cast<streamsize>(bytes.size()));
+    file.close();
+    return !file.fail();
+  }
+
+  bool ChatSearchIndex::ReadIndexFile(const string_t& index_file,
+                                      ChatRoomIndexMap* out_rooms) {
+    MappedFile mapped_file;
+    if (!mapped_file.Open(index_file) ||
+        mapped_file.GetSize() < sizeof(kIndexFileMagic) ||
+        memcmp(mapped_file.GetData(), kIndexFileMagic,
+               sizeof(kIndexFileMagic)) != 0) {
+      return false;
+    }
+    const unsigned char* data =
+        reinterpret_cast<const unsigned char*>(mapped_file.GetData()) +
+        sizeof(kIndexFileMagic);
+    const unsigned char* const end = data + mapped_file.GetSize() -
+                                     sizeof(kIndexFileMagic);
+
+    ChatRoomIndexMap rooms;
+    uint64_t version = 0;
+    uint64_t room_count = 0;
+    if (!ReadVarint(&data, end, &version) || version != kIndexFileVersion ||
+        !ReadVarint(&data, end, &room_count)) {
+      return false;
+    }
+    for (uint64_t i = 0; i < room_count; ++i) {
+      ChatString chat_room;
+      uint64_t last_timestamp = 0;
+      uint64_t term_count = 0;
+      ChatRoomIndex room_index;
+      if (!ReadText(&data, end, &chat_room) ||
+          !ReadVarint(&data, end, &room_index.indexed_count) ||
+          !ReadVarint(&data, end, &last_timestamp) ||
+          !ReadVarint(&data, end, &term_count)) {
+        return false;
+      }
+      room_index.last_timestamp = static_cast<int64_t>(last_timestamp);
+      for (uint64_t j = 0; j < term_count; ++j) {
+        ChatString term;
+        PostingList posting_list;
+        uint64_t delta_size = 0;
+        if (!ReadText(&data, end, &term) ||
+            !ReadVarint(&data, end, &posting_list.count) ||
+            !ReadVarint(&data, end, &posting_list.last_id) ||
+            !ReadVarint(&data, end, &delta_size) ||
+            delta_size > static_cast<uint64_t>(end - data) ||
+            posting_list.last_id > room_index.indexed_count ||
+            posting_list.count > room_index.indexed_count ||
+            posting_list.count > delta_size) {
+          // Each id takes at least one byte, so a larger count is corrupt
+          // and must not size the candidates of a search.
+          return false;
+        }
+        posting_list.deltas.assign(data, data + delta_size);
+        data += delta_size;
+        // An id of 0 or out of order would read outside a snapshot.
+        if (!IsValidPostingList(posting_list)) {
+          return false;
+        }
+        room_index.posting_memory_usage +=
+            GetPostingMemoryUsage(term, posting_list);
+        room_index.postings.emplace(move(term), move(posting_list));
+      }
+      rooms.emplace(move(chat_room), move(room_index));
+    }
+    if (data != end) {
+      return false;
+    }
+    *out_rooms = move(rooms);
+    return true;
+  }
+
+  bool ChatSearchIndex::IsValidPostingList(const PostingList& posting_list) {
+    const unsigned char* data = posting_list.deltas.data();
+    const unsigned char* const end = data + posting_list.deltas.size();
+    uint64_t id = 0;
+    uint64_t count = 0;
+    uint64_t delta = 0;
+    while (data != end) {
+      if (!ReadVarint(&data, end, &delta) || delta == 0 ||
+          delta > posting_list.last_id - id) {
+        return false;
+      }
+      id += delta;
+      ++count;
+    }
+    return count == posting_list.count && id == posting_list.last_id;
+  }
+
+  uint64_t ChatSearchIndex::GetPostingMemoryUsage(
+      const ChatString& term,
+      const PostingList& posting_list) {
+    // A node has the next pointer and the hash beside the pair. The buffer
+    // of a short term is in place, which this counts anyway.
+    return sizeof(void*) + sizeof(size_t) +
+           sizeof(pair<const ChatString, PostingList>) +
+           term.capacity() * sizeof(ChatChar) + posting_list.deltas.capacity();
+  }
+
+  vector<uint64_t> ChatSearchIndex::FindCandidates(
+      const ChatRoomIndex& room_index,
+      const ChatSearchQuery& query) const {
+    vector<const PostingList*> posting_lists;
+    for (const ChatString& term : query.terms) {
+      const auto posting = room_index.postings.find(term);
+      if (posting == room_index.postings.end()) {
+        return vector<uint64_t>();
+      }
+      posting_lists.push_back(&posting->second);
+    }
+    sort(posting_lists.begin(), posting_lists.end(),
+         [](const PostingList* left, const PostingList* right) {
+      return left->count < right->count ||
+             (left->count == right->count && left < right);
+    });
+    posting_lists.erase(unique(posting_lists.begin(), posting_lists.end()),
+                        posting_lists.end());
+
+    // Decode the shortest list, and keep the ids found in every other one.
+    vector<uint64_t> candidates;
+    for (const PostingList* posting_list : posting_lists) {
+      const unsigned char* data = posting_list->deltas.data();
+      const unsigned char* const end = data + posting_list->deltas.size();
+      uint64_t id = 0;
+      uint64_t delta = 0;
+      if (posting_list == posting_lists.front()) {
+        candidates.reserve(static_cast<size_t>(posting_list->count));
+        while (ReadVarint(&data, end, &delta)) {
+          id += delta;
+          candidates.push_back(id);
+        }
+        continue;
+      }
+      size_t candidate = 0;
+      size_t kept_count = 0;
+      while (candidate < candidates.size() &&
+             ReadVarint(&data, end, &delta)) {
+        id += delta;
+        while (candidate < candidates.size() && candidates[candidate] < id) {
+          ++candidate;
+        }
+        if (candidate < candidates.size() && candidates[candidate] == id) {
+          candidates[kept_count++] = id;
+          ++candidate;
+        }
+      }
+      candidates.resize(kept_count);
+      if (candidates.empty()) {
+        break;
+      }
+    }
+    return candidates;
+  }
+
+} // namespace chatserver
@@ -0,0 +1,185 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CHATSEARCHINDEX_H_
+#define CHATSERVER_CHATSEARCHINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "cpprest/details/basic_types.h"
+#include "chat_message.h"
+#include "chat_room_log.h"
+#include "chat_string.h"
+#include "instrumented_mutex.h"
+
+// ChatSearchIndex is an inverted index of the chat messages of every chat
+// room: term -> ids of the chat messages that have it, per chat room. A
+// posting list keeps the id deltas as variable-length integers, so most ids
+// take one byte. The index is incremental: IndexChatRoom reads only the chat
+// messages of a snapshot after the ones indexed so far, so it is called after
+// every append and costs the tokenization of the new chat messages.
+// A query is a list of terms that a chat message must all have (AND), and
+// quoted phrases whose terms must also be adjacent in order. The shortest
+// posting list is decoded and intersected with the others; phrases are then
+// checked on the text of the candidates, so no term positions are kept.
+// Terms are runs of letters and digits, with ASCII letters lowercased. Every
+// non-ASCII code unit counts as a letter, so words of any script are terms,
+// without case folding.
+// The index is saved to a file with the number of chat messages indexed per
+// chat room, so a loaded index only indexes the chat messages stored after
+// it was saved. The timestamp of the last indexed chat message tells whether
+// the chat message file was replaced since. A chat room can also be saved to
+// and loaded from a file of its own, e.g. next to its log file.
+// Indexers of a chat room must be serialized by the caller, like the writers
+// of its log. Chat rooms are tokenized concurrently, without any lock.
+// Example:
+//   ChatSearchIndex search_index;
+//   search_index.IndexChatRoom(chat_room, *snapshot);
+//   ChatSearchQuery query;
+//   if (ChatSearchIndex::ParseQuery(CHATSERVER_TEXT("\"good morning\" kaist"),
+//                                   &query)) {
+//     search_index.Search(chat_room, query, *snapshot, 20, &chat_messages);
+//   }
+
+namespace chatserver {
+
+  // Terms of a search query.
+  struct ChatSearchQuery {
+    // Every term of the query. A chat message must have all of them.
+    std::vector<ChatString> terms;
+
+    // Quoted terms that must be adjacent in this order.
+    std::vector<std::vector<ChatString>> phrases;
+  };
+
+  class ChatSearchIndex {
+   public:
+    // Terms longer than this are not indexed.
+    static const size_t kMaxTermSize = 64;
+
+    // Name mutex_index_ for lock profiling.
+    ChatSearchIndex();
+
+    ChatSearchIndex(const ChatSearchIndex&) = delete;
+    ChatSearchIndex& operator=(const ChatSearchIndex&) = delete;
+
+    // Split the given text into its terms, in order, with duplicates.
+    static void Tokenize(ChatStringView text,
+                         std::vector<ChatString>* out_terms);
+
+    // Parse the given query: terms separated by anything but letters and
+    // digits, and phrases in double quotes. Return false if it has no term.
+    static bool ParseQuery(ChatStringView text, ChatSearchQuery* out_query);
+
+    // Index the chat messages of the snapshot after the ones indexed so far.
+    // If the index has more chat messages than the snapshot, or its last one
+    // has another timestamp, it is not of this chat room log, so the chat
+    // room is indexed again from the start.
+    void IndexChatRoom(const ChatString& chat_room,
+                       const ChatRoomSnapshot& snapshot);
+
+    // Append the latest limit chat messages of the snapshot that match the
+    // query to out_chat_messages, oldest first. Return the number appended.
+    // The snapshot must be of the given chat room. If the chat room is not
+    // indexed, e.g. while ChatDatabase evicts it, the snapshot is scanned.
+    size_t Search(const ChatString& chat_room,
+                  const ChatSearchQuery& query,
+                  const ChatRoomSnapshot& snapshot,
+                  size_t limit,
+                  std::pmr::vector<ChatMessageView>* out_chat_messages) const;
+
+    // Get the number of chat messages indexed in the given chat room.
+    uint64_t GetIndexedCount(const ChatString& chat_room) const;
+
+    // Get the approximate bytes of the index of the given chat room, or 0 if
+    // it is not indexed.
+    uint64_t GetMemoryUsage(const ChatString& chat_room) const;
+
+    // Drop the index of the given chat room, e.g. after SaveChatRoom.
+    void EraseChatRoom(const ChatString& chat_room);
+
+    // Write the index to the given file. Return false if it can't be
+    // written.
+    bool Save(const utility::string_t& index_file) const;
+
+    // Replace the index with the one in the given file. Return false and
+    // keep the index if the file can't be read or is malformed.
+    bool Load(const utility::string_t& index_file);
+
+    // Write the index of the given chat room to the given file, in the
+    // format of Save. Return false if the chat room is not indexed or the
+    // file can't be written.
+    bool SaveChatRoom(const ChatString& chat_room,
+                      const utility::string_t& index_file) const;
+
+    // Replace the index of the given chat room with the one in the given
+    // file. Return false and keep the index if the file can't be read, is
+    // malformed, or has no index of the chat room.
+    bool LoadChatRoom(const ChatString& chat_room,
+                      const utility::string_t& index_file);
+
+   private:
+    // Ids of the chat messages with a term, as deltas from the previous id
+    // in variable-length integers.
+    struct PostingList {
+      std::vector<unsigned char> deltas;
+      uint64_t last_id = 0;
+      uint64_t count = 0;
+    };
+
+    // Index of one chat room: term -> posting list, the number and the last
+    // timestamp of the indexed chat messages, and the bytes of the postings.
+    struct ChatRoomIndex {
+      std::unordered_map<ChatString, PostingList> postings;
+      uint64_t indexed_count = 0;
+      int64_t last_timestamp = 0;
+      uint64_t posting_memory_usage = 0;
+    };
+
+    typedef std::map<ChatString, ChatRoomIndex> ChatRoomIndexMap;
+
+    // Get the approximate bytes of a posting: its hash node, and the buffers
+    // of the term and the deltas.
+    static uint64_t GetPostingMemoryUsage(const ChatString& term,
+                                          const PostingList& posting_list);
+
+    // Append the name and the index of a chat room to bytes, in the format
+    // of Save.
+    static void WriteChatRoomIndex(const ChatString& chat_room,
+                                   const ChatRoomIndex& room_index,
+                                   std::vector<unsigned char>* out_bytes);
+
+    // Write the magic, the version and the given bytes to the file.
+    static bool WriteIndexFile(const utility::string_t& index_file,
+                               const std::vector<unsigned char>& bytes);
+
+    // Check the deltas of the posting list decode to count ids, each larger
+    // than the previous one and than 0, the last of them last_id.
+    static bool IsValidPostingList(const PostingList& posting_list);
+
+    // Read the chat rooms of the given index file. Return false if it can't
+    // be read or is malformed.
+    static bool ReadIndexFile(const utility::string_t& index_file,
+                              ChatRoomIndexMap* out_rooms);
+
+    // Get the ids of the chat room that have every term of the query,
+    // ascending. mutex_index_ must be held.
+    std::vector<uint64_t> FindCandidates(const ChatRoomIndex& room_index,
+                                         const ChatSearchQuery& query) const;
+
+    // Mutex for rooms_: held to add postings and to read them.
+    mutable InstrumentedMutex mutex_index_;
+
+    // Index of every chat room.
+    ChatRoomIndexMap rooms_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CHATSEARCHINDEX_H_
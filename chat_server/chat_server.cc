@@ -4,17 +4,31 @@
 
 #include "chat_server.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <limits>
+#include <memory_resource>
+#include <string_view>
+
+#include "async_logging.h"
+#include "cbor_codec.h"
+#include "content_coding.h"
 #include "cpprest/json.h"
-#include "cpprest/uri.h"
+#include "route_table.h"
 #include "spdlog/spdlog.h"
+#include "tracing.h"
 
 using namespace std;
-using ::web::uri;
 using ::web::http::methods;
+using ::web::http::header_names;
 using ::web::http::http_request;
+using ::web::http::http_response;
 using ::web::http::status_codes;
 using ::web::http::experimental::listener::http_listener;
 using ::web::json::value;
+using ::web::uri;
 using ::utility::string_t;
 using ::utility::conversions::to_utf8string;
 using ::pplx::task;
@@ -24,12 +38,160 @@ using ::spdlog::error;
 
 namespace chatserver {
 
+  namespace {
+
+    // View of a query parameter or a header value.
+    typedef basic_string_view<utility::char_t> StringView;
+
+    // Maximum number of chat messages in a batch request.
+    const size_t kMaxBatchChatMessages = 1000;
+
+    // Unmatched requests are logged at most kUnmatchedRequestLogBurst times
+    // per second, and then one in kUnmatchedRequestLogSampling.
+    const uint64_t kUnmatchedRequestLogBurst = 10;
+    const uint64_t kUnmatchedRequestLogSampling = 1000;
+
+    // Response bodies smaller than this are not compressed: the saving does
+    // not pay for the compression time and the gzip header.
+    const size_t kCompressionThreshold = 1024;
+
+    // Chat messages of a search, user history or multi-room reply when the
+    // request gives no limit, and the most it may ask for.
+    const size_t kDefaultQueryLimit = 100;
+    const size_t kMaxQueryLimit = 1000;
+
+    // The response cache gets 1/kResponseCacheBudgetDivisor of a memory
+    // budget, as a cached body is about as large as its chat room.
+    const uint64_t kResponseCacheBudgetDivisor = 4;
+
+    // Vary of a reply whose body depends on Accept, and of one that may be
+    // compressed as well. A 304 reply repeats the Vary of its 200 reply.
+    const utility::char_t kVaryAccept[] = UU("Accept");
+    const utility::char_t kVaryAcceptAndEncoding[] =
+        UU("Accept, Accept-Encoding");
+
+    // Bytes of the stack buffer of a request arena. The query parameters and
+    // the temporaries of most requests fit in it.
+    const size_t kRequestArenaSize = 4096;
+
+    // Make the JSON object of the given chat message for an HTTP response.
+    // Message is a ChatMessage or a ChatMessageView.
+    template <typename Message>
+    value MakeChatMessageJson(const Message& chat_message) {
+      value json_obj = value::object();
+      json_obj[UU("date")] = value::number(chat_message.date);
+      json_obj[UU("user_id")] = value::string(ToStringT(chat_message.user_id));
+      json_obj[UU("message")] =
+          value::string(ToStringT(chat_message.chat_message));
+      json_obj[UU("room")] = value::string(ToStringT(chat_message.chat_room));
+      json_obj[UU("timestamp")] = value::number(chat_message.timestamp);
+      json_obj[UU("id")] = value::number(chat_message.id);
+      return json_obj;
+    }
+
+    // Parse the given decimal number: a Unix time or a chat message id.
+    // Return false if it is not a number.
+    template <typename Integer>
+    bool ParseDecimal(StringView text, Integer* out_value) {
+      if (text.empty() || text.size() > 18) {
+        return false;
+      }
+      Integer result = 0;
+      for (const utility::char_t c : text) {
+        if (c < UU('0') || c > UU('9')) {
+          return false;
+        }
+        result = result * 10 + (c - UU('0'));
+      }
+      *out_value = result;
+      return true;
+    }
+
+    // Parse the optional "limit" of the given query into out_limit, and set
+    // out_has_limit, if given, to whether the query has it. Return false if
+    // it is not a number from 1 to kMaxQueryLimit.
+    bool ParseQueryLimit(const UrlQuery& url_query,
+                         size_t* out_limit,
+                         bool* out_has_limit = nullptr) {
+      StringView limit_string;
+      const bool has_limit = url_query.FindView(UU("limit"), &limit_string);
+      if (out_has_limit != nullptr) {
+        *out_has_limit = has_limit;
+      }
+      if (!has_limit) {
+        *out_limit = kDefaultQueryLimit;
+        return true;
+      }
+      size_t limit = 0;
+      if (!ParseDecimal(limit_string, &limit) || limit == 0 ||
+          limit > kMaxQueryLimit) {
+        return false;
+      }
+      *out_limit = limit;
+      return true;
+    }
+
+    // Reply to POST chatmessage once the sequencer has stored its chat
+    // messages. They are validated before submission, so a failure here
+    // means the chat message file could not be written.
+    void ReplyChatMessagesStored(const http_request& message, bool is_stored) {
+      if (is_stored) {
+        message.reply(status_codes::OK);
+      } else {
+        message.reply(status_codes::InternalError,
+                      UU("Unable to store the chat message"));
+      }
+    }
+
+    // Reply to a request whose chat room can't be loaded: 503 if it is larger
+    // than the memory budget, and 500 if its log file can't be read.
+    void ReplyChatRoomLoadFailure(const http_request& message,
+                                  ChatDatabase::LoadResult load_result) {
+      if (load_result == ChatDatabase::kLoadOverMemoryBudget) {
+        message.reply(status_codes::ServiceUnavailable,
+                      UU("Chat room is larger than the memory budget"));
+      } else {
+        message.reply(status_codes::InternalError,
+                      UU("Unable to load the chat room"));
+      }
+    }
+
+    // Serialize the given chat messages as a JSON array in UTF-8.
+    // ChatMessages is a std::vector<ChatMessage>, a ChatRoomSnapshot or a
+    // std::pmr::vector<ChatMessageView>.
+    template <typename ChatMessages>
+    vector<unsigned char> SerializeChatMessagesJson(
+        const ChatMessages& chat_messages) {
+      value result = value::array(chat_messages.size());
+      for (size_t idx = 0; idx < chat_messages.size(); ++idx) {
+        result[idx] = MakeChatMessageJson(chat_messages[idx]);
+      }
+      const string body = to_utf8string(result.serialize());
+      return vector<unsigned char>(body.begin(), body.end());
+    }
+
+  } // namespace
+
   ChatServer::ChatServer(ChatDatabase* chat_database, 
                          AccountDatabase* account_database, 
                          SessionManager* session_manager)
                          : chat_database_(chat_database),
                            account_database_(account_database),
-                           session_manager_(session_manager) {
+                           session_manager_(session_manager),
+                           entity_tag_epoch_(
+                               utility::conversions::to_string_t(
+                                   to_string(time(nullptr)))),
+                           unmatched_request_log_(
+                               kUnmatchedRequestLogBurst,
+                               chrono::seconds(1),
+                               kUnmatchedRequestLogSampling),
+                           chat_message_sequencer_(chat_database) {
+  }
+
+  ChatServer::~ChatServer() {
+    if (chat_database_ != nullptr) {
+      chat_database_->SetEvictedCallback(nullptr);
+    }
   }
 
   bool ChatServer::Initialize(string_t server_url) {
@@ -39,7 +201,13 @@ namespace chatserver {
       error("chat_database, account_database, or session_manager is nullptr.");
       return false;
     }
+    // The cached bodies of a chat room are as large as its log, so they are
+    // dropped with it to keep the memory budget.
+    chat_database_->SetEvictedCallback([this](const ChatString& chat_room) {
+      response_cache_.Erase(ToStringT(chat_room));
+    });
     session_manager_->RunSessionExpireThread();
+    chat_message_sequencer_.RunSequencerThread();
 
     // HTTP request listener from cpprestsdk.
     listener_ = http_listener(server_url);  
@@ -56,90 +224,468 @@ namespace chatserver {
     return true;
   }
 
+  void ChatServer::SetMemoryBudget(uint64_t memory_budget) {
+    if (memory_budget == 0) {
+      response_cache_.SetCapacity(ResponseCache::kDefaultCapacity);
+      chat_database_->SetMemoryBudget(0);
+      return;
+    }
+    const uint64_t cache_capacity =
+        memory_budget / kResponseCacheBudgetDivisor;
+    response_cache_.SetCapacity(cache_capacity);
+    chat_database_->SetMemoryBudget(memory_budget - cache_capacity);
+  }
+
   task<void> ChatServer::OpenServer() {
+    // It is stopped by CloseServer.
+    chat_message_sequencer_.RunSequencerThread();
     return listener_.open();
   }
 
   task<void> ChatServer::CloseServer() {
-    return listener_.close();
+    // The sequencer stores the chat messages the listener took before it is
+    // joined, even if the listener fails to close.
+    return listener_.close().then([this](task<void> closed) {
+      chat_message_sequencer_.StopSequencerThread();
+      closed.get();
+    });
+  }
+
+  vector<unsigned char> ChatServer::SerializeChatMessages(
+      const vector<ChatMessage>& chat_messages,
+      bool is_cbor) {
+    if (is_cbor) {
+      // The columnar layout writes each key once and hoists the chat room.
+      return CborCodec::EncodeChatMessages(chat_messages);
+    }
+    return SerializeChatMessagesJson(chat_messages);
+  }
+
+  vector<unsigned char> ChatServer::SerializeChatMessages(
+      const ChatRoomSnapshot& chat_messages,
+      bool is_cbor) {
+    if (is_cbor) {
+      return CborCodec::EncodeChatRoomSnapshot(chat_messages);
+    }
+    return SerializeChatMessagesJson(chat_messages);
+  }
+
+  vector<unsigned char> ChatServer::SerializeChatMessages(
+      const pmr::vector<ChatMessageView>& chat_messages,
+      bool is_cbor) {
+    if (is_cbor) {
+      return CborCodec::EncodeChatMessageViews(chat_messages);
+    }
+    return SerializeChatMessagesJson(chat_messages);
   }
 
   void ChatServer::HandleGet(const http_request& message) {
-    // Path of HTTP request URL.
-    // path[n] means the name of the nth path in HTTP request URL.
-    vector<string_t> url_paths = uri::split_path(
-        uri::decode(message.relative_uri().path()));
-    
-    // Query string of HTTP request URL.
-    // Format: map<string_t, string_t> = <query name, query value>
-    map<string_t, string_t> url_queries = uri::split_query(
-        uri::decode(message.relative_uri().query()));
-
-    if (url_paths.empty()) {
-      message.reply(status_codes::NotFound);
+    CHATSERVER_TRACE_REQUEST("ChatServer::HandleGet");
+    // relative_uri() returns a copy, so take it once.
+    const uri relative_uri = message.relative_uri();
+    const Route route = RouteTable::Resolve(message.method(),
+                                            relative_uri.path());
+    if (route == Route::kNotFound) {
+      ReplyNotFound(message);
       return;
     }
 
-    if (!CheckAndUpdateValidSession(url_queries)) {
+    // API service without session ID.
+    if (route == Route::kGetMetrics) {
+      ProcessGetMetricsRequest(message);
+      return;
+    }
+
+    // Temporaries of the request are allocated from a buffer on the stack,
+    // and from the heap only when it is used up. They are released at once
+    // when the request returns.
+    alignas(max_align_t) unsigned char request_buffer[kRequestArenaSize];
+    pmr::monotonic_buffer_resource request_arena(request_buffer,
+                                                 sizeof(request_buffer));
+
+    // Query string of HTTP request URL. It is parsed on the first lookup.
+    const UrlQuery url_query(relative_uri.query(), &request_arena);
+    if (!CheckAndUpdateValidSession(url_query)) {
       message.reply(status_codes::Forbidden,
                     UU("Not a valid session ID"));
       return;
     }
 
     // Process API service: get chat message, get chat room list.
-    string_t first_request_url_path = url_paths[0];
-    if (first_request_url_path == UU("chatmessage")) {
-      ProcessGetChatMessageRequest(message, url_queries);
-      return;
-    } else if (first_request_url_path == UU("chatroom")) {
-      ProcessGetChatRoomRequest(message);
-      return;
+    switch (route) {
+      case Route::kGetChatMessage:
+        ProcessGetChatMessageRequest(message, url_query, &request_arena);
+        return;
+      case Route::kGetChatRoom:
+        ProcessGetChatRoomRequest(message);
+        return;
+      case Route::kGetChatMessageMulti:
+        ProcessGetChatMessageMultiRequest(message, url_query,
+                                          &request_arena);
+        return;
+      case Route::kGetSearch:
+        ProcessGetSearchRequest(message, url_query, &request_arena);
+        return;
+      case Route::kGetUserChatMessages:
+        ProcessGetUserChatMessagesRequest(message, url_query, &request_arena);
+        return;
+      case Route::kGetMemoryUsage:
+        ProcessGetMemoryUsageRequest(message);
+        return;
+      default:
+        break;
     }
 
-    // No matching HTTP request.
-    warn("No matching HTTP request");
-    message.reply(status_codes::NotFound);
+    ReplyNotFound(message);
   }
 
   void ChatServer::ProcessGetChatMessageRequest(
       const http_request& message,
-      const map<string_t, string_t>& url_queries) {
-    const auto chat_room_it = url_queries.find(UU("chat_room"));
-    if (chat_room_it == url_queries.end()) {
+      const UrlQuery& url_query,
+      pmr::memory_resource* request_arena) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessGetChatMessageRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kGetChatMessage));
+    string_t chat_room_query;
+    if (!url_query.Find(UU("chat_room"), &chat_room_query)) {
       message.reply(status_codes::BadRequest,
                     UU("Chat room information missing"));
       return;
     }
 
-    if (!chat_database_->IsExistChatRoom(chat_room_it->second)) {
+    const ChatString& chat_room = ToChatString(chat_room_query);
+    if (!chat_database_->IsExistChatRoom(chat_room)) {
       message.reply(status_codes::BadRequest,
-                    UU("There are no chat rooms: ") + chat_room_it->second);
+                    UU("There are no chat rooms: ") + chat_room_query);
       return;
     }
 
-    const vector<ChatMessage>* chat_messages =
-        chat_database_->GetAllChatMessages(chat_room_it->second);
-    value result = value::array(); // Body data for HTTP response.
-    size_t idx = 0;
-    for (auto chat_message = chat_messages->begin(); 
-         chat_message != chat_messages->end(); 
-         ++chat_message) {
-      value json_obj = value::object();
-      json_obj[UU("date")] = value::number(chat_message->date);
-      json_obj[UU("user_id")] = value::string(chat_message->user_id);
-      json_obj[UU("message")] = value::string(
-          chat_message->chat_message);
-      json_obj[UU("room")] = value::string(chat_message->chat_room);
+    uint64_t since_id = 0;
+    StringView since_id_string;
+    const bool has_since_id =
+        url_query.FindView(UU("since_id"), &since_id_string);
+    if (has_since_id && !ParseDecimal(since_id_string, &since_id)) {
+      message.reply(status_codes::BadRequest, UU("Invalid since_id"));
+      return;
+    }
 
-      result[idx++] = json_obj;
+    // The time range is [from, to) in microseconds, as the timestamps.
+    int64_t from = 0;
+    int64_t to = numeric_limits<int64_t>::max();
+    StringView time_string;
+    const bool has_from = url_query.FindView(UU("from"), &time_string);
+    if (has_from && !ParseDecimal(time_string, &from)) {
+      message.reply(status_codes::BadRequest, UU("Invalid from"));
+      return;
+    }
+    const bool has_to = url_query.FindView(UU("to"), &time_string);
+    if (has_to && !ParseDecimal(time_string, &to)) {
+      message.reply(status_codes::BadRequest, UU("Invalid to"));
+      return;
+    }
+
+    size_t limit = 0;
+    bool has_limit = false;
+    if (!ParseQueryLimit(url_query, &limit, &has_limit)) {
+      message.reply(status_codes::BadRequest, UU("Invalid limit"));
+      return;
+    }
+
+    // The snapshot is never changed, so it is serialized without a lock.
+    // Its size is the chat room version, so the entity tag always matches
+    // the body. A chat room that can't be loaded gets neither a body nor an
+    // entity tag, so its history never reads as empty.
+    ChatDatabase::LoadResult load_result = ChatDatabase::kLoadSuccess;
+    const shared_ptr<const ChatRoomSnapshot> chat_messages =
+        chat_database_->GetAllChatMessages(chat_room, &load_result);
+    if (chat_messages == nullptr) {
+      ReplyChatRoomLoadFailure(message, load_result);
+      return;
+    }
+    const uint64_t version = chat_messages->size();
+    const bool is_cbor = AcceptsCbor(message);
+    if (has_since_id || has_from || has_to || has_limit) {
+      // The chat messages after since_id start at its index, and the ones in
+      // the time range are found with the time index of the snapshot, so
+      // only the replied ones are read. The body is new for every query, so
+      // it is neither cached nor tagged, and bounded by the limit: the first
+      // chat messages after since_id or in the time range, or else the
+      // latest ones.
+      size_t begin = chat_messages->GetIndexAfterId(since_id);
+      size_t end = chat_messages->size();
+      const bool has_time_range = has_from || has_to;
+      const bool is_time_indexed =
+          has_time_range && chat_messages->is_time_ordered();
+      if (is_time_indexed) {
+        begin = max(begin, chat_messages->GetIndexAtTimestamp(from));
+        end = max(begin, chat_messages->GetIndexAtTimestamp(to));
+      }
+      if (!has_since_id && !has_time_range && end - begin > limit) {
+        begin = end - limit;
+      }
+      pmr::vector<ChatMessageView> result(request_arena);
+      result.reserve(min(end - begin, limit));
+      for (size_t i = begin; i < end && result.size() < limit; ++i) {
+        const ChatMessageView& chat_message = (*chat_messages)[i];
+        // Out-of-order timestamps of an old file are filtered one by one.
+        if (has_time_range && !is_time_indexed &&
+            (chat_message.timestamp < from || chat_message.timestamp >= to)) {
+          continue;
+        }
+        result.push_back(chat_message);
+      }
+      ReplyChatMessages(message, result, is_cbor, UU(""));
+      return;
     }
 
-    message.reply(status_codes::OK, result);
+    // Serialize and compress once per version of the chat room. The content
+    // coding depends on the body size, so the body is taken from the cache
+    // before the entity tag, which differs for each content coding.
+    ResponseCache::Body body = response_cache_.GetBody(
+        chat_room_query, is_cbor, version, [&]() {
+          return SerializeChatMessages(*chat_messages, is_cbor);
+        });
+    string_t content_coding = SelectContentCoding(message, body->size());
+    string_t entity_tag = MakeEntityTag(version, is_cbor, content_coding);
+    if (ReplyNotModifiedIfMatch(message, entity_tag,
+                                kVaryAcceptAndEncoding)) {
+      return;
+    }
+    if (!content_coding.empty()) {
+      const ResponseCache::Body compressed_body =
+          response_cache_.GetCompressedBody(chat_room_query, is_cbor,
+                                            version, content_coding, body);
+      if (compressed_body != nullptr) {
+        body = compressed_body;
+      } else {
+        content_coding.clear();
+        entity_tag = MakeEntityTag(version, is_cbor, content_coding);
+      }
+    }
+    ReplySerializedBody(message, *body, is_cbor, content_coding, entity_tag);
     return;
   }
 
+  void ChatServer::ProcessGetChatMessageMultiRequest(
+      const http_request& message,
+      const UrlQuery& url_query,
+      pmr::memory_resource* request_arena) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessGetChatMessageMultiRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kGetChatMessageMulti));
+    StringView rooms;
+    if (!url_query.FindView(UU("rooms"), &rooms) || rooms.empty()) {
+      message.reply(status_codes::BadRequest,
+                    UU("Chat room information missing"));
+      return;
+    }
+
+    int64_t since = 0;
+    StringView since_string;
+    const bool has_since = url_query.FindView(UU("since"), &since_string);
+    if (has_since && !ParseDecimal(since_string, &since)) {
+      message.reply(status_codes::BadRequest, UU("Invalid since"));
+      return;
+    }
+
+    size_t limit = 0;
+    if (!ParseQueryLimit(url_query, &limit)) {
+      message.reply(status_codes::BadRequest, UU("Invalid limit"));
+      return;
+    }
+
+    // A listed chat room, its optional since_id, and the range of its
+    // snapshot to reply.
+    struct ChatRoomRange {
+      StringView chat_room_query;
+      uint64_t since_id;
+      bool has_since_id;
+      shared_ptr<const ChatRoomSnapshot> chat_messages;
+      size_t begin;
+      size_t end;
+    };
+
+    // Check every chat room before building the body data. The snapshots
+    // keep the text of the chat message views below.
+    pmr::vector<ChatRoomRange> ranges(request_arena);
+    size_t start_index = 0;
+    while (start_index <= rooms.size()) {
+      size_t end_index = rooms.find(UU(','), start_index);
+      if (end_index == StringView::npos) {
+        end_index = rooms.size();
+      }
+      StringView chat_room_query =
+          rooms.substr(start_index, end_index - start_index);
+      start_index = end_index + 1;
+      uint64_t since_id = 0;
+      const size_t since_id_index = chat_room_query.rfind(UU(':'));
+      const bool has_since_id = since_id_index != StringView::npos;
+      if (has_since_id) {
+        if (!ParseDecimal(chat_room_query.substr(since_id_index + 1),
+                          &since_id)) {
+          message.reply(status_codes::BadRequest, UU("Invalid since_id"));
+          return;
+        }
+        chat_room_query = chat_room_query.substr(0, since_id_index);
+      }
+      if (find_if(ranges.begin(), ranges.end(),
+                  [chat_room_query](const ChatRoomRange& range) {
+        return range.chat_room_query == chat_room_query;
+      }) != ranges.end()) {
+        message.reply(status_codes::BadRequest,
+                      UU("Duplicated chat room: ") +
+                          string_t(chat_room_query));
+        return;
+      }
+      const ChatString chat_room = ToChatString(string_t(chat_room_query));
+      if (!chat_database_->IsExistChatRoom(chat_room)) {
+        message.reply(status_codes::BadRequest,
+                      UU("There are no chat rooms: ") +
+                          string_t(chat_room_query));
+        return;
+      }
+      ChatDatabase::LoadResult load_result = ChatDatabase::kLoadSuccess;
+      shared_ptr<const ChatRoomSnapshot> chat_messages =
+          chat_database_->GetAllChatMessages(chat_room, &load_result);
+      if (chat_messages == nullptr) {
+        ReplyChatRoomLoadFailure(message, load_result);
+        return;
+      }
+      ranges.push_back({chat_room_query, since_id, has_since_id,
+                        move(chat_messages), 0, 0});
+    }
+
+    // Only the replied chat messages are read: the ones after since_id
+    // start at its index, and the ones at or after since are found with the
+    // time index of the snapshot. A chat room with a since_id or since
+    // replies the first "limit" chat messages after it, so a client pages
+    // forward without a gap, and one without replies the latest ones.
+    size_t chat_message_count = 0;
+    for (ChatRoomRange& range : ranges) {
+      const ChatRoomSnapshot& chat_messages = *range.chat_messages;
+      range.begin = chat_messages.GetIndexAfterId(range.since_id);
+      range.end = chat_messages.size();
+      if (has_since && chat_messages.is_time_ordered()) {
+        range.begin =
+            max(range.begin, chat_messages.GetIndexAtTimestamp(since));
+      }
+      if (range.end - range.begin > limit && !range.has_since_id &&
+          !has_since) {
+        range.begin = range.end - limit;
+      }
+      chat_message_count += min(range.end - range.begin, limit);
+    }
+    pmr::vector<ChatMessageView> result(request_arena);
+    result.reserve(chat_message_count);
+    for (const ChatRoomRange& range : ranges) {
+      const ChatRoomSnapshot& chat_messages = *range.chat_messages;
+      const bool is_time_indexed = chat_messages.is_time_ordered();
+      size_t chat_room_count = 0;
+      for (size_t i = range.begin;
+           i < range.end && chat_room_count < limit; ++i) {
+        const ChatMessageView& chat_message = chat_messages[i];
+        // Out-of-order timestamps of an old file are filtered one by one.
+        if (has_since && !is_time_indexed && chat_message.timestamp < since) {
+          continue;
+        }
+        result.push_back(chat_message);
+        ++chat_room_count;
+      }
+    }
+    ReplyChatMessages(message, result, AcceptsCbor(message), UU(""));
+  }
+
+  void ChatServer::ProcessGetSearchRequest(
+      const http_request& message,
+      const UrlQuery& url_query,
+      pmr::memory_resource* request_arena) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessGetSearchRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kGetSearch));
+    string_t query_text;
+    ChatSearchQuery query;
+    if (!url_query.Find(UU("q"), &query_text) ||
+        !ChatSearchIndex::ParseQuery(ToChatString(query_text), &query)) {
+      message.reply(status_codes::BadRequest, UU("Search terms missing"));
+      return;
+    }
+
+    size_t limit = 0;
+    if (!ParseQueryLimit(url_query, &limit)) {
+      message.reply(status_codes::BadRequest, UU("Invalid limit"));
+      return;
+    }
+
+    // Search the given chat room, or every chat room. The snapshots keep the
+    // text of the chat message views below.
+    string_t chat_room_query;
+    vector<shared_ptr<const ChatRoomSnapshot>> snapshots;
+    pmr::vector<ChatMessageView> result(request_arena);
+    ChatDatabase::LoadResult load_result = ChatDatabase::kLoadSuccess;
+    if (url_query.Find(UU("room"), &chat_room_query)) {
+      const ChatString chat_room = ToChatString(chat_room_query);
+      if (!chat_database_->IsExistChatRoom(chat_room)) {
+        message.reply(status_codes::BadRequest,
+                      UU("There are no chat rooms: ") + chat_room_query);
+        return;
+      }
+      snapshots.push_back(chat_database_->SearchChatMessages(
+          chat_room, query, limit, &result, &load_result));
+    } else {
+      snapshots = chat_database_->SearchAllChatMessages(query, limit, &result,
+                                                        &load_result);
+    }
+    if (load_result != ChatDatabase::kLoadSuccess) {
+      ReplyChatRoomLoadFailure(message, load_result);
+      return;
+    }
+    ReplyChatMessages(message, result, AcceptsCbor(message), UU(""));
+  }
+
+  void ChatServer::ProcessGetUserChatMessagesRequest(
+      const http_request& message,
+      const UrlQuery& url_query,
+      pmr::memory_resource* request_arena) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessGetUserChatMessagesRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kGetUserChatMessages));
+    string_t user_id;
+    if (!url_query.Find(UU("user_id"), &user_id) || user_id.empty()) {
+      message.reply(status_codes::BadRequest, UU("User ID missing"));
+      return;
+    }
+    size_t limit = 0;
+    if (!ParseQueryLimit(url_query, &limit)) {
+      message.reply(status_codes::BadRequest, UU("Invalid limit"));
+      return;
+    }
+
+    // The snapshots keep the text of the chat message views below.
+    pmr::vector<ChatMessageView> result(request_arena);
+    ChatDatabase::LoadResult load_result = ChatDatabase::kLoadSuccess;
+    const vector<shared_ptr<const ChatRoomSnapshot>> snapshots =
+        chat_database_->GetUserChatMessages(ToChatString(user_id), limit,
+                                            &result, &load_result);
+    if (load_result != ChatDatabase::kLoadSuccess) {
+      ReplyChatRoomLoadFailure(message, load_result);
+      return;
+    }
+    ReplyChatMessages(message, result, AcceptsCbor(message), UU(""));
+  }
+
   void ChatServer::ProcessGetChatRoomRequest(const http_request& message) {
-    const vector<string_t>* chat_room_list = chat_database_->GetChatRoomList();
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessGetChatRoomRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kGetChatRoom));
+    const bool is_cbor = AcceptsCbor(message);
+    const string_t entity_tag = MakeEntityTag(
+        chat_database_->GetChatRoomListVersion(), is_cbor, UU(""));
+    if (ReplyNotModifiedIfMatch(message, entity_tag, kVaryAccept)) {
+      return;
+    }
+
+    const shared_ptr<const vector<ChatString>> chat_room_list =
+        chat_database_->GetChatRoomList();
     value result = value::array();  // Body data for HTTP response.
     size_t idx = 0;
     for (auto room = chat_room_list->begin(); 
@@ -147,27 +693,245 @@ namespace chatserver {
          ++room) {
       value json_obj = value::object();
 
-      json_obj[UU("room")] = value::string(room->data());
+      json_obj[UU("room")] = value::string(ToStringT(*room));
       result[idx++] = json_obj;
     }
-    message.reply(status_codes::OK, result);
+    ReplyBody(message, result, is_cbor, entity_tag);
+  }
+
+  void ChatServer::ProcessGetMetricsRequest(const http_request& message) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessGetMetricsRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kGetMetrics));
+    MetricsRegistry::Gauges gauges;
+    gauges.session_count = session_manager_->GetSessionCount();
+    gauges.chat_room_count = chat_database_->GetChatRoomList()->size();
+    gauges.chat_message_count = chat_database_->GetChatMessageCount();
+    gauges.chat_memory_bytes = chat_database_->GetMemoryUsage();
+    gauges.dropped_log_message_count = AsyncLogging::GetDroppedMessageCount();
+    const string body = metrics_.ExportPrometheusText(gauges);
+    metrics_.AddResponseBytes(body.size());
+
+    http_response response(status_codes::OK);
+    response.set_body(body, "text/plain; version=0.0.4; charset=utf-8");
+    message.reply(response);
+  }
+
+  void ChatServer::ProcessGetMemoryUsageRequest(const http_request& message) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessGetMemoryUsageRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kGetMemoryUsage));
+    value chat_rooms = value::array();
+    size_t idx = 0;
+    for (const auto& memory_usage :
+         chat_database_->GetChatRoomMemoryUsages()) {
+      value json_obj = value::object();
+      json_obj[UU("room")] =
+          value::string(ToStringT(memory_usage.chat_room));
+      json_obj[UU("bytes")] = value::number(memory_usage.bytes);
+      chat_rooms[idx++] = json_obj;
+    }
+    value result = value::object();  // Body data for HTTP response.
+    result[UU("budget")] = value::number(chat_database_->GetMemoryBudget());
+    result[UU("bytes")] = value::number(chat_database_->GetMemoryUsage());
+    result[UU("rooms")] = chat_rooms;
+    result[UU("cache_capacity")] =
+        value::number(response_cache_.GetCapacity());
+    result[UU("cache_bytes")] = value::number(response_cache_.GetMemoryUsage());
+    ReplyBody(message, result, AcceptsCbor(message), UU(""));
+  }
+
+  bool ChatServer::AcceptsCbor(const http_request& message) const {
+    // find() rather than match(), which copies the header value.
+    const auto accept = message.headers().find(header_names::accept);
+    return accept != message.headers().end() &&
+           CborCodec::IsCborMediaType(accept->second);
+  }
+
+  string_t ChatServer::MakeEntityTag(uint64_t version,
+                                     bool is_cbor,
+                                     const string_t& content_coding) const {
+    // Each representation of a resource, and each content coding of it, has
+    // different bytes, so it needs its own strong entity tag. It is built in
+    // one allocation.
+    utility::char_t version_digits[20];
+    size_t digit_count = 0;
+    do {
+      version_digits[digit_count++] =
+          static_cast<utility::char_t>(UU('0') + version % 10);
+      version /= 10;
+    } while (version != 0);
+
+    string_t entity_tag;
+    entity_tag.reserve(entity_tag_epoch_.size() + digit_count +
+                       content_coding.size() + 9);
+    entity_tag += UU('"');
+    entity_tag += entity_tag_epoch_;
+    entity_tag += UU('-');
+    while (digit_count > 0) {
+      entity_tag += version_digits[--digit_count];
+    }
+    if (is_cbor) {
+      entity_tag += UU("-cbor");
+    }
+    if (!content_coding.empty()) {
+      entity_tag += UU('-');
+      entity_tag += content_coding;
+    }
+    entity_tag += UU('"');
+    return entity_tag;
+  }
+
+  bool ChatServer::ReplyNotModifiedIfMatch(const http_request& message,
+                                           const string_t& entity_tag,
+                                           const string_t& vary) const {
+    const auto header = message.headers().find(header_names::if_none_match);
+    if (header == message.headers().end()) {
+      return false;
+    }
+    const StringView if_none_match(header->second);
+
+    // If-None-Match is "*" or a comma-separated list of entity tags.
+    bool is_matched = false;
+    size_t start_index = 0;
+    while (start_index <= if_none_match.size() && !is_matched) {
+      size_t end_index = if_none_match.find(UU(','), start_index);
+      if (end_index == StringView::npos) {
+        end_index = if_none_match.size();
+      }
+      const size_t first = if_none_match.find_first_not_of(UU(" \t"),
+                                                           start_index);
+      const size_t last = if_none_match.find_last_not_of(UU(" \t"),
+                                                         end_index - 1);
+      if (first != StringView::npos && first < end_index && last >= first) {
+        const StringView candidate =
+            if_none_match.substr(first, last - first + 1);
+        // A weak entity tag matches as well (weak comparison).
+        is_matched = candidate == UU("*") || candidate == entity_tag ||
+                     (candidate.substr(0, 2) == UU("W/") &&
+                      candidate.substr(2) == entity_tag);
+      }
+      start_index = end_index + 1;
+    }
+    if (!is_matched) {
+      return false;
+    }
+
+    http_response response(status_codes::NotModified);
+    response.headers().add(header_names::etag, entity_tag);
+    response.headers().add(header_names::vary, vary);
+    message.reply(response);
+    return true;
+  }
+
+  void ChatServer::ReplyBody(const http_request& message,
+                             const value& body_data,
+                             bool is_cbor,
+                             const string_t& entity_tag) const {
+    CHATSERVER_TRACE_SPAN("ChatServer::ReplyBody");
+    http_response response(status_codes::OK);
+    if (is_cbor) {
+      const vector<unsigned char> body = CborCodec::EncodeJson(body_data);
+      metrics_.AddResponseBytes(body.size());
+      response.set_body(body);
+      response.headers().set_content_type(CborCodec::kMediaType);
+    } else {
+      // Serialize here rather than in set_body() to count the size.
+      const string body = to_utf8string(body_data.serialize());
+      metrics_.AddResponseBytes(body.size());
+      response.set_body(body, "application/json");
+    }
+    if (!entity_tag.empty()) {
+      response.headers().add(header_names::etag, entity_tag);
+    }
+    response.headers().add(header_names::vary, kVaryAccept);
+    message.reply(response);
+  }
+
+  void ChatServer::ReplyChatMessages(
+      const http_request& message,
+      const pmr::vector<ChatMessageView>& chat_messages,
+      bool is_cbor,
+      const string_t& entity_tag) const {
+    const vector<unsigned char> body =
+        SerializeChatMessages(chat_messages, is_cbor);
+    const string_t content_coding = SelectContentCoding(message, body.size());
+    vector<unsigned char> compressed_body;
+    if (!content_coding.empty() &&
+        ContentCoding::Compress(content_coding, body, &compressed_body)) {
+      ReplySerializedBody(message, compressed_body, is_cbor, content_coding,
+                          entity_tag);
+      return;
+    }
+    ReplySerializedBody(message, body, is_cbor, UU(""), entity_tag);
+  }
+
+  string_t ChatServer::SelectContentCoding(const http_request& message,
+                                           size_t body_size) const {
+    if (body_size < kCompressionThreshold) {
+      return string_t();
+    }
+    const auto accept_encoding =
+        message.headers().find(header_names::accept_encoding);
+    if (accept_encoding == message.headers().end()) {
+      return string_t();
+    }
+    return ContentCoding::Select(accept_encoding->second);
+  }
+
+  void ChatServer::ReplySerializedBody(const http_request& message,
+                                       const vector<unsigned char>& body,
+                                       bool is_cbor,
+                                       const string_t& content_coding,
+                                       const string_t& entity_tag) const {
+    CHATSERVER_TRACE_SPAN("ChatServer::ReplySerializedBody");
+    metrics_.AddResponseBytes(body.size());
+    http_response response(status_codes::OK);
+    response.set_body(body);
+    response.headers().set_content_type(
+        is_cbor ? CborCodec::kMediaType : UU("application/json"));
+    if (!content_coding.empty()) {
+      response.headers().add(header_names::content_encoding, content_coding);
+    }
+    if (!entity_tag.empty()) {
+      response.headers().add(header_names::etag, entity_tag);
+    }
+    response.headers().add(header_names::vary, kVaryAcceptAndEncoding);
+    message.reply(response);
+  }
+
+  bool ChatServer::ExtractBodyData(const http_request& message,
+                                   value* out_body_data) const {
+    CHATSERVER_TRACE_SPAN("ChatServer::ExtractBodyData");
+    if (!CborCodec::IsCborMediaType(message.headers().content_type())) {
+      *out_body_data = message.extract_json().get();
+      return true;
+    }
+    return CborCodec::DecodeJson(message.extract_vector().get(),
+                                 out_body_data);
   }
 
   void ChatServer::HandlePost(const http_request& message) {
-    // Path of HTTP request URL.
-    // path[n] means the name of the nth path in HTTP request URL.
-    vector<string_t> url_paths = uri::split_path(
-        uri::decode(message.relative_uri().path()));
+    CHATSERVER_TRACE_REQUEST("ChatServer::HandlePost");
+    const Route route = RouteTable::Resolve(message.method(),
+                                            message.relative_uri().path());
+    if (route == Route::kNotFound) {
+      ReplyNotFound(message);
+      return;
+    }
 
-    // Body data of the post request. Use JSON format to read.
-    value body_data = message.extract_json().get();
+    // Body data of the post request. Use JSON or CBOR format to read.
+    value body_data;
+    if (!ExtractBodyData(message, &body_data)) {
+      message.reply(status_codes::BadRequest, UU("Invalid body data"));
+      return;
+    }
 
     // API service without session ID.
-    const string_t first_request_url_path = url_paths[0];
-    if (first_request_url_path == UU("account")) {
+    if (route == Route::kPostSignUp) {
       ProcessPostSignUpRequest(message, body_data);
       return;
-    } else if (first_request_url_path == UU("login")) {
+    } else if (route == Route::kPostLogin) {
       ProcessPostLoginRequest(message, body_data);
       return;
     }
@@ -179,23 +943,29 @@ namespace chatserver {
     }
 
     // Function call according to URL path with session ID.
-    const string_t second_request_url_path = url_paths[0];
-    if (second_request_url_path == UU("chatmessage")) {
-      ProcessPostInputChatMessageRequest(message, body_data);
-      return;
-    } else if (second_request_url_path == UU("chatroom")) {
-      ProcessCreateChatRoomRequest(message, body_data);
-      return;
+    switch (route) {
+      case Route::kPostChatMessage:
+        ProcessPostInputChatMessageRequest(message, body_data);
+        return;
+      case Route::kPostChatRoom:
+        ProcessCreateChatRoomRequest(message, body_data);
+        return;
+      case Route::kPostChatMessageBatch:
+        ProcessPostChatMessageBatchRequest(message, body_data);
+        return;
+      default:
+        break;
     }
 
-    // No matching HTTP request.
-    warn("No matching HTTP request");
-    message.reply(status_codes::NotFound);
+    ReplyNotFound(message);
   }
 
   void ChatServer::ProcessPostSignUpRequest(
       const http_request& message,
       const value& body_data) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessPostSignUpRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kPostSignUp));
     const string_t kJsonKeyId = UU("id");
     const string_t kJsonKeyPassword = UU("password");
     if (!body_data.has_string_field(kJsonKeyId) || 
@@ -208,7 +978,7 @@ namespace chatserver {
     const string_t id = body_data.at(kJsonKeyId).as_string();
     const string_t password = body_data.at(kJsonKeyPassword).as_string();
     const int signup_result = 
-        account_database_->SignUp(id, password);
+        account_database_->SignUp(ToChatString(id), ToChatString(password));
     if (signup_result == AccountDatabase::kAuthSuccess) {
       message.reply(status_codes::OK);
       return;
@@ -234,6 +1004,9 @@ namespace chatserver {
   void ChatServer::ProcessPostLoginRequest(
       const http_request& message, 
       const value& body_data) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessPostLoginRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kPostLogin));
     const string_t kJsonKeyId = UU("id");
     const string_t kJsonKeyPassword = UU("password");
     const string_t kJsonKeyNonce = UU("nonce");
@@ -248,12 +1021,13 @@ namespace chatserver {
     const string_t id = body_data.at(kJsonKeyId).as_string();
     const string_t password = body_data.at(kJsonKeyPassword).as_string();
     const string_t nonce = body_data.at(kJsonKeyNonce).as_string();
-    const int login_result = 
-        account_database_->Login(id, password, nonce);
+    const int login_result = account_database_->Login(
+        ToChatString(id), ToChatString(password), ToChatString(nonce));
     if (login_result == AccountDatabase::kAuthSuccess) {
-      const Session session = session_manager_->CreateSession(id);
+      const Session session =
+          session_manager_->CreateSession(ToChatString(id));
       value result = value::object();  // Body data for HTTP response.
-      result[UU("session_id")] = value::string(session.session_id);
+      result[UU("session_id")] = value::string(ToStringT(session.session_id));
       message.reply(status_codes::OK, result);
       return;
     } else if (login_result == AccountDatabase::kIDNotExist) {
@@ -269,6 +1043,10 @@ namespace chatserver {
   void ChatServer::ProcessPostInputChatMessageRequest(
       const http_request& message, 
       const value& body_data) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessPostInputChatMessageRequest");
+    // Shared with the stored callback, so the latency ends at the reply.
+    const auto latency_recorder = make_shared<ScopedLatencyRecorder>(
+        metrics_.GetRouteLatency(Route::kPostChatMessage));
     const string_t kJsonKeyChatMessage = UU("chat_message");
     const string_t kJsonKeyChatRoom = UU("chat_room");
     const string_t kJsonKeySessionId = UU("session_id");
@@ -285,30 +1063,112 @@ namespace chatserver {
     const string_t chat_room = body_data.at(kJsonKeyChatRoom).as_string();
     const string_t session_id = body_data.at(kJsonKeySessionId).as_string();
     ChatMessage chat_message;
-    if (!session_manager_->GetUserIDFromSessionId(session_id, 
+    if (!session_manager_->GetUserIDFromSessionId(ToChatString(session_id),
                                                   &chat_message.user_id)) {
       message.reply(status_codes::InternalError,
                     UU("Can't find user ID from given session ID"));
       return;
     }
 
-    chat_message.chat_message = chat_message_string;
-    chat_message.chat_room = chat_room;
-    chat_message.date = chrono::system_clock::to_time_t(
-        chrono::system_clock::now());
-    if (chat_database_->StoreChatMessage(chat_message)) {
-      message.reply(status_codes::OK);
-      return;
-    } else {
-      message.reply(status_codes::BadRequest, 
+    chat_message.chat_message = ToChatString(chat_message_string);
+    chat_message.chat_room = ToChatString(chat_room);
+    if (!chat_database_->DoesDelimiterExistInChatMessage(chat_message)) {
+      message.reply(status_codes::BadRequest,
                     UU("Prohibited char in the message, room, or date"));
       return;
     }
+    if (!chat_database_->IsExistChatRoom(chat_message.chat_room)) {
+      message.reply(status_codes::BadRequest,
+                    UU("There are no chat rooms: ") + chat_room);
+      return;
+    }
+    // The sequencer sets the date.
+    vector<ChatMessage> chat_messages;
+    chat_messages.push_back(move(chat_message));
+    chat_message_sequencer_.Submit(move(chat_messages),
+        [message, latency_recorder](bool is_stored) {
+      ReplyChatMessagesStored(message, is_stored);
+    });
+  }
+
+  void ChatServer::ProcessPostChatMessageBatchRequest(
+      const http_request& message,
+      const value& body_data) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessPostChatMessageBatchRequest");
+    // Shared with the stored callback, so the latency ends at the reply.
+    const auto latency_recorder = make_shared<ScopedLatencyRecorder>(
+        metrics_.GetRouteLatency(Route::kPostChatMessageBatch));
+    const string_t kJsonKeyChatMessages = UU("chat_messages");
+    const string_t kJsonKeyChatMessage = UU("chat_message");
+    const string_t kJsonKeyChatRoom = UU("chat_room");
+    const string_t kJsonKeySessionId = UU("session_id");
+    if (!body_data.has_array_field(kJsonKeyChatMessages) ||
+        !body_data.has_string_field(kJsonKeySessionId)) {
+      message.reply(status_codes::BadRequest,
+                    UU("Chat message information absence"));
+      return;
+    }
+
+    const web::json::array& items =
+        body_data.at(kJsonKeyChatMessages).as_array();
+    if (items.size() == 0 || items.size() > kMaxBatchChatMessages) {
+      message.reply(status_codes::BadRequest,
+                    UU("Invalid number of chat messages"));
+      return;
+    }
+
+    // One session lookup for the whole batch.
+    const string_t session_id = body_data.at(kJsonKeySessionId).as_string();
+    ChatString user_id;
+    if (!session_manager_->GetUserIDFromSessionId(ToChatString(session_id),
+                                                  &user_id)) {
+      message.reply(status_codes::InternalError,
+                    UU("Can't find user ID from given session ID"));
+      return;
+    }
+
+    // The sequencer sets the date.
+    vector<ChatMessage> chat_messages;
+    chat_messages.reserve(items.size());
+    for (const value& item : items) {
+      if (!item.has_string_field(kJsonKeyChatMessage) ||
+          !item.has_string_field(kJsonKeyChatRoom)) {
+        message.reply(status_codes::BadRequest,
+                      UU("Chat message information absence"));
+        return;
+      }
+      ChatMessage chat_message;
+      chat_message.user_id = user_id;
+      chat_message.chat_room =
+          ToChatString(item.at(kJsonKeyChatRoom).as_string());
+      chat_message.chat_message =
+          ToChatString(item.at(kJsonKeyChatMessage).as_string());
+      if (!chat_database_->DoesDelimiterExistInChatMessage(chat_message)) {
+        message.reply(status_codes::BadRequest,
+                      UU("Prohibited char in the message, room, or date"));
+        return;
+      }
+      if (!chat_database_->IsExistChatRoom(chat_message.chat_room)) {
+        message.reply(status_codes::BadRequest,
+                      UU("There are no chat rooms: ") +
+                          item.at(kJsonKeyChatRoom).as_string());
+        return;
+      }
+      chat_messages.push_back(move(chat_message));
+    }
+
+    chat_message_sequencer_.Submit(move(chat_messages),
+        [message, latency_recorder](bool is_stored) {
+      ReplyChatMessagesStored(message, is_stored);
+    });
   }
 
   void ChatServer::ProcessCreateChatRoomRequest(
       const http_request& message,
       const value& body_data) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessCreateChatRoomRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kPostChatRoom));
     const string_t kJsonKeyChatRoom = UU("chat_room");
     if (!body_data.has_string_field(kJsonKeyChatRoom)) {
       message.reply(status_codes::BadRequest,
@@ -317,7 +1177,7 @@ namespace chatserver {
     }
 
     const string_t chat_room = body_data.at(kJsonKeyChatRoom).as_string();
-    if (chat_database_->CreateChatRoom(chat_room)) {
+    if (chat_database_->CreateChatRoom(ToChatString(chat_room))) {
       message.reply(status_codes::OK);
     } else {
       message.reply(status_codes::BadRequest);
@@ -325,39 +1185,46 @@ namespace chatserver {
   }
 
   void ChatServer::HandleDelete(const http_request& message) {
-    // Path of HTTP request URL.
-    // path[n] means the name of the nth path in HTTP request URL.
-    vector<string_t> url_paths = uri::split_path(
-        uri::decode(message.relative_uri().path()));
-
-    // Query string of HTTP request URL.
-    // Format: map<string_t, string_t> = <query name, query value>
-    map<string_t, string_t> url_queries = uri::split_query(
-        uri::decode(message.relative_uri().query()));
+    CHATSERVER_TRACE_REQUEST("ChatServer::HandleDelete");
+    const uri relative_uri = message.relative_uri();
+    const Route route = RouteTable::Resolve(message.method(),
+                                            relative_uri.path());
+    if (route == Route::kNotFound) {
+      ReplyNotFound(message);
+      return;
+    }
 
-    if (!CheckAndUpdateValidSession(url_queries)) {
+    // Query string of HTTP request URL in the arena of the request. It is
+    // parsed on the first lookup.
+    alignas(max_align_t) unsigned char request_buffer[kRequestArenaSize];
+    pmr::monotonic_buffer_resource request_arena(request_buffer,
+                                                 sizeof(request_buffer));
+    const UrlQuery url_query(relative_uri.query(), &request_arena);
+    if (!CheckAndUpdateValidSession(url_query)) {
       message.reply(status_codes::Forbidden,
                     UU("Not a valid session ID"));
       return;
     }
 
     // Function call according to URL path.
-    if (url_paths[0] == UU("session")) {
-      ProcessDeleteLogoutRequest(message, url_queries);
+    if (route == Route::kDeleteSession) {
+      ProcessDeleteLogoutRequest(message, url_query);
       return;
     }
 
-    // No matching HTTP request.
-    warn("No matching HTTP request");
-    message.reply(status_codes::NotFound);
+    ReplyNotFound(message);
   }
 
   void ChatServer::ProcessDeleteLogoutRequest(
       const http_request& message, 
-      const map<string_t, string_t>& url_queries) {
-
-    const auto session_id = url_queries.find(UU("session_id"))->second;
-    const auto result = session_manager_->DeleteSession(session_id);
+      const UrlQuery& url_query) {
+    CHATSERVER_TRACE_SPAN("ChatServer::ProcessDeleteLogoutRequest");
+    const ScopedLatencyRecorder latency_recorder(
+        metrics_.GetRouteLatency(Route::kDeleteSession));
+    string_t session_id;
+    url_query.Find(UU("session_id"), &session_id);
+    const auto result =
+        session_manager_->DeleteSession(ToChatString(session_id));
     if (result) {
       message.reply(status_codes::OK);
       return;
@@ -368,21 +1235,35 @@ namespace chatserver {
   }
 
   void ChatServer::HandlePut(const http_request& message) {
-    // No matching HTTP request.
-    warn("No matching HTTP request");
+    CHATSERVER_TRACE_REQUEST("ChatServer::HandlePut");
+    ReplyNotFound(message);
+  }
+
+  void ChatServer::ReplyNotFound(const http_request& message) const {
+    // A scanner can send many unmatched requests, so sample the warning.
+    uint64_t suppressed_count = 0;
+    if (unmatched_request_log_.ShouldLog(&suppressed_count)) {
+      warn("No matching HTTP request: {} {} ({} similar suppressed)",
+           to_utf8string(message.method()),
+           to_utf8string(message.relative_uri().path()),
+           suppressed_count);
+    }
     message.reply(status_codes::NotFound);
   }
 
-  bool ChatServer::CheckAndUpdateValidSession(
-      const map<string_t, string_t>& url_queries) {
-    const auto session_id_it = url_queries.find(UU("session_id"));
-    if (session_id_it == url_queries.end() ||
-      !session_manager_->IsExistSessionId(session_id_it->second)) {
+  bool ChatServer::CheckAndUpdateValidSession(const UrlQuery& url_query) {
+    CHATSERVER_TRACE_SPAN("ChatServer::CheckAndUpdateValidSession");
+    string_t session_id_query;
+    if (!url_query.Find(UU("session_id"), &session_id_query)) {
+      return false;
+    }
+    const ChatString& session_id = ToChatString(session_id_query);
+    if (!session_manager_->IsExistSessionId(session_id)) {
       return false;
     } else {
       // If there is a request through a valid session id,
       // renew the session alive time.
-      if (!session_manager_->RenewLastActivityTime(session_id_it->second)) {
+      if (!session_manager_->RenewLastActivityTime(session_id)) {
         return false;
       }
     }
@@ -390,12 +1271,14 @@ namespace chatserver {
   }
 
   bool ChatServer::CheckAndUpdateValidSession(const value& body_data) {
+    CHATSERVER_TRACE_SPAN("ChatServer::CheckAndUpdateValidSession");
     const string_t kJsonKeySessionId = UU("session_id");
     if (!body_data.has_string_field(kJsonKeySessionId)) {
       return false;
     }
 
-    const string_t session_id = body_data.at(kJsonKeySessionId).as_string();
+    const ChatString& session_id =
+        ToChatString(body_data.at(kJsonKeySessionId).as_string());
     if (!session_manager_->IsExistSessionId(session_id)) {
       return false;
     } else {
@@ -5,12 +5,20 @@
 #ifndef CHATSERVER_CHATSERVER_H_
 #define CHATSERVER_CHATSERVER_H_
 
+#include <memory_resource>
+#include <vector>
+
 #include "cpprest/http_listener.h"
 #include "cpprest/details/basic_types.h"
 
 #include "account_database.h"
 #include "session_manager.h"
 #include "chat_database.h"
+#include "chat_message_sequencer.h"
+#include "metrics_registry.h"
+#include "rate_limited_log.h"
+#include "response_cache.h"
+#include "url_query.h"
 
 // This class is designed to run chat server with REST APIs.
 // Please, call Initialize function before using this class.
@@ -32,11 +40,24 @@ namespace chatserver {
                AccountDatabase* account_database,
                SessionManager* session_manager);
 
+    // Stop dropping cached responses when the chat database evicts a chat
+    // room.
+    ~ChatServer();
+
     // Set-up http_listener that process incoming HTTP request using given URL.
-    // Run session thread that removes an expired session.
+    // Run session thread that removes an expired session, and the sequencer
+    // thread that stores posted chat messages. The cached responses of a chat
+    // room are dropped when the chat database evicts it.
     bool Initialize(utility::string_t server_url);
 
-    // Open chat server. Return value, task<void>, means the chat server can be
+    // Set the bytes the loaded chat rooms and the cached responses may take
+    // together, or 0 for no budget. A quarter of it is the capacity of the
+    // response cache, and the rest the memory budget of the chat database.
+    // Without a budget, the response cache has its default capacity.
+    void SetMemoryBudget(uint64_t memory_budget);
+
+    // Open chat server, and run the sequencer thread if it was stopped by
+    // CloseServer. Return value, task<void>, means the chat server can be
     // executed asynchronously. Use wait() to run the task to open the chat
     // server.
     // Example:
@@ -47,7 +68,8 @@ namespace chatserver {
 
     // Close chat server. Return value, task<void>, means the chat server can be
     // closed asynchronously. Use wait() to run the task to close the chat
-    // server.
+    // server. Once it completes, the sequencer thread has stored every posted
+    // chat message and is joined, so the chat database can be saved.
     // Example:
     //   ChatServer chat_server;
     //   ...
@@ -56,28 +78,184 @@ namespace chatserver {
     //   status = chat_server.CloseServer().wait();
     pplx::task<void> CloseServer();
 
+    // Serialize the given chat messages as a JSON array in UTF-8, or in the
+    // CBOR columnar layout. It builds the body of GET chatmessage.
+    static std::vector<unsigned char> SerializeChatMessages(
+        const std::vector<ChatMessage>& chat_messages,
+        bool is_cbor);
+    static std::vector<unsigned char> SerializeChatMessages(
+        const ChatRoomSnapshot& chat_messages,
+        bool is_cbor);
+    static std::vector<unsigned char> SerializeChatMessages(
+        const std::pmr::vector<ChatMessageView>& chat_messages,
+        bool is_cbor);
+
    private:
     // Processes ResetAPI GET requests that involve server inquiry. It handles
     // for getting chat messages and getting existing chat rooms.
     // RestAPI URL forms:
     // 1) get chat message list:
-    //    http://server_url/chatmessage?chat_room=[]&session_id=[]
+    //    http://server_url/chatmessage?chat_room=[]&since_id=[]&from=[]&to=[]
+    //    &limit=[]&session_id=[]
     // 2) get chat room list: http://server_url/chatroom?session_id=[]
+    // 3) get chat messages of several chat rooms:
+    //    http://server_url/chatmessage/multi?rooms=[a:since_id,b]&since=[]
+    //    &limit=[]&session_id=[]
+    // 4) get metrics in Prometheus text format: http://server_url/metrics
+    // 5) search chat messages:
+    //    http://server_url/search?q=[]&room=[]&limit=[]&session_id=[]
+    // 6) get the chat messages of a user:
+    //    http://server_url/user/messages?user_id=[]&limit=[]&session_id=[]
+    // 7) get the memory usage, which requires a session: the bytes of each
+    //    loaded chat room, the memory budget and the response cache usage:
+    //    http://server_url/metrics/memory?session_id=[]
+    // A request that reads a chat room which can't be loaded gets 503 if the
+    // chat room is larger than the memory budget, and 500 otherwise.
     void HandleGet(const web::http::http_request& message);
 
-    // Process incoming GET HTTP request for chat message list request.
+    // Process incoming GET HTTP request for chat message list request. With
+    // the optional "since_id", reply only the chat messages whose id is
+    // larger, so a client resumes from the last id it has. With the optional
+    // "from" and "to", reply only the chat messages whose timestamp, in
+    // microseconds, is in [from, to); they are found in O(log n) with the
+    // time index of the chat room. With any of them, the optional "limit"
+    // (default 100, at most 1000) is the most chat messages replied: the
+    // first ones, so a client pages forward from the last id it has. With
+    // "limit" alone, the latest "limit" chat messages are replied.
     // <Parameter description>
     //  - message: Can make an HTTP reply to the incoming HTTP request.
-    //  - url_queries: Hold query string of the incoming HTTP request URL.
+    //  - url_query: Hold query string of the incoming HTTP request URL.
+    //  - request_arena: Allocate the temporaries of the request.
     void ProcessGetChatMessageRequest(
         const web::http::http_request& message,
-        const std::map<utility::string_t, utility::string_t>& url_queries);
+        const UrlQuery& url_query,
+        std::pmr::memory_resource* request_arena);
+
+    // Process incoming GET HTTP request for chat messages of several chat
+    // rooms. "rooms" is a comma-separated list of chat rooms, each with an
+    // optional ":since_id", and the optional "since" is a timestamp in
+    // microseconds. Reply the chat messages of every room after its since_id
+    // and at or after "since" in one array, room by room. The optional
+    // "limit" (default 100, at most 1000) is the most chat messages of a
+    // room: the first ones after since_id or "since", or else the latest
+    // ones.
+    // <Parameter description>
+    //  - message: Can make an HTTP reply to the incoming HTTP request.
+    //  - url_query: Hold query string of the incoming HTTP request URL.
+    //  - request_arena: Allocate the temporaries of the request.
+    void ProcessGetChatMessageMultiRequest(
+        const web::http::http_request& message,
+        const UrlQuery& url_query,
+        std::pmr::memory_resource* request_arena);
+
+    // Process incoming GET HTTP request for a chat message search. "q" has
+    // the terms a chat message must all have, and phrases in double quotes.
+    // The optional "room" limits the search to one chat room, and the
+    // optional "limit" (default 100, at most 1000) is the most chat messages
+    // to reply: the latest ones across the chat rooms, oldest first. Without
+    // "room", a database that loads lazily searches only its loaded chat
+    // rooms.
+    // <Parameter description>
+    //  - message: Can make an HTTP reply to the incoming HTTP request.
+    //  - url_query: Hold query string of the incoming HTTP request URL.
+    //  - request_arena: Allocate the temporaries of the request.
+    void ProcessGetSearchRequest(
+        const web::http::http_request& message,
+        const UrlQuery& url_query,
+        std::pmr::memory_resource* request_arena);
+
+    // Process incoming GET HTTP request for the chat messages of a user, for
+    // user history and moderation. Reply the latest "limit" (default 100, at
+    // most 1000) chat messages of "user_id" in every chat room, oldest first.
+    // They are found with the user index, without reading the chat rooms.
+    // <Parameter description>
+    //  - message: Can make an HTTP reply to the incoming HTTP request.
+    //  - url_query: Hold query string of the incoming HTTP request URL.
+    //  - request_arena: Allocate the temporaries of the request.
+    void ProcessGetUserChatMessagesRequest(
+        const web::http::http_request& message,
+        const UrlQuery& url_query,
+        std::pmr::memory_resource* request_arena);
 
     // Process incoming GET HTTP request for chat room list request.
     // <Parameter description>
     //  - message: Can make an HTTP reply to the incoming HTTP request.
     void ProcessGetChatRoomRequest(const web::http::http_request& message);
 
+    // Process incoming GET HTTP request for the metrics of the chat server.
+    // It needs no session ID, so a monitoring system can scrape it.
+    // <Parameter description>
+    //  - message: Can make an HTTP reply to the incoming HTTP request.
+    void ProcessGetMetricsRequest(const web::http::http_request& message);
+
+    // Process incoming GET HTTP request for the memory usage of the chat
+    // database: the budget, the total, and the bytes of each loaded chat
+    // room, and the capacity and the bytes of the response cache. It names
+    // every loaded chat room, so unlike the metrics it needs a valid session
+    // ID.
+    // <Parameter description>
+    //  - message: Can make an HTTP reply to the incoming HTTP request.
+    void ProcessGetMemoryUsageRequest(const web::http::http_request& message);
+
+    // Check the incoming HTTP request accepts the CBOR wire format.
+    bool AcceptsCbor(const web::http::http_request& message) const;
+
+    // Make an entity tag of the given resource version: "<epoch>-<version>",
+    // with "-cbor" for the CBOR representation, and "-<content coding>" for
+    // a body compressed with content_coding (empty for the identity coding).
+    // The epoch is the server start time, so an entity tag issued before a
+    // restart never matches.
+    utility::string_t MakeEntityTag(
+        uint64_t version,
+        bool is_cbor,
+        const utility::string_t& content_coding) const;
+
+    // Reply 304 Not Modified if If-None-Match of the incoming HTTP request
+    // matches the given entity tag. The reply has the given Vary, which must
+    // be the one of the 200 reply, so a shared cache picks the right stored
+    // representation. Return true if replied.
+    bool ReplyNotModifiedIfMatch(const web::http::http_request& message,
+                                 const utility::string_t& entity_tag,
+                                 const utility::string_t& vary) const;
+
+    // Reply 200 OK with the given body data as JSON, or as CBOR if is_cbor.
+    // The entity tag is sent unless it is empty.
+    void ReplyBody(const web::http::http_request& message,
+                   const web::json::value& body_data,
+                   bool is_cbor,
+                   const utility::string_t& entity_tag) const;
+
+    // Reply 200 OK with the given chat messages as a JSON array, or in the
+    // CBOR columnar layout if is_cbor. The body is compressed if the request
+    // accepts it. The entity tag is sent unless it is empty.
+    void ReplyChatMessages(
+        const web::http::http_request& message,
+        const std::pmr::vector<ChatMessageView>& chat_messages,
+        bool is_cbor,
+        const utility::string_t& entity_tag) const;
+
+    // Select the content coding of a response body of the given size from
+    // Accept-Encoding of the incoming HTTP request. Return an empty string
+    // if the body is small or no supported content coding is accepted.
+    utility::string_t SelectContentCoding(
+        const web::http::http_request& message,
+        size_t body_size) const;
+
+    // Reply 200 OK with the given serialized body, which is already encoded
+    // with content_coding (empty for the identity coding). The entity tag is
+    // sent unless it is empty.
+    void ReplySerializedBody(const web::http::http_request& message,
+                             const std::vector<unsigned char>& body,
+                             bool is_cbor,
+                             const utility::string_t& content_coding,
+                             const utility::string_t& entity_tag) const;
+
+    // Read body data of the incoming HTTP request. CBOR is read if
+    // Content-Type selects it, and JSON otherwise. Return false if the body
+    // data is malformed.
+    bool ExtractBodyData(const web::http::http_request& message,
+                         web::json::value* out_body_data) const;
+
     // Processes ResetAPI POST requests that change server internal states.
     // It handles for account creations, login, accepting chat message, and
     // creating chat rooms. POST requests must include data in the body.
@@ -88,6 +266,8 @@ namespace chatserver {
     //    http://server_url/chatmessage
     // 4) make chat room:
     //    http://server_url/chatroom
+    // 5) make several chat messages:
+    //    http://server_url/chatmessage/batch
     void HandlePost(const web::http::http_request& message);
 
     // Process incoming POST HTTP request for sign-up.
@@ -114,6 +294,17 @@ namespace chatserver {
         const web::http::http_request& message, 
         const web::json::value& body_data);
 
+    // Process incoming POST HTTP request for several chat messages. Body data
+    // has "session_id" and "chat_messages", an array of objects with
+    // "chat_room" and "chat_message". Every chat message is stored with a
+    // single append, or none is stored, e.g. if a chat room does not exist.
+    // <Parameter description>
+    //  - message: Can make an HTTP reply to the incoming HTTP request.
+    //  - body_data: Hold body data of the incoming HTTP request as JSON format.
+    void ProcessPostChatMessageBatchRequest(
+        const web::http::http_request& message,
+        const web::json::value& body_data);
+
     // Process incoming POST HTTP request for creating a chat room.
     // <Parameter description>
     //  - message: Can make an HTTP reply to the incoming HTTP request.
@@ -131,20 +322,22 @@ namespace chatserver {
     // Process incoming DELETE HTTP request for logout.
     // <Parameter description>
     //  - message: Can make an HTTP reply to the incoming HTTP request.
-    //  - url_queries: Hold query string of the incoming HTTP request URL.
+    //  - url_query: Hold query string of the incoming HTTP request URL.
     void ProcessDeleteLogoutRequest(
         const web::http::http_request& message,
-        const std::map<utility::string_t, utility::string_t>& url_queries);
+        const UrlQuery& url_query);
 
     // Listen to HTTP PUT requests.
     // Mainly provides API to update data in the web server.
     // API list: none
     void HandlePut(const web::http::http_request& message);
 
+    // Reply 404 Not Found and log the unmatched request with rate limiting.
+    void ReplyNotFound(const web::http::http_request& message) const;
+
     // Check the given session ID is valid or not. If the session is valid,
     // renew the alive time of the session.
-    bool CheckAndUpdateValidSession(
-        const std::map<utility::string_t, utility::string_t>& url_queries);
+    bool CheckAndUpdateValidSession(const UrlQuery& url_query);
 
     // Check the given session ID is valid or not. If the session is valid,
     // renew the alive time of the session.
@@ -162,6 +355,23 @@ namespace chatserver {
 
     // session_manager_ manages every session information for a user account.
     SessionManager* session_manager_;
+
+    // Epoch of entity tags. It is the server start time.
+    utility::string_t entity_tag_epoch_;
+
+    // Serialized and compressed chat message list of each chat room.
+    ResponseCache response_cache_;
+
+    // Route latencies and response sizes. Updates are lock-free, so the
+    // const reply functions record into it as well.
+    mutable MetricsRegistry metrics_;
+
+    // Rate limit of the warning for unmatched requests.
+    mutable RateLimitedLog unmatched_request_log_;
+
+    // Single writer of posted chat messages. POST handlers submit to it and
+    // reply when their chat messages are stored.
+    ChatMessageSequencer chat_message_sequencer_;
   };
 
 } // namespace chatserver
@@ -0,0 +1,111 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CHATSTRING_H_
+#define CHATSERVER_CHATSTRING_H_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "cpprest/asyncrt_utils.h"
+#include "cpprest/details/basic_types.h"
+
+// String type of the chat server data: chat messages, chat rooms, user IDs,
+// passwords and session IDs. It is utility::string_t by default, which is a
+// UTF-16 std::wstring on Windows. If CHATSERVER_UTF8_STRINGS is defined (in
+// the preprocessor definitions of every project that uses the chat server
+// classes), it is a UTF-8 std::string, which takes half the memory for
+// ASCII text and is written to the file databases without transcoding.
+// Strings are converted only where they cross cpprest (JSON values, URL
+// queries), the logger and the CBOR codec. On Linux, utility::string_t is
+// already UTF-8 and every conversion below returns its argument.
+// ChatStringView refers to text kept elsewhere, such as the text arena of a
+// chat room log.
+// Example:
+//   const ChatString room = ToChatString(json.at(UU("room")).as_string());
+//   if (room == CHATSERVER_TEXT("lobby")) {
+//     result[UU("room")] = value::string(ToStringT(room));
+//   }
+
+namespace chatserver {
+
+#if defined(CHATSERVER_UTF8_STRINGS)
+
+  typedef std::string ChatString;
+  typedef std::string_view ChatStringView;
+  typedef char ChatChar;
+  typedef std::ifstream ChatInputFileStream;
+  typedef std::ofstream ChatOutputFileStream;
+  typedef std::ostringstream ChatOutputStringStream;
+
+  // String literal of ChatString.
+#define CHATSERVER_TEXT(text) text
+
+  inline decltype(auto) ToChatString(const utility::string_t& text) {
+    return utility::conversions::to_utf8string(text);
+  }
+
+  inline decltype(auto) ToStringT(const ChatString& text) {
+    return utility::conversions::to_string_t(text);
+  }
+
+  inline decltype(auto) ToStringT(ChatStringView text) {
+    return utility::conversions::to_string_t(std::string(text));
+  }
+
+  inline const std::string& ToUtf8(const ChatString& text) {
+    return text;
+  }
+
+  inline std::string_view ToUtf8(ChatStringView text) {
+    return text;
+  }
+
+  inline ChatString FromUtf8(std::string text) {
+    return text;
+  }
+
+#else
+
+  typedef utility::string_t ChatString;
+  typedef std::basic_string_view<utility::char_t> ChatStringView;
+  typedef utility::char_t ChatChar;
+  typedef utility::ifstream_t ChatInputFileStream;
+  typedef utility::ofstream_t ChatOutputFileStream;
+  typedef utility::ostringstream_t ChatOutputStringStream;
+
+  // String literal of ChatString.
+#define CHATSERVER_TEXT(text) UU(text)
+
+  inline const utility::string_t& ToChatString(const utility::string_t& text) {
+    return text;
+  }
+
+  inline const utility::string_t& ToStringT(const ChatString& text) {
+    return text;
+  }
+
+  inline utility::string_t ToStringT(ChatStringView text) {
+    return utility::string_t(text);
+  }
+
+  inline decltype(auto) ToUtf8(const ChatString& text) {
+    return utility::conversions::to_utf8string(text);
+  }
+
+  inline decltype(auto) ToUtf8(ChatStringView text) {
+    return utility::conversions::to_utf8string(utility::string_t(text));
+  }
+
+  inline ChatString FromUtf8(std::string text) {
+    return utility::conversions::to_string_t(std::move(text));
+  }
+
+#endif
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CHATSTRING_H_
@@ -0,0 +1,123 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "chat_user_index.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "tracing.h"
+
+using namespace std;
+
+namespace chatserver {
+
+  ChatUserIndex::ChatUserIndex()
+      : mutex_index_("ChatUserIndex::mutex_index_") {
+  }
+
+  void ChatUserIndex::IndexChatRoom(const ChatString& chat_room,
+                                    const ChatRoomSnapshot& snapshot) {
+    CHATSERVER_TRACE_SPAN("ChatUserIndex::IndexChatRoom");
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    ChatRoomIndex& room_index = rooms_[chat_room];
+    // Consecutive chat messages of a user share the lookup.
+    ChatStringView last_user_id;
+    vector<uint64_t>* ids = nullptr;
+    for (size_t i = static_cast<size_t>(room_index.indexed_count);
+         i < snapshot.size(); ++i) {
+      const ChatMessageView& chat_message = snapshot[i];
+      if (ids == nullptr || chat_message.user_id != last_user_id) {
+        const ChatString user_id(chat_message.user_id);
+        const auto posting = room_index.postings.try_emplace(user_id);
+        ids = &posting.first->second;
+        if (posting.second) {
+          // A node has the next pointer and the hash beside the pair.
+          room_index.posting_memory_usage +=
+              sizeof(void*) + sizeof(size_t) +
+              sizeof(pair<const ChatString, vector<uint64_t>>) +
+              user_id.capacity() * sizeof(ChatChar);
+          AddChatRoomLocked(user_id, chat_room);
+        }
+        last_user_id = chat_message.user_id;
+      }
+      const size_t capacity = ids->capacity();
+      ids->push_back(chat_message.id);
+      room_index.posting_memory_usage +=
+          (ids->capacity() - capacity) * sizeof(uint64_t);
+    }
+    room_index.indexed_count =
+        max(room_index.indexed_count, static_cast<uint64_t>(snapshot.size()));
+  }
+
+  bool ChatUserIndex::AddChatRoom(const ChatString& user_id,
+                                  const ChatString& chat_room) {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    return AddChatRoomLocked(user_id, chat_room);
+  }
+
+  bool ChatUserIndex::HasChatRoom(const ChatString& user_id,
+                                  const ChatString& chat_room) const {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    const auto user_chat_rooms = chat_rooms_.find(user_id);
+    return user_chat_rooms != chat_rooms_.end() &&
+           find(user_chat_rooms->second.begin(), user_chat_rooms->second.end(),
+                chat_room) != user_chat_rooms->second.end();
+  }
+
+  vector<ChatString> ChatUserIndex::GetChatRooms(
+      const ChatString& user_id) const {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    const auto user_chat_rooms = chat_rooms_.find(user_id);
+    if (user_chat_rooms == chat_rooms_.end()) {
+      return vector<ChatString>();
+    }
+    return user_chat_rooms->second;
+  }
+
+  bool ChatUserIndex::GetLatestIds(const ChatString& user_id,
+                                   const ChatString& chat_room,
+                                   size_t limit,
+                                   vector<uint64_t>* out_ids) const {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    const auto room_index = rooms_.find(chat_room);
+    if (room_index == rooms_.end()) {
+      return false;
+    }
+    const auto ids = room_index->second.postings.find(user_id);
+    if (ids != room_index->second.postings.end()) {
+      const size_t count = min(limit, ids->second.size());
+      out_ids->assign(ids->second.end() - count, ids->second.end());
+    }
+    return true;
+  }
+
+  uint64_t ChatUserIndex::GetMemoryUsage(const ChatString& chat_room) const {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    const auto room_index = rooms_.find(chat_room);
+    if (room_index == rooms_.end()) {
+      return 0;
+    }
+    return sizeof(decltype(rooms_)::value_type) +
+           room_index->second.postings.bucket_count() * sizeof(void*) +
+           room_index->second.posting_memory_usage;
+  }
+
+  void ChatUserIndex::EraseChatRoom(const ChatString& chat_room) {
+    const lock_guard<InstrumentedMutex> lock(mutex_index_);
+    rooms_.erase(chat_room);
+  }
+
+  bool ChatUserIndex::AddChatRoomLocked(const ChatString& user_id,
+                                        const ChatString& chat_room) {
+    vector<ChatString>& user_chat_rooms = chat_rooms_[user_id];
+    if (find(user_chat_rooms.begin(), user_chat_rooms.end(), chat_room) !=
+        user_chat_rooms.end()) {
+      return false;
+    }
+    user_chat_rooms.push_back(chat_room);
+    return true;
+  }
+
+} // namespace chatserver
@@ -0,0 +1,104 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CHATUSERINDEX_H_
+#define CHATSERVER_CHATUSERINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "chat_room_log.h"
+#include "chat_string.h"
+#include "instrumented_mutex.h"
+
+// ChatUserIndex is a secondary index of the chat messages of every chat room
+// by user: per chat room, user ID -> the ids of the chat messages the user
+// posted. Like ChatSearchIndex, it is incremental: IndexChatRoom reads only
+// the chat messages of a snapshot after the ones indexed so far. A lookup
+// copies the latest ids of the user in a chat room, so it costs the limit,
+// whatever the size of the history.
+// It also keeps the chat rooms every user posted to, including chat rooms
+// that are not indexed, e.g. not loaded yet by a ChatDatabase that loads
+// lazily. They are added by AddChatRoom, and by IndexChatRoom.
+// Example:
+//   ChatUserIndex user_index;
+//   user_index.IndexChatRoom(chat_room, *snapshot);
+//   for (const ChatString& chat_room : user_index.GetChatRooms(user_id)) {
+//     vector<uint64_t> ids;
+//     if (user_index.GetLatestIds(user_id, chat_room, 20, &ids)) {
+//       do something with ids
+//     }
+//   }
+
+namespace chatserver {
+
+  class ChatUserIndex {
+   public:
+    // Name mutex_index_ for lock profiling.
+    ChatUserIndex();
+
+    ChatUserIndex(const ChatUserIndex&) = delete;
+    ChatUserIndex& operator=(const ChatUserIndex&) = delete;
+
+    // Index the chat messages of the snapshot after the ones indexed so far.
+    // The snapshot must be of the given chat room.
+    void IndexChatRoom(const ChatString& chat_room,
+                       const ChatRoomSnapshot& snapshot);
+
+    // Record that the given user posted to the given chat room. Return false
+    // if it is recorded already.
+    bool AddChatRoom(const ChatString& user_id, const ChatString& chat_room);
+
+    // Check the given user posted to the given chat room.
+    bool HasChatRoom(const ChatString& user_id,
+                     const ChatString& chat_room) const;
+
+    // Get the chat rooms the given user posted to, indexed or not.
+    std::vector<ChatString> GetChatRooms(const ChatString& user_id) const;
+
+    // Get the latest limit ids of the given user in the given chat room,
+    // ascending. Return false if the chat room is not indexed.
+    bool GetLatestIds(const ChatString& user_id,
+                      const ChatString& chat_room,
+                      size_t limit,
+                      std::vector<uint64_t>* out_ids) const;
+
+    // Get the approximate bytes of the ids of the given chat room, or 0 if
+    // it is not indexed. The chat rooms of the users are not counted.
+    uint64_t GetMemoryUsage(const ChatString& chat_room) const;
+
+    // Drop the ids of the given chat room. Its users keep it in their chat
+    // rooms.
+    void EraseChatRoom(const ChatString& chat_room);
+
+   private:
+    // Index of one chat room: user ID -> ids of the user's chat messages,
+    // the number of indexed chat messages, and the bytes of the postings.
+    struct ChatRoomIndex {
+      std::unordered_map<ChatString, std::vector<uint64_t>> postings;
+      uint64_t indexed_count = 0;
+      uint64_t posting_memory_usage = 0;
+    };
+
+    // Add the chat room to chat_rooms_ of the user unless it is there, and
+    // return whether it is added. mutex_index_ must be held.
+    bool AddChatRoomLocked(const ChatString& user_id,
+                           const ChatString& chat_room);
+
+    // Mutex for every member.
+    mutable InstrumentedMutex mutex_index_;
+
+    // Index of every indexed chat room.
+    std::map<ChatString, ChatRoomIndex> rooms_;
+
+    // user ID -> chat rooms the user posted to.
+    std::unordered_map<ChatString, std::vector<ChatString>> chat_rooms_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CHATUSERINDEX_H_
@@ -0,0 +1,167 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "content_coding.h"
+
+#include <exception>
+
+#include "cpprest/http_msg.h"
+#include "spdlog/spdlog.h"
+
+using namespace std;
+using ::utility::char_t;
+using ::utility::string_t;
+using ::spdlog::warn;
+
+namespace chatserver {
+
+  namespace compression = ::web::http::compression;
+
+  namespace {
+
+    // Quality value in thousandths: "q=0.5" -> 500.
+    const int kMaxQuality = 1000;
+
+    // Quality of a content coding that Accept-Encoding does not list.
+    const int kUnlistedQuality = -1;
+
+    // Output buffer grows by at least this size during compression.
+    const size_t kMinOutputGrowth = 1024;
+
+    string_t ToLower(string_t text) {
+      for (char_t& c : text) {
+        if (c >= UU('A') && c <= UU('Z')) {
+          c = c - UU('A') + UU('a');
+        }
+      }
+      return text;
+    }
+
+    string_t Trim(const string_t& text) {
+      const size_t first = text.find_first_not_of(UU(" \t"));
+      if (first == string_t::npos) {
+        return string_t();
+      }
+      const size_t last = text.find_last_not_of(UU(" \t"));
+      return text.substr(first, last - first + 1);
+    }
+
+    // Parse a quality value "0", "0.5", "1.000" into thousandths. Return
+    // kMaxQuality for a malformed value, as if there were no quality value.
+    int ParseQuality(const string_t& text) {
+      if (text.empty() || (text[0] != UU('0') && text[0] != UU('1'))) {
+        return kMaxQuality;
+      }
+      int quality = (text[0] - UU('0')) * kMaxQuality;
+      if (text.size() > 1 && text[1] == UU('.')) {
+        int scale = kMaxQuality / 10;
+        for (size_t i = 2; i < text.size() && scale > 0; ++i, scale /= 10) {
+          if (text[i] < UU('0') || text[i] > UU('9')) {
+            return kMaxQuality;
+          }
+          quality += (text[i] - UU('0')) * scale;
+        }
+      }
+      return quality > kMaxQuality ? kMaxQuality : quality;
+    }
+
+  } // namespace
+
+  string_t ContentCoding::Select(const string_t& accept_encoding) {
+    if (!compression::builtin::supported()) {
+      return string_t();
+    }
+
+    const string_t gzip = compression::builtin::algorithm::GZIP;
+    const string_t deflate = compression::builtin::algorithm::DEFLATE;
+    // "*" applies only to the content codings that are not listed, so an
+    // explicit "q=0" refuses a content coding whatever the order.
+    int gzip_quality = kUnlistedQuality;
+    int deflate_quality = kUnlistedQuality;
+    int any_quality = kUnlistedQuality;
+    const string_t lower_accept_encoding = ToLower(accept_encoding);
+    size_t start_index = 0;
+    while (start_index < lower_accept_encoding.size()) {
+      size_t end_index = lower_accept_encoding.find(UU(','), start_index);
+      if (end_index == string_t::npos) {
+        end_index = lower_accept_encoding.size();
+      }
+      const string_t item = lower_accept_encoding.substr(
+          start_index, end_index - start_index);
+      start_index = end_index + 1;
+
+      // item: coding[;q=value]
+      const size_t parameter_index = item.find(UU(';'));
+      const string_t coding = Trim(item.substr(0, parameter_index));
+      int quality = kMaxQuality;
+      if (parameter_index != string_t::npos) {
+        const string_t parameter = Trim(item.substr(parameter_index + 1));
+        if (parameter.compare(0, 2, UU("q=")) == 0) {
+          quality = ParseQuality(parameter.substr(2));
+        }
+      }
+
+      if (coding == gzip || coding == UU("x-gzip")) {
+        gzip_quality = quality;
+      } else if (coding == deflate) {
+        deflate_quality = quality;
+      } else if (coding == UU("*")) {
+        any_quality = quality;
+      }
+    }
+    if (gzip_quality == kUnlistedQuality) gzip_quality = any_quality;
+    if (deflate_quality == kUnlistedQuality) deflate_quality = any_quality;
+
+    if (gzip_quality > 0 && gzip_quality >= deflate_quality) {
+      return gzip;
+    } else if (deflate_quality > 0) {
+      return deflate;
+    }
+    return string_t();
+  }
+
+  bool ContentCoding::Compress(const string_t& content_coding,
+                               const vector<unsigned char>& input,
+                               vector<unsigned char>* output) {
+    if (output == nullptr ||
+        !compression::builtin::algorithm::supported(content_coding)) {
+      return false;
+    }
+    unique_ptr<compression::compress_provider> compressor =
+        compression::builtin::make_compressor(content_coding);
+    if (compressor == nullptr) {
+      return false;
+    }
+
+    // Chat history is text, so it usually shrinks to a fraction of its size.
+    output->resize(input.size() / 2 + kMinOutputGrowth);
+    size_t input_offset = 0;
+    size_t output_size = 0;
+    bool is_done = false;
+    try {
+      while (!is_done) {
+        if (output->size() - output_size < kMinOutputGrowth) {
+          output->resize(output->size() * 2);
+        }
+        size_t input_bytes_processed = 0;
+        output_size += compressor->compress(
+            input.data() + input_offset,
+            input.size() - input_offset,
+            output->data() + output_size,
+            output->size() - output_size,
+            compression::operation_hint::is_last,
+            input_bytes_processed,
+            is_done);
+        input_offset += input_bytes_processed;
+      }
+    } catch (const exception& e) {
+      warn("Compression failed: {}", e.what());
+      output->clear();
+      return false;
+    }
+    output->resize(output_size);
+    return true;
+  }
+
+} // namespace chatserver
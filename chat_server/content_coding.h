@@ -0,0 +1,43 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_CONTENTCODING_H_
+#define CHATSERVER_CONTENTCODING_H_
+
+#include <vector>
+
+#include "cpprest/details/basic_types.h"
+
+// This class selects and applies an HTTP content coding, gzip or deflate, for
+// a response body. It uses the built-in compressors of cpprestsdk, so no
+// content coding is selected if cpprestsdk was built without compression.
+// Example:
+//   utility::string_t content_coding = ContentCoding::Select(accept_encoding);
+//   std::vector<unsigned char> compressed_body;
+//   if (!content_coding.empty() &&
+//       ContentCoding::Compress(content_coding, body, &compressed_body)) {
+//     reply compressed_body with "Content-Encoding: content_coding"
+//   }
+
+namespace chatserver {
+
+  class ContentCoding {
+   public:
+    // Select a content coding from the given Accept-Encoding header value.
+    // Return "gzip", "deflate", or an empty string for the identity coding.
+    // The highest quality value wins and gzip wins a tie. "*" gives its
+    // quality to the content codings that are not listed, and "q=0" refuses
+    // a content coding.
+    static utility::string_t Select(const utility::string_t& accept_encoding);
+
+    // Compress the input with the given content coding into output. Return
+    // false if the content coding is not supported or compression fails.
+    static bool Compress(const utility::string_t& content_coding,
+                         const std::vector<unsigned char>& input,
+                         std::vector<unsigned char>* output);
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_CONTENTCODING_H_
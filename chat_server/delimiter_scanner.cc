@@ -0,0 +1,283 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "delimiter_scanner.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// SSE2 is part of x64 and the default of x86 builds of Visual Studio.
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || \
+    defined(__SSE2__)
+#define CHATSERVER_SCANNER_SSE2
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+// Visual Studio compiles AVX2 intrinsics without /arch:AVX2.
+#define CHATSERVER_TARGET_AVX2
+#else
+#define CHATSERVER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+namespace chatserver {
+
+  namespace {
+
+    // Check c, and b as well if kHasSecondNeedle.
+    template <typename Char, bool kHasSecondNeedle>
+    const Char* FindScalar(const Char* begin, const Char* end, Char a,
+                           Char b) {
+      for (; begin != end; ++begin) {
+        if (*begin == a || (kHasSecondNeedle && *begin == b)) {
+          return begin;
+        }
+      }
+      return end;
+    }
+
+#if defined(CHATSERVER_SCANNER_SSE2)
+
+    // The mask must not be 0.
+    int CountTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward(&index, mask);
+      return static_cast<int>(index);
+#else
+      return __builtin_ctz(mask);
+#endif
+    }
+
+    bool DetectAvx2() {
+#if defined(_MSC_VER)
+      int info[4];
+      __cpuid(info, 0);
+      if (info[0] < 7) {
+        return false;
+      }
+      // The OS must save the AVX registers on a context switch.
+      __cpuid(info, 1);
+      const int kOsxsave = 1 << 27;
+      const int kAvx = 1 << 28;
+      if ((info[2] & kOsxsave) == 0 || (info[2] & kAvx) == 0 ||
+          (_xgetbv(0) & 6) != 6) {
+        return false;
+      }
+      __cpuidex(info, 7, 0);
+      return (info[1] & (1 << 5)) != 0;
+#else
+      return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+
+    // Read once at start-up. A call during static initialization sees false
+    // and uses SSE2, which gives the same result.
+    const bool has_avx2 = DetectAvx2();
+
+    // Set by SetAvx2DisabledForTesting.
+    atomic<bool> is_avx2_disabled(false);
+
+    bool UsesAvx2() {
+      return has_avx2 && !is_avx2_disabled.load(memory_order_relaxed);
+    }
+
+    template <typename Char>
+    __m128i Broadcast128(Char c) {
+      switch (sizeof(Char)) {
+        case 1:
+          return _mm_set1_epi8(static_cast<char>(c));
+        case 2:
+          return _mm_set1_epi16(static_cast<short>(c));
+        default:
+          return _mm_set1_epi32(static_cast<int>(c));
+      }
+    }
+
+    template <typename Char>
+    __m128i CompareEqual128(__m128i a, __m128i b) {
+      switch (sizeof(Char)) {
+        case 1:
+          return _mm_cmpeq_epi8(a, b);
+        case 2:
+          return _mm_cmpeq_epi16(a, b);
+        default:
+          return _mm_cmpeq_epi32(a, b);
+      }
+    }
+
+    template <typename Char, bool kHasSecondNeedle>
+    const Char* FindSse2(const Char* begin, const Char* end, Char a, Char b) {
+      const size_t kLaneCount = 16 / sizeof(Char);
+      const __m128i needle_a = Broadcast128(a);
+      const __m128i needle_b = Broadcast128(b);
+      while (static_cast<size_t>(end - begin) >= kLaneCount) {
+        const __m128i block =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i match = CompareEqual128<Char>(block, needle_a);
+        if (kHasSecondNeedle) {
+          match = _mm_or_si128(match, CompareEqual128<Char>(block, needle_b));
+        }
+        // One bit per byte, so sizeof(Char) bits per character.
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+        if (mask != 0) {
+          return begin + CountTrailingZeros(mask) / sizeof(Char);
+        }
+        begin += kLaneCount;
+      }
+      return FindScalar<Char, kHasSecondNeedle>(begin, end, a, b);
+    }
+
+    template <typename Char>
+    CHATSERVER_TARGET_AVX2 __m256i Broadcast256(Char c) {
+      switch (sizeof(Char)) {
+        case 1:
+          return _mm256_set1_epi8(static_cast<char>(c));
+        case 2:
+          return _mm256_set1_epi16(static_cast<short>(c));
+        default:
+          return _mm256_set1_epi32(static_cast<int>(c));
+      }
+    }
+
+    template <typename Char>
+    CHATSERVER_TARGET_AVX2 __m256i CompareEqual256(__m256i a, __m256i b) {
+      switch (sizeof(Char)) {
+        case 1:
+          return _mm256_cmpeq_epi8(a, b);
+        case 2:
+          return _mm256_cmpeq_epi16(a, b);
+        default:
+          return _mm256_cmpeq_epi32(a, b);
+      }
+    }
+
+    template <typename Char, bool kHasSecondNeedle>
+    CHATSERVER_TARGET_AVX2 const Char* FindAvx2(const Char* begin,
+                                                const Char* end,
+                                                Char a,
+                                                Char b) {
+      const size_t kLaneCount = 32 / sizeof(Char);
+      const __m256i needle_a = Broadcast256(a);
+      const __m256i needle_b = Broadcast256(b);
+      // Two blocks per step for long text, so the loads overlap.
+      while (static_cast<size_t>(end - begin) >= 2 * kLaneCount) {
+        const __m256i first_block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        const __m256i second_block = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(begin + kLaneCount));
+        __m256i first_match = CompareEqual256<Char>(first_block, needle_a);
+        __m256i second_match = CompareEqual256<Char>(second_block, needle_a);
+        if (kHasSecondNeedle) {
+          first_match = _mm256_or_si256(
+              first_match, CompareEqual256<Char>(first_block, needle_b));
+          second_match = _mm256_or_si256(
+              second_match, CompareEqual256<Char>(second_block, needle_b));
+        }
+        // The loop below finds the position in the matching block.
+        const __m256i any_match = _mm256_or_si256(first_match, second_match);
+        if (!_mm256_testz_si256(any_match, any_match)) {
+          break;
+        }
+        begin += 2 * kLaneCount;
+      }
+      while (static_cast<size_t>(end - begin) >= kLaneCount) {
+        const __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        __m256i match = CompareEqual256<Char>(block, needle_a);
+        if (kHasSecondNeedle) {
+          match = _mm256_or_si256(match,
+                                  CompareEqual256<Char>(block, needle_b));
+        }
+        const uint32_t mask =
+            static_cast<uint32_t>(_mm256_movemask_epi8(match));
+        if (mask != 0) {
+          // Avoid the AVX to SSE transition penalty in the caller.
+          _mm256_zeroupper();
+          return begin + CountTrailingZeros(mask) / sizeof(Char);
+        }
+        begin += kLaneCount;
+      }
+      _mm256_zeroupper();
+      return FindSse2<Char, kHasSecondNeedle>(begin, end, a, b);
+    }
+
+    template <typename Char, bool kHasSecondNeedle>
+    const Char* FindAny(const Char* begin, const Char* end, Char a, Char b) {
+      if (UsesAvx2()) {
+        return FindAvx2<Char, kHasSecondNeedle>(begin, end, a, b);
+      }
+      return FindSse2<Char, kHasSecondNeedle>(begin, end, a, b);
+    }
+
+#else
+
+    template <typename Char, bool kHasSecondNeedle>
+    const Char* FindAny(const Char* begin, const Char* end, Char a, Char b) {
+      return FindScalar<Char, kHasSecondNeedle>(begin, end, a, b);
+    }
+
+#endif
+
+  } // namespace
+
+  const char* DelimiterScanner::Find(const char* begin, const char* end,
+                                     char c) {
+    return FindAny<char, false>(begin, end, c, c);
+  }
+
+  const wchar_t* DelimiterScanner::Find(const wchar_t* begin,
+                                        const wchar_t* end,
+                                        wchar_t c) {
+    return FindAny<wchar_t, false>(begin, end, c, c);
+  }
+
+  const char* DelimiterScanner::FindEither(const char* begin,
+                                           const char* end,
+                                           char a,
+                                           char b) {
+    return FindAny<char, true>(begin, end, a, b);
+  }
+
+  const wchar_t* DelimiterScanner::FindEither(const wchar_t* begin,
+                                              const wchar_t* end,
+                                              wchar_t a,
+                                              wchar_t b) {
+    return FindAny<wchar_t, true>(begin, end, a, b);
+  }
+
+  bool DelimiterScanner::Contains(const ChatString& text, ChatChar c) {
+    const ChatChar* end = text.data() + text.size();
+    return Find(text.data(), end, c) != end;
+  }
+
+  bool DelimiterScanner::ContainsEither(const ChatString& text,
+                                        ChatChar a,
+                                        ChatChar b) {
+    const ChatChar* end = text.data() + text.size();
+    return FindEither(text.data(), end, a, b) != end;
+  }
+
+  const char* DelimiterScanner::GetInstructionSet() {
+#if defined(CHATSERVER_SCANNER_SSE2)
+    return UsesAvx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+  }
+
+#if defined(CHATSERVER_SCANNER_SSE2)
+  void DelimiterScanner::SetAvx2DisabledForTesting(bool is_disabled) {
+    is_avx2_disabled = is_disabled;
+  }
+#else
+  void DelimiterScanner::SetAvx2DisabledForTesting(bool) {
+  }
+#endif
+
+} // namespace chatserver
@@ -0,0 +1,59 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_DELIMITERSCANNER_H_
+#define CHATSERVER_DELIMITERSCANNER_H_
+
+#include "chat_string.h"
+
+// This class finds delimiters, newlines and prohibited characters in text
+// with vector instructions. It compares 32 bytes at a time with AVX2 if the
+// CPU supports it, 16 bytes with SSE2 otherwise, and one character at a time
+// on other CPUs. Narrow text (the mapped chat message file) and wide text
+// (ChatString on Windows by default) are both supported.
+// Example:
+//   const char* newline = DelimiterScanner::Find(begin, end, '\n');
+//   if (DelimiterScanner::Contains(message.chat_message, '|')) {
+//     do something to reject the chat message
+//   }
+
+namespace chatserver {
+
+  class DelimiterScanner {
+   public:
+    // Find the first c in [begin, end). Return end if there is none.
+    static const char* Find(const char* begin, const char* end, char c);
+    static const wchar_t* Find(const wchar_t* begin,
+                               const wchar_t* end,
+                               wchar_t c);
+
+    // Find the first a or b in [begin, end). Return end if there is none.
+    static const char* FindEither(const char* begin,
+                                  const char* end,
+                                  char a,
+                                  char b);
+    static const wchar_t* FindEither(const wchar_t* begin,
+                                     const wchar_t* end,
+                                     wchar_t a,
+                                     wchar_t b);
+
+    // Check the given text has c.
+    static bool Contains(const ChatString& text, ChatChar c);
+
+    // Check the given text has a or b.
+    static bool ContainsEither(const ChatString& text,
+                               ChatChar a,
+                               ChatChar b);
+
+    // Get the instruction set in use: "avx2", "sse2" or "scalar".
+    static const char* GetInstructionSet();
+
+    // Use SSE2 instead of AVX2 while is_disabled is true, so tests cover the
+    // SSE2 path on AVX2 CPUs. It changes nothing on other CPUs.
+    static void SetAvx2DisabledForTesting(bool is_disabled);
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_DELIMITERSCANNER_H_
@@ -0,0 +1,68 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "instrumented_mutex.h"
+
+#include "spdlog/spdlog.h"
+
+using namespace std;
+using ::spdlog::info;
+
+namespace chatserver {
+
+  namespace {
+
+    // Every profile in the order of creation. The mutex is a plain
+    // std::mutex: profiling it would need a profile of its own.
+    struct ProfileList {
+      mutex mutex_profiles;
+      vector<unique_ptr<LockProfile>> profiles;
+    };
+
+    ProfileList& GetProfileList() {
+      // Created on first use: mutexes at namespace scope may be constructed
+      // before any other static variable of this file.
+      static ProfileList profile_list;
+      return profile_list;
+    }
+
+  } // namespace
+
+  LockProfile* LockProfiler::GetProfile(const string& name) {
+    ProfileList& profile_list = GetProfileList();
+    const lock_guard<mutex> lock(profile_list.mutex_profiles);
+    for (const unique_ptr<LockProfile>& profile : profile_list.profiles) {
+      if (profile->name == name) {
+        return profile.get();
+      }
+    }
+    profile_list.profiles.push_back(make_unique<LockProfile>(name));
+    return profile_list.profiles.back().get();
+  }
+
+  vector<const LockProfile*> LockProfiler::GetProfiles() {
+    ProfileList& profile_list = GetProfileList();
+    const lock_guard<mutex> lock(profile_list.mutex_profiles);
+    vector<const LockProfile*> result;
+    for (const unique_ptr<LockProfile>& profile : profile_list.profiles) {
+      result.push_back(profile.get());
+    }
+    return result;
+  }
+
+  void LockProfiler::Dump() {
+    for (const LockProfile* profile : GetProfiles()) {
+      info("Lock {}: {} acquisitions, {} contended, "
+           "wait p50 {} ns p99 {} ns, hold p50 {} ns p99 {} ns",
+           profile->name,
+           profile->hold_time.GetCount(),
+           profile->contention_count.load(memory_order_relaxed),
+           profile->wait_time.GetPercentile(0.5),
+           profile->wait_time.GetPercentile(0.99),
+           profile->hold_time.GetPercentile(0.5),
+           profile->hold_time.GetPercentile(0.99));
+    }
+  }
+
+} // namespace chatserver
@@ -0,0 +1,141 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_INSTRUMENTEDMUTEX_H_
+#define CHATSERVER_INSTRUMENTEDMUTEX_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "latency_histogram.h"
+
+// InstrumentedMutex is a drop-in replacement of std::mutex that can be used
+// with std::lock_guard and std::unique_lock. If CHATSERVER_ENABLE_LOCK_PROFILING
+// is defined, it records into the LockProfile of its name:
+//  - wait time: from lock() until the lock is acquired, 0 if not contended.
+//  - hold time: from the acquisition until unlock().
+//  - the number of contended acquisitions.
+// Otherwise it only forwards to std::mutex. The flag changes the class
+// layout, so define it for every project that links the chat server objects.
+// Mutexes with the same name share one profile, e.g. every SessionManager.
+// The chat server exports the profiles at GET /chat/metrics, and the chat
+// client dumps them to the log when it exits.
+// Example:
+//   InstrumentedMutex mutex_sessions_("SessionManager::mutex_sessions_");
+//   const std::lock_guard<InstrumentedMutex> lock(mutex_sessions_);
+
+namespace chatserver {
+
+  // Lock statistics of every mutex with the same name.
+  struct LockProfile {
+    explicit LockProfile(const std::string& profile_name)
+        : name(profile_name), contention_count(0) {
+    }
+
+    const std::string name;
+    LatencyHistogram wait_time;
+    LatencyHistogram hold_time;
+    std::atomic<uint64_t> contention_count;
+  };
+
+  class LockProfiler {
+   public:
+    // Get the profile of the given name. It is created on the first call and
+    // lives until the process ends, so the pointer can be kept.
+    static LockProfile* GetProfile(const std::string& name);
+
+    // Get every profile in the order of creation.
+    static std::vector<const LockProfile*> GetProfiles();
+
+    // Write a summary of every profile to the log.
+    static void Dump();
+  };
+
+#if defined(CHATSERVER_ENABLE_LOCK_PROFILING)
+
+  class InstrumentedMutex {
+   public:
+    explicit InstrumentedMutex(const char* name)
+        : profile_(LockProfiler::GetProfile(name)), hold_start_time_(0) {
+    }
+
+    InstrumentedMutex(const InstrumentedMutex&) = delete;
+    InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+    void lock() {
+      if (mutex_.try_lock()) {
+        profile_->wait_time.Record(0);
+      } else {
+        const int64_t wait_start_time = Now();
+        mutex_.lock();
+        profile_->wait_time.Record(
+            static_cast<uint64_t>(Now() - wait_start_time));
+        profile_->contention_count.fetch_add(1, std::memory_order_relaxed);
+      }
+      hold_start_time_ = Now();
+    }
+
+    bool try_lock() {
+      if (!mutex_.try_lock()) {
+        return false;
+      }
+      profile_->wait_time.Record(0);
+      hold_start_time_ = Now();
+      return true;
+    }
+
+    void unlock() {
+      // hold_start_time_ is only touched by the owner of the lock.
+      profile_->hold_time.Record(
+          static_cast<uint64_t>(Now() - hold_start_time_));
+      mutex_.unlock();
+    }
+
+   private:
+    static int64_t Now() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::mutex mutex_;
+    LockProfile* profile_;
+    int64_t hold_start_time_;
+  };
+
+#else
+
+  class InstrumentedMutex {
+   public:
+    explicit InstrumentedMutex(const char* /* name */) {
+    }
+
+    InstrumentedMutex(const InstrumentedMutex&) = delete;
+    InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+    void lock() {
+      mutex_.lock();
+    }
+
+    bool try_lock() {
+      return mutex_.try_lock();
+    }
+
+    void unlock() {
+      mutex_.unlock();
+    }
+
+   private:
+    std::mutex mutex_;
+  };
+
+#endif
+
+} // namespace chatserver
+
+#endif // CHATSERVER_INSTRUMENTEDMUTEX_H_
@@ -0,0 +1,97 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "latency_histogram.h"
+
+#include <cmath>
+
+using namespace std;
+
+namespace chatserver {
+
+  LatencyHistogram::LatencyHistogram() {
+    Reset();
+  }
+
+  uint64_t LatencyHistogram::GetCount() const {
+    uint64_t count = 0;
+    for (const atomic<uint64_t>& bucket : buckets_) {
+      count += bucket.load(memory_order_relaxed);
+    }
+    return count;
+  }
+
+  uint64_t LatencyHistogram::GetSum() const {
+    return sum_.load(memory_order_relaxed);
+  }
+
+  uint64_t LatencyHistogram::GetBucketCount(size_t bucket_index) const {
+    if (bucket_index >= kBucketCount) {
+      return 0;
+    }
+    return buckets_[bucket_index].load(memory_order_relaxed);
+  }
+
+  uint64_t LatencyHistogram::GetCountAtOrBelow(uint64_t nanoseconds) const {
+    uint64_t count = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+      if (GetBucketUpperBound(i) > nanoseconds) {
+        break;
+      }
+      count += buckets_[i].load(memory_order_relaxed);
+    }
+    return count;
+  }
+
+  uint64_t LatencyHistogram::GetPercentile(double quantile) const {
+    uint64_t counts[kBucketCount];
+    uint64_t total_count = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+      counts[i] = buckets_[i].load(memory_order_relaxed);
+      total_count += counts[i];
+    }
+    if (total_count == 0) {
+      return 0;
+    }
+
+    if (quantile < 0.0) quantile = 0.0;
+    if (quantile > 1.0) quantile = 1.0;
+    uint64_t rank = static_cast<uint64_t>(ceil(quantile * total_count));
+    if (rank == 0) rank = 1;
+
+    uint64_t count = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+      count += counts[i];
+      if (count >= rank) {
+        return GetBucketUpperBound(i);
+      }
+    }
+    return GetBucketUpperBound(kBucketCount - 1);
+  }
+
+  void LatencyHistogram::Reset() {
+    for (atomic<uint64_t>& bucket : buckets_) {
+      bucket.store(0, memory_order_relaxed);
+    }
+    sum_.store(0, memory_order_relaxed);
+  }
+
+  uint64_t LatencyHistogram::GetBucketLowerBound(size_t bucket_index) {
+    if (bucket_index < kSubBucketCount) {
+      return bucket_index;
+    }
+    const size_t shift = bucket_index / kSubBucketCount - 1;
+    const uint64_t sub_bucket = bucket_index % kSubBucketCount;
+    return (kSubBucketCount + sub_bucket) << shift;
+  }
+
+  uint64_t LatencyHistogram::GetBucketUpperBound(size_t bucket_index) {
+    if (bucket_index < kSubBucketCount) {
+      return bucket_index;
+    }
+    const size_t shift = bucket_index / kSubBucketCount - 1;
+    return GetBucketLowerBound(bucket_index) + ((uint64_t{1} << shift) - 1);
+  }
+
+} // namespace chatserver
@@ -0,0 +1,140 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_LATENCYHISTOGRAM_H_
+#define CHATSERVER_LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// This class records latencies in nanoseconds into a log-linear histogram
+// in the style of HdrHistogram. Every power of two is split into
+// kSubBucketCount buckets, so a recorded value is kept with a relative error
+// of at most 1 / kSubBucketCount over the whole 64-bit range.
+// Recording is lock-free: one bit scan and two relaxed atomic additions.
+// Readers see a consistent enough snapshot for monitoring, but not an atomic
+// one.
+// Example:
+//   LatencyHistogram histogram;
+//   {
+//     ScopedLatencyRecorder recorder(&histogram);
+//     do something to measure
+//   }
+//   uint64_t p99 = histogram.GetPercentile(0.99);
+
+namespace chatserver {
+
+  class LatencyHistogram {
+   public:
+    // Values below kSubBucketCount have a bucket each.
+    static const int kSubBucketBits = 3;
+    static const size_t kSubBucketCount = size_t{1} << kSubBucketBits;
+    static const size_t kBucketCount = (64 - kSubBucketBits + 1) *
+                                       kSubBucketCount;
+
+    LatencyHistogram();
+
+    // Record the given latency in nanoseconds. It is inline because it is on
+    // the request path.
+    void Record(uint64_t nanoseconds) {
+      buckets_[GetBucketIndex(nanoseconds)].fetch_add(
+          1, std::memory_order_relaxed);
+      sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    // Get the number of recorded values.
+    uint64_t GetCount() const;
+
+    // Get the sum of recorded values in nanoseconds.
+    uint64_t GetSum() const;
+
+    // Get the number of recorded values of the given bucket.
+    uint64_t GetBucketCount(size_t bucket_index) const;
+
+    // Get the number of recorded values below or equal to the given value.
+    // Values of the bucket that holds the given value are not counted unless
+    // the whole bucket is below or equal to it.
+    uint64_t GetCountAtOrBelow(uint64_t nanoseconds) const;
+
+    // Get the value at the given quantile (0.0 - 1.0) in nanoseconds. It is
+    // the upper bound of the bucket that holds the value. Return 0 if no
+    // value is recorded.
+    uint64_t GetPercentile(double quantile) const;
+
+    // Remove every recorded value.
+    void Reset();
+
+    // Get the bucket of the given value.
+    static size_t GetBucketIndex(uint64_t value) {
+      if (value < kSubBucketCount) {
+        return static_cast<size_t>(value);
+      }
+      const int shift = FindMostSignificantBit(value) - kSubBucketBits;
+      return static_cast<size_t>(shift + 1) * kSubBucketCount +
+             static_cast<size_t>((value >> shift) & (kSubBucketCount - 1));
+    }
+
+    // Get the smallest value of the given bucket.
+    static uint64_t GetBucketLowerBound(size_t bucket_index);
+
+    // Get the largest value of the given bucket.
+    static uint64_t GetBucketUpperBound(size_t bucket_index);
+
+   private:
+    // Index of the highest set bit. The value must not be 0.
+    static int FindMostSignificantBit(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+      unsigned long index = 0;
+      _BitScanReverse64(&index, value);
+      return static_cast<int>(index);
+#elif defined(_MSC_VER)
+      unsigned long index = 0;
+      if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) {
+        return static_cast<int>(index) + 32;
+      }
+      _BitScanReverse(&index, static_cast<unsigned long>(value));
+      return static_cast<int>(index);
+#else
+      return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    // Number of recorded values of each bucket.
+    std::atomic<uint64_t> buckets_[kBucketCount];
+
+    // Sum of recorded values in nanoseconds.
+    std::atomic<uint64_t> sum_;
+  };
+
+  // Record the lifetime of this object into the given histogram.
+  class ScopedLatencyRecorder {
+   public:
+    explicit ScopedLatencyRecorder(LatencyHistogram* histogram)
+        : histogram_(histogram),
+          start_time_(std::chrono::steady_clock::now()) {
+    }
+
+    ~ScopedLatencyRecorder() {
+      histogram_->Record(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start_time_).count()));
+    }
+
+    ScopedLatencyRecorder(const ScopedLatencyRecorder&) = delete;
+    ScopedLatencyRecorder& operator=(const ScopedLatencyRecorder&) = delete;
+
+   private:
+    LatencyHistogram* histogram_;
+    std::chrono::steady_clock::time_point start_time_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_LATENCYHISTOGRAM_H_
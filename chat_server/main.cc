@@ -2,13 +2,20 @@
 // Code style follows Google C++ Style Guide.
 // (https://google.github.io/styleguide/cppguide.html)
 
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <string>
 
 #include "cpprest/http_listener.h"
 #include "cpprest/uri.h"
+#include "async_logging.h"
 #include "chat_server.h"
+#include "partitioned_chat_log.h"
 #include "spdlog/spdlog.h"
+#include "tracing.h"
 
 using namespace std;
 using ::utility::string_t;
@@ -19,11 +26,23 @@ using ::web::uri_builder;
 using ::concurrency::task_status;
 
 namespace chatserver {
+
+  // Partitioned chat message database of the chat server.
+  const utility::char_t kChatLogDirectory[] = UU("chat_messages_sample");
   
-  int RunChatserver(string_t chat_server_uri) { 
+  int RunChatserver(string_t chat_server_uri, uint64_t memory_budget) { 
     unique_ptr<ChatDatabase> chat_database = make_unique<ChatDatabase>();
-    if (!chat_database->Initialize(UU("chat_messages_sample.txt"),
-                                   UU("chat_rooms_sample.txt"))) {
+    // A partitioned directory made by "convert" replaces the single file.
+    // Its chat rooms are loaded on first access, so the start doesn't wait
+    // for the history.
+    const bool initialized =
+        PartitionedChatLog::Exists(kChatLogDirectory)
+            ? chat_database->InitializePartitioned(kChatLogDirectory,
+                                                   UU("chat_rooms_sample.txt"),
+                                                   true)
+            : chat_database->Initialize(UU("chat_messages_sample.txt"),
+                                        UU("chat_rooms_sample.txt"));
+    if (!initialized) {
       error("Fail chat database initialization");
       return 0;
     }
@@ -43,6 +62,8 @@ namespace chatserver {
       error("Fail chat server initialization");
       return 0;
     }
+    // The budget covers the chat rooms and the cached responses.
+    chat_server.SetMemoryBudget(memory_budget);
 
     // Open the chat server
     task_status status = chat_server.OpenServer().wait();  
@@ -62,6 +83,9 @@ namespace chatserver {
       } else {
         error("Fail to close the chat server.");
       }
+      // The sequencer is joined, so the index has every stored chat message.
+      // The next start indexes only the chat messages stored after this.
+      chat_database->SaveSearchIndex();
     } else {
       error("Fail to start the chat server.");
     }
@@ -71,11 +95,65 @@ namespace chatserver {
 }  // namespace chatserver
 
 
+// Usage: chat_server [port] [log overflow policy: block | overrun_oldest]
+//                    [memory budget of chat rooms and cached responses in
+//                     MiB, 0 for none]
+//        chat_server convert [chat message file] [chat log directory]
 int main(int argc, char* argv[]) {
+  if (argc >= 2 && string(argv[1]) == "convert") {
+    // Split the single chat message file into one log file per chat room.
+    const string_t chat_message_file =
+        argc >= 3 ? utility::conversions::to_string_t(argv[2])
+                  : UU("chat_messages_sample.txt");
+    const string_t chat_log_directory =
+        argc >= 4 ? utility::conversions::to_string_t(argv[3])
+                  : chatserver::kChatLogDirectory;
+    if (!chatserver::PartitionedChatLog::Convert(chat_message_file,
+                                                 chat_log_directory)) {
+      error("Fail to convert: {}", to_utf8string(chat_message_file));
+      return 1;
+    }
+    info("Converted into: {}", to_utf8string(chat_log_directory));
+    return 0;
+  }
+
   string_t port = UU("34568");
-  if (argc == 2) {
+  if (argc >= 2) {
     port = utility::conversions::to_string_t(argv[1]);
   }
+
+  // Block by default: no log message is lost, and a full ring only slows
+  // down request threads while the console catches up.
+  spdlog::async_overflow_policy overflow_policy =
+      spdlog::async_overflow_policy::block;
+  if (argc >= 3 &&
+      !chatserver::AsyncLogging::ParseOverflowPolicy(argv[2],
+                                                     &overflow_policy)) {
+    error("Unknown log overflow policy: {}", argv[2]);
+    return 0;
+  }
+  // Chat rooms are evicted only if they are loaded lazily.
+  uint64_t memory_budget = 0;
+  if (argc >= 4) {
+    char* end = nullptr;
+    const uint64_t kBytesPerMebibyte = 1024 * 1024;
+    errno = 0;
+    memory_budget = strtoull(argv[3], &end, 10);
+    // A budget that doesn't fit in bytes would wrap to a tiny one.
+    if (end == argv[3] || *end != '\0' || argv[3][0] == '-' ||
+        errno == ERANGE ||
+        memory_budget > numeric_limits<uint64_t>::max() / kBytesPerMebibyte) {
+      error("Invalid memory budget: {}", argv[3]);
+      return 0;
+    }
+    memory_budget *= kBytesPerMebibyte;
+  }
+  chatserver::AsyncLogging::Initialize(
+      chatserver::AsyncLogging::kDefaultQueueSize, overflow_policy);
+#if defined(CHATSERVER_ENABLE_TRACING)
+  // Trace 1% of requests into chat_server_trace.json.
+  chatserver::Tracing::Start("chat_server_trace.json", 0.01);
+#endif
   
   string_t address = UU("http://localhost:");
   address.append(port);
@@ -83,5 +161,11 @@ int main(int argc, char* argv[]) {
   uri_builder uri(address);
   uri.append_path(UU("chat"));
 
-  return chatserver::RunChatserver(uri.to_uri().to_string());
+  const int result = chatserver::RunChatserver(uri.to_uri().to_string(),
+                                                memory_budget);
+#if defined(CHATSERVER_ENABLE_TRACING)
+  chatserver::Tracing::Stop();
+#endif
+  chatserver::AsyncLogging::Shutdown();
+  return result;
 }
\ No newline at end of file
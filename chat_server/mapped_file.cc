@@ -0,0 +1,116 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "mapped_file.h"
+
+#include <cstdint>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace chatserver {
+
+  MappedFile::MappedFile() : data_(nullptr), size_(0) {
+  }
+
+  MappedFile::~MappedFile() {
+    Close();
+  }
+
+#if defined(_WIN32)
+
+  bool MappedFile::Open(const utility::string_t& file_name) {
+    Close();
+    const HANDLE file = CreateFileW(file_name.c_str(), GENERIC_READ,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                    nullptr, OPEN_EXISTING,
+                                    FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) ||
+        static_cast<unsigned long long>(file_size.QuadPart) > SIZE_MAX) {
+      CloseHandle(file);
+      return false;
+    }
+    // A mapping of an empty file can't be created.
+    if (file_size.QuadPart == 0) {
+      CloseHandle(file);
+      return true;
+    }
+
+    const HANDLE mapping =
+        CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+      return false;
+    }
+    // The view keeps the mapping alive.
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+      return false;
+    }
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    return true;
+  }
+
+  void MappedFile::Close() {
+    if (data_ != nullptr) {
+      UnmapViewOfFile(data_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+#else
+
+  bool MappedFile::Open(const utility::string_t& file_name) {
+    Close();
+    const int file = open(file_name.c_str(), O_RDONLY);
+    if (file < 0) {
+      return false;
+    }
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0) {
+      close(file);
+      return false;
+    }
+    if (file_stat.st_size == 0) {
+      close(file);
+      return true;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(file_stat.st_size),
+                      PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (view == MAP_FAILED) {
+      return false;
+    }
+    // The file is read from the beginning to the end once.
+    madvise(view, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<size_t>(file_stat.st_size);
+    return true;
+  }
+
+  void MappedFile::Close() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+#endif
+
+} // namespace chatserver
@@ -0,0 +1,59 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_MAPPEDFILE_H_
+#define CHATSERVER_MAPPEDFILE_H_
+
+#include <cstddef>
+
+#include "cpprest/details/basic_types.h"
+
+// This class maps a whole file into memory for reading. The pages are read
+// by the OS on first access, so several threads can parse parts of a large
+// file without copying it into a buffer first.
+// The whole file must fit in the address space: a Win32 process can map
+// about 1 GB, so use an x64 build for larger files.
+// Example:
+//   MappedFile mapped_file;
+//   if (mapped_file.Open(UU("chat_messages.txt"))) {
+//     Parse(mapped_file.GetData(), mapped_file.GetSize());
+//   }
+
+namespace chatserver {
+
+  class MappedFile {
+   public:
+    MappedFile();
+
+    // Unmap the file.
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the given file read-only. An empty file is opened with no data.
+    // Return false if the file can't be opened or mapped.
+    bool Open(const utility::string_t& file_name);
+
+    // Unmap the file. GetData returns nullptr afterwards.
+    void Close();
+
+    // Get the first byte of the file, or nullptr if the file is empty.
+    const char* GetData() const {
+      return data_;
+    }
+
+    // Get the size of the file in bytes.
+    size_t GetSize() const {
+      return size_;
+    }
+
+   private:
+    const char* data_;
+    size_t size_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_MAPPEDFILE_H_
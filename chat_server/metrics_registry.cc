@@ -0,0 +1,176 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "metrics_registry.h"
+
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "instrumented_mutex.h"
+
+using namespace std;
+
+namespace chatserver {
+
+  namespace {
+
+    // Upper bounds of the exported histogram buckets.
+    struct ExportBucket {
+      const char* le;
+      uint64_t nanoseconds;
+    };
+
+    // Buckets of request latencies: 50 us - 10 s.
+    const ExportBucket kRequestBuckets[] = {
+      {"0.00005", 50000},
+      {"0.0001", 100000},
+      {"0.00025", 250000},
+      {"0.0005", 500000},
+      {"0.001", 1000000},
+      {"0.0025", 2500000},
+      {"0.005", 5000000},
+      {"0.01", 10000000},
+      {"0.025", 25000000},
+      {"0.05", 50000000},
+      {"0.1", 100000000},
+      {"0.25", 250000000},
+      {"0.5", 500000000},
+      {"1", 1000000000},
+      {"2.5", 2500000000},
+      {"5", 5000000000},
+      {"10", 10000000000},
+    };
+
+    // Buckets of lock wait and hold times: 100 ns - 100 ms.
+    const ExportBucket kLockBuckets[] = {
+      {"0.0000001", 100},
+      {"0.0000005", 500},
+      {"0.000001", 1000},
+      {"0.000005", 5000},
+      {"0.00001", 10000},
+      {"0.00005", 50000},
+      {"0.0001", 100000},
+      {"0.0005", 500000},
+      {"0.001", 1000000},
+      {"0.01", 10000000},
+      {"0.1", 100000000},
+    };
+
+    template <size_t kBucketSize>
+    void WriteHistogram(ostringstream& out,
+                        const char* name,
+                        const string& label,
+                        const LatencyHistogram& histogram,
+                        const ExportBucket (&buckets)[kBucketSize]) {
+      // Read the total first, so a value recorded meanwhile can only make a
+      // bucket larger than the total; clamp to keep the buckets monotonic.
+      const uint64_t count = histogram.GetCount();
+      for (const ExportBucket& bucket : buckets) {
+        uint64_t bucket_count = histogram.GetCountAtOrBelow(bucket.nanoseconds);
+        if (bucket_count > count) bucket_count = count;
+        out << name << "_bucket{" << label << ",le=\"" << bucket.le << "\"} "
+            << bucket_count << "\n";
+      }
+      out << name << "_bucket{" << label << ",le=\"+Inf\"} " << count << "\n";
+      out << name << "_sum{" << label << "} " << histogram.GetSum() / 1e9
+          << "\n";
+      out << name << "_count{" << label << "} " << count << "\n";
+    }
+
+    void WriteHeader(ostringstream& out, const char* name, const char* help,
+                     const char* type) {
+      out << "# HELP " << name << " " << help << "\n";
+      out << "# TYPE " << name << " " << type << "\n";
+    }
+
+    void WriteGauge(ostringstream& out, const char* name, const char* help,
+                    uint64_t value) {
+      WriteHeader(out, name, help, "gauge");
+      out << name << " " << value << "\n";
+    }
+
+  } // namespace
+
+  MetricsRegistry::MetricsRegistry() : response_bytes_(0) {
+  }
+
+  LatencyHistogram* MetricsRegistry::GetRouteLatency(Route route) {
+    return &route_latencies_[static_cast<size_t>(route)];
+  }
+
+  uint64_t MetricsRegistry::GetResponseBytes() const {
+    return response_bytes_.load(memory_order_relaxed);
+  }
+
+  string MetricsRegistry::ExportPrometheusText(const Gauges& gauges) const {
+    ostringstream out;
+    out << setprecision(9);
+
+    const char* const kLatencyName = "chat_server_request_duration_seconds";
+    WriteHeader(out, kLatencyName,
+                "Time spent in the request handler of each route.",
+                "histogram");
+    for (size_t i = 0; i < static_cast<size_t>(Route::kRouteCount); ++i) {
+      const Route route = static_cast<Route>(i);
+      if (route == Route::kNotFound) {
+        continue;
+      }
+      WriteHistogram(out, kLatencyName,
+                     string("route=\"") + RouteTable::GetRouteName(route) +
+                         "\"",
+                     route_latencies_[i], kRequestBuckets);
+    }
+
+    // Lock profiles exist only if lock profiling is compiled in.
+    const vector<const LockProfile*> lock_profiles =
+        LockProfiler::GetProfiles();
+    if (!lock_profiles.empty()) {
+      const char* const kLockWaitName = "chat_server_lock_wait_seconds";
+      WriteHeader(out, kLockWaitName, "Time to acquire each lock.",
+                  "histogram");
+      for (const LockProfile* profile : lock_profiles) {
+        WriteHistogram(out, kLockWaitName,
+                       "lock=\"" + profile->name + "\"",
+                       profile->wait_time, kLockBuckets);
+      }
+      const char* const kLockHoldName = "chat_server_lock_hold_seconds";
+      WriteHeader(out, kLockHoldName, "Time each lock is held.", "histogram");
+      for (const LockProfile* profile : lock_profiles) {
+        WriteHistogram(out, kLockHoldName,
+                       "lock=\"" + profile->name + "\"",
+                       profile->hold_time, kLockBuckets);
+      }
+      const char* const kLockContentionName =
+          "chat_server_lock_contentions_total";
+      WriteHeader(out, kLockContentionName,
+                  "Acquisitions that waited for another thread.", "counter");
+      for (const LockProfile* profile : lock_profiles) {
+        out << kLockContentionName << "{lock=\"" << profile->name << "\"} "
+            << profile->contention_count.load(memory_order_relaxed) << "\n";
+      }
+    }
+
+    WriteHeader(out, "chat_server_response_bytes_total",
+                "Size of response bodies with data.", "counter");
+    out << "chat_server_response_bytes_total " << GetResponseBytes() << "\n";
+
+    WriteHeader(out, "chat_server_dropped_log_messages_total",
+                "Log messages overwritten in the asynchronous log queue.",
+                "counter");
+    out << "chat_server_dropped_log_messages_total "
+        << gauges.dropped_log_message_count << "\n";
+
+    WriteGauge(out, "chat_server_sessions", "Number of live sessions.",
+               gauges.session_count);
+    WriteGauge(out, "chat_server_chat_rooms", "Number of chat rooms.",
+               gauges.chat_room_count);
+    WriteGauge(out, "chat_server_chat_messages", "Number of chat messages.",
+               gauges.chat_message_count);
+    WriteGauge(out, "chat_server_chat_memory_bytes",
+               "Bytes of the chat rooms in memory.", gauges.chat_memory_bytes);
+    return out.str();
+  }
+
+} // namespace chatserver
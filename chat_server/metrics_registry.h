@@ -0,0 +1,72 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_METRICSREGISTRY_H_
+#define CHATSERVER_METRICSREGISTRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "latency_histogram.h"
+#include "route_table.h"
+
+// This class keeps the in-process metrics of the chat server: a latency
+// histogram of each route and the number of response body bytes. Every
+// update is lock-free, so it can be called on the request path. Values that
+// other classes already own, such as the number of sessions and the lock
+// profiles of InstrumentedMutex, are read when the metrics are exported.
+// Example:
+//   MetricsRegistry metrics;
+//   {
+//     ScopedLatencyRecorder recorder(
+//         metrics.GetRouteLatency(Route::kGetChatRoom));
+//     do something to process the request
+//   }
+//   metrics.AddResponseBytes(body.size());
+//   std::string text = metrics.ExportPrometheusText(gauges);
+
+namespace chatserver {
+
+  class MetricsRegistry {
+   public:
+    // Values owned by other classes. They are sampled when the metrics are
+    // exported.
+    struct Gauges {
+      uint64_t session_count = 0;
+      uint64_t chat_room_count = 0;
+      uint64_t chat_message_count = 0;
+      uint64_t chat_memory_bytes = 0;
+      uint64_t dropped_log_message_count = 0;
+    };
+
+    MetricsRegistry();
+
+    // Get the latency histogram of the given route.
+    LatencyHistogram* GetRouteLatency(Route route);
+
+    // Add the size of a response body.
+    void AddResponseBytes(uint64_t bytes) {
+      response_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // Get the total size of response bodies.
+    uint64_t GetResponseBytes() const;
+
+    // Export every metric in the Prometheus text exposition format 0.0.4.
+    // Latencies are exported as histograms in seconds.
+    std::string ExportPrometheusText(const Gauges& gauges) const;
+
+   private:
+    // Latency histogram of each route, indexed by Route.
+    LatencyHistogram
+        route_latencies_[static_cast<size_t>(Route::kRouteCount)];
+
+    // Total size of response bodies.
+    std::atomic<uint64_t> response_bytes_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_METRICSREGISTRY_H_
@@ -0,0 +1,94 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_MPSCQUEUE_H_
+#define CHATSERVER_MPSCQUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+// MpscQueue is an unbounded lock-free queue for many producers and a single
+// consumer. Push is wait-free: one atomic exchange of the head and one store.
+// Pop is called only from the consumer thread. A value pushed while Pop runs
+// may be seen by the next Pop, since the producer links its node after the
+// exchange.
+// Example:
+//   MpscQueue<ChatMessage> queue;
+//   queue.Push(chat_message);  // any thread
+//   ChatMessage chat_message;
+//   while (queue.Pop(&chat_message)) {  // the consumer thread
+//     do something with chat_message
+//   }
+
+namespace chatserver {
+
+  template <typename T>
+  class MpscQueue {
+   public:
+    // Make the queue with its stub node.
+    MpscQueue() : head_(new Node()), tail_(head_.load()) {
+    }
+
+    // Delete the values left in the queue.
+    ~MpscQueue() {
+      while (tail_ != nullptr) {
+        Node* const next = tail_->next.load(std::memory_order_relaxed);
+        delete tail_;
+        tail_ = next;
+      }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Add the given value to the queue. Safe from any thread.
+    void Push(T value) {
+      Node* const node = new Node(std::move(value));
+      Node* const previous = head_.exchange(node, std::memory_order_acq_rel);
+      previous->next.store(node, std::memory_order_release);
+    }
+
+    // Move the oldest value into out_value. Return false if the queue is
+    // empty. Only the consumer thread may call it.
+    bool Pop(T* out_value) {
+      Node* const next = tail_->next.load(std::memory_order_acquire);
+      if (next == nullptr) {
+        return false;
+      }
+      // next becomes the stub node, so its value is moved out.
+      *out_value = std::move(next->value);
+      delete tail_;
+      tail_ = next;
+      return true;
+    }
+
+    // Check whether Pop would return false. Only the consumer thread may
+    // call it.
+    bool IsEmpty() const {
+      return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+   private:
+    struct Node {
+      Node() : next(nullptr) {
+      }
+
+      explicit Node(T node_value)
+          : next(nullptr), value(std::move(node_value)) {
+      }
+
+      std::atomic<Node*> next;
+      T value;
+    };
+
+    // Last pushed node. Producers swap it.
+    std::atomic<Node*> head_;
+
+    // Stub node in front of the oldest value. Only the consumer touches it.
+    Node* tail_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_MPSCQUEUE_H_
@@ -0,0 +1,332 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "partitioned_chat_log.h"
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+#include "cpprest/asyncrt_utils.h"
+#include "chat_message_loader.h"
+#include "spdlog/spdlog.h"
+#include "tracing.h"
+
+using namespace std;
+using ::utility::string_t;
+using ::utility::conversions::to_utf8string;
+using ::spdlog::error;
+
+namespace chatserver {
+
+  namespace {
+
+    // File name of the manifest in the directory.
+    const char kManifestFileName[] = "manifest.txt";
+
+    // File name of the chat rooms of users in the directory.
+    const char kUserChatRoomFileName[] = "user_chat_rooms.txt";
+
+    // Delimiter between the file name and the chat room in the manifest, and
+    // between the user ID and the chat room in the user chat room file.
+    const ChatChar kManifestDelimiter = CHATSERVER_TEXT('|');
+
+    // Get the path of the given file in the given directory.
+    template <typename FileName>
+    string_t JoinPath(const string_t& directory, const FileName& file_name) {
+      return (filesystem::path(directory) / file_name).native();
+    }
+
+  } // namespace
+
+  PartitionedChatLog::Partition::Partition(string_t partition_file)
+      : mutex_append("PartitionedChatLog::Partition::mutex_append"),
+        file(move(partition_file)),
+        index_file(file + UU(".index")) {
+  }
+
+  PartitionedChatLog::PartitionedChatLog()
+      : mutex_partitions_("PartitionedChatLog::mutex_partitions_"),
+        mutex_user_chat_rooms_("PartitionedChatLog::mutex_user_chat_rooms_") {
+  }
+
+  bool PartitionedChatLog::Exists(const string_t& directory) {
+    error_code error_code;
+    return filesystem::exists(JoinPath(directory, kManifestFileName),
+                              error_code);
+  }
+
+  bool PartitionedChatLog::Open(const string_t& directory) {
+    CHATSERVER_TRACE_SPAN("PartitionedChatLog::Open");
+    const lock_guard<InstrumentedMutex> lock(mutex_partitions_);
+    directory_ = directory;
+    partitions_.clear();
+    error_code error_code;
+    filesystem::create_directories(directory_, error_code);
+    if (error_code) {
+      error("Unable to create the chat log directory: {}",
+            to_utf8string(directory_));
+      return false;
+    }
+
+    const string_t manifest_file = JoinPath(directory_, kManifestFileName);
+    if (!filesystem::exists(manifest_file, error_code)) {
+      ChatOutputFileStream file(manifest_file, ChatOutputFileStream::out);
+      return file.is_open();
+    }
+    ChatInputFileStream file(manifest_file);
+    if (!file.is_open()) {
+      error("Can't open the manifest: {}", to_utf8string(manifest_file));
+      return false;
+    }
+    ChatString line;
+    while (getline(file, line)) {
+      if (line.empty()) {
+        continue;
+      }
+      const size_t delimiter = line.find(kManifestDelimiter);
+      if (delimiter == 0 || delimiter == ChatString::npos ||
+          delimiter + 1 == line.size()) {
+        error("Malformed manifest: {}", to_utf8string(manifest_file));
+        return false;
+      }
+      const ChatString chat_room = line.substr(delimiter + 1);
+      partitions_[chat_room] = make_unique<Partition>(
+          JoinPath(directory_, line.substr(0, delimiter)));
+    }
+    return true;
+  }
+
+  vector<ChatString> PartitionedChatLog::GetChatRooms() const {
+    const lock_guard<InstrumentedMutex> lock(mutex_partitions_);
+    vector<ChatString> chat_rooms;
+    for (const auto& partition : partitions_) {
+      chat_rooms.push_back(partition.first);
+    }
+    return chat_rooms;
+  }
+
+  PartitionedChatLog::Partition* PartitionedChatLog::GetPartition(
+      const ChatString& chat_room) {
+    const lock_guard<InstrumentedMutex> lock(mutex_partitions_);
+    const auto partition = partitions_.find(chat_room);
+    if (partition != partitions_.end()) {
+      return partition->second.get();
+    }
+
+    // Log files are numbered, so any chat room name is stored safely.
+    error_code error_code;
+    size_t number = partitions_.size();
+    string file_name;
+    do {
+      file_name = "room_" + to_string(number++) + ".log";
+    } while (filesystem::exists(JoinPath(directory_, file_name), error_code));
+
+    const string_t manifest_file = JoinPath(directory_, kManifestFileName);
+    ChatOutputFileStream file(manifest_file,
+                              ChatOutputFileStream::out |
+                              ChatOutputFileStream::app);
+    if (!file.is_open()) {
+      error("Unable to open file: {}", to_utf8string(manifest_file));
+      return nullptr;
+    }
+    file << FromUtf8(file_name) << kManifestDelimiter << chat_room
+         << CHATSERVER_TEXT('\n');
+    file.flush();
+    if (file.fail()) {
+      error("Unable to write file: {}", to_utf8string(manifest_file));
+      return nullptr;
+    }
+    unique_ptr<Partition>& new_partition = partitions_[chat_room];
+    new_partition = make_unique<Partition>(JoinPath(directory_, file_name));
+    return new_partition.get();
+  }
+
+  bool PartitionedChatLog::LoadChatRoom(
+      const ChatString& chat_room,
+      vector<ChatMessage>* out_chat_messages) const {
+    CHATSERVER_TRACE_SPAN("PartitionedChatLog::LoadChatRoom");
+    string_t partition_file;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_partitions_);
+      const auto partition = partitions_.find(chat_room);
+      if (partition == partitions_.end()) {
+        return true;
+      }
+      partition_file = partition->second->file;
+    }
+    error_code error_code;
+    if (!filesystem::exists(partition_file, error_code)) {
+      return true;
+    }
+
+    // Chat rooms are loaded in parallel, so one thread parses each file.
+    ChatMessageLoader::ChatMessageMap chat_messages;
+    if (!ChatMessageLoader::Load(partition_file, 1, &chat_messages)) {
+      return false;
+    }
+    for (auto& room_chat_messages : chat_messages) {
+      if (room_chat_messages.first != chat_room) {
+        error("Chat message of another chat room in {}",
+              to_utf8string(partition_file));
+        return false;
+      }
+      *out_chat_messages = move(room_chat_messages.second);
+    }
+    return true;
+  }
+
+  uint64_t PartitionedChatLog::GetLogFileSize(
+      const ChatString& chat_room) const {
+    string_t partition_file;
+    {
+      const lock_guard<InstrumentedMutex> lock(mutex_partitions_);
+      const auto partition = partitions_.find(chat_room);
+      if (partition == partitions_.end()) {
+        return 0;
+      }
+      partition_file = partition->second->file;
+    }
+    error_code error_code;
+    const uintmax_t file_size = filesystem::file_size(partition_file,
+                                                      error_code);
+    return error_code ? 0 : file_size;
+  }
+
+  bool PartitionedChatLog::AppendLines(const Partition& partition,
+                                       const ChatString& lines) {
+    // A partial line makes the chat room unloadable, so a failed write is
+    // cut back to the size before it.
+    error_code error_code;
+    uintmax_t file_size = filesystem::file_size(partition.file, error_code);
+    if (error_code) {
+      file_size = 0;
+    }
+    bool is_written = false;
+    {
+      ChatOutputFileStream file(partition.file,
+                                ChatOutputFileStream::out |
+                                ChatOutputFileStream::app);
+      if (!file.is_open()) {
+        error("Unable to open file: {}", to_utf8string(partition.file));
+        return false;
+      }
+      file << lines;
+      file.flush();
+      is_written = !file.fail();
+    }
+    if (!is_written) {
+      filesystem::resize_file(partition.file, file_size, error_code);
+      if (error_code) {
+        error("Unable to truncate file: {}", to_utf8string(partition.file));
+      }
+    }
+    return is_written;
+  }
+
+  bool PartitionedChatLog::LoadUserChatRooms(
+      vector<UserChatRoom>* out_user_chat_rooms) const {
+    CHATSERVER_TRACE_SPAN("PartitionedChatLog::LoadUserChatRooms");
+    const lock_guard<InstrumentedMutex> lock(mutex_user_chat_rooms_);
+    const string_t user_chat_room_file =
+        JoinPath(directory_, kUserChatRoomFileName);
+    ChatInputFileStream file(user_chat_room_file);
+    if (!file.is_open()) {
+      return false;
+    }
+    ChatString line;
+    while (getline(file, line)) {
+      if (line.empty()) {
+        continue;
+      }
+      const size_t delimiter = line.find(kManifestDelimiter);
+      if (delimiter == 0 || delimiter == ChatString::npos ||
+          delimiter + 1 == line.size()) {
+        error("Malformed user chat room file: {}",
+              to_utf8string(user_chat_room_file));
+        return false;
+      }
+      out_user_chat_rooms->push_back(
+          {line.substr(0, delimiter), line.substr(delimiter + 1)});
+    }
+    return true;
+  }
+
+  bool PartitionedChatLog::AppendUserChatRooms(
+      const vector<UserChatRoom>& user_chat_rooms) {
+    return WriteUserChatRooms(user_chat_rooms,
+                              ChatOutputFileStream::out |
+                              ChatOutputFileStream::app);
+  }
+
+  bool PartitionedChatLog::RewriteUserChatRooms(
+      const vector<UserChatRoom>& user_chat_rooms) {
+    return WriteUserChatRooms(user_chat_rooms,
+                              ChatOutputFileStream::out |
+                              ChatOutputFileStream::trunc);
+  }
+
+  bool PartitionedChatLog::WriteUserChatRooms(
+      const vector<UserChatRoom>& user_chat_rooms,
+      ios_base::openmode mode) {
+    const lock_guard<InstrumentedMutex> lock(mutex_user_chat_rooms_);
+    const string_t user_chat_room_file =
+        JoinPath(directory_, kUserChatRoomFileName);
+    ChatOutputFileStream file(user_chat_room_file, mode);
+    if (!file.is_open()) {
+      error("Unable to open file: {}", to_utf8string(user_chat_room_file));
+      return false;
+    }
+    for (const UserChatRoom& user_chat_room : user_chat_rooms) {
+      file << user_chat_room.user_id << kManifestDelimiter
+           << user_chat_room.chat_room << CHATSERVER_TEXT('\n');
+    }
+    file.flush();
+    if (file.fail()) {
+      error("Unable to write file: {}", to_utf8string(user_chat_room_file));
+      return false;
+    }
+    return true;
+  }
+
+  bool PartitionedChatLog::Convert(const string_t& chat_message_file,
+                                   const string_t& directory) {
+    CHATSERVER_TRACE_SPAN("PartitionedChatLog::Convert");
+    ChatMessageLoader::ChatMessageMap chat_messages;
+    if (!ChatMessageLoader::Load(chat_message_file, 0, &chat_messages)) {
+      error("Parsing error: {}", to_utf8string(chat_message_file));
+      return false;
+    }
+    PartitionedChatLog partitioned_log;
+    if (!partitioned_log.Open(directory)) {
+      return false;
+    }
+    if (!partitioned_log.GetChatRooms().empty()) {
+      error("The chat log directory is not empty: {}",
+            to_utf8string(directory));
+      return false;
+    }
+
+    for (const auto& room_chat_messages : chat_messages) {
+      Partition* const partition =
+          partitioned_log.GetPartition(room_chat_messages.first);
+      if (partition == nullptr) {
+        return false;
+      }
+      // The id of a chat message is its position in the chat room.
+      ChatOutputStringStream lines;
+      uint64_t id = 0;
+      for (const ChatMessage& chat_message : room_chat_messages.second) {
+        ChatMessageLoader::FormatLine(chat_message, ++id, &lines);
+      }
+      const lock_guard<InstrumentedMutex> lock(partition->mutex_append);
+      if (!AppendLines(*partition, lines.str())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+} // namespace chatserver
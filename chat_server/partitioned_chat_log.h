@@ -0,0 +1,145 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_PARTITIONEDCHATLOG_H_
+#define CHATSERVER_PARTITIONEDCHATLOG_H_
+
+#include <cstdint>
+#include <ios>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "cpprest/details/basic_types.h"
+#include "chat_message.h"
+#include "chat_string.h"
+#include "instrumented_mutex.h"
+
+// PartitionedChatLog keeps the chat message file database as a directory
+// with one log file per chat room, so a chat room is loaded without reading
+// the others, the chat rooms are loaded in parallel, and appends of different
+// chat rooms take different locks and files. A manifest lists the partitions,
+// one "file name|chat room" line each, as a chat room name may not be a valid
+// file name. A log file has the lines of the single chat message file, in
+// the format of ChatMessageLoader.
+// A partition is added to the manifest before its log file is written, so a
+// partition without a log file has no chat messages.
+// The directory also keeps the search index of each chat room next to its log
+// file, and the chat rooms every user posted to, one "user ID|chat room" line
+// each, so the chat rooms of a user are known without loading every chat
+// room.
+// Example:
+//   PartitionedChatLog partitioned_log;
+//   if (partitioned_log.Open(UU("chat_messages"))) {
+//     PartitionedChatLog::Partition* partition =
+//         partitioned_log.GetPartition(chat_room);
+//     const lock_guard<InstrumentedMutex> lock(partition->mutex_append);
+//     PartitionedChatLog::AppendLines(*partition, lines);
+//   }
+
+namespace chatserver {
+
+  class PartitionedChatLog {
+   public:
+    // Log file of one chat room.
+    struct Partition {
+      explicit Partition(utility::string_t partition_file);
+
+      // Mutex for writers of the chat room. It is held while the lines are
+      // formatted and appended, so the ids follow the order of the file.
+      InstrumentedMutex mutex_append;
+
+      // Path of the log file.
+      const utility::string_t file;
+
+      // Path of the search index file of the chat room.
+      const utility::string_t index_file;
+    };
+
+    // A chat room a user posted to.
+    struct UserChatRoom {
+      ChatString user_id;
+      ChatString chat_room;
+    };
+
+    // Name mutex_partitions_ and mutex_user_chat_rooms_ for lock profiling.
+    PartitionedChatLog();
+
+    PartitionedChatLog(const PartitionedChatLog&) = delete;
+    PartitionedChatLog& operator=(const PartitionedChatLog&) = delete;
+
+    // Check the given directory has a manifest.
+    static bool Exists(const utility::string_t& directory);
+
+    // Open the given directory, and create it and its manifest if there are
+    // none. Return false if the manifest can't be read or is malformed.
+    bool Open(const utility::string_t& directory);
+
+    // Get the chat rooms with a partition.
+    std::vector<ChatString> GetChatRooms() const;
+
+    // Get the partition of the given chat room, and add it to the manifest if
+    // there is none. A partition is never removed, so the pointer stays
+    // valid. Return nullptr if the manifest can't be written.
+    Partition* GetPartition(const ChatString& chat_room);
+
+    // Read the chat messages of the given chat room in file order. A chat
+    // room without a partition has none. Return false if its log file is
+    // malformed or has lines of another chat room.
+    bool LoadChatRoom(const ChatString& chat_room,
+                      std::vector<ChatMessage>* out_chat_messages) const;
+
+    // Get the bytes of the log file of the given chat room, or 0 if it has
+    // none.
+    uint64_t GetLogFileSize(const ChatString& chat_room) const;
+
+    // Append the given lines to the log file of the partition and flush
+    // them. If that fails, the file is truncated back to its size before.
+    // mutex_append of the partition must be held.
+    static bool AppendLines(const Partition& partition,
+                            const ChatString& lines);
+
+    // Read the chat rooms every user posted to. Return false if there is no
+    // user chat room file, or it can't be read or is malformed.
+    bool LoadUserChatRooms(
+        std::vector<UserChatRoom>* out_user_chat_rooms) const;
+
+    // Append the given chat rooms of users to the user chat room file and
+    // flush them. Return false if they can't be written.
+    bool AppendUserChatRooms(const std::vector<UserChatRoom>& user_chat_rooms);
+
+    // Replace the user chat room file with the given chat rooms of users.
+    // Return false if they can't be written.
+    bool RewriteUserChatRooms(
+        const std::vector<UserChatRoom>& user_chat_rooms);
+
+    // Write the chat messages of the given single chat message file into a
+    // new partitioned directory. The chat messages of old lines get their
+    // ids and timestamps. Return false if the file can't be read, or the
+    // directory already has partitions.
+    static bool Convert(const utility::string_t& chat_message_file,
+                        const utility::string_t& directory);
+
+   private:
+    // Write the given chat rooms of users to the user chat room file, opened
+    // with the given mode.
+    bool WriteUserChatRooms(const std::vector<UserChatRoom>& user_chat_rooms,
+                            std::ios_base::openmode mode);
+
+    // Mutex for partitions_ and the manifest.
+    mutable InstrumentedMutex mutex_partitions_;
+
+    // Mutex for the user chat room file.
+    mutable InstrumentedMutex mutex_user_chat_rooms_;
+
+    // Directory of the manifest and the log files.
+    utility::string_t directory_;
+
+    // chat room -> partition.
+    std::map<ChatString, std::unique_ptr<Partition>> partitions_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_PARTITIONEDCHATLOG_H_
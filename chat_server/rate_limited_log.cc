@@ -0,0 +1,60 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "rate_limited_log.h"
+
+using namespace std;
+using chrono::duration_cast;
+using chrono::nanoseconds;
+using chrono::steady_clock;
+
+namespace chatserver {
+
+  namespace {
+
+    int64_t GetSteadyNanoseconds() {
+      return duration_cast<nanoseconds>(
+          steady_clock::now().time_since_epoch()).count();
+    }
+
+  } // namespace
+
+  RateLimitedLog::RateLimitedLog(uint64_t burst_size,
+                                 chrono::milliseconds interval,
+                                 uint64_t sample_every)
+      : burst_size_(burst_size),
+        interval_(duration_cast<nanoseconds>(interval).count()),
+        sample_every_(sample_every),
+        interval_start_(GetSteadyNanoseconds()),
+        interval_count_(0),
+        suppressed_count_(0) {
+  }
+
+  bool RateLimitedLog::ShouldLog(uint64_t* out_suppressed_count) {
+    const int64_t now = GetSteadyNanoseconds();
+    int64_t interval_start = interval_start_.load(memory_order_relaxed);
+    if (now - interval_start >= interval_ &&
+        interval_start_.compare_exchange_strong(interval_start, now,
+                                                memory_order_relaxed)) {
+      // Only the thread that starts the new interval resets the count. A
+      // message counted meanwhile may land in either interval.
+      interval_count_.store(0, memory_order_relaxed);
+    }
+
+    const uint64_t count = interval_count_.fetch_add(1, memory_order_relaxed);
+    const bool is_sampled = sample_every_ > 0 && count >= burst_size_ &&
+                            (count - burst_size_ + 1) % sample_every_ == 0;
+    if (count < burst_size_ || is_sampled) {
+      const uint64_t suppressed_count =
+          suppressed_count_.exchange(0, memory_order_relaxed);
+      if (out_suppressed_count != nullptr) {
+        *out_suppressed_count = suppressed_count;
+      }
+      return true;
+    }
+    suppressed_count_.fetch_add(1, memory_order_relaxed);
+    return false;
+  }
+
+} // namespace chatserver
@@ -0,0 +1,58 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_RATELIMITEDLOG_H_
+#define CHATSERVER_RATELIMITEDLOG_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// This class decides whether a high-frequency log message is written. In
+// each interval the first burst_size messages are written, and after that
+// only every sample_every-th message (none if sample_every is 0). A written
+// message reports how many messages were skipped since the previous one.
+// It is lock-free, so it can be called on the request path.
+// Example:
+//   RateLimitedLog rate_limited_log(10, std::chrono::seconds(1), 100);
+//   uint64_t suppressed_count = 0;
+//   if (rate_limited_log.ShouldLog(&suppressed_count)) {
+//     warn("No matching HTTP request ({} suppressed)", suppressed_count);
+//   }
+
+namespace chatserver {
+
+  class RateLimitedLog {
+   public:
+    RateLimitedLog(uint64_t burst_size,
+                   std::chrono::milliseconds interval,
+                   uint64_t sample_every);
+
+    // Check the current message should be written. If so, out_suppressed_count
+    // gets the number of messages skipped since the last written message.
+    bool ShouldLog(uint64_t* out_suppressed_count);
+
+   private:
+    // Number of messages written at the start of each interval.
+    const uint64_t burst_size_;
+
+    // Length of an interval in nanoseconds.
+    const int64_t interval_;
+
+    // Write every sample_every_-th message after the burst. 0 disables it.
+    const uint64_t sample_every_;
+
+    // Start of the current interval in steady clock nanoseconds.
+    std::atomic<int64_t> interval_start_;
+
+    // Number of messages in the current interval.
+    std::atomic<uint64_t> interval_count_;
+
+    // Number of messages skipped since the last written message.
+    std::atomic<uint64_t> suppressed_count_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_RATELIMITEDLOG_H_
@@ -0,0 +1,150 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "response_cache.h"
+
+#include "content_coding.h"
+
+using namespace std;
+using ::utility::string_t;
+
+namespace chatserver {
+
+  ResponseCache::ResponseCache()
+      : memory_usage_(0),
+        capacity_(kDefaultCapacity),
+        mutex_entries_("ResponseCache::mutex_entries_") {
+  }
+
+  void ResponseCache::SetCapacity(uint64_t capacity) {
+    lock_guard<InstrumentedMutex> lock_entries(mutex_entries_);
+    capacity_ = capacity;
+    EvictEntries();
+  }
+
+  uint64_t ResponseCache::GetCapacity() const {
+    lock_guard<InstrumentedMutex> lock_entries(mutex_entries_);
+    return capacity_;
+  }
+
+  uint64_t ResponseCache::GetMemoryUsage() const {
+    lock_guard<InstrumentedMutex> lock_entries(mutex_entries_);
+    return memory_usage_;
+  }
+
+  ResponseCache::Body ResponseCache::GetBody(
+      const string_t& chat_room,
+      bool is_cbor,
+      uint64_t version,
+      const function<vector<unsigned char>()>& serialize) {
+    const Key key(chat_room, is_cbor);
+    {
+      lock_guard<InstrumentedMutex> lock_entries(mutex_entries_);
+      const auto entry = FindEntry(key);
+      if (entry != entries_.end() && entry->second.version == version) {
+        return entry->second.body;
+      }
+    }
+
+    Body body = make_shared<const vector<unsigned char>>(serialize());
+    lock_guard<InstrumentedMutex> lock_entries(mutex_entries_);
+    auto entry = FindEntry(key);
+    if (entry == entries_.end()) {
+      lru_keys_.push_front(key);
+      entry = entries_.emplace(key, Entry()).first;
+      entry->second.lru_position = lru_keys_.begin();
+    } else if (entry->second.version == version) {
+      // Another request has just cached the same version.
+      return entry->second.body;
+    } else if (entry->second.version > version) {
+      return body;
+    }
+    memory_usage_ -= entry->second.bytes;
+    entry->second.bytes = 0;
+    entry->second.version = version;
+    entry->second.body = body;
+    entry->second.compressed_bodies.clear();
+    AddBytes(entry, body->size());
+    return body;
+  }
+
+  ResponseCache::Body ResponseCache::GetCompressedBody(
+      const string_t& chat_room,
+      bool is_cbor,
+      uint64_t version,
+      const string_t& content_coding,
+      const Body& body) {
+    const Key key(chat_room, is_cbor);
+    {
+      lock_guard<InstrumentedMutex> lock_entries(mutex_entries_);
+      const auto entry = FindEntry(key);
+      if (entry != entries_.end() && entry->second.version == version) {
+        const auto compressed_body =
+            entry->second.compressed_bodies.find(content_coding);
+        if (compressed_body != entry->second.compressed_bodies.end()) {
+          return compressed_body->second;
+        }
+      }
+    }
+
+    vector<unsigned char> compressed_data;
+    if (body == nullptr ||
+        !ContentCoding::Compress(content_coding, *body, &compressed_data)) {
+      return nullptr;
+    }
+    Body compressed_body =
+        make_shared<const vector<unsigned char>>(move(compressed_data));
+    lock_guard<InstrumentedMutex> lock_entries(mutex_entries_);
+    const auto entry = FindEntry(key);
+    if (entry != entries_.end() && entry->second.version == version &&
+        entry->second.body == body) {
+      Body& cached_body = entry->second.compressed_bodies[content_coding];
+      if (cached_body != nullptr) {
+        // Another request has just compressed the same body.
+        return cached_body;
+      }
+      cached_body = compressed_body;
+      AddBytes(entry, compressed_body->size());
+    }
+    return compressed_body;
+  }
+
+  void ResponseCache::Erase(const string_t& chat_room) {
+    lock_guard<InstrumentedMutex> lock_entries(mutex_entries_);
+    for (const bool is_cbor : {false, true}) {
+      const auto entry = entries_.find(Key(chat_room, is_cbor));
+      if (entry != entries_.end()) {
+        EraseEntry(entry);
+      }
+    }
+  }
+
+  ResponseCache::EntryMap::iterator ResponseCache::FindEntry(const Key& key) {
+    const auto entry = entries_.find(key);
+    if (entry != entries_.end()) {
+      lru_keys_.splice(lru_keys_.begin(), lru_keys_,
+                       entry->second.lru_position);
+    }
+    return entry;
+  }
+
+  void ResponseCache::AddBytes(EntryMap::iterator entry, uint64_t bytes) {
+    entry->second.bytes += bytes;
+    memory_usage_ += bytes;
+    EvictEntries();
+  }
+
+  void ResponseCache::EvictEntries() {
+    while (memory_usage_ > capacity_ && !lru_keys_.empty()) {
+      EraseEntry(entries_.find(lru_keys_.back()));
+    }
+  }
+
+  void ResponseCache::EraseEntry(EntryMap::iterator entry) {
+    memory_usage_ -= entry->second.bytes;
+    lru_keys_.erase(entry->second.lru_position);
+    entries_.erase(entry);
+  }
+
+} // namespace chatserver
@@ -0,0 +1,137 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_RESPONSECACHE_H_
+#define CHATSERVER_RESPONSECACHE_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "cpprest/details/basic_types.h"
+#include "instrumented_mutex.h"
+
+// This class caches the serialized chat message list of each chat room and
+// its compressed forms, keyed by the chat room version. A body is serialized
+// and compressed at most once per version of the chat room, and an entry is
+// replaced when the version changes, and dropped by Erase, e.g. when
+// ChatDatabase evicts the chat room.
+// The bodies take at most the capacity in bytes: the least recently used
+// entries are dropped to fit a new body. A body larger than the capacity is
+// returned without being cached.
+// The class is thread-safe. Serialization and compression run without the
+// lock, so two requests may rarely build the same body at the same time.
+// Example:
+//   auto body = response_cache.GetBody(chat_room, is_cbor, version,
+//                                      [&]() { return Serialize(...); });
+//   auto gzip_body = response_cache.GetCompressedBody(
+//       chat_room, is_cbor, version, UU("gzip"), body);
+
+namespace chatserver {
+
+  class ResponseCache {
+   public:
+    // Serialized or compressed response body shared with in-flight replies.
+    typedef std::shared_ptr<const std::vector<unsigned char>> Body;
+
+    // Default capacity in bytes.
+    static const uint64_t kDefaultCapacity = 64 * 1024 * 1024;
+
+    // Name mutex_entries_ for lock profiling.
+    ResponseCache();
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    // Set the capacity in bytes, and drop the least recently used entries
+    // to fit it.
+    void SetCapacity(uint64_t capacity);
+
+    // Get the capacity in bytes.
+    uint64_t GetCapacity() const;
+
+    // Get the bytes of the cached bodies.
+    uint64_t GetMemoryUsage() const;
+
+    // Get the serialized body of the given chat room and wire format. Call
+    // serialize if the cache has no body of the given version.
+    Body GetBody(const utility::string_t& chat_room,
+                 bool is_cbor,
+                 uint64_t version,
+                 const std::function<std::vector<unsigned char>()>& serialize);
+
+    // Get the given body compressed with the given content coding. Compress
+    // it if the cache has no compressed body of the given version. Return
+    // nullptr if compression fails.
+    Body GetCompressedBody(const utility::string_t& chat_room,
+                           bool is_cbor,
+                           uint64_t version,
+                           const utility::string_t& content_coding,
+                           const Body& body);
+
+    // Drop the bodies of the given chat room, in both wire formats.
+    void Erase(const utility::string_t& chat_room);
+
+   private:
+    // Cache key: <chat room, whether the body is CBOR>.
+    typedef std::pair<utility::string_t, bool> Key;
+
+    struct Entry {
+      // Chat room version of body and compressed_bodies.
+      uint64_t version = 0;
+
+      // Serialized body.
+      Body body;
+
+      // Compressed bodies: std::map<content coding, body>.
+      std::map<utility::string_t, Body> compressed_bodies;
+
+      // Bytes of body and compressed_bodies.
+      uint64_t bytes = 0;
+
+      // Position of the key in lru_keys_.
+      std::list<Key>::iterator lru_position;
+    };
+
+    typedef std::map<Key, Entry> EntryMap;
+
+    // Find the entry of the given key and mark it the most recently used.
+    // Return entries_.end() if there is none. mutex_entries_ must be held.
+    EntryMap::iterator FindEntry(const Key& key);
+
+    // Add the given bytes to the entry, and drop the least recently used
+    // entries until the bodies fit the capacity. The entry must be the most
+    // recently used one, so it is dropped last. mutex_entries_ must be held.
+    void AddBytes(EntryMap::iterator entry, uint64_t bytes);
+
+    // Drop the least recently used entries until the bodies fit the
+    // capacity. mutex_entries_ must be held.
+    void EvictEntries();
+
+    // Drop the given entry. mutex_entries_ must be held.
+    void EraseEntry(EntryMap::iterator entry);
+
+    // Cached entries.
+    EntryMap entries_;
+
+    // Keys of entries_, the most recently used first.
+    std::list<Key> lru_keys_;
+
+    // Bytes of the bodies in entries_.
+    uint64_t memory_usage_;
+
+    // Most bytes of the bodies in entries_.
+    uint64_t capacity_;
+
+    // Mutex for entries_, lru_keys_, memory_usage_ and capacity_.
+    mutable InstrumentedMutex mutex_entries_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_RESPONSECACHE_H_
@@ -0,0 +1,204 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "route_table.h"
+
+#include <cstdint>
+#include <type_traits>
+
+#include "cpprest/base_uri.h"
+
+using namespace std;
+using ::web::uri;
+using ::utility::char_t;
+using ::utility::string_t;
+
+namespace chatserver {
+
+  namespace {
+
+    // Entry of the route table: "method path" -> route.
+    struct RouteEntry {
+      const char* http_method;
+      const char* url_path;
+      Route route;
+      const char* name;
+    };
+
+    // Every REST API of the chat server. The URL path is relative to the
+    // chat server URL and has no leading or trailing slash.
+    constexpr RouteEntry kRouteEntries[] = {
+      {"GET", "chatmessage", Route::kGetChatMessage, "GET chatmessage"},
+      {"GET", "chatroom", Route::kGetChatRoom, "GET chatroom"},
+      {"GET", "chatmessage/multi", Route::kGetChatMessageMulti,
+       "GET chatmessage/multi"},
+      {"GET", "search", Route::kGetSearch, "GET search"},
+      {"GET", "user/messages", Route::kGetUserChatMessages,
+       "GET user/messages"},
+      {"GET", "metrics", Route::kGetMetrics, "GET metrics"},
+      {"GET", "metrics/memory", Route::kGetMemoryUsage, "GET metrics/memory"},
+      {"POST", "account", Route::kPostSignUp, "POST account"},
+      {"POST", "login", Route::kPostLogin, "POST login"},
+      {"POST", "chatmessage", Route::kPostChatMessage, "POST chatmessage"},
+      {"POST", "chatroom", Route::kPostChatRoom, "POST chatroom"},
+      {"POST", "chatmessage/batch", Route::kPostChatMessageBatch,
+       "POST chatmessage/batch"},
+      {"DELETE", "session", Route::kDeleteSession, "DELETE session"},
+    };
+    constexpr size_t kRouteEntryCount =
+        sizeof(kRouteEntries) / sizeof(kRouteEntries[0]);
+    static_assert(kRouteEntryCount + 1 ==
+                      static_cast<size_t>(Route::kRouteCount),
+                  "Every route but kNotFound needs a route entry.");
+
+    // Number of hash slots. It must be a power of two.
+    constexpr size_t kRouteSlotCount = 64;
+
+    // 32-bit FNV-1a hash parameters. The seed replaces the FNV offset basis
+    // and is chosen so that every route key gets its own slot.
+    constexpr uint32_t kRouteHashSeed = 3u;
+    constexpr uint32_t kFnvPrime = 16777619u;
+
+    constexpr uint32_t HashCodeUnit(uint32_t hash, uint32_t code_unit) {
+      return (hash ^ code_unit) * kFnvPrime;
+    }
+
+    constexpr uint32_t HashLiteral(uint32_t hash, const char* literal) {
+      while (*literal != '\0') {
+        hash = HashCodeUnit(hash, static_cast<unsigned char>(*literal));
+        ++literal;
+      }
+      return hash;
+    }
+
+    // Hash of the route key "method path".
+    constexpr uint32_t HashRouteKey(const char* http_method,
+                                    const char* url_path) {
+      return HashLiteral(
+          HashCodeUnit(HashLiteral(kRouteHashSeed, http_method), ' '),
+          url_path);
+    }
+
+    // Hash slot -> index of kRouteEntries, or -1 for an empty slot.
+    struct RouteSlots {
+      int entry_index[kRouteSlotCount];
+      bool is_perfect;
+    };
+
+    constexpr RouteSlots BuildRouteSlots() {
+      RouteSlots route_slots = {};
+      route_slots.is_perfect = true;
+      for (size_t i = 0; i < kRouteSlotCount; ++i) {
+        route_slots.entry_index[i] = -1;
+      }
+      for (size_t i = 0; i < kRouteEntryCount; ++i) {
+        const size_t slot = HashRouteKey(kRouteEntries[i].http_method,
+                                         kRouteEntries[i].url_path) &
+                            (kRouteSlotCount - 1);
+        if (route_slots.entry_index[slot] != -1) {
+          route_slots.is_perfect = false;
+        }
+        route_slots.entry_index[slot] = static_cast<int>(i);
+      }
+      return route_slots;
+    }
+
+    constexpr RouteSlots kRouteSlots = BuildRouteSlots();
+    static_assert(kRouteSlots.is_perfect,
+                  "Route keys collide. Please change kRouteHashSeed.");
+
+    inline uint32_t ToCodeUnit(char_t c) {
+      return static_cast<uint32_t>(
+          static_cast<make_unsigned<char_t>::type>(c));
+    }
+
+    // Compare [begin, end) with the given ASCII literal.
+    bool EqualsLiteral(const char_t* begin, const char_t* end,
+                       const char* literal) {
+      for (; begin != end; ++begin, ++literal) {
+        if (*literal == '\0' ||
+            ToCodeUnit(*begin) != static_cast<unsigned char>(*literal)) {
+          return false;
+        }
+      }
+      return *literal == '\0';
+    }
+
+    // Look up the route of the given method and path [begin, end).
+    Route LookUpRoute(const string_t& http_method,
+                      const char_t* begin,
+                      const char_t* end) {
+      uint32_t hash = kRouteHashSeed;
+      for (const char_t c : http_method) {
+        hash = HashCodeUnit(hash, ToCodeUnit(c));
+      }
+      hash = HashCodeUnit(hash, ' ');
+      for (const char_t* it = begin; it != end; ++it) {
+        hash = HashCodeUnit(hash, ToCodeUnit(*it));
+      }
+
+      const int index = kRouteSlots.entry_index[hash & (kRouteSlotCount - 1)];
+      if (index < 0) {
+        return Route::kNotFound;
+      }
+
+      // The slot is shared with unknown keys, so confirm the key itself.
+      const RouteEntry& entry = kRouteEntries[index];
+      const char_t* method = http_method.data();
+      if (!EqualsLiteral(method, method + http_method.size(),
+                         entry.http_method) ||
+          !EqualsLiteral(begin, end, entry.url_path)) {
+        return Route::kNotFound;
+      }
+      return entry.route;
+    }
+
+    Route ResolveDecodedPath(const string_t& http_method,
+                             const string_t& url_path) {
+      const char_t* begin = url_path.data();
+      const char_t* end = begin + url_path.size();
+      while (begin != end && *begin == UU('/')) ++begin;
+      while (end != begin && *(end - 1) == UU('/')) --end;
+      if (begin == end) {
+        return Route::kNotFound;
+      }
+
+      // Match the whole path.
+      const Route route = LookUpRoute(http_method, begin, end);
+      if (route != Route::kNotFound) {
+        return route;
+      }
+
+      // Match the first segment of the path.
+      const char_t* first_segment_end = begin;
+      while (first_segment_end != end && *first_segment_end != UU('/')) {
+        ++first_segment_end;
+      }
+      if (first_segment_end == end) {
+        return Route::kNotFound;
+      }
+      return LookUpRoute(http_method, begin, first_segment_end);
+    }
+
+  } // namespace
+
+  Route RouteTable::Resolve(const string_t& http_method,
+                            const string_t& url_path) {
+    // Decode only when needed: most paths have no percent-encoded character.
+    if (url_path.find(UU('%')) != string_t::npos) {
+      return ResolveDecodedPath(http_method, uri::decode(url_path));
+    }
+    return ResolveDecodedPath(http_method, url_path);
+  }
+
+  const char* RouteTable::GetRouteName(Route route) {
+    for (const RouteEntry& entry : kRouteEntries) {
+      if (entry.route == route) {
+        return entry.name;
+      }
+    }
+    return "not found";
+  }
+
+} // namespace chatserver
@@ -0,0 +1,61 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_ROUTETABLE_H_
+#define CHATSERVER_ROUTETABLE_H_
+
+#include <cstddef>
+
+#include "cpprest/details/basic_types.h"
+
+// This class resolves an HTTP method and a relative URL path into one of the
+// REST API routes of the chat server. The route table is a perfect hash table
+// that is built at compile time, so resolving a request costs one hash of the
+// method and path, one table lookup, and one string comparison. No temporary
+// strings or containers are allocated.
+// A path is matched as a whole first (e.g. "chatmessage/batch"). If there is
+// no match, its first segment is matched (e.g. "chatroom/abc" -> "chatroom").
+// Example:
+//   Route route = RouteTable::Resolve(UU("GET"), UU("/chatmessage"));
+//   if (route == Route::kGetChatMessage) {
+//     do something to process the chat message request
+//   }
+
+namespace chatserver {
+
+  // REST API routes of the chat server.
+  enum class Route {
+    kNotFound,
+    kGetChatMessage,
+    kGetChatRoom,
+    kGetChatMessageMulti,
+    kGetSearch,
+    kGetUserChatMessages,
+    kGetMetrics,
+    kGetMemoryUsage,
+    kPostSignUp,
+    kPostLogin,
+    kPostChatMessage,
+    kPostChatRoom,
+    kPostChatMessageBatch,
+    kDeleteSession,
+    // Number of routes. It must stay last.
+    kRouteCount
+  };
+
+  class RouteTable {
+   public:
+    // Resolve the given HTTP method and relative URL path to a route.
+    // Leading and trailing slashes of the path are ignored. Return
+    // Route::kNotFound if there is no matching route.
+    static Route Resolve(const utility::string_t& http_method,
+                         const utility::string_t& url_path);
+
+    // Get the name of the given route for logging, e.g. "GET chatmessage".
+    static const char* GetRouteName(Route route);
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_ROUTETABLE_H_
@@ -5,7 +5,7 @@
 #ifndef CHATSERVER_SESSION_H_
 #define CHATSERVER_SESSION_H_
 
-#include "cpprest/details/basic_types.h"
+#include "chat_string.h"
 
 // Session information structure (session_id, user_id, last_activity_time).
 
@@ -13,10 +13,10 @@ namespace chatserver {
 
   struct Session {
     // Session id.
-    utility::string_t session_id;
+    ChatString session_id;
 
     // User id.
-    utility::string_t user_id;
+    ChatString user_id;
 
     // Last activity time of this session.
     time_t last_activity_time;
@@ -6,15 +6,15 @@
 
 #include <chrono>
 #include <future>
+#include <vector>
 
 #include "cpprest/asyncrt_utils.h"
 #include "spdlog/spdlog.h"
+#include "tracing.h"
 
 using namespace std;
 using chrono::system_clock;
 using chrono::duration;
-using ::utility::conversions::to_utf8string;
-using ::utility::string_t;
 using ::spdlog::info;
 
 namespace chatserver {
@@ -26,14 +26,15 @@ namespace chatserver {
   // Period to check session expire (second).
   const time_t kSessionCheckInterval = 1;
   // Session seed.
-  const string_t kSessionValue = UU(
+  const ChatString kSessionValue = CHATSERVER_TEXT(
       "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz");
 
   SessionManager::SessionManager() : SessionManager(kSessionAliveTime) {
   }
 
   SessionManager::SessionManager(time_t session_alive_time)
-      : rand_(std::random_device{}()),
+      : mutex_sessions_("SessionManager::mutex_sessions_"),
+        rand_(std::random_device{}()),
         session_generator_(0, kSessionValue.size() - 1),
         session_alive_time_(session_alive_time) {
   }
@@ -42,8 +43,9 @@ namespace chatserver {
     run_thread_ = false;
   }
 
-  bool SessionManager::IsExistSessionId(string_t session_id) {
-    const lock_guard<mutex> lock(mutex_sessions_);
+  bool SessionManager::IsExistSessionId(const ChatString& session_id) {
+    CHATSERVER_TRACE_SPAN("SessionManager::IsExistSessionId");
+    const lock_guard<InstrumentedMutex> lock(mutex_sessions_);
 
     if (sessions_.find(session_id) == sessions_.end()) {
       return false;
@@ -52,8 +54,9 @@ namespace chatserver {
     }
   }
 
-  Session SessionManager::CreateSession(string_t user_id) {
-    const lock_guard<mutex> lock(mutex_sessions_);
+  Session SessionManager::CreateSession(ChatString user_id) {
+    CHATSERVER_TRACE_SPAN("SessionManager::CreateSession");
+    const lock_guard<InstrumentedMutex> lock(mutex_sessions_);
 
     // If user ID exists, update session active time
     if (user_id_to_session_id_.find(user_id) != user_id_to_session_id_.end()) {
@@ -73,8 +76,9 @@ namespace chatserver {
     return new_session;
   }
 
-  bool SessionManager::DeleteSession(string_t session_id) {
-    const lock_guard<mutex> lock(mutex_sessions_);
+  bool SessionManager::DeleteSession(ChatString session_id) {
+    CHATSERVER_TRACE_SPAN("SessionManager::DeleteSession");
+    const lock_guard<InstrumentedMutex> lock(mutex_sessions_);
     if (sessions_.find(session_id) == sessions_.end()) {
       return false;
     } else {
@@ -84,8 +88,9 @@ namespace chatserver {
     }
   }
 
-  bool SessionManager::RenewLastActivityTime(string_t session_id) {
-    const lock_guard<mutex> lock(mutex_sessions_);
+  bool SessionManager::RenewLastActivityTime(const ChatString& session_id) {
+    CHATSERVER_TRACE_SPAN("SessionManager::RenewLastActivityTime");
+    const lock_guard<InstrumentedMutex> lock(mutex_sessions_);
 
     if (sessions_.find(session_id) == sessions_.end()) {
       return false;
@@ -96,19 +101,20 @@ namespace chatserver {
     }
   }
 
-  const string_t SessionManager::GenerateSessionId() {
-    string_t result;
+  const ChatString SessionManager::GenerateSessionId() {
+    ChatString result;
     for (size_t i = 0; i < kSessionLength; i++) {
       result += kSessionValue.at(session_generator_(rand_));
     }
     return result;
   }
 
-  bool SessionManager::GetUserIDFromSessionId(string_t session_id, 
-                                              string_t* out_user_id) {
+  bool SessionManager::GetUserIDFromSessionId(ChatString session_id, 
+                                              ChatString* out_user_id) {
+    CHATSERVER_TRACE_SPAN("SessionManager::GetUserIDFromSessionId");
     if (out_user_id == nullptr)
       return false;
-    const lock_guard<mutex> lock(mutex_sessions_);
+    const lock_guard<InstrumentedMutex> lock(mutex_sessions_);
 
     if (user_id_to_session_id_.find(sessions_[session_id].user_id) == 
         user_id_to_session_id_.end()) {
@@ -119,6 +125,11 @@ namespace chatserver {
     }
   }
 
+  size_t SessionManager::GetSessionCount() {
+    const lock_guard<InstrumentedMutex> lock(mutex_sessions_);
+    return sessions_.size();
+  }
+
   void SessionManager::RunSessionExpireThread() {
     run_thread_ = true;
     // Getting return value is necessary to run async thread,
@@ -131,16 +142,17 @@ namespace chatserver {
     while (run_thread_) {
       // Remove expired sessions every kSessionCheckInterval
       this_thread::sleep_for(duration<int>(kSessionCheckInterval));
+      // Log after releasing the lock: request threads wait for it.
+      vector<ChatString> expired_user_ids;
       {
-        const lock_guard<mutex> lock(mutex_sessions_);
+        const lock_guard<InstrumentedMutex> lock(mutex_sessions_);
         auto current_time = system_clock::now();
         for (auto it = sessions_.cbegin(); it != sessions_.cend();) {
           duration<double> diff = current_time -
             system_clock::from_time_t(
                 it->second.last_activity_time);
           if (diff.count() > session_alive_time_) {
-            info("Delete expired session: {}", 
-                to_utf8string(it->second.user_id));
+            expired_user_ids.push_back(it->second.user_id);
             user_id_to_session_id_.erase(it->second.user_id);
             sessions_.erase(it++);
           } else {
@@ -148,6 +160,9 @@ namespace chatserver {
           }
         }
       }
+      for (const ChatString& user_id : expired_user_ids) {
+        info("Delete expired session: {}", ToUtf8(user_id));
+      }
     }
   }
 
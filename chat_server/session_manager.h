@@ -7,10 +7,11 @@
 
 #include <future>
 #include <map>
-#include <mutex>
 #include <random>
 
 #include "cpprest/details/basic_types.h"
+#include "chat_string.h"
+#include "instrumented_mutex.h"
 #include "session.h"
 
 // This class is designed to manage a session for each connected account.
@@ -53,41 +54,44 @@ namespace chatserver {
     ~SessionManager();
 
     // Check the given session ID exists.
-    bool IsExistSessionId(utility::string_t session_id);
+    bool IsExistSessionId(const ChatString& session_id);
 
     // Create a session ID for a given user ID.
     // If the user ID has session, renew session alive time.
-    Session CreateSession(utility::string_t user_id);
+    Session CreateSession(ChatString user_id);
 
     // Delete the given session with session_id.
-    bool DeleteSession(utility::string_t session_id);
+    bool DeleteSession(ChatString session_id);
 
     // Update the last alive time for the session with a given session_id.
-    bool RenewLastActivityTime(utility::string_t session_id);
+    bool RenewLastActivityTime(const ChatString& session_id);
 
     // Get the user ID corresponding to the given session ID.
     // Return false If the given ID has no session.
-    bool GetUserIDFromSessionId(utility::string_t session_id, 
-                                utility::string_t* out_user_id);
+    bool GetUserIDFromSessionId(ChatString session_id, 
+                                ChatString* out_user_id);
+
+    // Get the number of live sessions.
+    size_t GetSessionCount();
 
     // Execute thread that deletes sessions that are over alive time.
     void RunSessionExpireThread();
     
    private:
     // Create session id of length kSessionLength using alphabet and number.
-    const utility::string_t GenerateSessionId();
+    const ChatString GenerateSessionId();
 
     // Delete expired sessions every kSessionCheckInterval seconds.
     void CheckAndDeleteExpiredSession();
 
     // Store session information <session_id, Session>
-    std::map<utility::string_t, Session> sessions_;
+    std::map<ChatString, Session> sessions_;
 
     // Store user_id mapping with session_id <user_id, session_id>
-    std::map<utility::string_t, utility::string_t> user_id_to_session_id_;
+    std::map<ChatString, ChatString> user_id_to_session_id_;
 
     // Mutex for member variables: sessions_, user_id_to_session_id_
-    std::mutex mutex_sessions_;
+    InstrumentedMutex mutex_sessions_;
 
     // The variable to control the async thread for start and stop.
     bool run_thread_;
@@ -0,0 +1,143 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "tracing.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#include "instrumented_mutex.h"
+#include "spdlog/spdlog.h"
+
+using namespace std;
+using ::spdlog::error;
+
+namespace chatserver {
+
+  thread_local bool Tracing::is_sampled_ = false;
+
+  namespace {
+
+    // Spans are written to the file in batches of this size.
+    const size_t kFlushSpanCount = 1024;
+
+    // Complete span: "ph": "X" in the Chrome trace event format.
+    struct Span {
+      const char* name;
+      int64_t start_time;
+      int64_t duration;
+      uint32_t thread_id;
+    };
+
+    // Requests are sampled if a random 32-bit number is below the threshold.
+    // 0 means tracing is stopped.
+    atomic<uint64_t> sample_threshold(0);
+
+    // Trace clock time of Start(). Timestamps in the file are relative to it.
+    atomic<int64_t> origin_time(0);
+
+    // Small sequential thread IDs are easier to read in a trace viewer.
+    atomic<uint32_t> next_thread_id(1);
+
+    // Guards every variable below.
+    InstrumentedMutex mutex_trace("Tracing::mutex_trace");
+    ofstream trace_file_stream;
+    vector<Span> pending_spans;
+    bool is_first_span = true;
+
+    uint32_t GetThreadId() {
+      thread_local const uint32_t thread_id =
+          next_thread_id.fetch_add(1, memory_order_relaxed);
+      return thread_id;
+    }
+
+    // xorshift32: cheap and good enough to pick requests.
+    uint32_t NextRandom() {
+      thread_local uint32_t state =
+          (2463534242u ^ (GetThreadId() * 2654435761u)) | 1u;
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+
+    // Write pending_spans to the file. mutex_trace must be held.
+    void WritePendingSpans() {
+      const int64_t origin = origin_time.load(memory_order_relaxed);
+      char line[256];
+      for (const Span& span : pending_spans) {
+        // Timestamps and durations are in microseconds.
+        snprintf(line, sizeof(line),
+                 "%s{\"name\":\"%s\",\"cat\":\"chat_server\",\"ph\":\"X\","
+                 "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                 is_first_span ? "" : ",\n", span.name,
+                 (span.start_time - origin) / 1000.0,
+                 span.duration / 1000.0, span.thread_id);
+        trace_file_stream << line;
+        is_first_span = false;
+      }
+      pending_spans.clear();
+      trace_file_stream.flush();
+    }
+
+  } // namespace
+
+  bool Tracing::Start(const string& trace_file, double sample_rate) {
+    const lock_guard<InstrumentedMutex> lock(mutex_trace);
+    if (trace_file_stream.is_open()) {
+      error("Tracing is already started");
+      return false;
+    }
+    trace_file_stream.open(trace_file, ofstream::out | ofstream::trunc);
+    if (!trace_file_stream.is_open()) {
+      error("Can't open trace file: {}", trace_file);
+      return false;
+    }
+    trace_file_stream << "[\n";
+    is_first_span = true;
+    pending_spans.reserve(kFlushSpanCount);
+
+    if (sample_rate < 0.0) sample_rate = 0.0;
+    if (sample_rate > 1.0) sample_rate = 1.0;
+    origin_time.store(Now(), memory_order_relaxed);
+    sample_threshold.store(
+        static_cast<uint64_t>(sample_rate * 4294967296.0),
+        memory_order_release);
+    return true;
+  }
+
+  void Tracing::Stop() {
+    sample_threshold.store(0, memory_order_release);
+    const lock_guard<InstrumentedMutex> lock(mutex_trace);
+    if (!trace_file_stream.is_open()) {
+      return;
+    }
+    WritePendingSpans();
+    trace_file_stream << "\n]\n";
+    trace_file_stream.close();
+  }
+
+  bool Tracing::BeginRequest() {
+    const uint64_t threshold = sample_threshold.load(memory_order_acquire);
+    is_sampled_ = threshold != 0 && NextRandom() < threshold;
+    return is_sampled_;
+  }
+
+  void Tracing::AddSpan(const char* name, int64_t start_time,
+                        int64_t end_time) {
+    const Span span = {name, start_time, end_time - start_time, GetThreadId()};
+    const lock_guard<InstrumentedMutex> lock(mutex_trace);
+    if (!trace_file_stream.is_open()) {
+      return;
+    }
+    pending_spans.push_back(span);
+    if (pending_spans.size() >= kFlushSpanCount) {
+      WritePendingSpans();
+    }
+  }
+
+} // namespace chatserver
@@ -0,0 +1,153 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_TRACING_H_
+#define CHATSERVER_TRACING_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Request lifecycle tracing. A request is sampled when it starts, and every
+// span of a sampled request is written to a file in the Chrome trace event
+// format (JSON array), which chrome://tracing or Perfetto can open. Spans of
+// a request that is not sampled cost one thread-local check.
+// Tracing is compiled in only if CHATSERVER_ENABLE_TRACING is defined (e.g.
+// in the preprocessor definitions of the project). Otherwise the macros below
+// expand to nothing.
+// Example:
+//   Tracing::Start("chat_server_trace.json", 0.01);
+//   void HandlePost(...) {
+//     CHATSERVER_TRACE_REQUEST("HandlePost");
+//     {
+//       CHATSERVER_TRACE_SPAN("ExtractBodyData");
+//       do something to measure
+//     }
+//   }
+//   Tracing::Stop();
+
+#if defined(CHATSERVER_ENABLE_TRACING)
+#define CHATSERVER_TRACE_CONCAT_INNER(a, b) a##b
+#define CHATSERVER_TRACE_CONCAT(a, b) CHATSERVER_TRACE_CONCAT_INNER(a, b)
+// Start a request: decide whether it is sampled and trace it as a span.
+#define CHATSERVER_TRACE_REQUEST(name) \
+    const ::chatserver::TraceRequest \
+        CHATSERVER_TRACE_CONCAT(trace_request_, __LINE__)(name)
+// Continue work of earlier requests on this thread, e.g. a batch of them, and
+// trace it as a span if any of them is sampled.
+#define CHATSERVER_TRACE_CONTINUED_REQUEST(name, is_sampled) \
+    const ::chatserver::TraceRequest \
+        CHATSERVER_TRACE_CONCAT(trace_request_, __LINE__)(name, is_sampled)
+// Trace the rest of the enclosing scope. The name must be a string literal.
+#define CHATSERVER_TRACE_SPAN(name) \
+    const ::chatserver::TraceSpan \
+        CHATSERVER_TRACE_CONCAT(trace_span_, __LINE__)(name)
+#else
+#define CHATSERVER_TRACE_REQUEST(name) static_cast<void>(0)
+#define CHATSERVER_TRACE_CONTINUED_REQUEST(name, is_sampled) \
+    static_cast<void>(0)
+#define CHATSERVER_TRACE_SPAN(name) static_cast<void>(0)
+#endif
+
+namespace chatserver {
+
+  class Tracing {
+   public:
+    // Start writing sampled requests to the given file. sample_rate is the
+    // fraction of requests to trace (0.0 - 1.0). Return false if the file
+    // can't be opened or tracing is already started.
+    static bool Start(const std::string& trace_file, double sample_rate);
+
+    // Write the buffered spans and close the trace file.
+    static void Stop();
+
+    // Decide whether the request that starts on this thread is sampled.
+    static bool BeginRequest();
+
+    // Continue work of a request that was sampled, or not, on another
+    // thread.
+    static bool ContinueRequest(bool is_sampled) {
+      is_sampled_ = is_sampled;
+      return is_sampled_;
+    }
+
+    // End the request on this thread.
+    static void EndRequest() {
+      is_sampled_ = false;
+    }
+
+    // Check the request on this thread is sampled.
+    static bool IsSampled() {
+      return is_sampled_;
+    }
+
+    // Get the current time of the trace clock in nanoseconds.
+    static int64_t Now() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Add a complete span. name must outlive tracing: use a string literal.
+    static void AddSpan(const char* name, int64_t start_time, int64_t end_time);
+
+   private:
+    // Whether the request on this thread is sampled.
+    static thread_local bool is_sampled_;
+  };
+
+  // Trace the lifetime of this object if the current request is sampled.
+  class TraceSpan {
+   public:
+    explicit TraceSpan(const char* name)
+        : name_(name),
+          start_time_(Tracing::IsSampled() ? Tracing::Now() : -1) {
+    }
+
+    ~TraceSpan() {
+      if (start_time_ >= 0) {
+        Tracing::AddSpan(name_, start_time_, Tracing::Now());
+      }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+   private:
+    const char* name_;
+    int64_t start_time_;
+  };
+
+  // Start a request on this thread and trace it if it is sampled.
+  class TraceRequest {
+   public:
+    explicit TraceRequest(const char* name)
+        : name_(name),
+          start_time_(Tracing::BeginRequest() ? Tracing::Now() : -1) {
+    }
+
+    // Continue a request whose sampling was decided on another thread.
+    TraceRequest(const char* name, bool is_sampled)
+        : name_(name),
+          start_time_(Tracing::ContinueRequest(is_sampled) ? Tracing::Now()
+                                                           : -1) {
+    }
+
+    ~TraceRequest() {
+      if (start_time_ >= 0) {
+        Tracing::AddSpan(name_, start_time_, Tracing::Now());
+        Tracing::EndRequest();
+      }
+    }
+
+    TraceRequest(const TraceRequest&) = delete;
+    TraceRequest& operator=(const TraceRequest&) = delete;
+
+   private:
+    const char* name_;
+    int64_t start_time_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_TRACING_H_
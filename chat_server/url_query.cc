@@ -0,0 +1,116 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "url_query.h"
+
+#include "cpprest/base_uri.h"
+
+using namespace std;
+using ::web::uri;
+using ::utility::string_t;
+
+namespace chatserver {
+
+  namespace {
+
+    // Percent-decode the given part of a query string when needed, into the
+    // given memory resource.
+    UrlQuery::String DecodeQueryPart(UrlQuery::StringView part,
+                                     pmr::memory_resource* memory_resource) {
+      if (part.find(UU('%')) != UrlQuery::StringView::npos) {
+        const string_t decoded_part = uri::decode(string_t(part));
+        return UrlQuery::String(decoded_part.data(), decoded_part.size(),
+                                memory_resource);
+      }
+      return UrlQuery::String(part.data(), part.size(), memory_resource);
+    }
+
+  } // namespace
+
+  UrlQuery::UrlQuery(const string_t& query,
+                     pmr::memory_resource* memory_resource)
+      : query_(query.data(), query.size(), memory_resource),
+        parameters_(memory_resource),
+        is_parsed_(false) {
+  }
+
+  bool UrlQuery::Find(StringView key, string_t* out_value) const {
+    StringView value;
+    if (out_value == nullptr || !FindView(key, &value)) {
+      return false;
+    }
+    out_value->assign(value.data(), value.size());
+    return true;
+  }
+
+  bool UrlQuery::FindView(StringView key, StringView* out_value) const {
+    if (out_value == nullptr) {
+      return false;
+    }
+
+    const size_t index = FindIndex(key);
+    if (index == kNotFound) {
+      return false;
+    }
+    *out_value = parameters_[index].second;
+    return true;
+  }
+
+  bool UrlQuery::Contains(StringView key) const {
+    return FindIndex(key) != kNotFound;
+  }
+
+  size_t UrlQuery::FindIndex(StringView key) const {
+    if (!is_parsed_) {
+      Parse();
+    }
+
+    for (size_t i = 0; i < parameters_.size(); ++i) {
+      if (parameters_[i].first == key) {
+        return i;
+      }
+    }
+    return kNotFound;
+  }
+
+  void UrlQuery::Parse() const {
+    is_parsed_ = true;
+    pmr::memory_resource* const memory_resource =
+        parameters_.get_allocator().resource();
+    const StringView query(query_);
+    size_t start_index = 0;
+    while (start_index < query.size()) {
+      size_t end_index = query.find_first_of(UU("&;"), start_index);
+      if (end_index == StringView::npos) {
+        end_index = query.size();
+      }
+
+      const size_t equal_index = query.find(UU('='), start_index);
+      if (equal_index != StringView::npos && equal_index < end_index) {
+        String key = DecodeQueryPart(
+            query.substr(start_index, equal_index - start_index),
+            memory_resource);
+        String value = DecodeQueryPart(
+            query.substr(equal_index + 1, end_index - equal_index - 1),
+            memory_resource);
+
+        // A duplicate key keeps the last value.
+        size_t index = 0;
+        while (index < parameters_.size() && parameters_[index].first != key) {
+          ++index;
+        }
+        if (index < parameters_.size()) {
+          parameters_[index].second = move(value);
+        } else {
+          if (parameters_.empty()) {
+            parameters_.reserve(kReservedQueryParameters);
+          }
+          parameters_.emplace_back(move(key), move(value));
+        }
+      }
+      start_index = end_index + 1;
+    }
+  }
+
+} // namespace chatserver
@@ -0,0 +1,85 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVER_URLQUERY_H_
+#define CHATSERVER_URLQUERY_H_
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "cpprest/details/basic_types.h"
+
+// This class holds the query string of an HTTP request URL and finds query
+// parameters in it. The query string is parsed lazily on the first lookup into
+// a flat vector, so a request that needs no query parameter never parses
+// it. Keys and values are percent-decoded. A duplicate key keeps the last
+// value, and a pair without '=' is ignored.
+// The query string and the parameters are allocated from the given memory
+// resource, which is the arena of the request in ChatServer handlers, and a
+// value can be found as a view without a copy.
+// The class is NOT thread-safe.
+// Example:
+//   UrlQuery url_query(message.relative_uri().query(), &request_arena);
+//   UrlQuery::StringView session_id;
+//   if (url_query.FindView(UU("session_id"), &session_id)) {
+//     do something with the session ID
+//   }
+
+namespace chatserver {
+
+  class UrlQuery {
+   public:
+    // Key or value of a query parameter.
+    typedef std::basic_string_view<utility::char_t> StringView;
+
+    // String allocated from the memory resource of the UrlQuery.
+    typedef std::pmr::basic_string<utility::char_t> String;
+
+    // Hold a copy of the given raw (not decoded) query string in the given
+    // memory resource.
+    explicit UrlQuery(const utility::string_t& query,
+                      std::pmr::memory_resource* memory_resource =
+                          std::pmr::get_default_resource());
+
+    // Find the value of the given query parameter. Return false if the query
+    // string has no such parameter.
+    bool Find(StringView key, utility::string_t* out_value) const;
+
+    // Find the value of the given query parameter without a copy. The view
+    // is valid as long as the UrlQuery is.
+    bool FindView(StringView key, StringView* out_value) const;
+
+    // Check the given query parameter exists.
+    bool Contains(StringView key) const;
+
+   private:
+    // Number of query parameters reserved on the first one. The chat server
+    // APIs use at most a few parameters, but parameters_ grows past it.
+    static const size_t kReservedQueryParameters = 8;
+
+    // Index FindIndex returns for a missing key.
+    static const size_t kNotFound = static_cast<size_t>(-1);
+
+    // Split query_ into parameters_.
+    void Parse() const;
+
+    // Find the index of the given key in parameters_, or kNotFound.
+    size_t FindIndex(StringView key) const;
+
+    // Raw query string.
+    String query_;
+
+    // Parsed query parameters <key, value>.
+    mutable std::pmr::vector<std::pair<String, String>> parameters_;
+
+    // Whether query_ has been parsed.
+    mutable bool is_parsed_;
+  };
+
+} // namespace chatserver
+
+#endif // CHATSERVER_URLQUERY_H_
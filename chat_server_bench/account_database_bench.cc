@@ -0,0 +1,75 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Measure AccountDatabase::Login without HTTP: a successful login, a wrong
+// password and an unknown ID with kAccountCount accounts.
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+#include "account_database.h"
+#include "bench_harness.h"
+
+using namespace std;
+using namespace chatserver;
+using ::utility::string_t;
+using ::utility::conversions::to_string_t;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kLoginIterations = 500000;
+    const size_t kAccountCount = 10000;
+
+    const char* const kAccountFile = "account_database_bench.txt";
+
+    // Hash a string the way the chat client does.
+    ChatString HashString(const ChatString& string) {
+      return FromUtf8(to_string(hash<string_t>{}(ToStringT(string))));
+    }
+
+    ChatString GetUserId(size_t index) {
+      return CHATSERVER_TEXT("user") + FromUtf8(to_string(index));
+    }
+
+  } // namespace
+
+  void RunAccountDatabaseBenchmarks() {
+    const ChatString password_hash = HashString(CHATSERVER_TEXT("12345678"));
+    ChatOutputFileStream file(kAccountFile,
+                              ChatOutputFileStream::out |
+                                  ChatOutputFileStream::trunc);
+    for (size_t i = 0; i < kAccountCount; ++i) {
+      file << GetUserId(i) << "," << password_hash << endl;
+    }
+    file.close();
+
+    AccountDatabase account_database;
+    account_database.Initialize(to_string_t(kAccountFile));
+
+    const ChatString user_id = GetUserId(kAccountCount / 2);
+    const ChatString nonce = CHATSERVER_TEXT("a1b2c3d4e5");
+    const ChatString login_password = HashString(password_hash + nonce);
+    RunBenchmark("account_database/login", kLoginIterations, [&]() {
+      DoNotOptimize(account_database.Login(user_id, login_password, nonce));
+    });
+
+    RunBenchmark("account_database/login_password_error", kLoginIterations,
+                 [&]() {
+      DoNotOptimize(
+          account_database.Login(user_id, CHATSERVER_TEXT("wrong"), nonce));
+    });
+
+    const ChatString unknown_user_id = CHATSERVER_TEXT("unknown_user");
+    RunBenchmark("account_database/login_id_not_exist", kLoginIterations,
+                 [&]() {
+      DoNotOptimize(
+          account_database.Login(unknown_user_id, login_password, nonce));
+    });
+    remove(kAccountFile);
+  }
+
+} // namespace chatserverbench
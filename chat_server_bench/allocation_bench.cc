@@ -0,0 +1,217 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Count the heap allocations of the GET chatmessage path with and without
+// the arenas: the query lookups of a request, the chat messages of a
+// multi-room request, and the append of a chat message to its chat room.
+// The global operator new of this program is replaced to count the calls.
+// The value of a result is heap allocations per operation, not nanoseconds.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "chat_room_log.h"
+#include "url_query.h"
+
+using namespace std;
+using namespace chatserver;
+using ::utility::string_t;
+
+namespace {
+
+  // Number of calls of the global operator new.
+  atomic<uint64_t> heap_allocation_count(0);
+
+} // namespace
+
+void* operator new(size_t size) {
+  heap_allocation_count.fetch_add(1, memory_order_relaxed);
+  void* const memory = malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept {
+  free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  free(memory);
+}
+
+// std::pmr::new_delete_resource() may allocate with the aligned form.
+void* operator new(size_t size, align_val_t alignment) {
+  heap_allocation_count.fetch_add(1, memory_order_relaxed);
+  const size_t alignment_size = static_cast<size_t>(alignment);
+  void* const memory = malloc(size + alignment_size + sizeof(void*));
+  if (memory == nullptr) {
+    throw bad_alloc();
+  }
+  // Keep the pointer from malloc right before the aligned memory.
+  const uintptr_t aligned_address =
+      (reinterpret_cast<uintptr_t>(memory) + sizeof(void*) +
+       alignment_size - 1) & ~(alignment_size - 1);
+  reinterpret_cast<void**>(aligned_address)[-1] = memory;
+  return reinterpret_cast<void*>(aligned_address);
+}
+
+void operator delete(void* memory, align_val_t) noexcept {
+  if (memory != nullptr) {
+    free(static_cast<void**>(memory)[-1]);
+  }
+}
+
+void operator delete(void* memory, size_t, align_val_t alignment) noexcept {
+  operator delete(memory, alignment);
+}
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kAllocationIterations = 10000;
+
+    // Bytes of the stack buffer of a request arena, as in ChatServer.
+    const size_t kRequestArenaSize = 4096;
+
+    // Query string of a typical GET chatmessage request.
+    const utility::char_t kChatMessageQuery[] =
+        UU("chat_room=abc&session_id=0123456789ABCDEFGHIJKLMNOPQRSTUV");
+
+    // Run function iterations times, and report the heap allocations of
+    // one call.
+    template <typename Function>
+    void RunAllocationBenchmark(const string& name,
+                                size_t iterations,
+                                Function function) {
+      if (!BenchmarkReport::IsSelected(name)) {
+        return;
+      }
+      function();
+      const uint64_t start_count = heap_allocation_count.load();
+      for (size_t i = 0; i < iterations; ++i) {
+        function();
+      }
+      const uint64_t allocation_count =
+          heap_allocation_count.load() - start_count;
+      BenchmarkReport::Add(
+          {name, static_cast<double>(allocation_count) / iterations,
+           iterations, 1});
+    }
+
+    // Chat room log with the given number of chat messages.
+    shared_ptr<ChatRoomLog> MakeChatRoomLog(
+        const shared_ptr<ChatMessageChunkPool>& chunk_pool,
+        const ChatString& chat_room,
+        size_t chat_message_count) {
+      const auto chat_room_log = make_shared<ChatRoomLog>(chunk_pool);
+      for (size_t i = 0; i < chat_message_count; ++i) {
+        chat_room_log->Append(ChatMessage(
+            1583581783 + i, CHATSERVER_TEXT("samsung"), chat_room,
+            CHATSERVER_TEXT("hello, this is a benchmark message")));
+      }
+      return chat_room_log;
+    }
+
+  } // namespace
+
+  void RunAllocationBenchmarks() {
+    const string_t query = kChatMessageQuery;
+    RunAllocationBenchmark(
+        "allocation/url_query_find_default", kAllocationIterations, [&]() {
+      const UrlQuery url_query(query);
+      string_t session_id;
+      string_t chat_room;
+      url_query.Find(UU("session_id"), &session_id);
+      url_query.Find(UU("chat_room"), &chat_room);
+      DoNotOptimize(session_id);
+      DoNotOptimize(chat_room);
+    });
+    RunAllocationBenchmark(
+        "allocation/url_query_find_request_arena", kAllocationIterations,
+        [&]() {
+      alignas(max_align_t) unsigned char request_buffer[kRequestArenaSize];
+      pmr::monotonic_buffer_resource request_arena(request_buffer,
+                                                   sizeof(request_buffer));
+      const UrlQuery url_query(query, &request_arena);
+      UrlQuery::StringView session_id;
+      UrlQuery::StringView chat_room;
+      url_query.FindView(UU("session_id"), &session_id);
+      url_query.FindView(UU("chat_room"), &chat_room);
+      DoNotOptimize(session_id);
+      DoNotOptimize(chat_room);
+    });
+
+    // Chat messages of two chat rooms collected for GET chatmessage/multi.
+    const auto chunk_pool = make_shared<ChatMessageChunkPool>();
+    const shared_ptr<ChatRoomLog> chat_room_logs[] = {
+        MakeChatRoomLog(chunk_pool, CHATSERVER_TEXT("lobby"), 30),
+        MakeChatRoomLog(chunk_pool, CHATSERVER_TEXT("samsung"), 30)};
+    RunAllocationBenchmark(
+        "allocation/multi_room_copy", kAllocationIterations, [&]() {
+      vector<ChatMessage> result;
+      for (const auto& chat_room_log : chat_room_logs) {
+        const shared_ptr<const ChatRoomSnapshot> chat_messages =
+            chat_room_log->GetSnapshot();
+        for (size_t i = 0; i < chat_messages->size(); ++i) {
+          result.push_back((*chat_messages)[i].ToChatMessage());
+        }
+      }
+      DoNotOptimize(result);
+    });
+    RunAllocationBenchmark(
+        "allocation/multi_room_views_request_arena", kAllocationIterations,
+        [&]() {
+      alignas(max_align_t) unsigned char request_buffer[kRequestArenaSize];
+      pmr::monotonic_buffer_resource request_arena(request_buffer,
+                                                   sizeof(request_buffer));
+      pmr::vector<shared_ptr<const ChatRoomSnapshot>> snapshots(
+          &request_arena);
+      size_t chat_message_count = 0;
+      for (const auto& chat_room_log : chat_room_logs) {
+        snapshots.push_back(chat_room_log->GetSnapshot());
+        chat_message_count += snapshots.back()->size();
+      }
+      pmr::vector<ChatMessageView> result(&request_arena);
+      result.reserve(chat_message_count);
+      for (const auto& chat_messages : snapshots) {
+        for (size_t i = 0; i < chat_messages->size(); ++i) {
+          result.push_back((*chat_messages)[i]);
+        }
+      }
+      DoNotOptimize(result);
+    });
+
+    // Append: the vector keeps three strings per chat message, the log
+    // copies the text into the arena of the chat room.
+    const ChatMessage chat_message(
+        1583581783, CHATSERVER_TEXT("samsung"), CHATSERVER_TEXT("lobby"),
+        CHATSERVER_TEXT("hello, this is a benchmark message"));
+    {
+      vector<ChatMessage> chat_messages;
+      RunAllocationBenchmark(
+          "allocation/chat_message_vector_push_back", kAllocationIterations,
+          [&]() {
+        chat_messages.push_back(chat_message);
+      });
+    }
+    {
+      ChatRoomLog chat_room_log(chunk_pool);
+      RunAllocationBenchmark(
+          "allocation/chat_room_log_append", kAllocationIterations, [&]() {
+        chat_room_log.Append(chat_message);
+      });
+    }
+  }
+
+} // namespace chatserverbench
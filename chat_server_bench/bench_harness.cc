@@ -0,0 +1,145 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "bench_harness.h"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "cpprest/json.h"
+
+using namespace std;
+using ::utility::conversions::to_string_t;
+using ::utility::conversions::to_utf8string;
+using ::web::json::value;
+using ::spdlog::error;
+using ::spdlog::info;
+
+namespace chatserverbench {
+
+  namespace {
+
+    // JSON keys of a result.
+    const char* const kJsonKeyBenchmarks = "benchmarks";
+    const char* const kJsonKeyName = "name";
+    const char* const kJsonKeyNanosecondsPerOp = "ns_per_op";
+    const char* const kJsonKeyIterations = "iterations";
+    const char* const kJsonKeyThreads = "threads";
+
+    // Benchmarks run on the main thread, so the state needs no lock.
+    string& GetFilter() {
+      static string filter;
+      return filter;
+    }
+
+    vector<BenchmarkResult>& GetResults() {
+      static vector<BenchmarkResult> results;
+      return results;
+    }
+
+  } // namespace
+
+  void BenchmarkReport::SetFilter(const string& filter) {
+    GetFilter() = filter;
+  }
+
+  bool BenchmarkReport::IsSelected(const string& name) {
+    return name.find(GetFilter()) != string::npos;
+  }
+
+  void BenchmarkReport::Add(const BenchmarkResult& result) {
+    if (result.thread_count > 1) {
+      info("{:<48} {:>12.1f} ns/op ({} iterations, {} threads)",
+           result.name, result.nanoseconds_per_op, result.iterations,
+           result.thread_count);
+    } else {
+      info("{:<48} {:>12.1f} ns/op ({} iterations)",
+           result.name, result.nanoseconds_per_op, result.iterations);
+    }
+    GetResults().push_back(result);
+  }
+
+  bool BenchmarkReport::WriteJson(const string& result_file) {
+    const vector<BenchmarkResult>& results = GetResults();
+    value benchmarks = value::array(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+      value benchmark;
+      benchmark[to_string_t(kJsonKeyName)] =
+          value::string(to_string_t(results[i].name));
+      benchmark[to_string_t(kJsonKeyNanosecondsPerOp)] =
+          value::number(results[i].nanoseconds_per_op);
+      benchmark[to_string_t(kJsonKeyIterations)] =
+          value::number(static_cast<uint64_t>(results[i].iterations));
+      benchmark[to_string_t(kJsonKeyThreads)] =
+          value::number(static_cast<uint64_t>(results[i].thread_count));
+      benchmarks[i] = benchmark;
+    }
+    value document;
+    document[to_string_t(kJsonKeyBenchmarks)] = benchmarks;
+
+    ofstream file(result_file, ofstream::out | ofstream::trunc);
+    file << to_utf8string(document.serialize()) << endl;
+    file.close();
+    if (file.fail()) {
+      error("Can't write benchmark results: {}", result_file);
+      return false;
+    }
+    info("Benchmark results are written to {}", result_file);
+    return true;
+  }
+
+  bool BenchmarkReport::CompareWithBaseline(const string& baseline_file,
+                                            double max_regression_percent) {
+    ifstream file(baseline_file);
+    if (!file.is_open()) {
+      error("Can't open benchmark baseline: {}", baseline_file);
+      return false;
+    }
+    ostringstream text;
+    text << file.rdbuf();
+
+    // std::map<benchmark name, ns/op of the baseline>.
+    map<string, double> baseline;
+    try {
+      const value document = value::parse(to_string_t(text.str()));
+      for (const value& benchmark :
+           document.at(to_string_t(kJsonKeyBenchmarks)).as_array()) {
+        baseline[to_utf8string(
+            benchmark.at(to_string_t(kJsonKeyName)).as_string())] =
+            benchmark.at(to_string_t(kJsonKeyNanosecondsPerOp)).as_double();
+      }
+    } catch (const web::json::json_exception& e) {
+      error("Malformed benchmark baseline {}: {}", baseline_file, e.what());
+      return false;
+    }
+
+    info("Comparison with {} (regression above {:.1f}%)", baseline_file,
+         max_regression_percent);
+    size_t regression_count = 0;
+    for (const BenchmarkResult& result : GetResults()) {
+      const auto it = baseline.find(result.name);
+      if (it == baseline.end() || it->second <= 0.0) {
+        info("{:<48} {:>12.1f} ns/op (no baseline)", result.name,
+             result.nanoseconds_per_op);
+        continue;
+      }
+      const double change_percent =
+          (result.nanoseconds_per_op / it->second - 1.0) * 100.0;
+      const bool is_regression = change_percent > max_regression_percent;
+      if (is_regression) {
+        ++regression_count;
+      }
+      info("{:<48} {:>12.1f} -> {:>12.1f} ns/op {:>+8.1f}%{}", result.name,
+           it->second, result.nanoseconds_per_op, change_percent,
+           is_regression ? " REGRESSION" : "");
+    }
+    if (regression_count != 0) {
+      error("{} benchmarks regressed", regression_count);
+      return false;
+    }
+    return true;
+  }
+
+} // namespace chatserverbench
@@ -0,0 +1,154 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVERBENCH_BENCHHARNESS_H_
+#define CHATSERVERBENCH_BENCHHARNESS_H_
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+// Minimal microbenchmark harness for the chat server classes. Each benchmark
+// runs a function for a fixed number of iterations after a short warm-up and
+// prints the average wall-clock cost of one call. Every result is kept in
+// BenchmarkReport, which writes them as JSON and compares them with a
+// baseline written by an earlier run.
+// Example:
+//   RunBenchmark("route/resolve", 1000000, [&]() {
+//     DoNotOptimize(RouteTable::Resolve(method, path));
+//   });
+//   BenchmarkReport::WriteJson("bench_result.json");
+
+namespace chatserverbench {
+
+  // Keep the compiler from optimizing away a value that is computed in the
+  // measured function. Its address is written to a volatile pointer and read
+  // back, so the value must be in memory.
+  template <typename T>
+  void DoNotOptimize(const T& value) {
+    static const void* volatile sink;
+    sink = &value;
+    static_cast<void>(sink);
+  }
+
+  // Result of a benchmark.
+  struct BenchmarkResult {
+    std::string name;
+    double nanoseconds_per_op;
+    size_t iterations;
+    // Number of threads that ran the function at the same time.
+    size_t thread_count;
+  };
+
+  class BenchmarkReport {
+   public:
+    // Run only the benchmarks whose name contains the given filter. Every
+    // benchmark runs if it is empty.
+    static void SetFilter(const std::string& filter);
+
+    // Check the benchmark of the given name is selected by the filter.
+    // Check it before a costly setup that only one benchmark needs.
+    static bool IsSelected(const std::string& name);
+
+    // Keep the result and print it.
+    static void Add(const BenchmarkResult& result);
+
+    // Write every kept result to the given file as JSON:
+    //   {"benchmarks": [{"name": ..., "ns_per_op": ..., "iterations": ...,
+    //                    "threads": ...}, ...]}
+    // Return false if the file can't be written.
+    static bool WriteJson(const std::string& result_file);
+
+    // Compare every kept result with the same benchmark in the given JSON
+    // file of an earlier run and print the change. A benchmark regresses if
+    // it is slower than the baseline by more than max_regression_percent.
+    // Return false if any benchmark regresses or the file can't be read.
+    static bool CompareWithBaseline(const std::string& baseline_file,
+                                    double max_regression_percent);
+  };
+
+  // Run the function for the given iterations and print the average cost
+  // per call in nanoseconds. Return the average cost, or 0 if the benchmark
+  // is not selected.
+  template <typename Function>
+  double RunBenchmark(const std::string& name,
+                      size_t iterations,
+                      Function function) {
+    if (!BenchmarkReport::IsSelected(name)) {
+      return 0.0;
+    }
+    const size_t warm_up_iterations = iterations / 10 + 1;
+    for (size_t i = 0; i < warm_up_iterations; ++i) {
+      function();
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      function();
+    }
+    const std::chrono::duration<double, std::nano> elapsed_time =
+        std::chrono::steady_clock::now() - start_time;
+
+    const double nanoseconds_per_call = elapsed_time.count() / iterations;
+    BenchmarkReport::Add({name, nanoseconds_per_call, iterations, 1});
+    return nanoseconds_per_call;
+  }
+
+  // Run the function on thread_count threads at the same time, for the given
+  // iterations on each thread, and print the cost of one call as seen by a
+  // thread: the wall-clock time divided by iterations_per_thread. The
+  // function gets the index of its thread and of the iteration. There is no
+  // warm-up. Return the cost, or 0 if the benchmark is not selected.
+  template <typename Function>
+  double RunConcurrentBenchmark(const std::string& name,
+                                size_t thread_count,
+                                size_t iterations_per_thread,
+                                Function function) {
+    if (!BenchmarkReport::IsSelected(name)) {
+      return 0.0;
+    }
+    const auto start_time = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t) {
+      threads.emplace_back([&function, t, iterations_per_thread]() {
+        for (size_t i = 0; i < iterations_per_thread; ++i) {
+          function(t, i);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    const std::chrono::duration<double, std::nano> elapsed_time =
+        std::chrono::steady_clock::now() - start_time;
+
+    const double nanoseconds_per_call =
+        elapsed_time.count() / iterations_per_thread;
+    BenchmarkReport::Add(
+        {name, nanoseconds_per_call, iterations_per_thread, thread_count});
+    return nanoseconds_per_call;
+  }
+
+  // Benchmark suites. Each suite lives in its own *_bench.cc file.
+  void RunRouteTableBenchmarks();
+  void RunCborCodecBenchmarks();
+  void RunContentCodingBenchmarks();
+  void RunMetricsBenchmarks();
+  void RunLoggingBenchmarks();
+  void RunTracingBenchmarks();
+  void RunInstrumentedMutexBenchmarks();
+  void RunChatDatabaseBenchmarks(size_t chat_message_file_megabytes);
+  void RunSessionManagerBenchmarks();
+  void RunAccountDatabaseBenchmarks();
+  void RunSerializationBenchmarks();
+  void RunDelimiterScannerBenchmarks();
+  void RunChatRoomLogBenchmarks(size_t room_chat_message_count);
+  void RunAllocationBenchmarks();
+
+} // namespace chatserverbench
+
+#endif // CHATSERVERBENCH_BENCHHARNESS_H_
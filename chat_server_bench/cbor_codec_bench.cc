@@ -0,0 +1,88 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Compare encode and decode cost and payload size of a chat message list in
+// web::json and in the CBOR columnar layout of CborCodec.
+
+#include <vector>
+
+#include "bench_harness.h"
+#include "cbor_codec.h"
+#include "chat_message.h"
+#include "chat_server.h"
+#include "cpprest/json.h"
+
+using namespace std;
+using namespace chatserver;
+using ::web::json::value;
+using ::utility::conversions::to_string_t;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kCodecIterations = 2000;
+
+    // Number of chat messages in one response: a full room history page.
+    const size_t kChatMessageCount = 200;
+
+    vector<ChatMessage> MakeBenchChatMessages() {
+      vector<ChatMessage> chat_messages;
+      for (size_t i = 0; i < kChatMessageCount; ++i) {
+        chat_messages.emplace_back(
+            1583581783 + static_cast<time_t>(i * 3),
+            CHATSERVER_TEXT("user") + FromUtf8(to_string(i % 7)),
+            CHATSERVER_TEXT("lobby"),
+            CHATSERVER_TEXT("chat message number ") + FromUtf8(to_string(i)));
+      }
+      return chat_messages;
+    }
+
+    // The JSON body of GET chatmessage.
+    string JsonEncode(const vector<ChatMessage>& chat_messages) {
+      const vector<unsigned char> body =
+          ChatServer::SerializeChatMessages(chat_messages, false);
+      return string(body.begin(), body.end());
+    }
+
+    vector<ChatMessage> JsonDecode(const string& body) {
+      vector<ChatMessage> chat_messages;
+      const value result = value::parse(to_string_t(body));
+      for (const value& chat_message : result.as_array()) {
+        chat_messages.emplace_back(
+            chat_message.at(UU("date")).as_number().to_int64(),
+            ToChatString(chat_message.at(UU("user_id")).as_string()),
+            ToChatString(chat_message.at(UU("room")).as_string()),
+            ToChatString(chat_message.at(UU("message")).as_string()));
+      }
+      return chat_messages;
+    }
+
+  } // namespace
+
+  void RunCborCodecBenchmarks() {
+    const vector<ChatMessage> chat_messages = MakeBenchChatMessages();
+    const string json_body = JsonEncode(chat_messages);
+    const vector<unsigned char> cbor_body =
+        CborCodec::EncodeChatMessages(chat_messages);
+    spdlog::info("{:<48} {:>12} bytes", "codec/json_payload", json_body.size());
+    spdlog::info("{:<48} {:>12} bytes", "codec/cbor_payload", cbor_body.size());
+
+    RunBenchmark("codec/json_encode_200_messages", kCodecIterations, [&]() {
+      DoNotOptimize(JsonEncode(chat_messages));
+    });
+    RunBenchmark("codec/cbor_encode_200_messages", kCodecIterations, [&]() {
+      DoNotOptimize(CborCodec::EncodeChatMessages(chat_messages));
+    });
+    RunBenchmark("codec/json_decode_200_messages", kCodecIterations, [&]() {
+      DoNotOptimize(JsonDecode(json_body));
+    });
+    RunBenchmark("codec/cbor_decode_200_messages", kCodecIterations, [&]() {
+      vector<ChatMessage> decoded_messages;
+      CborCodec::DecodeChatMessages(cbor_body, &decoded_messages);
+      DoNotOptimize(decoded_messages);
+    });
+  }
+
+} // namespace chatserverbench
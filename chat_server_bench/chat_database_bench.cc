@@ -0,0 +1,156 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Measure the chat database without HTTP: storing a chat message (one
+// append to the file database), looking up the chat messages of a chat room,
+// checking a chat room exists with kChatRoomCount chat rooms, and parsing a
+// chat message file of the given size at start-up with ChatMessageLoader.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#include "bench_harness.h"
+#include "chat_database.h"
+#include "chat_message_loader.h"
+#include "cpprest/asyncrt_utils.h"
+
+using namespace std;
+using namespace chatserver;
+using ::utility::conversions::to_string_t;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kStoreIterations = 20000;
+    const size_t kLookupIterations = 1000000;
+    const size_t kChatRoomCount = 100;
+    const size_t kMaxLoaderThreadCount = 8;
+    // A line of the chat message file takes about 100 bytes.
+    const size_t kChatMessageFileBytes = kChatRoomCount * 100 * 100;
+
+    const char* const kChatMessageFile = "chat_database_bench_messages.txt";
+    const char* const kChatRoomFile = "chat_database_bench_rooms.txt";
+
+    ChatString GetChatRoomName(size_t index) {
+      return CHATSERVER_TEXT("room") + FromUtf8(to_string(index));
+    }
+
+    // Write kChatRoomCount chat rooms, and chat messages of about the given
+    // size in bytes spread over the chat rooms.
+    void WriteDatabaseFiles(size_t chat_message_file_bytes) {
+      ChatOutputFileStream file(kChatRoomFile, ChatOutputFileStream::out |
+                                                   ChatOutputFileStream::trunc);
+      for (size_t i = 0; i < kChatRoomCount; ++i) {
+        file << GetChatRoomName(i) << endl;
+      }
+      file.close();
+
+      file.open(kChatMessageFile,
+                ChatOutputFileStream::out | ChatOutputFileStream::trunc);
+      const ChatString message = CHATSERVER_TEXT(
+          "The quick brown fox jumps over the lazy dog, again and again.");
+      size_t written_bytes = 0;
+      for (size_t i = 0; written_bytes < chat_message_file_bytes; ++i) {
+        // File format: date|user_id|chat_room|chat_message
+        ChatOutputStringStream line;
+        line << 1583134930 + i << CHATSERVER_TEXT("|user") << i % 1000
+             << CHATSERVER_TEXT("|") << GetChatRoomName(i % kChatRoomCount)
+             << CHATSERVER_TEXT("|") << message << CHATSERVER_TEXT("\n");
+        file << line.str();
+        written_bytes += line.str().size();
+      }
+      file.close();
+    }
+
+    void RemoveDatabaseFiles() {
+      remove(kChatMessageFile);
+      remove(kChatRoomFile);
+    }
+
+  } // namespace
+
+  void RunChatDatabaseBenchmarks(size_t chat_message_file_megabytes) {
+    WriteDatabaseFiles(kChatMessageFileBytes);
+    {
+      ChatDatabase chat_database;
+      chat_database.Initialize(to_string_t(kChatMessageFile),
+                               to_string_t(kChatRoomFile));
+
+      const ChatMessage message(
+          1583134930, CHATSERVER_TEXT("samsung"), GetChatRoomName(7),
+          CHATSERVER_TEXT("hello, this is a benchmark message"));
+      RunBenchmark("chat_database/store_chat_message", kStoreIterations, [&]() {
+        DoNotOptimize(chat_database.StoreChatMessage(message));
+      });
+
+      size_t index = 0;
+      RunBenchmark("chat_database/get_all_chat_messages", kLookupIterations,
+                   [&]() {
+        DoNotOptimize(chat_database.GetAllChatMessages(
+            GetChatRoomName(index++ % kChatRoomCount)));
+      });
+
+      // The last chat room is the worst case of the linear search.
+      const ChatString last_chat_room = GetChatRoomName(kChatRoomCount - 1);
+      RunBenchmark("chat_database/is_exist_chat_room", kLookupIterations,
+                   [&]() {
+        DoNotOptimize(chat_database.IsExistChatRoom(last_chat_room));
+      });
+    }
+
+    // Parsing runs once at start-up, so it is measured once on a cold
+    // database, and then by ChatMessageLoader alone with 1 to
+    // kMaxLoaderThreadCount threads to show how it scales with cores.
+    const string size_name = to_string(chat_message_file_megabytes) + "mb";
+    const string name = "chat_database/parse_chat_message_file_" + size_name;
+    if (BenchmarkReport::IsSelected("chat_database/parse_chat_message_file") ||
+        BenchmarkReport::IsSelected("chat_message_loader/load")) {
+      WriteDatabaseFiles(chat_message_file_megabytes * 1024 * 1024);
+    }
+    if (BenchmarkReport::IsSelected(name)) {
+      ChatDatabase chat_database;
+      const auto start_time = chrono::steady_clock::now();
+      const bool is_initialized =
+          chat_database.Initialize(to_string_t(kChatMessageFile),
+                                   to_string_t(kChatRoomFile));
+      const chrono::duration<double, nano> elapsed_time =
+          chrono::steady_clock::now() - start_time;
+      if (is_initialized) {
+        BenchmarkReport::Add({name, elapsed_time.count(), 1, 1});
+        spdlog::info("{:<48} {:>12.1f} MB/s ({} chat messages)", name,
+                     chat_message_file_megabytes /
+                         (elapsed_time.count() / 1e9),
+                     chat_database.GetChatMessageCount());
+      } else {
+        spdlog::error("Fail to parse the chat message file");
+      }
+    }
+    for (size_t thread_count = 1; thread_count <= kMaxLoaderThreadCount;
+         thread_count *= 2) {
+      const string loader_name = "chat_message_loader/load_" + size_name +
+                                 "_" + to_string(thread_count) + "_threads";
+      if (!BenchmarkReport::IsSelected(loader_name)) {
+        continue;
+      }
+      ChatMessageLoader::ChatMessageMap chat_messages;
+      const auto start_time = chrono::steady_clock::now();
+      if (!ChatMessageLoader::Load(to_string_t(kChatMessageFile),
+                                   thread_count, &chat_messages)) {
+        spdlog::error("Fail to load the chat message file");
+        break;
+      }
+      const chrono::duration<double, nano> elapsed_time =
+          chrono::steady_clock::now() - start_time;
+      BenchmarkReport::Add({loader_name, elapsed_time.count(), 1,
+                            thread_count});
+      spdlog::info("{:<48} {:>12.1f} MB/s", loader_name,
+                   chat_message_file_megabytes /
+                       (elapsed_time.count() / 1e9));
+    }
+    RemoveDatabaseFiles();
+  }
+
+} // namespace chatserverbench
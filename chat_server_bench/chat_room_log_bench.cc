@@ -0,0 +1,87 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Compare the latency of one append to a large chat room in ChatRoomLog and
+// in the std::vector<ChatMessage> it replaces. The average hides the
+// reallocation of the vector, so each append is timed and the percentiles
+// and the maximum are reported in nanoseconds.
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "chat_room_log.h"
+#include "latency_histogram.h"
+
+using namespace std;
+using namespace chatserver;
+using ::spdlog::info;
+
+namespace chatserverbench {
+
+  namespace {
+
+    // Append the given number of chat messages with append, and report the
+    // latency of one call.
+    template <typename Function>
+    void RunAppendLatencyBenchmark(const string& name,
+                                   size_t chat_message_count,
+                                   Function append) {
+      if (!BenchmarkReport::IsSelected(name)) {
+        return;
+      }
+      const ChatMessage chat_message(
+          1583581783, CHATSERVER_TEXT("samsung"), CHATSERVER_TEXT("lobby"),
+          CHATSERVER_TEXT("hello, this is a benchmark message"));
+      LatencyHistogram histogram;
+      uint64_t max_nanoseconds = 0;
+      for (size_t i = 0; i < chat_message_count; ++i) {
+        const auto start_time = chrono::steady_clock::now();
+        append(chat_message);
+        const uint64_t nanoseconds = static_cast<uint64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now() - start_time).count());
+        histogram.Record(nanoseconds);
+        max_nanoseconds = max(max_nanoseconds, nanoseconds);
+      }
+
+      const double kQuantiles[] = {0.5, 0.99, 0.999};
+      const char* const kQuantileNames[] = {"p50", "p99", "p999"};
+      for (size_t i = 0; i < 3; ++i) {
+        BenchmarkReport::Add(
+            {name + "_" + kQuantileNames[i],
+             static_cast<double>(histogram.GetPercentile(kQuantiles[i])),
+             chat_message_count, 1});
+      }
+      BenchmarkReport::Add({name + "_max",
+                            static_cast<double>(max_nanoseconds),
+                            chat_message_count, 1});
+    }
+
+  } // namespace
+
+  void RunChatRoomLogBenchmarks(size_t room_chat_message_count) {
+    const string suffix = "_" + to_string(room_chat_message_count);
+    {
+      vector<ChatMessage> chat_messages;
+      RunAppendLatencyBenchmark(
+          "chat_room_log/vector_push_back" + suffix, room_chat_message_count,
+          [&](const ChatMessage& chat_message) {
+        chat_messages.push_back(chat_message);
+      });
+    }
+    {
+      ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+      RunAppendLatencyBenchmark(
+          "chat_room_log/append" + suffix, room_chat_message_count,
+          [&](const ChatMessage& chat_message) {
+        chat_room_log.Append(chat_message);
+      });
+    }
+  }
+
+} // namespace chatserverbench
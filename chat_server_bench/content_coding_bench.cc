@@ -0,0 +1,72 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Measure gzip and deflate cost and ratio for a full room history page, and
+// the cost of a cached response body against compressing on every request.
+
+#include <vector>
+
+#include "bench_harness.h"
+#include "content_coding.h"
+#include "cpprest/http_msg.h"
+#include "response_cache.h"
+
+using namespace std;
+using namespace chatserver;
+using ::utility::string_t;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kCompressionIterations = 500;
+    const size_t kCacheIterations = 100000;
+
+    // JSON body of GET chatmessage with 200 chat messages.
+    vector<unsigned char> MakeBenchBody() {
+      string body = "[";
+      for (size_t i = 0; i < 200; ++i) {
+        if (i > 0) body += ",";
+        body += "{\"date\":" + to_string(1583581783 + i * 3) +
+                ",\"message\":\"chat message number " + to_string(i) +
+                "\",\"room\":\"lobby\",\"user_id\":\"user" +
+                to_string(i % 7) + "\"}";
+      }
+      body += "]";
+      return vector<unsigned char>(body.begin(), body.end());
+    }
+
+  } // namespace
+
+  void RunContentCodingBenchmarks() {
+    if (!web::http::compression::builtin::supported()) {
+      spdlog::info("cpprestsdk has no built-in compression: skipped");
+      return;
+    }
+
+    const vector<unsigned char> body = MakeBenchBody();
+    for (const string_t content_coding : {UU("gzip"), UU("deflate")}) {
+      const string name = utility::conversions::to_utf8string(content_coding);
+      vector<unsigned char> output;
+      ContentCoding::Compress(content_coding, body, &output);
+      spdlog::info("{:<48} {:>12} -> {} bytes",
+                   "coding/" + name + "_payload", body.size(), output.size());
+      RunBenchmark("coding/" + name + "_compress_per_request",
+                   kCompressionIterations, [&]() {
+        vector<unsigned char> compressed_body;
+        ContentCoding::Compress(content_coding, body, &compressed_body);
+        DoNotOptimize(compressed_body);
+      });
+    }
+
+    ResponseCache response_cache;
+    const ResponseCache::Body cached_body = response_cache.GetBody(
+        UU("lobby"), false, 1, [&]() { return body; });
+    RunBenchmark("coding/gzip_cached_per_version", kCacheIterations, [&]() {
+      DoNotOptimize(response_cache.GetCompressedBody(
+          UU("lobby"), false, 1, UU("gzip"), cached_body));
+    });
+  }
+
+} // namespace chatserverbench
@@ -0,0 +1,79 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Compare DelimiterScanner with memchr and the std::basic_string searches it
+// replaces. Each benchmark scans a buffer without the delimiter to the end,
+// so the cost per call is the cost of the whole buffer.
+
+#include <cstring>
+#include <string>
+
+#include "bench_harness.h"
+#include "delimiter_scanner.h"
+
+using namespace std;
+using namespace chatserver;
+using ::spdlog::info;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kBufferSize = 1 << 20;
+    const size_t kScanIterations = 2000;
+
+    // Print the throughput of a scan of the given bytes.
+    void PrintThroughput(const string& name, size_t bytes,
+                         double nanoseconds_per_call) {
+      if (nanoseconds_per_call > 0.0) {
+        info("{}: {:.2f} GB/s", name, bytes / nanoseconds_per_call);
+      }
+    }
+
+  } // namespace
+
+  void RunDelimiterScannerBenchmarks() {
+    info("DelimiterScanner instruction set: {}",
+         DelimiterScanner::GetInstructionSet());
+
+    // Chat message text without the delimiter, like a long chat message.
+    const string narrow_text(kBufferSize, 'a');
+    const char* narrow_begin = narrow_text.data();
+    const char* narrow_end = narrow_begin + narrow_text.size();
+    const wstring wide_text(kBufferSize, L'a');
+    const wchar_t* wide_begin = wide_text.data();
+    const wchar_t* wide_end = wide_begin + wide_text.size();
+
+    // The compiler knows memchr has no side effect, so keep its result.
+    const void* volatile memchr_result = nullptr;
+    PrintThroughput("scan/narrow_memchr", kBufferSize,
+        RunBenchmark("scan/narrow_memchr", kScanIterations, [&]() {
+      memchr_result = memchr(narrow_begin, '|', kBufferSize);
+    }));
+    PrintThroughput("scan/narrow_scanner", kBufferSize,
+        RunBenchmark("scan/narrow_scanner", kScanIterations, [&]() {
+      DoNotOptimize(DelimiterScanner::Find(narrow_begin, narrow_end, '|'));
+    }));
+
+    const size_t wide_bytes = kBufferSize * sizeof(wchar_t);
+    PrintThroughput("scan/wide_string_find", wide_bytes,
+        RunBenchmark("scan/wide_string_find", kScanIterations, [&]() {
+      DoNotOptimize(wide_text.find(L'|'));
+    }));
+    PrintThroughput("scan/wide_scanner", wide_bytes,
+        RunBenchmark("scan/wide_scanner", kScanIterations, [&]() {
+      DoNotOptimize(DelimiterScanner::Find(wide_begin, wide_end, L'|'));
+    }));
+    PrintThroughput("scan/wide_string_find_first_of", wide_bytes,
+        RunBenchmark("scan/wide_string_find_first_of", kScanIterations, [&]() {
+      DoNotOptimize(wide_text.find_first_of(L",|"));
+    }));
+    PrintThroughput("scan/wide_scanner_either", wide_bytes,
+        RunBenchmark("scan/wide_scanner_either", kScanIterations, [&]() {
+      DoNotOptimize(
+          DelimiterScanner::FindEither(wide_begin, wide_end, L',', L'|'));
+    }));
+  }
+
+} // namespace chatserverbench
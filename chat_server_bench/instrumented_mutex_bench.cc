@@ -0,0 +1,68 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Compare lock and unlock of std::mutex with InstrumentedMutex, without and
+// with contention. Build with CHATSERVER_ENABLE_LOCK_PROFILING to measure
+// the profiling cost; without it both should cost the same.
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "bench_harness.h"
+#include "instrumented_mutex.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kLockIterations = 5000000;
+    const size_t kContendedLockIterations = 1000000;
+
+    // Lock the mutex from one more thread while the function runs.
+    template <typename Mutex, typename Function>
+    void RunContendedBenchmark(const string& name, Mutex* mutex,
+                               Function function) {
+      atomic<bool> is_running(true);
+      thread other_thread([&]() {
+        while (is_running.load(memory_order_relaxed)) {
+          const lock_guard<Mutex> lock(*mutex);
+        }
+      });
+      RunBenchmark(name, kContendedLockIterations, function);
+      is_running = false;
+      other_thread.join();
+    }
+
+  } // namespace
+
+  void RunInstrumentedMutexBenchmarks() {
+    mutex std_mutex;
+    InstrumentedMutex instrumented_mutex("Bench::instrumented_mutex");
+    uint64_t counter = 0;
+
+    RunBenchmark("mutex/std_mutex", kLockIterations, [&]() {
+      const lock_guard<mutex> lock(std_mutex);
+      DoNotOptimize(++counter);
+    });
+    RunBenchmark("mutex/instrumented_mutex", kLockIterations, [&]() {
+      const lock_guard<InstrumentedMutex> lock(instrumented_mutex);
+      DoNotOptimize(++counter);
+    });
+
+    RunContendedBenchmark("mutex/std_mutex_contended", &std_mutex, [&]() {
+      const lock_guard<mutex> lock(std_mutex);
+      DoNotOptimize(++counter);
+    });
+    RunContendedBenchmark("mutex/instrumented_mutex_contended",
+                          &instrumented_mutex, [&]() {
+      const lock_guard<InstrumentedMutex> lock(instrumented_mutex);
+      DoNotOptimize(++counter);
+    });
+  }
+
+} // namespace chatserverbench
@@ -0,0 +1,99 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Measure the cost of a log call on the request thread with the synchronous
+// file logger and with the asynchronous logger for both overflow policies,
+// in the style of devlib/spdlog-1.5.0/bench/async_bench.cpp. The rate-limited
+// warning for unmatched requests is measured as well.
+
+#include <chrono>
+#include <memory>
+
+#include "async_logging.h"
+#include "bench_harness.h"
+#include "rate_limited_log.h"
+#include "spdlog/sinks/basic_file_sink.h"
+
+using namespace std;
+using namespace chatserver;
+using ::spdlog::async_logger;
+using ::spdlog::async_overflow_policy;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kLogIterations = 200000;
+    const size_t kThreadCount = 4;
+
+    shared_ptr<spdlog::logger> MakeSyncLogger() {
+      return make_shared<spdlog::logger>(
+          "bench_sync",
+          make_shared<spdlog::sinks::basic_file_sink_mt>(
+              "chat_server_bench_sync.log", true));
+    }
+
+    // The logger only keeps a weak pointer, so the caller owns the pool.
+    shared_ptr<spdlog::logger> MakeAsyncLogger(
+        const shared_ptr<spdlog::details::thread_pool>& thread_pool,
+        async_overflow_policy overflow_policy) {
+      return make_shared<async_logger>(
+          "bench_async",
+          make_shared<spdlog::sinks::basic_file_sink_mt>(
+              "chat_server_bench_async.log", true),
+          thread_pool, overflow_policy);
+    }
+
+    // Log from kThreadCount threads, as request threads do, and print the
+    // average cost of one call on a request thread.
+    void RunConcurrentLogBenchmark(const string& name,
+                                   shared_ptr<spdlog::logger> logger) {
+      RunConcurrentBenchmark(name, kThreadCount, kLogIterations / kThreadCount,
+                             [&](size_t, size_t i) {
+        logger->warn("No matching HTTP request: GET /chat/{}", i);
+      });
+      logger->flush();
+    }
+
+  } // namespace
+
+  void RunLoggingBenchmarks() {
+    size_t index = 0;
+    shared_ptr<spdlog::logger> logger = MakeSyncLogger();
+    RunBenchmark("logging/sync_file", kLogIterations, [&]() {
+      logger->warn("No matching HTTP request: GET /chat/{}", index++);
+    });
+    RunConcurrentLogBenchmark("logging/sync_file_concurrent", logger);
+
+    auto thread_pool = make_shared<spdlog::details::thread_pool>(
+        AsyncLogging::kDefaultQueueSize, 1);
+    logger = MakeAsyncLogger(thread_pool, async_overflow_policy::block);
+    RunBenchmark("logging/async_block", kLogIterations, [&]() {
+      logger->warn("No matching HTTP request: GET /chat/{}", index++);
+    });
+    RunConcurrentLogBenchmark("logging/async_block_concurrent", logger);
+
+    logger = MakeAsyncLogger(thread_pool,
+                             async_overflow_policy::overrun_oldest);
+    RunBenchmark("logging/async_overrun_oldest", kLogIterations, [&]() {
+      logger->warn("No matching HTTP request: GET /chat/{}", index++);
+    });
+    RunConcurrentLogBenchmark("logging/async_overrun_oldest_concurrent",
+                              logger);
+    logger.reset();
+    thread_pool.reset();
+
+    // Unmatched requests as sent by a scanner: most warnings are skipped.
+    RateLimitedLog rate_limited_log(10, chrono::seconds(1), 1000);
+    logger = MakeSyncLogger();
+    RunBenchmark("logging/rate_limited_sync_file", kLogIterations, [&]() {
+      uint64_t suppressed_count = 0;
+      if (rate_limited_log.ShouldLog(&suppressed_count)) {
+        logger->warn("No matching HTTP request: GET /chat/{} ({} suppressed)",
+                     index++, suppressed_count);
+      }
+    });
+  }
+
+} // namespace chatserverbench
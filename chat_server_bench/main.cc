@@ -0,0 +1,148 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+#include "bench_harness.h"
+#include "spdlog/spdlog.h"
+
+using namespace std;
+using ::spdlog::error;
+using ::spdlog::info;
+
+namespace {
+
+  // Size of the chat message file to parse. A Win32 process can't keep the
+  // chat messages of a 1 GB file in memory; use --parse_file_mb=1024 with an
+  // x64 build.
+  const size_t kDefaultParseFileMegabytes = 256;
+
+  // Chat messages of the chat room that the append latency is measured on.
+  // The vector of a 10M chat message room does not fit in a Win32 process;
+  // use --room_messages=10000000 with an x64 build.
+  const size_t kDefaultRoomChatMessageCount = 1000000;
+
+  // Slowdown against the baseline that counts as a regression.
+  const double kDefaultMaxRegressionPercent = 10.0;
+
+  // Parse "--name=value" into value. Return false if arg is another option.
+  bool ParseOption(const string& arg, const string& name, string* out_value) {
+    const string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+      return false;
+    }
+    *out_value = arg.substr(prefix.size());
+    return true;
+  }
+
+  // Parse a decimal integer option value. Return false if it is empty, has
+  // other characters or does not fit size_t.
+  bool ParseSize(const string& text, size_t* out_value) {
+    if (text.empty() || text[0] < '0' || text[0] > '9') {
+      return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long value = strtoull(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE ||
+        value > numeric_limits<size_t>::max()) {
+      return false;
+    }
+    *out_value = static_cast<size_t>(value);
+    return true;
+  }
+
+  // Parse a number option value. Return false if it is empty, has other
+  // characters or is not finite.
+  bool ParseNumber(const string& text, double* out_value) {
+    char* end = nullptr;
+    const double value = strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !isfinite(value)) {
+      return false;
+    }
+    *out_value = value;
+    return true;
+  }
+
+} // namespace
+
+// Run every benchmark suite of the chat server. Please use the Release
+// configuration: Debug numbers are not meaningful.
+// Usage: chat_server_bench [--filter=session_manager/]
+//            [--output=result.json] [--baseline=baseline.json]
+//            [--max_regression=10] [--parse_file_mb=256]
+//            [--room_messages=1000000]
+// Exit with 1 if a benchmark is slower than the baseline by more than
+// max_regression percent.
+int main(int argc, char* argv[]) {
+  const char* const kUsage =
+      "Usage: chat_server_bench [--filter=session_manager/] "
+      "[--output=result.json] [--baseline=baseline.json] "
+      "[--max_regression=10] [--parse_file_mb=256] [--room_messages=1000000]";
+  string output_file;
+  string baseline_file;
+  double max_regression_percent = kDefaultMaxRegressionPercent;
+  size_t parse_file_megabytes = kDefaultParseFileMegabytes;
+  size_t room_chat_message_count = kDefaultRoomChatMessageCount;
+  for (int i = 1; i < argc; ++i) {
+    const string arg = argv[i];
+    string value;
+    bool is_valid = true;
+    if (ParseOption(arg, "filter", &value)) {
+      chatserverbench::BenchmarkReport::SetFilter(value);
+    } else if (ParseOption(arg, "output", &value)) {
+      output_file = value;
+    } else if (ParseOption(arg, "baseline", &value)) {
+      baseline_file = value;
+    } else if (ParseOption(arg, "max_regression", &value)) {
+      is_valid = ParseNumber(value, &max_regression_percent) &&
+                 max_regression_percent >= 0.0;
+    } else if (ParseOption(arg, "parse_file_mb", &value)) {
+      is_valid = ParseSize(value, &parse_file_megabytes) &&
+                 parse_file_megabytes > 0;
+    } else if (ParseOption(arg, "room_messages", &value)) {
+      is_valid = ParseSize(value, &room_chat_message_count) &&
+                 room_chat_message_count > 0;
+    } else {
+      error("Unknown option: {}\n{}", arg, kUsage);
+      return 1;
+    }
+    if (!is_valid) {
+      error("Invalid option: {}\n{}", arg, kUsage);
+      return 1;
+    }
+  }
+
+  info("Chat server microbenchmarks");
+  chatserverbench::RunRouteTableBenchmarks();
+  chatserverbench::RunCborCodecBenchmarks();
+  chatserverbench::RunContentCodingBenchmarks();
+  chatserverbench::RunMetricsBenchmarks();
+  chatserverbench::RunLoggingBenchmarks();
+  chatserverbench::RunTracingBenchmarks();
+  chatserverbench::RunInstrumentedMutexBenchmarks();
+  chatserverbench::RunChatDatabaseBenchmarks(parse_file_megabytes);
+  chatserverbench::RunSessionManagerBenchmarks();
+  chatserverbench::RunAccountDatabaseBenchmarks();
+  chatserverbench::RunSerializationBenchmarks();
+  chatserverbench::RunDelimiterScannerBenchmarks();
+  chatserverbench::RunChatRoomLogBenchmarks(room_chat_message_count);
+  chatserverbench::RunAllocationBenchmarks();
+
+  int result = 0;
+  if (!output_file.empty() &&
+      !chatserverbench::BenchmarkReport::WriteJson(output_file)) {
+    result = 1;
+  }
+  if (!baseline_file.empty() &&
+      !chatserverbench::BenchmarkReport::CompareWithBaseline(
+          baseline_file, max_regression_percent)) {
+    result = 1;
+  }
+  return result;
+}
@@ -0,0 +1,81 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Measure the per-request cost of the metrics: recording a latency into a
+// route histogram, the two clock reads of ScopedLatencyRecorder, and adding
+// response bytes. Exporting is measured as well, but it runs per scrape.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "bench_harness.h"
+#include "metrics_registry.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kRecordIterations = 10000000;
+    const size_t kExportIterations = 1000;
+    const size_t kContendedThreadCount = 4;
+
+  } // namespace
+
+  void RunMetricsBenchmarks() {
+    MetricsRegistry metrics;
+    LatencyHistogram* histogram = metrics.GetRouteLatency(Route::kGetChatRoom);
+
+    uint64_t value = 1;
+    RunBenchmark("metrics/histogram_record", kRecordIterations, [&]() {
+      // Spread values over many buckets like real latencies.
+      value = value * 6364136223846793005ull + 1442695040888963407ull;
+      histogram->Record(value >> 44);
+    });
+
+    RunBenchmark("metrics/clock_read_pair", kRecordIterations, [&]() {
+      const auto start_time = chrono::steady_clock::now();
+      DoNotOptimize(chrono::steady_clock::now() - start_time);
+    });
+
+    RunBenchmark("metrics/scoped_latency_recorder", kRecordIterations, [&]() {
+      const ScopedLatencyRecorder latency_recorder(histogram);
+    });
+
+    RunBenchmark("metrics/add_response_bytes", kRecordIterations, [&]() {
+      metrics.AddResponseBytes(1024);
+    });
+
+    // Every thread records into the same histogram, as request threads do.
+    atomic<bool> is_running(true);
+    vector<thread> threads;
+    for (size_t i = 1; i < kContendedThreadCount; ++i) {
+      threads.emplace_back([&]() {
+        uint64_t latency = 1000;
+        while (is_running.load(memory_order_relaxed)) {
+          histogram->Record(latency);
+          latency = latency % 100000 + 7;
+        }
+      });
+    }
+    RunBenchmark("metrics/histogram_record_4_threads", kRecordIterations,
+                 [&]() {
+      histogram->Record(20000);
+    });
+    is_running = false;
+    for (thread& t : threads) {
+      t.join();
+    }
+
+    MetricsRegistry::Gauges gauges;
+    RunBenchmark("metrics/export_prometheus_text", kExportIterations, [&]() {
+      DoNotOptimize(metrics.ExportPrometheusText(gauges));
+    });
+  }
+
+} // namespace chatserverbench
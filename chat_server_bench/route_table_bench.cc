@@ -0,0 +1,121 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Compare the request dispatch cost of RouteTable and UrlQuery with the
+// previous dispatch that split the path and the query string into fresh
+// containers and compared the first path segment with string literals.
+
+#include <map>
+#include <vector>
+
+#include "bench_harness.h"
+#include "cpprest/base_uri.h"
+#include "route_table.h"
+#include "url_query.h"
+
+using namespace std;
+using namespace chatserver;
+using ::web::uri;
+using ::utility::string_t;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kDispatchIterations = 1000000;
+
+    // Method, path and query of a typical incoming request.
+    struct BenchRequest {
+      string_t http_method;
+      string_t url_path;
+      string_t url_query;
+    };
+
+    const vector<BenchRequest>& GetBenchRequests() {
+      static const vector<BenchRequest> requests = {
+        {UU("GET"), UU("/chatmessage"),
+         UU("chat_room=abc&session_id=0123456789ABCDEFGHIJKLMNOPQRSTUV")},
+        {UU("GET"), UU("/chatroom"),
+         UU("session_id=0123456789ABCDEFGHIJKLMNOPQRSTUV")},
+        {UU("POST"), UU("/chatmessage"), UU("")},
+        {UU("DELETE"), UU("/session"),
+         UU("session_id=0123456789ABCDEFGHIJKLMNOPQRSTUV")},
+        {UU("GET"), UU("/unknown"), UU("session_id=abc")},
+      };
+      return requests;
+    }
+
+    // The dispatch of the chat server before RouteTable.
+    int DispatchWithSplitPath(const BenchRequest& request) {
+      const vector<string_t> url_paths =
+          uri::split_path(uri::decode(request.url_path));
+      const map<string_t, string_t> url_queries =
+          uri::split_query(uri::decode(request.url_query));
+      if (url_paths.empty()) {
+        return -1;
+      }
+
+      int result = url_queries.find(UU("session_id")) != url_queries.end();
+      if (request.http_method == UU("GET")) {
+        if (url_paths[0] == UU("chatmessage")) {
+          result += url_queries.find(UU("chat_room")) != url_queries.end();
+          return result + 1;
+        } else if (url_paths[0] == UU("chatroom")) {
+          return result + 2;
+        }
+      } else if (request.http_method == UU("POST")) {
+        if (url_paths[0] == UU("chatmessage")) {
+          return result + 3;
+        }
+      } else if (request.http_method == UU("DELETE")) {
+        if (url_paths[0] == UU("session")) {
+          return result + 4;
+        }
+      }
+      return result;
+    }
+
+    int DispatchWithRouteTable(const BenchRequest& request) {
+      const Route route =
+          RouteTable::Resolve(request.http_method, request.url_path);
+      if (route == Route::kNotFound) {
+        return -1;
+      }
+
+      const UrlQuery url_query(request.url_query);
+      int result = url_query.Contains(UU("session_id"));
+      if (route == Route::kGetChatMessage) {
+        result += url_query.Contains(UU("chat_room"));
+      }
+      return result + static_cast<int>(route);
+    }
+
+  } // namespace
+
+  void RunRouteTableBenchmarks() {
+    const vector<BenchRequest>& requests = GetBenchRequests();
+
+    size_t index = 0;
+    RunBenchmark("dispatch/split_path_and_query", kDispatchIterations, [&]() {
+      DoNotOptimize(DispatchWithSplitPath(requests[index]));
+      index = (index + 1) % requests.size();
+    });
+
+    index = 0;
+    RunBenchmark("dispatch/route_table_and_lazy_query", kDispatchIterations,
+                 [&]() {
+      DoNotOptimize(DispatchWithRouteTable(requests[index]));
+      index = (index + 1) % requests.size();
+    });
+
+    index = 0;
+    RunBenchmark("dispatch/route_table_only", kDispatchIterations, [&]() {
+      const BenchRequest& request = requests[index];
+      DoNotOptimize(RouteTable::Resolve(request.http_method,
+                                        request.url_path));
+      index = (index + 1) % requests.size();
+    });
+  }
+
+} // namespace chatserverbench
@@ -0,0 +1,65 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Measure building the body of GET chatmessage without HTTP: the chat
+// messages of a chat room serialized by ChatServer::SerializeChatMessages as
+// JSON and as CBOR, from a small chat room up to a long history. It runs
+// once per version of a chat room, when the response cache misses.
+
+#include <vector>
+
+#include "bench_harness.h"
+#include "chat_message.h"
+#include "chat_server.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace chatserverbench {
+
+  namespace {
+
+    // Chat messages in a chat room and the iterations to serialize it.
+    struct ChatRoomSize {
+      size_t chat_message_count;
+      size_t iterations;
+    };
+
+    const ChatRoomSize kChatRoomSizes[] = {
+      {10, 100000},
+      {1000, 1000},
+      {10000, 100},
+    };
+
+    vector<ChatMessage> MakeChatMessages(size_t count) {
+      vector<ChatMessage> chat_messages;
+      for (size_t i = 0; i < count; ++i) {
+        chat_messages.emplace_back(
+            1583581783 + static_cast<time_t>(i * 3),
+            CHATSERVER_TEXT("user") + FromUtf8(to_string(i % 50)),
+            CHATSERVER_TEXT("lobby"),
+            CHATSERVER_TEXT("chat message number ") + FromUtf8(to_string(i)));
+      }
+      return chat_messages;
+    }
+
+  } // namespace
+
+  void RunSerializationBenchmarks() {
+    for (const ChatRoomSize& size : kChatRoomSizes) {
+      const vector<ChatMessage> chat_messages =
+          MakeChatMessages(size.chat_message_count);
+      const string suffix = "_" + to_string(size.chat_message_count);
+      RunBenchmark("serialization/get_chat_message_json" + suffix,
+                   size.iterations, [&]() {
+        DoNotOptimize(ChatServer::SerializeChatMessages(chat_messages, false));
+      });
+      RunBenchmark("serialization/get_chat_message_cbor" + suffix,
+                   size.iterations, [&]() {
+        DoNotOptimize(ChatServer::SerializeChatMessages(chat_messages, true));
+      });
+    }
+  }
+
+} // namespace chatserverbench
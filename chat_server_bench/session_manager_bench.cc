@@ -0,0 +1,87 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Measure every SessionManager operation without HTTP from 1 to
+// kMaxThreadCount threads. Every request checks and renews its session under
+// the same lock, so the cost per call as seen by a request thread shows how
+// the lock scales.
+
+#include <vector>
+
+#include "bench_harness.h"
+#include "cpprest/asyncrt_utils.h"
+#include "session_manager.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kUserCount = 10000;
+    const size_t kIterationsPerThread = 200000;
+    const size_t kCreateIterationsPerThread = 20000;
+    const size_t kMaxThreadCount = 8;
+
+    ChatString GetUserId(size_t index) {
+      return CHATSERVER_TEXT("user") + FromUtf8(to_string(index));
+    }
+
+  } // namespace
+
+  void RunSessionManagerBenchmarks() {
+    for (size_t thread_count = 1; thread_count <= kMaxThreadCount;
+         thread_count *= 2) {
+      const string suffix = "_" + to_string(thread_count) + "_threads";
+      SessionManager session_manager;
+      vector<ChatString> session_ids;
+      for (size_t i = 0; i < kUserCount; ++i) {
+        session_ids.push_back(
+            session_manager.CreateSession(GetUserId(i)).session_id);
+      }
+
+      RunConcurrentBenchmark("session_manager/is_exist_session_id" + suffix,
+                             thread_count, kIterationsPerThread,
+                             [&](size_t thread_index, size_t i) {
+        DoNotOptimize(session_manager.IsExistSessionId(
+            session_ids[(i * 7919 + thread_index) % kUserCount]));
+      });
+
+      RunConcurrentBenchmark(
+          "session_manager/renew_last_activity_time" + suffix, thread_count,
+          kIterationsPerThread, [&](size_t thread_index, size_t i) {
+        DoNotOptimize(session_manager.RenewLastActivityTime(
+            session_ids[(i * 7919 + thread_index) % kUserCount]));
+      });
+
+      RunConcurrentBenchmark(
+          "session_manager/get_user_id_from_session_id" + suffix,
+          thread_count, kIterationsPerThread,
+          [&](size_t thread_index, size_t i) {
+        ChatString user_id;
+        DoNotOptimize(session_manager.GetUserIDFromSessionId(
+            session_ids[(i * 7919 + thread_index) % kUserCount], &user_id));
+      });
+
+      // New users, so each call creates a session and the delete below
+      // removes one.
+      RunConcurrentBenchmark("session_manager/create_session" + suffix,
+                             thread_count, kCreateIterationsPerThread,
+                             [&](size_t thread_index, size_t i) {
+        DoNotOptimize(session_manager.CreateSession(
+            GetUserId(kUserCount +
+                      thread_index * kCreateIterationsPerThread + i)));
+      });
+
+      RunConcurrentBenchmark("session_manager/delete_session" + suffix,
+                             thread_count, kUserCount / thread_count,
+                             [&](size_t thread_index, size_t i) {
+        DoNotOptimize(session_manager.DeleteSession(
+            session_ids[thread_index * (kUserCount / thread_count) + i]));
+      });
+    }
+  }
+
+} // namespace chatserverbench
@@ -0,0 +1,50 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+// Measure the tracing cost of one request with a request span and eight
+// stage spans, as a POST chatmessage has: tracing stopped, 1% sampled, and
+// every request sampled. Compare the 1% cost with the route latency from
+// GET /chat/metrics; it should stay under 1% of it.
+
+#include <cstdio>
+
+#include "bench_harness.h"
+#include "tracing.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace chatserverbench {
+
+  namespace {
+
+    const size_t kRequestIterations = 1000000;
+    const char kBenchTraceFile[] = "chat_server_bench_trace.json";
+
+    void TraceRequestWithStages() {
+      const TraceRequest trace_request("Bench::Request");
+      for (int i = 0; i < 8; ++i) {
+        const TraceSpan trace_span("Bench::Stage");
+      }
+    }
+
+  } // namespace
+
+  void RunTracingBenchmarks() {
+    RunBenchmark("tracing/request_8_spans_stopped", kRequestIterations,
+                 TraceRequestWithStages);
+
+    Tracing::Start(kBenchTraceFile, 0.01);
+    RunBenchmark("tracing/request_8_spans_sampled_1_percent",
+                 kRequestIterations, TraceRequestWithStages);
+    Tracing::Stop();
+
+    Tracing::Start(kBenchTraceFile, 1.0);
+    RunBenchmark("tracing/request_8_spans_sampled_all",
+                 kRequestIterations / 10, TraceRequestWithStages);
+    Tracing::Stop();
+    remove(kBenchTraceFile);
+  }
+
+} // namespace chatserverbench
@@ -0,0 +1,353 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "load_generator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+#include "spdlog/spdlog.h"
+
+using namespace std;
+using ::pplx::task;
+using ::utility::string_t;
+using ::utility::conversions::to_string_t;
+using ::web::http::http_request;
+using ::web::http::http_response;
+using ::web::http::methods;
+using ::web::http::status_codes;
+using ::web::http::client::http_client;
+using ::web::json::value;
+using ::spdlog::error;
+using ::spdlog::info;
+
+namespace chatserverloadgen {
+
+  namespace {
+
+    // Length of nonce.
+    const size_t kNonceLength = 10;
+    // Nonce seed.
+    const string_t kNonceValue = UU(
+        "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz");
+
+    // Logins in flight while the users log in before the measurement.
+    const size_t kLoginBatchSize = 64;
+
+    // Time to wait for the outstanding requests after the measurement.
+    const chrono::seconds kDrainTimeout(30);
+
+  } // namespace
+
+  const string_t LoadGenerator::kUserPassword = UU("load_password");
+
+  LoadGenerator::LoadGenerator(const string_t& chat_server_url,
+                               const Options& options)
+      : next_http_client_(0),
+        options_(options),
+        outstanding_request_count_(0),
+        elapsed_time_(0.0),
+        next_unique_id_(0),
+        random_(random_device{}()) {
+    if (options_.http_client_count == 0) {
+      options_.http_client_count = 1;
+    }
+    for (size_t i = 0; i < options_.http_client_count; ++i) {
+      http_clients_.push_back(make_unique<http_client>(chat_server_url));
+    }
+  }
+
+  bool LoadGenerator::Run() {
+    if (!LoginUsers()) {
+      return false;
+    }
+    info("{} users logged in. Sending {:.0f} requests/s for {:.0f} s.",
+         options_.user_count, options_.arrival_rate, options_.duration);
+
+    discrete_distribution<size_t> operation_distribution(
+        begin(options_.operation_weights), end(options_.operation_weights));
+    exponential_distribution<double> interval_distribution(
+        options_.arrival_rate / 1e9);
+
+    const int64_t start_time = Now();
+    const int64_t end_time =
+        start_time + static_cast<int64_t>(options_.duration * 1e9);
+    double scheduled_time = static_cast<double>(start_time);
+    while (true) {
+      scheduled_time += interval_distribution(random_);
+      const int64_t arrival_time = static_cast<int64_t>(scheduled_time);
+      if (arrival_time >= end_time) {
+        break;
+      }
+      // Sleep only for gaps that the scheduler can keep. Shorter gaps are
+      // sent in a burst, which keeps the average rate.
+      const int64_t wait_time = arrival_time - Now();
+      if (wait_time > 1000000) {
+        this_thread::sleep_for(chrono::nanoseconds(wait_time));
+      }
+
+      const Operation operation =
+          static_cast<Operation>(operation_distribution(random_));
+      if (outstanding_request_count_.load() >=
+          options_.max_outstanding_requests) {
+        operation_stats_[static_cast<size_t>(operation)].skipped_count++;
+        continue;
+      }
+      SendRequest(operation, arrival_time);
+    }
+
+    const auto drain_deadline = chrono::steady_clock::now() + kDrainTimeout;
+    while (outstanding_request_count_.load() != 0 &&
+           chrono::steady_clock::now() < drain_deadline) {
+      this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    if (outstanding_request_count_.load() != 0) {
+      error("{} requests did not complete",
+            outstanding_request_count_.load());
+    }
+    elapsed_time_ = (Now() - start_time) / 1e9;
+    return true;
+  }
+
+  void LoadGenerator::Report() const {
+    info("{:<16} {:>10} {:>8} {:>8} {:>10} {:>10} {:>10} {:>10}",
+         "operation", "requests", "errors", "skipped", "req/s",
+         "p50 ms", "p99 ms", "p999 ms");
+    uint64_t total_error_count = 0;
+    uint64_t total_skipped_count = 0;
+    for (size_t i = 0; i < kOperationSize; ++i) {
+      const OperationStats& stats = operation_stats_[i];
+      const uint64_t count = stats.latency.GetCount();
+      const uint64_t error_count = stats.error_count.load();
+      const uint64_t skipped_count = stats.skipped_count.load();
+      if (count == 0 && skipped_count == 0) {
+        continue;
+      }
+      info("{:<16} {:>10} {:>8} {:>8} {:>10.1f} {:>10.3f} {:>10.3f} "
+           "{:>10.3f}",
+           GetOperationName(static_cast<Operation>(i)), count, error_count,
+           skipped_count, count / elapsed_time_,
+           stats.latency.GetPercentile(0.5) / 1e6,
+           stats.latency.GetPercentile(0.99) / 1e6,
+           stats.latency.GetPercentile(0.999) / 1e6);
+      total_error_count += error_count;
+      total_skipped_count += skipped_count;
+    }
+    const uint64_t total_count = total_latency_.GetCount();
+    info("{:<16} {:>10} {:>8} {:>8} {:>10.1f} {:>10.3f} {:>10.3f} {:>10.3f}",
+         "total", total_count, total_error_count, total_skipped_count,
+         total_count / elapsed_time_, total_latency_.GetPercentile(0.5) / 1e6,
+         total_latency_.GetPercentile(0.99) / 1e6,
+         total_latency_.GetPercentile(0.999) / 1e6);
+  }
+
+  bool LoadGenerator::ParseOperationMix(
+      const string& mix,
+      double (&out_weights)[kOperationSize]) {
+    double weights[kOperationSize] = {};
+    double total_weight = 0.0;
+    istringstream stream(mix);
+    string entry;
+    while (getline(stream, entry, ',')) {
+      const size_t colon = entry.find(':');
+      if (colon == string::npos) {
+        return false;
+      }
+      const string name = entry.substr(0, colon);
+      const string weight_text = entry.substr(colon + 1);
+      char* weight_end = nullptr;
+      const double weight = strtod(weight_text.c_str(), &weight_end);
+      if (weight_text.empty() || *weight_end != '\0' || weight < 0.0) {
+        return false;
+      }
+
+      bool is_known_operation = false;
+      for (size_t i = 0; i < kOperationSize; ++i) {
+        if (name == GetOperationName(static_cast<Operation>(i))) {
+          weights[i] = weight;
+          is_known_operation = true;
+          break;
+        }
+      }
+      if (!is_known_operation) {
+        return false;
+      }
+      total_weight += weight;
+    }
+    if (total_weight <= 0.0) {
+      return false;
+    }
+    copy(begin(weights), end(weights), out_weights);
+    return true;
+  }
+
+  const char* LoadGenerator::GetOperationName(Operation operation) {
+    switch (operation) {
+      case Operation::kSignUp:
+        return "signup";
+      case Operation::kLogin:
+        return "login";
+      case Operation::kPoll:
+        return "poll";
+      case Operation::kPost:
+        return "post";
+      case Operation::kCreateChatRoom:
+        return "room_create";
+    }
+    return "unknown";
+  }
+
+  string_t LoadGenerator::GetUserId(size_t user_index) {
+    return UU("load_user_") + to_string_t(to_string(user_index));
+  }
+
+  string_t LoadGenerator::GetChatRoomName(size_t chat_room_index) {
+    return UU("load_room_") + to_string_t(to_string(chat_room_index));
+  }
+
+  string_t LoadGenerator::HashString(const string_t& string) {
+    return to_string_t(to_string(hash<string_t>{}(string)));
+  }
+
+  bool LoadGenerator::LoginUsers() {
+    session_ids_.assign(options_.user_count, string_t());
+    for (size_t first = 0; first < options_.user_count;
+         first += kLoginBatchSize) {
+      const size_t last = min(first + kLoginBatchSize, options_.user_count);
+      vector<task<http_response>> logins;
+      for (size_t i = first; i < last; ++i) {
+        logins.push_back(http_clients_[i % http_clients_.size()]->request(
+            MakeLoginRequest(i)));
+      }
+      for (size_t i = first; i < last; ++i) {
+        try {
+          http_response response = logins[i - first].get();
+          if (response.status_code() != status_codes::OK) {
+            error("Fail to login {}: {}",
+                  utility::conversions::to_utf8string(GetUserId(i)),
+                  response.status_code());
+            return false;
+          }
+          session_ids_[i] =
+              response.extract_json().get()[UU("session_id")].as_string();
+        } catch (const exception& e) {
+          error("Fail to login {}: {}",
+                utility::conversions::to_utf8string(GetUserId(i)), e.what());
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void LoadGenerator::SendRequest(Operation operation,
+                                  int64_t scheduled_time) {
+    OperationStats* stats = &operation_stats_[static_cast<size_t>(operation)];
+    http_client& client = *http_clients_[next_http_client_];
+    next_http_client_ = (next_http_client_ + 1) % http_clients_.size();
+
+    outstanding_request_count_++;
+    client.request(MakeRequest(operation))
+        .then([](http_response response) {
+          // The latency includes reading the whole body.
+          return response.content_ready();
+        })
+        .then([this, stats, scheduled_time](task<http_response> response) {
+          bool is_success = false;
+          try {
+            is_success = response.get().status_code() == status_codes::OK;
+          } catch (const exception&) {
+          }
+          const uint64_t latency =
+              static_cast<uint64_t>(Now() - scheduled_time);
+          stats->latency.Record(latency);
+          total_latency_.Record(latency);
+          if (!is_success) {
+            stats->error_count++;
+          }
+          outstanding_request_count_--;
+        });
+  }
+
+  http_request LoadGenerator::MakeRequest(Operation operation) {
+    uniform_int_distribution<size_t> user_distribution(
+        0, options_.user_count - 1);
+    uniform_int_distribution<size_t> chat_room_distribution(
+        0, options_.chat_room_count - 1);
+    const size_t user_index = user_distribution(random_);
+    const string_t& session_id = session_ids_[user_index];
+
+    http_request request;
+    value body_data;
+    switch (operation) {
+      case Operation::kSignUp:
+        request.set_method(methods::POST);
+        request.set_request_uri(UU("account"));
+        body_data[UU("id")] = value::string(
+            UU("load_signup_") + to_string_t(to_string(next_unique_id_++)));
+        body_data[UU("password")] = value::string(HashString(kUserPassword));
+        request.set_body(body_data);
+        break;
+      case Operation::kLogin:
+        return MakeLoginRequest(user_index);
+      case Operation::kPoll:
+        request.set_method(methods::GET);
+        request.set_request_uri(
+            UU("chatmessage?chat_room=") +
+            GetChatRoomName(chat_room_distribution(random_)) +
+            UU("&session_id=") + session_id);
+        break;
+      case Operation::kPost:
+        request.set_method(methods::POST);
+        request.set_request_uri(UU("chatmessage"));
+        body_data[UU("chat_message")] = value::string(
+            UU("load message ") + to_string_t(to_string(next_unique_id_++)));
+        body_data[UU("chat_room")] =
+            value::string(GetChatRoomName(chat_room_distribution(random_)));
+        body_data[UU("session_id")] = value::string(session_id);
+        request.set_body(body_data);
+        break;
+      case Operation::kCreateChatRoom:
+        request.set_method(methods::POST);
+        request.set_request_uri(UU("chatroom"));
+        body_data[UU("chat_room")] = value::string(
+            UU("load_new_room_") + to_string_t(to_string(next_unique_id_++)));
+        body_data[UU("session_id")] = value::string(session_id);
+        request.set_body(body_data);
+        break;
+    }
+    return request;
+  }
+
+  http_request LoadGenerator::MakeLoginRequest(size_t user_index) {
+    const string_t nonce = GenerateNonce();
+    value body_data;
+    body_data[UU("id")] = value::string(GetUserId(user_index));
+    body_data[UU("nonce")] = value::string(nonce);
+    body_data[UU("password")] =
+        value::string(HashString(HashString(kUserPassword) + nonce));
+
+    http_request request(methods::POST);
+    request.set_request_uri(UU("login"));
+    request.set_body(body_data);
+    return request;
+  }
+
+  string_t LoadGenerator::GenerateNonce() {
+    uniform_int_distribution<size_t> distribution(0, kNonceValue.size() - 1);
+    string_t result;
+    for (size_t i = 0; i < kNonceLength; i++) {
+      result += kNonceValue.at(distribution(random_));
+    }
+    return result;
+  }
+
+  int64_t LoadGenerator::Now() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+} // namespace chatserverloadgen
@@ -0,0 +1,171 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#ifndef CHATSERVERLOADGEN_LOADGENERATOR_H_
+#define CHATSERVERLOADGEN_LOADGENERATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cpprest/http_client.h"
+#include "latency_histogram.h"
+
+// This class drives a chat server over HTTP with many simulated users and
+// reports the throughput and latency percentiles of each operation.
+// Requests arrive open-loop: arrival times follow a Poisson process of the
+// given rate whether or not earlier requests have completed, and latency is
+// measured from the scheduled arrival time. A slow server therefore shows up
+// as a higher latency instead of a lower request rate (no coordinated
+// omission). Every user logs in before the measurement starts.
+// The class is NOT thread-safe: call Run from one thread.
+// Example:
+//   LoadGenerator::Options options;
+//   options.arrival_rate = 1000.0;
+//   LoadGenerator load_generator(chat_server_url, options);
+//   if (load_generator.Run()) load_generator.Report();
+
+namespace chatserverloadgen {
+
+  class LoadGenerator {
+   public:
+    // Operations of a simulated user.
+    enum class Operation {
+      kSignUp,
+      kLogin,
+      kPoll,
+      kPost,
+      kCreateChatRoom
+    };
+
+    // Number of Operation values.
+    static const size_t kOperationSize =
+        static_cast<size_t>(Operation::kCreateChatRoom) + 1;
+
+    struct Options {
+      // Users with the ID "load_user_<index>" and kUserPassword. They must
+      // exist in the account database of the chat server.
+      size_t user_count = 2000;
+
+      // Chat rooms with the name "load_room_<index>" to poll and post to.
+      // They must exist in the chat database of the chat server.
+      size_t chat_room_count = 16;
+
+      // Requests per second of every operation together.
+      double arrival_rate = 500.0;
+
+      // Length of the measurement in seconds.
+      double duration = 30.0;
+
+      // Arrivals are skipped while this many requests are in flight, so an
+      // overloaded server can't exhaust the memory of the load generator.
+      size_t max_outstanding_requests = 2000;
+
+      // Number of HTTP clients the requests are spread over.
+      size_t http_client_count = 8;
+
+      // Relative weight of each operation, indexed by Operation.
+      double operation_weights[kOperationSize] = {1.0, 4.0, 60.0, 30.0, 1.0};
+    };
+
+    // Password of every simulated user.
+    static const utility::string_t kUserPassword;
+
+    LoadGenerator(const utility::string_t& chat_server_url,
+                  const Options& options);
+
+    // Log in every user, then send requests for the configured duration and
+    // wait for the outstanding ones. Return false if a user can't log in.
+    bool Run();
+
+    // Write the throughput and p50/p99/p999 latency of each operation to the
+    // log.
+    void Report() const;
+
+    // Parse a mix such as "poll:60,post:30,login:4" into weights. Operations
+    // that are not given get the weight 0. Return false if the mix is
+    // malformed or every weight is 0.
+    static bool ParseOperationMix(const std::string& mix,
+                                  double (&out_weights)[kOperationSize]);
+
+    // Get the name of the given operation, e.g. "poll".
+    static const char* GetOperationName(Operation operation);
+
+    // Get the ID of the simulated user of the given index.
+    static utility::string_t GetUserId(size_t user_index);
+
+    // Get the name of the load chat room of the given index.
+    static utility::string_t GetChatRoomName(size_t chat_room_index);
+
+    // Hash a password the way the chat client does.
+    static utility::string_t HashString(const utility::string_t& string);
+
+   private:
+    // Result of an operation. Updated from the HTTP client threads.
+    struct OperationStats {
+      OperationStats() : error_count(0), skipped_count(0) {
+      }
+
+      // Latency of completed requests from the scheduled arrival time.
+      chatserver::LatencyHistogram latency;
+      // Requests that failed or returned a status other than 200 OK.
+      std::atomic<uint64_t> error_count;
+      // Arrivals that were not sent because of max_outstanding_requests.
+      std::atomic<uint64_t> skipped_count;
+    };
+
+    // Log in every user and keep the session IDs.
+    bool LoginUsers();
+
+    // Send the request of the given operation and record its latency from
+    // scheduled_time in nanoseconds of the steady clock.
+    void SendRequest(Operation operation, int64_t scheduled_time);
+
+    // Make the request of the given operation for a random user.
+    web::http::http_request MakeRequest(Operation operation);
+
+    // Make a login request of the given user.
+    web::http::http_request MakeLoginRequest(size_t user_index);
+
+    // Make a random nonce for a login request.
+    utility::string_t GenerateNonce();
+
+    // Get the current time of the steady clock in nanoseconds.
+    static int64_t Now();
+
+    // HTTP clients the requests are spread over round-robin.
+    std::vector<std::unique_ptr<web::http::client::http_client>> http_clients_;
+    size_t next_http_client_;
+
+    Options options_;
+
+    // Session ID of each user. Written only by LoginUsers.
+    std::vector<utility::string_t> session_ids_;
+
+    // Result of each operation, indexed by Operation.
+    OperationStats operation_stats_[kOperationSize];
+
+    // Latency of every completed request.
+    chatserver::LatencyHistogram total_latency_;
+
+    // Requests sent and not completed yet.
+    std::atomic<size_t> outstanding_request_count_;
+
+    // Time from the first arrival until the last request completed, in
+    // seconds.
+    double elapsed_time_;
+
+    // Suffix of the IDs and chat rooms that are created during the run.
+    uint64_t next_unique_id_;
+
+    // Random source for arrivals, operations, users and chat rooms.
+    std::mt19937_64 random_;
+  };
+
+} // namespace chatserverloadgen
+
+#endif // CHATSERVERLOADGEN_LOADGENERATOR_H_
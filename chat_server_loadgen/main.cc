@@ -0,0 +1,211 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "async_logging.h"
+#include "chat_server.h"
+#include "load_generator.h"
+#include "spdlog/spdlog.h"
+
+using namespace std;
+using ::chatserver::AccountDatabase;
+using ::chatserver::AsyncLogging;
+using ::chatserver::ChatDatabase;
+using ::chatserver::ChatServer;
+using ::chatserver::SessionManager;
+using ::chatserverloadgen::LoadGenerator;
+using ::concurrency::task_status;
+using ::utility::string_t;
+using ::utility::conversions::to_string_t;
+using ::spdlog::error;
+
+namespace {
+
+  // Database files of the in-process chat server.
+  const char* const kAccountFile = "loadgen_accounts.txt";
+  const char* const kChatMessageFile = "loadgen_chat_messages.txt";
+  const char* const kChatRoomFile = "loadgen_chat_rooms.txt";
+
+  // Write the database files with the users and chat rooms of the load
+  // generator.
+  bool WriteDatabaseFiles(const LoadGenerator::Options& options) {
+    wofstream file(kAccountFile, wofstream::out | wofstream::trunc);
+    const string_t password_hash =
+        LoadGenerator::HashString(LoadGenerator::kUserPassword);
+    for (size_t i = 0; i < options.user_count; ++i) {
+      file << LoadGenerator::GetUserId(i) << "," << password_hash << endl;
+    }
+    file.close();
+    if (file.fail()) {
+      return false;
+    }
+
+    file.open(kChatRoomFile, wofstream::out | wofstream::trunc);
+    for (size_t i = 0; i < options.chat_room_count; ++i) {
+      file << LoadGenerator::GetChatRoomName(i) << endl;
+    }
+    file.close();
+    if (file.fail()) {
+      return false;
+    }
+
+    file.open(kChatMessageFile, wofstream::out | wofstream::trunc);
+    file.close();
+    return !file.fail();
+  }
+
+  void RemoveDatabaseFiles() {
+    remove(kAccountFile);
+    remove(kChatMessageFile);
+    remove(kChatRoomFile);
+  }
+
+  // Parse "--name=value" into value. Return false if arg is another option.
+  bool ParseOption(const string& arg, const string& name, string* out_value) {
+    const string prefix = "--" + name + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+      return false;
+    }
+    *out_value = arg.substr(prefix.size());
+    return true;
+  }
+
+  // Parse a decimal integer option value. Return false if it is empty, has
+  // other characters or does not fit size_t.
+  bool ParseSize(const string& text, size_t* out_value) {
+    if (text.empty() || text[0] < '0' || text[0] > '9') {
+      return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long value = strtoull(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE ||
+        value > numeric_limits<size_t>::max()) {
+      return false;
+    }
+    *out_value = static_cast<size_t>(value);
+    return true;
+  }
+
+  // Parse a number option value. Return false if it is empty, has other
+  // characters or is not finite.
+  bool ParseNumber(const string& text, double* out_value) {
+    char* end = nullptr;
+    const double value = strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !isfinite(value)) {
+      return false;
+    }
+    *out_value = value;
+    return true;
+  }
+
+  // Start a chat server in this process, drive it with the load generator
+  // and report the result.
+  int RunLoadGenerator(const string_t& port,
+                       const LoadGenerator::Options& options) {
+    if (!WriteDatabaseFiles(options)) {
+      error("Fail to write the database files");
+      return 1;
+    }
+    ChatDatabase chat_database;
+    AccountDatabase account_database;
+    if (!chat_database.Initialize(to_string_t(kChatMessageFile),
+                                  to_string_t(kChatRoomFile)) ||
+        !account_database.Initialize(to_string_t(kAccountFile))) {
+      error("Fail database initialization");
+      RemoveDatabaseFiles();
+      return 1;
+    }
+    SessionManager session_manager;
+
+    const string_t address = UU("http://localhost:") + port + UU("/chat");
+    ChatServer chat_server(&chat_database, &account_database,
+                           &session_manager);
+    if (!chat_server.Initialize(address) ||
+        chat_server.OpenServer().wait() != task_status::completed) {
+      error("Fail to start the chat server");
+      RemoveDatabaseFiles();
+      return 1;
+    }
+
+    int result = 0;
+    LoadGenerator load_generator(address, options);
+    if (load_generator.Run()) {
+      load_generator.Report();
+    } else {
+      result = 1;
+    }
+
+    chat_server.CloseServer().wait();
+    RemoveDatabaseFiles();
+    return result;
+  }
+
+} // namespace
+
+// Usage: chat_server_loadgen [--users=2000] [--rooms=16] [--rate=500]
+//            [--duration=30] [--max_outstanding=2000] [--port=34570]
+//            [--mix=signup:1,login:4,poll:60,post:30,room_create:1]
+// Please use the Release configuration: Debug numbers are not meaningful.
+int main(int argc, char* argv[]) {
+  const char* const kUsage =
+      "Usage: chat_server_loadgen [--users=2000] [--rooms=16] [--rate=500] "
+      "[--duration=30] [--max_outstanding=2000] [--port=34570] "
+      "[--mix=signup:1,login:4,poll:60,post:30,room_create:1]";
+  LoadGenerator::Options options;
+  string_t port = UU("34570");
+  for (int i = 1; i < argc; ++i) {
+    const string arg = argv[i];
+    string value;
+    bool is_valid = true;
+    if (ParseOption(arg, "users", &value)) {
+      is_valid = ParseSize(value, &options.user_count);
+    } else if (ParseOption(arg, "rooms", &value)) {
+      is_valid = ParseSize(value, &options.chat_room_count);
+    } else if (ParseOption(arg, "rate", &value)) {
+      is_valid = ParseNumber(value, &options.arrival_rate);
+    } else if (ParseOption(arg, "duration", &value)) {
+      is_valid = ParseNumber(value, &options.duration);
+    } else if (ParseOption(arg, "max_outstanding", &value)) {
+      is_valid = ParseSize(value, &options.max_outstanding_requests);
+    } else if (ParseOption(arg, "port", &value)) {
+      size_t port_number = 0;
+      is_valid = ParseSize(value, &port_number) && port_number > 0 &&
+                 port_number <= numeric_limits<uint16_t>::max();
+      port = to_string_t(value);
+    } else if (ParseOption(arg, "mix", &value)) {
+      is_valid = LoadGenerator::ParseOperationMix(value,
+                                                  options.operation_weights);
+    } else {
+      error("Unknown option: {}\n{}", arg, kUsage);
+      return 1;
+    }
+    if (!is_valid) {
+      error("Invalid option: {}\n{}", arg, kUsage);
+      return 1;
+    }
+  }
+  if (options.user_count == 0 || options.chat_room_count == 0 ||
+      options.arrival_rate <= 0.0 || options.duration <= 0.0) {
+    error("users, rooms, rate and duration must be positive\n{}", kUsage);
+    return 1;
+  }
+
+  // Drop log messages of the chat server rather than let a slow console
+  // throttle it.
+  AsyncLogging::Initialize(AsyncLogging::kDefaultQueueSize,
+                           spdlog::async_overflow_policy::overrun_oldest);
+  const int result = RunLoadGenerator(port, options);
+  AsyncLogging::Shutdown();
+  return result;
+}
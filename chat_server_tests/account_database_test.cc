@@ -18,40 +18,41 @@ class AccountDatabaseTest : public ::testing::Test {
   ChatDatabase chat_database_;
 
   // Delimiter between id and password in a file database.
-  string_t kParsingDelimeterAccount = UU(",");
+  ChatString kParsingDelimeterAccount = CHATSERVER_TEXT(",");
   // Delimiter in the chat message file database.
-  string_t kParsingDelimeterChatDb = UU("|");
+  ChatString kParsingDelimeterChatDb = CHATSERVER_TEXT("|");
   // Length of nonce.
   const size_t kNonceLength = 10;
   // Nonce seed.
-  const string_t kNonceValue = UU(
+  const ChatString kNonceValue = CHATSERVER_TEXT(
       "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz");
 
   void SetUp() override {
     const string_t file_name = UU("accounts.txt");
-    wofstream file(file_name, wofstream::out | ofstream::trunc);
-    file << "kaist" << "," << HashString(UU("12345678")) << endl;
-    file << "wsp" << "," << HashString(UU("abcdefgh")) << endl;
-    file << "gsis" << "," << HashString(UU("!@#$%^&*")) << endl;
+    ChatOutputFileStream file(file_name, wofstream::out | ofstream::trunc);
+    file << "kaist" << "," << HashString(CHATSERVER_TEXT("12345678")) << endl;
+    file << "wsp" << "," << HashString(CHATSERVER_TEXT("abcdefgh")) << endl;
+    file << "gsis" << "," << HashString(CHATSERVER_TEXT("!@#$%^&*")) << endl;
     file.close();
     true, account_database_.Initialize(file_name);
   }
 
-  string_t HashLoginPassword(string_t password, string_t nonce) const {
+  ChatString HashLoginPassword(ChatString password, ChatString nonce) const {
     return HashString(HashString(password) + nonce);
   }
 
-  string_t HashString(utility::string_t string) const {
-    return conversions::to_string_t(
-      std::to_string(std::hash<utility::string_t>{}(string)));
+  // Hash of the utility::string_t, as the client sends.
+  ChatString HashString(ChatString string) const {
+    return FromUtf8(
+      std::to_string(std::hash<utility::string_t>{}(ToStringT(string))));
   }
 
-  string_t GenerateNonce() const {
+  ChatString GenerateNonce() const {
     std::random_device device;
     std::mt19937 generator(device());
     const std::uniform_int_distribution<int>
         distribution(0, kNonceValue.size() - 1);
-    string_t result;
+    ChatString result;
     for (size_t i = 0; i < 10; i++) {
       result += kNonceValue.at(distribution(generator));
     }
@@ -66,66 +67,71 @@ TEST_F(AccountDatabaseTest, Initialization_Fail) {
 
 TEST_F(AccountDatabaseTest, Login_Success) {
   // Login success.
-  string_t nonce = GenerateNonce();
+  ChatString nonce = GenerateNonce();
   EXPECT_EQ(AccountDatabase::kAuthSuccess,
-            account_database_.Login(UU("kaist"), 
-            HashLoginPassword(UU("12345678"), nonce), 
+            account_database_.Login(CHATSERVER_TEXT("kaist"), 
+            HashLoginPassword(CHATSERVER_TEXT("12345678"), nonce), 
             nonce));
   nonce = GenerateNonce();
   EXPECT_EQ(AccountDatabase::kAuthSuccess,
-            account_database_.Login(UU("wsp"), 
-            HashLoginPassword(UU("abcdefgh"), nonce), 
+            account_database_.Login(CHATSERVER_TEXT("wsp"), 
+            HashLoginPassword(CHATSERVER_TEXT("abcdefgh"), nonce), 
             nonce));
   nonce = GenerateNonce();
   EXPECT_EQ(AccountDatabase::kAuthSuccess,
-            account_database_.Login(UU("gsis"), 
-            HashLoginPassword(UU("!@#$%^&*"), nonce), 
+            account_database_.Login(CHATSERVER_TEXT("gsis"), 
+            HashLoginPassword(CHATSERVER_TEXT("!@#$%^&*"), nonce), 
             nonce));
 }
 
 TEST_F(AccountDatabaseTest, Login_Fail_Password) {
   // Login fails due to incorrect password.
-  const string_t nonce = GenerateNonce();
+  const ChatString nonce = GenerateNonce();
   EXPECT_EQ(AccountDatabase::kPasswordError,
-            account_database_.Login(UU("kaist"), 
-            HashLoginPassword(UU("23456789"), nonce), 
+            account_database_.Login(CHATSERVER_TEXT("kaist"), 
+            HashLoginPassword(CHATSERVER_TEXT("23456789"), nonce), 
             nonce));
 }
 
 TEST_F(AccountDatabaseTest, Login_Fail_Id) {
   // Login fails due to incorrect ID.
-  const string_t nonce = GenerateNonce();
+  const ChatString nonce = GenerateNonce();
   EXPECT_EQ(AccountDatabase::kIDNotExist,
-            account_database_.Login(UU("gss"), 
-            HashLoginPassword(UU("23456789"), nonce), 
+            account_database_.Login(CHATSERVER_TEXT("gss"), 
+            HashLoginPassword(CHATSERVER_TEXT("23456789"), nonce), 
             nonce));
 }
 
 TEST_F(AccountDatabaseTest, SignUp_Success) {
   // SignUp success.
   EXPECT_EQ(AccountDatabase::kAuthSuccess,
-            account_database_.SignUp(UU("abc"), HashString(UU("12345678"))));
+            account_database_.SignUp(CHATSERVER_TEXT("abc"),
+                                     HashString(CHATSERVER_TEXT("12345678"))));
   EXPECT_EQ(AccountDatabase::kDuplicateID,
-            account_database_.SignUp(UU("wsp"), HashString(UU("45678901"))));
+            account_database_.SignUp(CHATSERVER_TEXT("wsp"),
+                                     HashString(CHATSERVER_TEXT("45678901"))));
   EXPECT_EQ(AccountDatabase::kDuplicateID,
-            account_database_.SignUp(UU("abc"), HashString(UU("78901234"))));
+            account_database_.SignUp(CHATSERVER_TEXT("abc"),
+                                     HashString(CHATSERVER_TEXT("78901234"))));
 }
 
 TEST_F(AccountDatabaseTest, SignUp_Fail_ProhibitedCharInId) {
   // SignUp fails due to prohibited char.
   EXPECT_EQ(AccountDatabase::kProhibitedCharInID,
-      account_database_.SignUp(UU("kaist") + kParsingDelimeterAccount,
-          HashString(UU("12345678"))));
+      account_database_.SignUp(
+          CHATSERVER_TEXT("kaist") + kParsingDelimeterAccount,
+          HashString(CHATSERVER_TEXT("12345678"))));
   EXPECT_EQ(AccountDatabase::kProhibitedCharInID,
-      account_database_.SignUp(UU("kaist") + kParsingDelimeterChatDb,
-          HashString(UU("12345678"))));
+      account_database_.SignUp(
+          CHATSERVER_TEXT("kaist") + kParsingDelimeterChatDb,
+          HashString(CHATSERVER_TEXT("12345678"))));
 }
 
 TEST_F(AccountDatabaseTest, SignUp_Fail_ProhibitedCharInPassword) {
   // SignUp fails due to prohibited char.
   EXPECT_EQ(AccountDatabase::kProhibitedCharInPassword,
-      account_database_.SignUp(UU("kaist"),
-          UU("234") + kParsingDelimeterAccount));
+      account_database_.SignUp(CHATSERVER_TEXT("kaist"),
+          CHATSERVER_TEXT("234") + kParsingDelimeterAccount));
 }
 
 TEST_F(AccountDatabaseTest, ParsingAccountFile_Success) {
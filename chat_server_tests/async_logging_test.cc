@@ -0,0 +1,26 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "async_logging.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace chatserver;
+using ::spdlog::async_overflow_policy;
+
+TEST(AsyncLogging, ParseOverflowPolicy_Success) {
+  async_overflow_policy policy = async_overflow_policy::block;
+  EXPECT_EQ(true, AsyncLogging::ParseOverflowPolicy("overrun_oldest",
+                                                    &policy));
+  EXPECT_EQ(async_overflow_policy::overrun_oldest, policy);
+  EXPECT_EQ(true, AsyncLogging::ParseOverflowPolicy("block", &policy));
+  EXPECT_EQ(async_overflow_policy::block, policy);
+}
+
+TEST(AsyncLogging, ParseOverflowPolicy_Fail) {
+  async_overflow_policy policy = async_overflow_policy::block;
+  EXPECT_EQ(false, AsyncLogging::ParseOverflowPolicy("drop", &policy));
+  EXPECT_EQ(false, AsyncLogging::ParseOverflowPolicy("", &policy));
+  EXPECT_EQ(false, AsyncLogging::ParseOverflowPolicy("block", nullptr));
+}
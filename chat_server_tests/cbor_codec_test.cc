@@ -0,0 +1,159 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "gtest/gtest.h"
+#include "cbor_codec.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+using ::web::json::value;
+
+namespace {
+
+  vector<ChatMessage> MakeChatMessages() {
+    vector<ChatMessage> chat_messages;
+    chat_messages.emplace_back(1583581783, CHATSERVER_TEXT("kaist"),
+                               CHATSERVER_TEXT("a"), CHATSERVER_TEXT("hihi"));
+    chat_messages.emplace_back(1583581784, CHATSERVER_TEXT("wsp"),
+                               CHATSERVER_TEXT("a"), CHATSERVER_TEXT("hello"));
+    chat_messages.emplace_back(1583581700, CHATSERVER_TEXT("kaist"),
+                               CHATSERVER_TEXT("b"), CHATSERVER_TEXT(""));
+    for (size_t i = 0; i < chat_messages.size(); ++i) {
+      chat_messages[i].timestamp = chat_messages[i].GetTimestamp() + 123;
+      chat_messages[i].id = i + 1;
+    }
+    return chat_messages;
+  }
+
+} // namespace
+
+TEST(CborCodec, IsCborMediaType_Success) {
+  EXPECT_EQ(true, CborCodec::IsCborMediaType(UU("application/cbor")));
+  EXPECT_EQ(true, CborCodec::IsCborMediaType(
+      UU("Application/CBOR, application/json;q=0.5")));
+  EXPECT_EQ(false, CborCodec::IsCborMediaType(UU("application/json")));
+  EXPECT_EQ(false, CborCodec::IsCborMediaType(UU("")));
+  EXPECT_EQ(true, CborCodec::IsCborMediaType(
+      UU("application/json, application/cbor ; q=0.5")));
+}
+
+TEST(CborCodec, IsCborMediaType_Fail_OtherMediaRange) {
+  // The type and subtype of a media range must match exactly.
+  EXPECT_EQ(false, CborCodec::IsCborMediaType(UU("application/cbor-seq")));
+  EXPECT_EQ(false, CborCodec::IsCborMediaType(
+      UU("application/json;profile=application/cbor")));
+}
+
+TEST(CborCodec, IsCborMediaType_Fail_Refused) {
+  // A quality value of 0 refuses CBOR.
+  EXPECT_EQ(false, CborCodec::IsCborMediaType(UU("application/cbor;q=0")));
+  EXPECT_EQ(false, CborCodec::IsCborMediaType(
+      UU("application/json, application/cbor; q=0.000")));
+}
+
+TEST(CborCodec, EncodeJson_Success_KnownBytes) {
+  // {"a": [1, -2, true, null]} in RFC 7049.
+  value json_value;
+  json_value[UU("a")][0] = value::number(1);
+  json_value[UU("a")][1] = value::number(-2);
+  json_value[UU("a")][2] = value::boolean(true);
+  json_value[UU("a")][3] = value::null();
+  const vector<unsigned char> expected_data = {
+      0xa1, 0x61, 'a', 0x84, 0x01, 0x21, 0xf5, 0xf6};
+  EXPECT_EQ(expected_data, CborCodec::EncodeJson(json_value));
+}
+
+TEST(CborCodec, DecodeJson_Success_RoundTrip) {
+  value json_value;
+  json_value[UU("session_id")] = value::string(UU("abc"));
+  json_value[UU("number")] = value::number(1583581783);
+  json_value[UU("double")] = value::number(0.5);
+  json_value[UU("chat_messages")][0][UU("chat_room")] =
+      value::string(UU("room"));
+  value decoded_value;
+  EXPECT_EQ(true, CborCodec::DecodeJson(CborCodec::EncodeJson(json_value),
+                                        &decoded_value));
+  EXPECT_EQ(json_value, decoded_value);
+}
+
+TEST(CborCodec, DecodeJson_Fail_Malformed) {
+  value decoded_value;
+  // Truncated text string.
+  EXPECT_EQ(false, CborCodec::DecodeJson({0x63, 'a', 'b'}, &decoded_value));
+  // Trailing data.
+  EXPECT_EQ(false, CborCodec::DecodeJson({0x01, 0x01}, &decoded_value));
+  // Indefinite-length array.
+  EXPECT_EQ(false, CborCodec::DecodeJson({0x9f, 0x01, 0xff}, &decoded_value));
+  // Array size beyond the data.
+  EXPECT_EQ(false, CborCodec::DecodeJson({0x9a, 0xff, 0xff, 0xff, 0xff},
+                                         &decoded_value));
+  EXPECT_EQ(false, CborCodec::DecodeJson({}, &decoded_value));
+}
+
+TEST(CborCodec, DecodeChatMessages_Success_RoundTrip) {
+  const vector<ChatMessage> chat_messages = MakeChatMessages();
+  vector<ChatMessage> decoded_messages;
+  EXPECT_EQ(true, CborCodec::DecodeChatMessages(
+      CborCodec::EncodeChatMessages(chat_messages), &decoded_messages));
+  ASSERT_EQ(chat_messages.size(), decoded_messages.size());
+  for (size_t i = 0; i < chat_messages.size(); ++i) {
+    EXPECT_EQ(chat_messages[i], decoded_messages[i]);
+    EXPECT_EQ(chat_messages[i].date, decoded_messages[i].date);
+    EXPECT_EQ(chat_messages[i].timestamp, decoded_messages[i].timestamp);
+    EXPECT_EQ(chat_messages[i].id, decoded_messages[i].id);
+  }
+}
+
+TEST(CborCodec, DecodeChatMessages_Success_Empty) {
+  vector<ChatMessage> decoded_messages;
+  EXPECT_EQ(true, CborCodec::DecodeChatMessages(
+      CborCodec::EncodeChatMessages({}), &decoded_messages));
+  EXPECT_EQ(0, decoded_messages.size());
+}
+
+TEST(CborCodec, DecodeChatMessages_Fail_Truncated) {
+  const vector<unsigned char> data =
+      CborCodec::EncodeChatMessages(MakeChatMessages());
+  for (size_t size = 0; size < data.size(); ++size) {
+    const vector<unsigned char> truncated_data(data.begin(),
+                                               data.begin() + size);
+    vector<ChatMessage> decoded_messages;
+    EXPECT_EQ(false, CborCodec::DecodeChatMessages(truncated_data,
+                                                   &decoded_messages));
+    EXPECT_EQ(0, decoded_messages.size());
+  }
+}
+
+TEST(CborCodec, DecodeChatMessages_Fail_DuplicateKey) {
+  // [{"room": "a", "date": [], "message": [], "message": []}]
+  const vector<unsigned char> data = {
+      0x81, 0xa4,
+      0x64, 'r', 'o', 'o', 'm', 0x61, 'a',
+      0x64, 'd', 'a', 't', 'e', 0x80,
+      0x67, 'm', 'e', 's', 's', 'a', 'g', 'e', 0x80,
+      0x67, 'm', 'e', 's', 's', 'a', 'g', 'e', 0x80};
+  vector<ChatMessage> decoded_messages;
+  EXPECT_EQ(false, CborCodec::DecodeChatMessages(data, &decoded_messages));
+  EXPECT_EQ(0, decoded_messages.size());
+}
+
+TEST(CborCodec, EncodeChatMessages_Success_SmallerThanJson) {
+  const vector<ChatMessage> chat_messages = MakeChatMessages();
+  value json_value = value::array();
+  for (size_t i = 0; i < chat_messages.size(); ++i) {
+    json_value[i][UU("date")] = value::number(chat_messages[i].date);
+    json_value[i][UU("user_id")] =
+        value::string(ToStringT(chat_messages[i].user_id));
+    json_value[i][UU("message")] =
+        value::string(ToStringT(chat_messages[i].chat_message));
+    json_value[i][UU("room")] =
+        value::string(ToStringT(chat_messages[i].chat_room));
+    json_value[i][UU("timestamp")] =
+        value::number(chat_messages[i].timestamp);
+    json_value[i][UU("id")] = value::number(chat_messages[i].id);
+  }
+  EXPECT_LT(CborCodec::EncodeChatMessages(chat_messages).size(),
+            utility::conversions::to_utf8string(json_value.serialize()).size());
+}
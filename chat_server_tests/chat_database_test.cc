@@ -2,6 +2,12 @@
 // Code style follows Google C++ Style Guide.
 // (https://google.github.io/styleguide/cppguide.html)
 
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory_resource>
+#include <thread>
+
 #include "gtest/gtest.h"
 #include "chat_database.h"
 #include "chat_message.h"
@@ -15,7 +21,7 @@ class ChatDatabaseTest : public ::testing::Test {
  protected:
   ChatDatabase chat_database_;
   // Delimiter in the chat message file database.
-  string_t kParsingDelimeterChatDb = UU("|");
+  ChatString kParsingDelimeterChatDb = CHATSERVER_TEXT("|");
 
   void SetUp() override {
     const string_t chat_message_file = UU("chat_messages.txt");
@@ -48,55 +54,591 @@ TEST_F(ChatDatabaseTest, Initialization_Fail) {
 TEST_F(ChatDatabaseTest, GetAllChatMessages) {
   // Check number of messages from the chat room
   vector<ChatMessage> chat_message;
-  EXPECT_EQ(2, chat_database_.GetAllChatMessages(UU("a"))->size());
-  EXPECT_EQ(1, chat_database_.GetAllChatMessages(UU("b"))->size());
-  EXPECT_EQ(1, chat_database_.GetAllChatMessages(UU("c"))->size());
-  EXPECT_EQ(0, chat_database_.GetAllChatMessages(UU("d"))->size());
-  EXPECT_EQ(0, chat_database_.GetAllChatMessages(UU("e"))->size());
+  EXPECT_EQ(2, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+  EXPECT_EQ(1, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+  EXPECT_EQ(1, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("c"))->size());
+  EXPECT_EQ(0, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("d"))->size());
+  EXPECT_EQ(0, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("e"))->size());
 }
 
 TEST_F(ChatDatabaseTest, StoreChatMessage_Success) {
   // Success to store message.
   ChatMessage message;
   message.date = 1583581800;
-  message.user_id = UU("gsis");
-  message.chat_room = UU("c");
-  message.chat_message = UU("haha");
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("c");
+  message.chat_message = CHATSERVER_TEXT("haha");
   EXPECT_EQ(true, chat_database_.StoreChatMessage(message));
-  EXPECT_EQ(2, chat_database_.GetAllChatMessages(UU("c"))->size());
+  EXPECT_EQ(2, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("c"))->size());
 }
 
 TEST_F(ChatDatabaseTest, StoreChatMessage_Fail_ProhibitedChar_Id) {
   // Fail to store message due to prohibited char.
   ChatMessage message;
   message.date = 1583581800;
-  message.user_id = UU("gsis" + kParsingDelimeterChatDb);
-  message.chat_room = UU("c");
-  message.chat_message = UU("haha");
+  message.user_id = CHATSERVER_TEXT("gsis" + kParsingDelimeterChatDb);
+  message.chat_room = CHATSERVER_TEXT("c");
+  message.chat_message = CHATSERVER_TEXT("haha");
   EXPECT_EQ(false, chat_database_.StoreChatMessage(message));
-  EXPECT_EQ(1, chat_database_.GetAllChatMessages(UU("c"))->size());
+  EXPECT_EQ(1, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("c"))->size());
 }
 
 TEST_F(ChatDatabaseTest, StoreChatMessage_Fail_ProhibitedChar_Room) {
   // Fail to store message due to prohibited char.
   ChatMessage message;
   message.date = 1583581800;
-  message.user_id = UU("gsis");
-  message.chat_room = UU("c" + kParsingDelimeterChatDb);
-  message.chat_message = UU("haha");
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("c" + kParsingDelimeterChatDb);
+  message.chat_message = CHATSERVER_TEXT("haha");
   EXPECT_EQ(false, chat_database_.StoreChatMessage(message));
-  EXPECT_EQ(1, chat_database_.GetAllChatMessages(UU("c"))->size());
+  EXPECT_EQ(1, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("c"))->size());
 }
 
 TEST_F(ChatDatabaseTest, StoreChatMessage_Fail_ProhibitedChar_Message) {
   // Fail to store message due to prohibited char.
   ChatMessage message;
   message.date = 1583581800;
-  message.user_id = UU("gsis");
-  message.chat_room = UU("c");
-  message.chat_message = UU("haha" + kParsingDelimeterChatDb);
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("c");
+  message.chat_message = CHATSERVER_TEXT("haha" + kParsingDelimeterChatDb);
   EXPECT_EQ(false, chat_database_.StoreChatMessage(message));
-  EXPECT_EQ(1, chat_database_.GetAllChatMessages(UU("c"))->size());
+  EXPECT_EQ(1, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("c"))->size());
+}
+
+TEST_F(ChatDatabaseTest, StoreChatMessages_Success) {
+  // Success to store several messages at once.
+  vector<ChatMessage> messages(2);
+  messages[0].date = 1583581800;
+  messages[0].user_id = CHATSERVER_TEXT("gsis");
+  messages[0].chat_room = CHATSERVER_TEXT("b");
+  messages[0].chat_message = CHATSERVER_TEXT("haha");
+  messages[1] = messages[0];
+  messages[1].chat_room = CHATSERVER_TEXT("c");
+  EXPECT_EQ(true, chat_database_.StoreChatMessages(messages));
+  EXPECT_EQ(2, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+  EXPECT_EQ(2, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("c"))->size());
+}
+
+TEST_F(ChatDatabaseTest, StoreChatMessages_Fail_ProhibitedChar) {
+  // Nothing is stored if any message has a prohibited char.
+  vector<ChatMessage> messages(2);
+  messages[0].date = 1583581800;
+  messages[0].user_id = CHATSERVER_TEXT("gsis");
+  messages[0].chat_room = CHATSERVER_TEXT("b");
+  messages[0].chat_message = CHATSERVER_TEXT("haha");
+  messages[1] = messages[0];
+  messages[1].chat_message = CHATSERVER_TEXT("haha" + kParsingDelimeterChatDb);
+  EXPECT_EQ(false, chat_database_.StoreChatMessages(messages));
+  EXPECT_EQ(1, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+}
+
+TEST_F(ChatDatabaseTest, StoreChatMessages_Fail_NoChatRoom) {
+  // Nothing is stored, and no log file is created, for an unknown chat room.
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), false));
+  vector<ChatMessage> messages(2);
+  messages[0].date = 1583581800;
+  messages[0].user_id = CHATSERVER_TEXT("gsis");
+  messages[0].chat_room = CHATSERVER_TEXT("a");
+  messages[0].chat_message = CHATSERVER_TEXT("haha");
+  messages[1] = messages[0];
+  messages[1].chat_room = CHATSERVER_TEXT("d");
+  EXPECT_EQ(false, chat_database.StoreChatMessages(messages));
+  EXPECT_EQ(false, chat_database_.StoreChatMessages(messages));
+  EXPECT_EQ(0, chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+  EXPECT_EQ(2, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+  EXPECT_EQ(0, filesystem::file_size(chat_log_directory + UU("/manifest.txt")));
+  EXPECT_EQ(false,
+            filesystem::exists(chat_log_directory + UU("/room_0.log")));
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, StoreChatMessages_Success_IdAndTimestamp) {
+  // Ids continue the chat room, and both are read back from the file.
+  vector<ChatMessage> messages(2);
+  messages[0].date = 1583581800;
+  messages[0].timestamp = 1583581800123456;
+  messages[0].user_id = CHATSERVER_TEXT("gsis");
+  messages[0].chat_room = CHATSERVER_TEXT("a");
+  messages[0].chat_message = CHATSERVER_TEXT("haha");
+  messages[1] = messages[0];
+  messages[1].timestamp = 0;
+  EXPECT_EQ(true, chat_database_.StoreChatMessages(messages));
+
+  ChatDatabase reloaded_chat_database;
+  EXPECT_EQ(true, reloaded_chat_database.Initialize(UU("chat_messages.txt"),
+                                                    UU("chat_room.txt")));
+  for (const ChatDatabase* chat_database :
+       {&chat_database_, &reloaded_chat_database}) {
+    const auto snapshot =
+        chat_database->GetAllChatMessages(CHATSERVER_TEXT("a"));
+    ASSERT_EQ(4, snapshot->size());
+    for (size_t i = 0; i < snapshot->size(); ++i) {
+      EXPECT_EQ(i + 1, (*snapshot)[i].id);
+    }
+    EXPECT_EQ(1583581800123456, (*snapshot)[2].timestamp);
+    // Without a timestamp, the date is used.
+    EXPECT_EQ(1583581800000000, (*snapshot)[3].timestamp);
+  }
+}
+
+TEST_F(ChatDatabaseTest, SearchChatMessages_Success) {
+  // Loaded and stored chat messages are both found.
+  ChatMessage message;
+  message.date = 1583581800;
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("a");
+  message.chat_message = CHATSERVER_TEXT("Hello again");
+  EXPECT_EQ(true, chat_database_.StoreChatMessage(message));
+
+  ChatSearchQuery query;
+  ASSERT_EQ(true, ChatSearchIndex::ParseQuery(CHATSERVER_TEXT("hello"),
+                                              &query));
+  pmr::vector<ChatMessageView> chat_messages;
+  ChatDatabase::LoadResult load_result;
+  const auto snapshot = chat_database_.SearchChatMessages(
+      CHATSERVER_TEXT("a"), query, 10, &chat_messages, &load_result);
+  EXPECT_EQ(ChatDatabase::kLoadSuccess, load_result);
+  ASSERT_EQ(2, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("hello"), chat_messages[0].chat_message);
+  EXPECT_EQ(CHATSERVER_TEXT("Hello again"), chat_messages[1].chat_message);
+  EXPECT_EQ(3, snapshot->size());
+}
+
+TEST_F(ChatDatabaseTest, SearchAllChatMessages_Success) {
+  // The chat rooms are merged by time.
+  ChatSearchQuery query;
+  ASSERT_EQ(true, ChatSearchIndex::ParseQuery(CHATSERVER_TEXT("hello"),
+                                              &query));
+  pmr::vector<ChatMessageView> chat_messages;
+  ChatDatabase::LoadResult load_result;
+  auto snapshots = chat_database_.SearchAllChatMessages(
+      query, 10, &chat_messages, &load_result);
+  EXPECT_EQ(ChatDatabase::kLoadSuccess, load_result);
+  ASSERT_EQ(2, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("hello"), chat_messages[0].chat_message);
+  EXPECT_EQ(CHATSERVER_TEXT("hello world"), chat_messages[1].chat_message);
+  EXPECT_EQ(2, snapshots.size());
+
+  // The latest ones, with only the snapshot of the kept chat message.
+  chat_messages.clear();
+  snapshots = chat_database_.SearchAllChatMessages(query, 1, &chat_messages,
+                                                   &load_result);
+  ASSERT_EQ(1, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("hello world"), chat_messages[0].chat_message);
+  ASSERT_EQ(1, snapshots.size());
+  EXPECT_EQ(1, snapshots[0]->size());
+}
+
+TEST_F(ChatDatabaseTest, SaveSearchIndex_Success_Reloaded) {
+  EXPECT_EQ(true, chat_database_.SaveSearchIndex());
+  ChatMessage message;
+  message.date = 1583581800;
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("b");
+  message.chat_message = CHATSERVER_TEXT("hello again");
+  EXPECT_EQ(true, chat_database_.StoreChatMessage(message));
+
+  // The saved index is loaded, and the chat message stored after the save
+  // is indexed on initialization.
+  ChatDatabase reloaded_chat_database;
+  EXPECT_EQ(true, reloaded_chat_database.Initialize(UU("chat_messages.txt"),
+                                                    UU("chat_room.txt")));
+  ChatSearchQuery query;
+  ASSERT_EQ(true, ChatSearchIndex::ParseQuery(CHATSERVER_TEXT("hello"),
+                                              &query));
+  pmr::vector<ChatMessageView> chat_messages;
+  ChatDatabase::LoadResult load_result;
+  const auto snapshot = reloaded_chat_database.SearchChatMessages(
+      CHATSERVER_TEXT("b"), query, 10, &chat_messages, &load_result);
+  ASSERT_EQ(2, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("hello world"), chat_messages[0].chat_message);
+  EXPECT_EQ(CHATSERVER_TEXT("hello again"), chat_messages[1].chat_message);
+  remove("chat_messages.txt.index");
+}
+
+TEST_F(ChatDatabaseTest, GetUserChatMessages_Success) {
+  // Loaded and stored chat messages of every chat room, by time.
+  ChatMessage message;
+  message.date = 1583581800;
+  message.user_id = CHATSERVER_TEXT("kaist");
+  message.chat_room = CHATSERVER_TEXT("c");
+  message.chat_message = CHATSERVER_TEXT("bye");
+  EXPECT_EQ(true, chat_database_.StoreChatMessage(message));
+
+  pmr::vector<ChatMessageView> chat_messages;
+  ChatDatabase::LoadResult load_result;
+  auto snapshots = chat_database_.GetUserChatMessages(
+      CHATSERVER_TEXT("kaist"), 10, &chat_messages, &load_result);
+  EXPECT_EQ(ChatDatabase::kLoadSuccess, load_result);
+  ASSERT_EQ(3, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("hihi"), chat_messages[0].chat_message);
+  EXPECT_EQ(CHATSERVER_TEXT("hello world"), chat_messages[1].chat_message);
+  EXPECT_EQ(CHATSERVER_TEXT("bye"), chat_messages[2].chat_message);
+
+  // The latest ones.
+  chat_messages.clear();
+  snapshots = chat_database_.GetUserChatMessages(CHATSERVER_TEXT("kaist"), 1,
+                                                 &chat_messages, &load_result);
+  ASSERT_EQ(1, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("bye"), chat_messages[0].chat_message);
+  // Only the snapshot of the kept chat message is held.
+  ASSERT_EQ(1, snapshots.size());
+  EXPECT_EQ(2, snapshots[0]->size());
+}
+
+TEST_F(ChatDatabaseTest, InitializePartitioned_Success_Converted) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  {
+    ChatDatabase chat_database;
+    ASSERT_EQ(true, chat_database.InitializePartitioned(
+                        chat_log_directory, UU("chat_room.txt"), false));
+    EXPECT_EQ(2, chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+    EXPECT_EQ(1, chat_database.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+    EXPECT_EQ(1, chat_database.GetAllChatMessages(CHATSERVER_TEXT("c"))->size());
+    EXPECT_EQ(4, chat_database.GetChatMessageCount());
+
+    ChatMessage message;
+    message.date = 1583581800;
+    message.user_id = CHATSERVER_TEXT("gsis");
+    message.chat_room = CHATSERVER_TEXT("a");
+    message.chat_message = CHATSERVER_TEXT("haha");
+    EXPECT_EQ(true, chat_database.StoreChatMessage(message));
+  }
+
+  // The stored chat message is read back from the file of its chat room.
+  ChatDatabase reloaded_chat_database;
+  ASSERT_EQ(true, reloaded_chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), false));
+  const auto snapshot =
+      reloaded_chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"));
+  ASSERT_EQ(3, snapshot->size());
+  EXPECT_EQ(3, (*snapshot)[2].id);
+  EXPECT_EQ(CHATSERVER_TEXT("haha"), (*snapshot)[2].chat_message);
+  EXPECT_EQ(5, reloaded_chat_database.GetChatMessageCount());
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, InitializePartitioned_Success_Lazy) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), true));
+  EXPECT_EQ(3, chat_database.GetChatRoomList()->size());
+  EXPECT_EQ(0, chat_database.GetChatMessageCount());
+
+  // Concurrent first reads of a chat room load it once.
+  vector<thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&chat_database]() {
+      EXPECT_EQ(2,
+                chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+    });
+  }
+  for (thread& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(2, chat_database.GetChatMessageCount());
+
+  // A write loads the chat room first, so the id follows its history.
+  ChatMessage message;
+  message.date = 1583581800;
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("b");
+  message.chat_message = CHATSERVER_TEXT("hello again");
+  EXPECT_EQ(true, chat_database.StoreChatMessage(message));
+  const auto snapshot = chat_database.GetAllChatMessages(CHATSERVER_TEXT("b"));
+  ASSERT_EQ(2, snapshot->size());
+  EXPECT_EQ(2, (*snapshot)[1].id);
+  EXPECT_EQ(0, chat_database.GetAllChatMessages(CHATSERVER_TEXT("d"))->size());
+  EXPECT_EQ(4, chat_database.GetChatMessageCount());
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, GetUserChatMessages_Success_Lazy) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  {
+    ChatDatabase chat_database;
+    ASSERT_EQ(true, chat_database.InitializePartitioned(
+                        chat_log_directory, UU("chat_room.txt"), true));
+    // The chat rooms of the user are loaded for the lookup.
+    pmr::vector<ChatMessageView> chat_messages;
+    ChatDatabase::LoadResult load_result;
+    const auto snapshots = chat_database.GetUserChatMessages(
+        CHATSERVER_TEXT("kaist"), 10, &chat_messages, &load_result);
+    ASSERT_EQ(2, chat_messages.size());
+    EXPECT_EQ(CHATSERVER_TEXT("hihi"), chat_messages[0].chat_message);
+    EXPECT_EQ(CHATSERVER_TEXT("hello world"), chat_messages[1].chat_message);
+
+    ChatMessage message;
+    message.date = 1583581800;
+    message.user_id = CHATSERVER_TEXT("gsis");
+    message.chat_room = CHATSERVER_TEXT("c");
+    message.chat_message = CHATSERVER_TEXT("good night");
+    EXPECT_EQ(true, chat_database.StoreChatMessage(message));
+    EXPECT_EQ(true, chat_database.SaveSearchIndex());
+  }
+
+  // The chat rooms of a new user, and the search index of each loaded chat
+  // room, are saved in the directory.
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(chat_log_directory));
+  EXPECT_EQ(true, filesystem::exists(
+      partitioned_log.GetPartition(CHATSERVER_TEXT("a"))->index_file));
+  EXPECT_EQ(true, filesystem::exists(
+      partitioned_log.GetPartition(CHATSERVER_TEXT("c"))->index_file));
+  ChatDatabase reloaded_chat_database;
+  ASSERT_EQ(true, reloaded_chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), true));
+  pmr::vector<ChatMessageView> chat_messages;
+  ChatDatabase::LoadResult load_result;
+  const auto snapshots = reloaded_chat_database.GetUserChatMessages(
+      CHATSERVER_TEXT("gsis"), 10, &chat_messages, &load_result);
+  ASSERT_EQ(1, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("good night"), chat_messages[0].chat_message);
+  ChatSearchQuery query;
+  ASSERT_EQ(true, ChatSearchIndex::ParseQuery(CHATSERVER_TEXT("night"),
+                                              &query));
+  chat_messages.clear();
+  const auto snapshot = reloaded_chat_database.SearchChatMessages(
+      CHATSERVER_TEXT("c"), query, 10, &chat_messages, &load_result);
+  EXPECT_EQ(1, chat_messages.size());
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, SetMemoryBudget_Success_Evicted) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), true));
+  EXPECT_EQ(0, chat_database.GetMemoryUsage());
+  EXPECT_EQ(2, chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+  this_thread::sleep_for(chrono::milliseconds(5));
+  EXPECT_EQ(1, chat_database.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+  vector<ChatDatabase::ChatRoomMemoryUsage> memory_usages =
+      chat_database.GetChatRoomMemoryUsages();
+  ASSERT_EQ(2, memory_usages.size());
+  EXPECT_EQ(memory_usages[0].bytes + memory_usages[1].bytes,
+            chat_database.GetMemoryUsage());
+
+  // The least recently accessed chat room is evicted to fit the budget.
+  chat_database.SetMemoryBudget(chat_database.GetMemoryUsage() - 1);
+  memory_usages = chat_database.GetChatRoomMemoryUsages();
+  ASSERT_EQ(1, memory_usages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("b"), memory_usages[0].chat_room);
+  EXPECT_EQ(1, chat_database.GetChatMessageCount());
+
+  // An evicted chat room is loaded again, and keeps its ids on a write.
+  this_thread::sleep_for(chrono::milliseconds(5));
+  ChatMessage message;
+  message.date = 1583581800;
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("a");
+  message.chat_message = CHATSERVER_TEXT("haha");
+  EXPECT_EQ(true, chat_database.StoreChatMessage(message));
+  memory_usages = chat_database.GetChatRoomMemoryUsages();
+  ASSERT_EQ(1, memory_usages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("a"), memory_usages[0].chat_room);
+  const auto snapshot = chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"));
+  ASSERT_EQ(3, snapshot->size());
+  EXPECT_EQ(3, (*snapshot)[2].id);
+  EXPECT_GE(chat_database.GetMemoryBudget(), chat_database.GetMemoryUsage());
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, SetMemoryBudget_Success_EvictsIndexes) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), true));
+  vector<ChatString> evicted_chat_rooms;
+  chat_database.SetEvictedCallback(
+      [&evicted_chat_rooms](const ChatString& chat_room) {
+    evicted_chat_rooms.push_back(chat_room);
+  });
+  const auto snapshot = chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"));
+  ASSERT_EQ(2, snapshot->size());
+  // The indexes of the chat room are counted with its log.
+  EXPECT_LT(0, chat_database.GetMemoryUsage());
+  EXPECT_EQ(chat_database.GetMemoryUsage(),
+            chat_database.GetChatRoomMemoryUsages()[0].bytes);
+
+  // Evicting the chat room drops its indexes, after saving the search index.
+  chat_database.SetMemoryBudget(1);
+  EXPECT_EQ(0, chat_database.GetMemoryUsage());
+  EXPECT_EQ(vector<ChatString>({CHATSERVER_TEXT("a")}), evicted_chat_rooms);
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(chat_log_directory));
+  EXPECT_EQ(true, filesystem::exists(
+      partitioned_log.GetPartition(CHATSERVER_TEXT("a"))->index_file));
+
+  // Lookups load the chat room and its indexes again.
+  chat_database.SetMemoryBudget(0);
+  chat_database.SetEvictedCallback(nullptr);
+  ChatSearchQuery query;
+  ASSERT_EQ(true, ChatSearchIndex::ParseQuery(CHATSERVER_TEXT("hello"),
+                                              &query));
+  pmr::vector<ChatMessageView> chat_messages;
+  ChatDatabase::LoadResult load_result;
+  const auto searched_snapshot = chat_database.SearchChatMessages(
+      CHATSERVER_TEXT("a"), query, 10, &chat_messages, &load_result);
+  ASSERT_EQ(1, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("wsp"), chat_messages[0].user_id);
+  chat_messages.clear();
+  const auto snapshots = chat_database.GetUserChatMessages(
+      CHATSERVER_TEXT("kaist"), 10, &chat_messages, &load_result);
+  EXPECT_EQ(2, chat_messages.size());
+  EXPECT_EQ(1, evicted_chat_rooms.size());
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, SetMemoryBudget_Success_EvictsBeforeLoad) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), true));
+  EXPECT_EQ(2, chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(chat_log_directory));
+  ASSERT_GE(chat_database.GetMemoryUsage(),
+            partitioned_log.GetLogFileSize(CHATSERVER_TEXT("b")));
+  chat_database.SetMemoryBudget(chat_database.GetMemoryUsage());
+
+  // The loaded chat room is evicted to make room before b is read.
+  vector<size_t> loaded_chat_room_counts;
+  chat_database.SetEvictedCallback(
+      [&chat_database, &loaded_chat_room_counts](const ChatString&) {
+    loaded_chat_room_counts.push_back(
+        chat_database.GetChatRoomMemoryUsages().size());
+  });
+  EXPECT_EQ(1, chat_database.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+  EXPECT_EQ(vector<size_t>({0}), loaded_chat_room_counts);
+  chat_database.SetEvictedCallback(nullptr);
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, SetMemoryBudget_Success_ConcurrentLoads) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), true));
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(chat_log_directory));
+  chat_database.SetMemoryBudget(
+      max(partitioned_log.GetLogFileSize(CHATSERVER_TEXT("a")),
+          partitioned_log.GetLogFileSize(CHATSERVER_TEXT("b"))));
+
+  // Every load is evicted for, so concurrent loads stay in the budget.
+  vector<thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&chat_database, i]() {
+      if (i % 2 == 0) {
+        EXPECT_EQ(2, chat_database.GetAllChatMessages(
+                         CHATSERVER_TEXT("a"))->size());
+      } else {
+        EXPECT_EQ(1, chat_database.GetAllChatMessages(
+                         CHATSERVER_TEXT("b"))->size());
+      }
+    });
+  }
+  for (thread& t : threads) {
+    t.join();
+  }
+  EXPECT_LE(chat_database.GetMemoryUsage(), chat_database.GetMemoryBudget());
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, SetMemoryBudget_Success_SearchAllLoadsNone) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), true));
+  EXPECT_EQ(2, chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+  chat_database.SetMemoryBudget(chat_database.GetMemoryUsage());
+
+  // Only the loaded chat room is searched, and no other one is loaded.
+  ChatSearchQuery query;
+  ASSERT_EQ(true, ChatSearchIndex::ParseQuery(CHATSERVER_TEXT("hello"),
+                                              &query));
+  pmr::vector<ChatMessageView> chat_messages;
+  ChatDatabase::LoadResult load_result = ChatDatabase::kLoadError;
+  const auto snapshots = chat_database.SearchAllChatMessages(
+      query, 10, &chat_messages, &load_result);
+  EXPECT_EQ(ChatDatabase::kLoadSuccess, load_result);
+  ASSERT_EQ(1, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("hello"), chat_messages[0].chat_message);
+  const vector<ChatDatabase::ChatRoomMemoryUsage> memory_usages =
+      chat_database.GetChatRoomMemoryUsages();
+  ASSERT_EQ(1, memory_usages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("a"), memory_usages[0].chat_room);
+  EXPECT_EQ(2, chat_database.GetChatMessageCount());
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatDatabaseTest, SetMemoryBudget_Fail_LargerThanBudget) {
+  const string_t chat_log_directory = UU("chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(UU("chat_messages.txt"),
+                                              chat_log_directory));
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("chat_room.txt"), true));
+
+  // A chat room whose log file can't fit the budget is never read, and
+  // reads of it fail rather than find it empty.
+  chat_database.SetMemoryBudget(1);
+  ChatDatabase::LoadResult load_result = ChatDatabase::kLoadSuccess;
+  EXPECT_EQ(nullptr, chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"),
+                                                      &load_result));
+  EXPECT_EQ(ChatDatabase::kLoadOverMemoryBudget, load_result);
+  ChatSearchQuery query;
+  ASSERT_EQ(true, ChatSearchIndex::ParseQuery(CHATSERVER_TEXT("hello"),
+                                              &query));
+  pmr::vector<ChatMessageView> chat_messages;
+  load_result = ChatDatabase::kLoadSuccess;
+  chat_database.SearchChatMessages(CHATSERVER_TEXT("a"), query, 10,
+                                   &chat_messages, &load_result);
+  EXPECT_EQ(ChatDatabase::kLoadOverMemoryBudget, load_result);
+  EXPECT_EQ(0, chat_messages.size());
+  EXPECT_EQ(0, chat_database.GetMemoryUsage());
+  ChatMessage message;
+  message.date = 1583581800;
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("a");
+  message.chat_message = CHATSERVER_TEXT("haha");
+  EXPECT_EQ(false, chat_database.StoreChatMessage(message));
+
+  // It is read once the budget allows it, without the failed store.
+  chat_database.SetMemoryBudget(0);
+  EXPECT_EQ(2, chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+  filesystem::remove_all(chat_log_directory);
 }
 
 TEST_F(ChatDatabaseTest, GetChatRoomList) {
@@ -104,55 +646,86 @@ TEST_F(ChatDatabaseTest, GetChatRoomList) {
 }
 
 TEST_F(ChatDatabaseTest, CreateChatRoom_Success) {
-  chat_database_.CreateChatRoom(UU("d"));
+  chat_database_.CreateChatRoom(CHATSERVER_TEXT("d"));
   EXPECT_EQ(4, chat_database_.GetChatRoomList()->size());
 }
 
+TEST_F(ChatDatabaseTest, GetChatRoomVersion_Success) {
+  // Check the room version changes only for the room of a stored message.
+  const uint64_t version_b =
+      chat_database_.GetChatRoomVersion(CHATSERVER_TEXT("b"));
+  const uint64_t version_c =
+      chat_database_.GetChatRoomVersion(CHATSERVER_TEXT("c"));
+  EXPECT_NE(0, version_c);
+  EXPECT_EQ(0, chat_database_.GetChatRoomVersion(CHATSERVER_TEXT("d")));
+
+  ChatMessage message;
+  message.date = 1583581800;
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("c");
+  message.chat_message = CHATSERVER_TEXT("haha");
+  EXPECT_EQ(true, chat_database_.StoreChatMessage(message));
+  EXPECT_NE(version_c, chat_database_.GetChatRoomVersion(CHATSERVER_TEXT("c")));
+  EXPECT_EQ(version_b, chat_database_.GetChatRoomVersion(CHATSERVER_TEXT("b")));
+}
+
+TEST_F(ChatDatabaseTest, GetChatRoomListVersion_Success) {
+  // Check the room list version changes only when a room is created.
+  const uint64_t version = chat_database_.GetChatRoomListVersion();
+  chat_database_.CreateChatRoom(CHATSERVER_TEXT("a"));
+  EXPECT_EQ(version, chat_database_.GetChatRoomListVersion());
+  chat_database_.CreateChatRoom(CHATSERVER_TEXT("d"));
+  EXPECT_NE(version, chat_database_.GetChatRoomListVersion());
+}
+
 TEST_F(ChatDatabaseTest, CreateChatRoom_Fail_Duplicate) {
   // Check duplicated chat name.
-  chat_database_.CreateChatRoom(UU("a"));
+  chat_database_.CreateChatRoom(CHATSERVER_TEXT("a"));
   EXPECT_EQ(3, chat_database_.GetChatRoomList()->size());
 }
 
 TEST_F(ChatDatabaseTest, CreateChatRoom_Fail_InvalidName) {
   // Check invalid chat name.
-  chat_database_.CreateChatRoom(UU(""));
+  EXPECT_EQ(false, chat_database_.CreateChatRoom(CHATSERVER_TEXT("")));
+  // The separators of a chat room list are not allowed either.
+  EXPECT_EQ(false, chat_database_.CreateChatRoom(CHATSERVER_TEXT("d:1")));
+  EXPECT_EQ(false, chat_database_.CreateChatRoom(CHATSERVER_TEXT("d,e")));
   EXPECT_EQ(3, chat_database_.GetChatRoomList()->size());
 }
 
 TEST_F(ChatDatabaseTest, DoesDelimiterExistInChatMessage_Success) {
   ChatMessage message;
   message.date = 1583581800;
-  message.user_id = UU("gsis");
-  message.chat_room = UU("c");
-  message.chat_message = UU("haha");
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("c");
+  message.chat_message = CHATSERVER_TEXT("haha");
   EXPECT_EQ(true, chat_database_.DoesDelimiterExistInChatMessage(message));
 }
 
 TEST_F(ChatDatabaseTest, DoesDelimiterExist_Fail_DelimiterInId) {
   ChatMessage message;
   message.date = 1583581800;
-  message.user_id = UU("gsis" + kParsingDelimeterChatDb);
-  message.chat_room = UU("c");
-  message.chat_message = UU("haha");
+  message.user_id = CHATSERVER_TEXT("gsis" + kParsingDelimeterChatDb);
+  message.chat_room = CHATSERVER_TEXT("c");
+  message.chat_message = CHATSERVER_TEXT("haha");
   EXPECT_EQ(false, chat_database_.DoesDelimiterExistInChatMessage(message));
 }
 
 TEST_F(ChatDatabaseTest, DoesDelimiterExist_Fail_DelimiterInRoom) {
   ChatMessage message;
   message.date = 1583581800;
-  message.user_id = UU("gsis");
-  message.chat_room = UU("c" + kParsingDelimeterChatDb);
-  message.chat_message = UU("haha");
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("c" + kParsingDelimeterChatDb);
+  message.chat_message = CHATSERVER_TEXT("haha");
   EXPECT_EQ(false, chat_database_.DoesDelimiterExistInChatMessage(message));
 }
 
 TEST_F(ChatDatabaseTest, DoesDelimiterExist_Fail_DelimiterInMessage) {
   ChatMessage message;
   message.date = 1583581800;
-  message.user_id = UU("gsis");
-  message.chat_room = UU("c");
-  message.chat_message = UU("haha" + kParsingDelimeterChatDb);
+  message.user_id = CHATSERVER_TEXT("gsis");
+  message.chat_room = CHATSERVER_TEXT("c");
+  message.chat_message = CHATSERVER_TEXT("haha" + kParsingDelimeterChatDb);
   EXPECT_EQ(false, chat_database_.DoesDelimiterExistInChatMessage(message));
 }
 
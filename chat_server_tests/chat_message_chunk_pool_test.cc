@@ -0,0 +1,61 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "gtest/gtest.h"
+#include "chat_message_chunk_pool.h"
+
+using namespace std;
+using namespace chatserver;
+
+TEST(ChatMessageChunkPool, Allocate_Success_Empty) {
+  ChatMessageChunkPool chunk_pool;
+  ChatMessageChunk* chunk = chunk_pool.Allocate();
+  ASSERT_NE(nullptr, chunk);
+  EXPECT_EQ(nullptr, chunk->next);
+  EXPECT_EQ(true, chunk->chat_messages[0].chat_message.empty());
+  chunk_pool.Free(chunk);
+}
+
+TEST(ChatMessageChunkPool, Free_Success_Reused) {
+  ChatMessageChunkPool chunk_pool;
+  ChatMessageChunk* first_chunk = chunk_pool.Allocate();
+  ChatMessageChunk* second_chunk = chunk_pool.Allocate();
+  first_chunk->chat_messages[0].date = 1583581783;
+  first_chunk->chat_messages[0].user_id = CHATSERVER_TEXT("kaist");
+  first_chunk->chat_messages[0].chat_room = CHATSERVER_TEXT("a");
+  first_chunk->chat_messages[0].chat_message = CHATSERVER_TEXT("hihi");
+  first_chunk->next = second_chunk;
+  chunk_pool.Free(first_chunk);
+  EXPECT_EQ(1, chunk_pool.GetFreeChunkCount());
+
+  // The freed chunk comes back with empty chat messages.
+  ChatMessageChunk* reused_chunk = chunk_pool.Allocate();
+  EXPECT_EQ(first_chunk, reused_chunk);
+  EXPECT_EQ(0, chunk_pool.GetFreeChunkCount());
+  EXPECT_EQ(nullptr, reused_chunk->next);
+  EXPECT_EQ(true, reused_chunk->chat_messages[0].chat_message.empty());
+  EXPECT_EQ(true, reused_chunk->chat_messages[0].user_id.empty());
+
+  chunk_pool.Free(reused_chunk);
+  chunk_pool.Free(second_chunk);
+  EXPECT_EQ(2, chunk_pool.GetFreeChunkCount());
+}
+
+TEST(ChatMessageChunkPool, SetMaxFreeChunkCount_Success) {
+  ChatMessageChunkPool chunk_pool;
+  ChatMessageChunk* first_chunk = chunk_pool.Allocate();
+  ChatMessageChunk* second_chunk = chunk_pool.Allocate();
+  ChatMessageChunk* third_chunk = chunk_pool.Allocate();
+  chunk_pool.Free(first_chunk);
+  chunk_pool.Free(second_chunk);
+  EXPECT_EQ(2, chunk_pool.GetFreeChunkCount());
+
+  // The surplus is deleted, and so are chunks freed beyond the most kept.
+  chunk_pool.SetMaxFreeChunkCount(1);
+  EXPECT_EQ(1, chunk_pool.GetFreeChunkCount());
+  chunk_pool.Free(third_chunk);
+  EXPECT_EQ(1, chunk_pool.GetFreeChunkCount());
+  chunk_pool.SetMaxFreeChunkCount(0);
+  EXPECT_EQ(0, chunk_pool.GetFreeChunkCount());
+}
@@ -0,0 +1,150 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "cpprest/asyncrt_utils.h"
+#include "chat_message_loader.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+
+namespace {
+
+  bool ParseLine(const string& line, ChatMessage* out_chat_message) {
+    return ChatMessageLoader::ParseLine(line.data(), line.data() + line.size(),
+                                        out_chat_message);
+  }
+
+  bool Parse(const string& data, size_t thread_count,
+             ChatMessageLoader::ChatMessageMap* out_chat_messages) {
+    return ChatMessageLoader::Parse(data.data(), data.size(), thread_count,
+                                    out_chat_messages);
+  }
+
+  // Lines of several MB, so the parse is split over threads.
+  string MakeChatMessageFile() {
+    string data;
+    for (int i = 0; i < 100000; ++i) {
+      data += to_string(1583581783 + i) + "|user" + to_string(i % 13) +
+              "|room" + to_string(i % 7) + "|chat message number " +
+              to_string(i) + "\n";
+    }
+    return data;
+  }
+
+} // namespace
+
+TEST(ChatMessageLoader, ParseLine_Success) {
+  ChatMessage chat_message;
+  EXPECT_EQ(true, ParseLine("1583581783|kaist|a|hello world", &chat_message));
+  EXPECT_EQ(1583581783, chat_message.date);
+  EXPECT_EQ(CHATSERVER_TEXT("kaist"), chat_message.user_id);
+  EXPECT_EQ(CHATSERVER_TEXT("a"), chat_message.chat_room);
+  EXPECT_EQ(CHATSERVER_TEXT("hello world"), chat_message.chat_message);
+}
+
+TEST(ChatMessageLoader, ParseLine_Success_TimestampAndId) {
+  ChatMessage chat_message;
+  EXPECT_EQ(true, ParseLine("1583581783123456|7|kaist|a|hello world",
+                            &chat_message));
+  EXPECT_EQ(1583581783123456, chat_message.timestamp);
+  EXPECT_EQ(1583581783, chat_message.date);
+  EXPECT_EQ(7, chat_message.id);
+  EXPECT_EQ(CHATSERVER_TEXT("kaist"), chat_message.user_id);
+  EXPECT_EQ(CHATSERVER_TEXT("a"), chat_message.chat_room);
+  EXPECT_EQ(CHATSERVER_TEXT("hello world"), chat_message.chat_message);
+}
+
+TEST(ChatMessageLoader, ParseLine_Fail_Malformed) {
+  ChatMessage chat_message;
+  EXPECT_EQ(false, ParseLine("1583581783kaist|aihi", &chat_message));
+  EXPECT_EQ(false, ParseLine("1583581783|kaista|hihi", &chat_message));
+  EXPECT_EQ(false, ParseLine("|||", &chat_message));
+  EXPECT_EQ(false, ParseLine("1583581783|||", &chat_message));
+  EXPECT_EQ(false, ParseLine("|kaist|a|hihi", &chat_message));
+  EXPECT_EQ(false, ParseLine("1583581783|kaist|a|", &chat_message));
+  EXPECT_EQ(false, ParseLine("1583581783|kaist|a|hi|b", &chat_message));
+  EXPECT_EQ(false, ParseLine("15835x1783|kaist|a|hihi", &chat_message));
+  EXPECT_EQ(false, ParseLine("1583581783|0|kaist|a|hihi", &chat_message));
+  EXPECT_EQ(false, ParseLine("1583581783|1|kaist|a|hi|b", &chat_message));
+}
+
+TEST(ChatMessageLoader, Parse_Success_CarriageReturnAndEmptyLine) {
+  ChatMessageLoader::ChatMessageMap chat_messages;
+  EXPECT_EQ(true, Parse("1583581783|kaist|a|hihi\r\n\r\n\n"
+                        "1583581784|wsp|b|hello", 1, &chat_messages));
+  ASSERT_EQ(1, chat_messages[CHATSERVER_TEXT("a")].size());
+  EXPECT_EQ(CHATSERVER_TEXT("hihi"),
+            chat_messages[CHATSERVER_TEXT("a")][0].chat_message);
+  ASSERT_EQ(1, chat_messages[CHATSERVER_TEXT("b")].size());
+  EXPECT_EQ(CHATSERVER_TEXT("hello"),
+            chat_messages[CHATSERVER_TEXT("b")][0].chat_message);
+}
+
+TEST(ChatMessageLoader, Parse_Success_SameOrderWithThreads) {
+  const string data = MakeChatMessageFile();
+  ChatMessageLoader::ChatMessageMap single_thread_chat_messages;
+  ChatMessageLoader::ChatMessageMap multi_thread_chat_messages;
+  EXPECT_EQ(true, Parse(data, 1, &single_thread_chat_messages));
+  EXPECT_EQ(true, Parse(data, 4, &multi_thread_chat_messages));
+
+  EXPECT_EQ(7, multi_thread_chat_messages.size());
+  size_t chat_message_count = 0;
+  for (const auto& chat_room : single_thread_chat_messages) {
+    const vector<ChatMessage>& chat_messages =
+        multi_thread_chat_messages[chat_room.first];
+    ASSERT_EQ(chat_room.second.size(), chat_messages.size());
+    for (size_t i = 0; i < chat_messages.size(); ++i) {
+      EXPECT_EQ(chat_room.second[i], chat_messages[i]);
+      if (i > 0) {
+        EXPECT_LT(chat_messages[i - 1].date, chat_messages[i].date);
+      }
+    }
+    chat_message_count += chat_messages.size();
+  }
+  EXPECT_EQ(100000, chat_message_count);
+}
+
+TEST(ChatMessageLoader, Parse_Fail_MalformedLineInLastChunk) {
+  const string data = MakeChatMessageFile() + "1583581783|kaista|hihi\n";
+  ChatMessageLoader::ChatMessageMap chat_messages;
+  EXPECT_EQ(false, Parse(data, 4, &chat_messages));
+}
+
+TEST(ChatMessageLoader, Load_Success) {
+  ofstream file("chat_message_loader_test.txt", ofstream::trunc);
+  file << "1583581783|kaist|a|hihi" << endl;
+  file << "1583581784|wsp|a|hello" << endl;
+  file.close();
+
+  ChatMessageLoader::ChatMessageMap chat_messages;
+  EXPECT_EQ(true, ChatMessageLoader::Load(UU("chat_message_loader_test.txt"),
+                                          0, &chat_messages));
+  ASSERT_EQ(2, chat_messages[CHATSERVER_TEXT("a")].size());
+  EXPECT_EQ(CHATSERVER_TEXT("wsp"),
+            chat_messages[CHATSERVER_TEXT("a")][1].user_id);
+  remove("chat_message_loader_test.txt");
+}
+
+TEST(ChatMessageLoader, Load_Success_EmptyFile) {
+  ofstream file("chat_message_loader_test.txt", ofstream::trunc);
+  file.close();
+
+  ChatMessageLoader::ChatMessageMap chat_messages;
+  EXPECT_EQ(true, ChatMessageLoader::Load(UU("chat_message_loader_test.txt"),
+                                          0, &chat_messages));
+  EXPECT_EQ(true, chat_messages.empty());
+  remove("chat_message_loader_test.txt");
+}
+
+TEST(ChatMessageLoader, Load_Fail_NoFile) {
+  ChatMessageLoader::ChatMessageMap chat_messages;
+  EXPECT_EQ(false, ChatMessageLoader::Load(UU("no_such_file.txt"), 0,
+                                           &chat_messages));
+}
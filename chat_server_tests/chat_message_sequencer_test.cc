@@ -0,0 +1,217 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "chat_database.h"
+#include "chat_message_sequencer.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+
+namespace {
+
+  // Chat message of kaist in the given chat room. The date is left 0.
+  ChatMessage MakeChatMessage(const ChatString& chat_room,
+                              const ChatString& text) {
+    ChatMessage chat_message;
+    chat_message.user_id = CHATSERVER_TEXT("kaist");
+    chat_message.chat_room = chat_room;
+    chat_message.chat_message = text;
+    return chat_message;
+  }
+
+} // namespace
+
+// Fixture class for chat_message_sequencer.h testing.
+class ChatMessageSequencerTest : public ::testing::Test {
+ protected:
+  ChatDatabase chat_database_;
+
+  void SetUp() override {
+    const string_t chat_message_file = UU("sequencer_chat_messages.txt");
+    const string_t chat_room_file = UU("sequencer_chat_room.txt");
+    wofstream file(chat_message_file, wofstream::out | ofstream::trunc);
+    file << "1583581783|kaist|a|hihi" << endl;
+    file.close();
+
+    file.open(chat_room_file, wofstream::out | ofstream::trunc);
+    file << "a" << endl;
+    file << "b" << endl;
+    file.close();
+    chat_database_.Initialize(chat_message_file, chat_room_file);
+  }
+
+  // Submit the given chat messages and wait for the callback.
+  bool SubmitAndWait(ChatMessageSequencer* sequencer,
+                     vector<ChatMessage> chat_messages) {
+    const auto is_stored = make_shared<promise<bool>>();
+    future<bool> result = is_stored->get_future();
+    sequencer->Submit(move(chat_messages), [is_stored](bool stored) {
+      is_stored->set_value(stored);
+    });
+    return result.get();
+  }
+};
+
+TEST_F(ChatMessageSequencerTest, Submit_Success) {
+  ChatMessageSequencer sequencer(&chat_database_);
+  sequencer.RunSequencerThread();
+  vector<ChatMessage> chat_messages;
+  chat_messages.push_back(
+      MakeChatMessage(CHATSERVER_TEXT("a"), CHATSERVER_TEXT("hello")));
+  chat_messages.push_back(
+      MakeChatMessage(CHATSERVER_TEXT("b"), CHATSERVER_TEXT("world")));
+  EXPECT_EQ(true, SubmitAndWait(&sequencer, move(chat_messages)));
+
+  const auto snapshot = chat_database_.GetAllChatMessages(CHATSERVER_TEXT("a"));
+  ASSERT_EQ(2, snapshot->size());
+  EXPECT_EQ(ChatStringView(CHATSERVER_TEXT("hello")),
+            (*snapshot)[1].chat_message);
+  // The sequencer sets the server time.
+  EXPECT_LT(1583581783, (*snapshot)[1].date);
+  EXPECT_EQ((*snapshot)[1].date,
+            (*snapshot)[1].timestamp / ChatMessage::kMicrosecondsPerSecond);
+  EXPECT_EQ(1, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+}
+
+TEST_F(ChatMessageSequencerTest, Submit_Fail_ProhibitedChar) {
+  ChatMessageSequencer sequencer(&chat_database_);
+  sequencer.RunSequencerThread();
+  vector<ChatMessage> chat_messages;
+  chat_messages.push_back(
+      MakeChatMessage(CHATSERVER_TEXT("a"), CHATSERVER_TEXT("hi|hi")));
+  EXPECT_EQ(false, SubmitAndWait(&sequencer, move(chat_messages)));
+  EXPECT_EQ(1, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+}
+
+TEST_F(ChatMessageSequencerTest, Submit_Fail_NoChatRoom) {
+  ChatMessageSequencer sequencer(&chat_database_);
+  sequencer.RunSequencerThread();
+  vector<ChatMessage> chat_messages;
+  chat_messages.push_back(
+      MakeChatMessage(CHATSERVER_TEXT("c"), CHATSERVER_TEXT("hihi")));
+  EXPECT_EQ(false, SubmitAndWait(&sequencer, move(chat_messages)));
+  EXPECT_EQ(0, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("c"))->size());
+}
+
+TEST_F(ChatMessageSequencerTest, StopSequencerThread_Success_StoresQueued) {
+  ChatMessageSequencer sequencer(&chat_database_);
+  // Submitted before the thread runs: stored as one batch on stop.
+  atomic<int> stored_count(0);
+  for (int i = 0; i < 3; ++i) {
+    vector<ChatMessage> chat_messages;
+    chat_messages.push_back(
+        MakeChatMessage(CHATSERVER_TEXT("b"), CHATSERVER_TEXT("hihi")));
+    sequencer.Submit(move(chat_messages), [&stored_count](bool is_stored) {
+      if (is_stored) {
+        ++stored_count;
+      }
+    });
+  }
+  sequencer.StopSequencerThread();
+  EXPECT_EQ(3, stored_count.load());
+  EXPECT_EQ(1, sequencer.GetBatchCount());
+  EXPECT_EQ(3, chat_database_.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+}
+
+TEST_F(ChatMessageSequencerTest, Submit_Success_ManyThreads) {
+  ChatMessageSequencer sequencer(&chat_database_);
+  sequencer.RunSequencerThread();
+  const int kThreadCount = 4;
+  const int kSubmitCount = 200;
+  vector<thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([this, &sequencer]() {
+      for (int j = 0; j < kSubmitCount; ++j) {
+        vector<ChatMessage> chat_messages;
+        chat_messages.push_back(
+            MakeChatMessage(CHATSERVER_TEXT("b"), CHATSERVER_TEXT("hihi")));
+        ASSERT_EQ(true, SubmitAndWait(&sequencer, move(chat_messages)));
+      }
+    });
+  }
+  for (thread& submitter : threads) {
+    submitter.join();
+  }
+
+  // Every chat message is stored once, with timestamps increasing in log
+  // order.
+  const auto snapshot = chat_database_.GetAllChatMessages(CHATSERVER_TEXT("b"));
+  ASSERT_EQ(kThreadCount * kSubmitCount, snapshot->size());
+  for (size_t i = 1; i < snapshot->size(); ++i) {
+    ASSERT_LT((*snapshot)[i - 1].timestamp, (*snapshot)[i].timestamp);
+    ASSERT_EQ(i + 1, (*snapshot)[i].id);
+  }
+  EXPECT_GE(static_cast<uint64_t>(kThreadCount * kSubmitCount),
+            sequencer.GetBatchCount());
+}
+
+TEST_F(ChatMessageSequencerTest, Submit_Success_LoadsChatRoom) {
+  const string_t chat_log_directory = UU("sequencer_chat_log");
+  filesystem::remove_all(chat_log_directory);
+  ASSERT_EQ(true, PartitionedChatLog::Convert(
+                      UU("sequencer_chat_messages.txt"), chat_log_directory));
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("sequencer_chat_room.txt"),
+                      true));
+
+  // The chat room is loaded on submission, before the sequencer stores it.
+  ChatMessageSequencer sequencer(&chat_database);
+  vector<ChatMessage> chat_messages;
+  chat_messages.push_back(MakeChatMessage(CHATSERVER_TEXT("a"),
+                                          CHATSERVER_TEXT("hi")));
+  sequencer.Submit(move(chat_messages), [](bool is_stored) {
+    EXPECT_EQ(true, is_stored);
+  });
+  EXPECT_EQ(1, chat_database.GetChatMessageCount());
+  sequencer.StopSequencerThread();
+  const auto snapshot = chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"));
+  ASSERT_EQ(2, snapshot->size());
+  EXPECT_EQ(2, (*snapshot)[1].id);
+  filesystem::remove_all(chat_log_directory);
+}
+
+TEST_F(ChatMessageSequencerTest, StopSequencerThread_Success_PartlyStored) {
+  // The log file of chat room b is a directory, so its append fails.
+  const string_t chat_log_directory = UU("sequencer_chat_log");
+  filesystem::remove_all(chat_log_directory);
+  filesystem::create_directories(chat_log_directory);
+  wofstream file(chat_log_directory + UU("/manifest.txt"),
+                 wofstream::out | ofstream::trunc);
+  file << "room_0.log|a" << endl;
+  file << "room_1.log|b" << endl;
+  file.close();
+  ChatDatabase chat_database;
+  ASSERT_EQ(true, chat_database.InitializePartitioned(
+                      chat_log_directory, UU("sequencer_chat_room.txt"),
+                      false));
+  filesystem::create_directories(chat_log_directory + UU("/room_1.log"));
+
+  // Only the submission of the failed chat room fails in the batch.
+  ChatMessageSequencer sequencer(&chat_database);
+  vector<bool> results;
+  for (const ChatString chat_room : {CHATSERVER_TEXT("a"),
+                                     CHATSERVER_TEXT("b")}) {
+    vector<ChatMessage> chat_messages;
+    chat_messages.push_back(MakeChatMessage(chat_room, CHATSERVER_TEXT("hi")));
+    sequencer.Submit(move(chat_messages), [&results](bool is_stored) {
+      results.push_back(is_stored);
+    });
+  }
+  sequencer.StopSequencerThread();
+  EXPECT_EQ(1, sequencer.GetBatchCount());
+  EXPECT_EQ(vector<bool>({true, false}), results);
+  EXPECT_EQ(1, chat_database.GetAllChatMessages(CHATSERVER_TEXT("a"))->size());
+  EXPECT_EQ(0, chat_database.GetAllChatMessages(CHATSERVER_TEXT("b"))->size());
+  filesystem::remove_all(chat_log_directory);
+}
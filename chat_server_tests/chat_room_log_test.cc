@@ -0,0 +1,210 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "chat_room_log.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace {
+
+  // Chat message i of a test chat room. The date is i.
+  ChatMessage MakeChatMessage(size_t i) {
+    return ChatMessage(static_cast<time_t>(i), CHATSERVER_TEXT("kaist"),
+                       CHATSERVER_TEXT("a"),
+                       CHATSERVER_TEXT("hello ") + FromUtf8(to_string(i)));
+  }
+
+  // Check the snapshot has chat messages 0 to size - 1.
+  void CheckSnapshot(const ChatRoomSnapshot& snapshot, size_t size) {
+    ASSERT_EQ(size, snapshot.size());
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(MakeChatMessage(i), snapshot[i].ToChatMessage());
+      ASSERT_EQ(static_cast<time_t>(i), snapshot[i].date);
+      ASSERT_EQ(i + 1, snapshot[i].id);
+    }
+  }
+
+} // namespace
+
+TEST(ChatRoomLog, GetSnapshot_Success_Empty) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  EXPECT_EQ(true, chat_room_log.GetSnapshot()->empty());
+}
+
+TEST(ChatRoomLog, GetMemoryUsage_Success) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  EXPECT_EQ(0, chat_room_log.GetMemoryUsage());
+  chat_room_log.Append(MakeChatMessage(0));
+  const size_t memory_usage = chat_room_log.GetMemoryUsage();
+  EXPECT_LT(sizeof(ChatMessageChunk), memory_usage);
+
+  // The text arena is counted by its blocks, and a chunk once, so a short
+  // chat message takes no more memory.
+  chat_room_log.Append(MakeChatMessage(1));
+  EXPECT_EQ(memory_usage, chat_room_log.GetMemoryUsage());
+
+  // A text larger than the block takes a new one.
+  const ChatString long_text(8192, CHATSERVER_TEXT('a'));
+  chat_room_log.Append(ChatMessage(2, CHATSERVER_TEXT("kaist"),
+                                   CHATSERVER_TEXT("a"), long_text));
+  EXPECT_LE(memory_usage + long_text.size() * sizeof(ChatChar),
+            chat_room_log.GetMemoryUsage());
+}
+
+TEST(ChatRoomLog, Append_Success_OverChunks) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  // Over several directories.
+  const size_t kSize = ChatMessageChunk::kCapacity * 100 + 5;
+  for (size_t i = 0; i < kSize; ++i) {
+    chat_room_log.Append(MakeChatMessage(i));
+  }
+  CheckSnapshot(*chat_room_log.GetSnapshot(), kSize);
+}
+
+TEST(ChatRoomLog, Append_Success_Batch) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  chat_room_log.Append(MakeChatMessage(0));
+  vector<ChatMessage> chat_messages;
+  for (size_t i = 1; i < ChatMessageChunk::kCapacity * 2; ++i) {
+    chat_messages.push_back(MakeChatMessage(i));
+  }
+  chat_room_log.Append(move(chat_messages));
+  chat_room_log.Append(MakeChatMessage(ChatMessageChunk::kCapacity * 2));
+  CheckSnapshot(*chat_room_log.GetSnapshot(),
+                ChatMessageChunk::kCapacity * 2 + 1);
+}
+
+TEST(ChatRoomLog, GetIndexAfterId_Success) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  for (size_t i = 0; i < 3; ++i) {
+    chat_room_log.Append(MakeChatMessage(i));
+  }
+  const shared_ptr<const ChatRoomSnapshot> snapshot =
+      chat_room_log.GetSnapshot();
+  EXPECT_EQ(0, snapshot->GetIndexAfterId(0));
+  EXPECT_EQ(2, snapshot->GetIndexAfterId(2));
+  EXPECT_EQ(3, snapshot->GetIndexAfterId(3));
+  EXPECT_EQ(3, snapshot->GetIndexAfterId(100));
+}
+
+TEST(ChatRoomLog, GetIndexAtTimestamp_Success) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  EXPECT_EQ(0, chat_room_log.GetSnapshot()->GetIndexAtTimestamp(0));
+  // Over several directories, with two chat messages per timestamp.
+  const size_t kSize = ChatMessageChunk::kCapacity * 20 + 3;
+  for (size_t i = 0; i < kSize; ++i) {
+    ChatMessage chat_message = MakeChatMessage(i);
+    chat_message.timestamp = static_cast<int64_t>(i / 2 + 1) * 10;
+    chat_room_log.Append(chat_message);
+  }
+  const shared_ptr<const ChatRoomSnapshot> snapshot =
+      chat_room_log.GetSnapshot();
+  EXPECT_EQ(true, snapshot->is_time_ordered());
+  for (size_t i = 0; i < kSize; i += 2) {
+    const int64_t timestamp = static_cast<int64_t>(i / 2 + 1) * 10;
+    ASSERT_EQ(i, snapshot->GetIndexAtTimestamp(timestamp));
+    ASSERT_EQ(min(i + 2, kSize), snapshot->GetIndexAtTimestamp(timestamp + 1));
+  }
+  EXPECT_EQ(0, snapshot->GetIndexAtTimestamp(0));
+  EXPECT_EQ(kSize, snapshot->GetIndexAtTimestamp(kSize * 10));
+}
+
+TEST(ChatRoomLog, GetIndexAtTimestamp_Success_OutOfOrder) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  chat_room_log.Append(MakeChatMessage(2));
+  chat_room_log.Append(MakeChatMessage(2));
+  EXPECT_EQ(true, chat_room_log.GetSnapshot()->is_time_ordered());
+  chat_room_log.Append(MakeChatMessage(1));
+  EXPECT_EQ(false, chat_room_log.GetSnapshot()->is_time_ordered());
+}
+
+TEST(ChatRoomLog, Append_Success_Pointers) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  vector<ChatMessage> chat_messages;
+  for (size_t i = 0; i < ChatMessageChunk::kCapacity + 1; ++i) {
+    chat_messages.push_back(MakeChatMessage(i));
+  }
+  vector<const ChatMessage*> chat_message_pointers;
+  for (const ChatMessage& chat_message : chat_messages) {
+    chat_message_pointers.push_back(&chat_message);
+  }
+  chat_room_log.Append(chat_message_pointers);
+  CheckSnapshot(*chat_room_log.GetSnapshot(), ChatMessageChunk::kCapacity + 1);
+}
+
+TEST(ChatRoomLog, Append_Success_CopyText) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  ChatMessage chat_message = MakeChatMessage(0);
+  chat_room_log.Append(chat_message);
+  chat_room_log.Append(MakeChatMessage(1));
+  // The log keeps its own copy of the text.
+  chat_message.chat_message = CHATSERVER_TEXT("changed");
+  const shared_ptr<const ChatRoomSnapshot> snapshot =
+      chat_room_log.GetSnapshot();
+  CheckSnapshot(*snapshot, 2);
+  // The chat messages share the chat room text.
+  EXPECT_EQ((*snapshot)[0].chat_room.data(),
+            (*snapshot)[1].chat_room.data());
+}
+
+TEST(ChatRoomLog, GetSnapshot_Success_UnchangedByAppend) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  vector<shared_ptr<const ChatRoomSnapshot>> snapshots;
+  for (size_t i = 0; i < ChatMessageChunk::kCapacity + 2; ++i) {
+    snapshots.push_back(chat_room_log.GetSnapshot());
+    chat_room_log.Append(MakeChatMessage(i));
+  }
+  for (size_t i = 0; i < snapshots.size(); ++i) {
+    CheckSnapshot(*snapshots[i], i);
+  }
+}
+
+TEST(ChatRoomLog, GetSnapshot_Success_WhileAppending) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  const size_t kSize = ChatMessageChunk::kCapacity * 40;
+  thread writer([&]() {
+    for (size_t i = 0; i < kSize; ++i) {
+      chat_room_log.Append(MakeChatMessage(i));
+    }
+  });
+
+  // Every snapshot has a prefix of the chat messages, and never shrinks.
+  size_t last_size = 0;
+  while (last_size < kSize) {
+    const shared_ptr<const ChatRoomSnapshot> snapshot =
+        chat_room_log.GetSnapshot();
+    ASSERT_LE(last_size, snapshot->size());
+    if (snapshot->size() > 0) {
+      ASSERT_EQ(MakeChatMessage(snapshot->size() - 1),
+                (*snapshot)[snapshot->size() - 1].ToChatMessage());
+    }
+    last_size = snapshot->size();
+  }
+  writer.join();
+  CheckSnapshot(*chat_room_log.GetSnapshot(), kSize);
+}
+
+TEST(ChatRoomLog, Append_Success_ChunksReturnedToPool) {
+  const auto chunk_pool = make_shared<ChatMessageChunkPool>();
+  shared_ptr<const ChatRoomSnapshot> snapshot;
+  {
+    ChatRoomLog chat_room_log(chunk_pool);
+    for (size_t i = 0; i < ChatMessageChunk::kCapacity * 2 + 1; ++i) {
+      chat_room_log.Append(MakeChatMessage(i));
+    }
+    snapshot = chat_room_log.GetSnapshot();
+  }
+  // The snapshot keeps the chunks after the log is gone.
+  EXPECT_EQ(0, chunk_pool->GetFreeChunkCount());
+  CheckSnapshot(*snapshot, ChatMessageChunk::kCapacity * 2 + 1);
+  snapshot.reset();
+  EXPECT_EQ(3, chunk_pool->GetFreeChunkCount());
+}
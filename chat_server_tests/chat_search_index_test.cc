@@ -0,0 +1,259 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "chat_search_index.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace {
+
+  // Chat messages of a test chat room "a".
+  const ChatString kChatRoom = CHATSERVER_TEXT("a");
+  const ChatString kChatMessages[] = {
+    CHATSERVER_TEXT("Good morning, KAIST!"),
+    CHATSERVER_TEXT("morning meeting at 10"),
+    CHATSERVER_TEXT("good night"),
+    CHATSERVER_TEXT("a good morning to you"),
+    CHATSERVER_TEXT("morning good"),
+  };
+
+  // Append the chat messages to the log and index them.
+  void AppendAndIndex(ChatRoomLog* chat_room_log,
+                      ChatSearchIndex* search_index) {
+    for (const ChatString& text : kChatMessages) {
+      chat_room_log->Append(ChatMessage(1583581783, CHATSERVER_TEXT("kaist"),
+                                        kChatRoom, text));
+    }
+    search_index->IndexChatRoom(kChatRoom, *chat_room_log->GetSnapshot());
+  }
+
+  // Search the chat room and get the ids found.
+  vector<uint64_t> Search(const ChatSearchIndex& search_index,
+                          const ChatRoomSnapshot& snapshot,
+                          const ChatString& query_text,
+                          size_t limit = 100) {
+    ChatSearchQuery query;
+    EXPECT_EQ(true, ChatSearchIndex::ParseQuery(query_text, &query));
+    pmr::vector<ChatMessageView> chat_messages;
+    search_index.Search(kChatRoom, query, snapshot, limit, &chat_messages);
+    vector<uint64_t> ids;
+    for (const ChatMessageView& chat_message : chat_messages) {
+      ids.push_back(chat_message.id);
+    }
+    return ids;
+  }
+
+} // namespace
+
+TEST(ChatSearchIndex, Tokenize_Success) {
+  vector<ChatString> terms;
+  ChatSearchIndex::Tokenize(CHATSERVER_TEXT("Hello, World! 2020 hello"),
+                            &terms);
+  const vector<ChatString> expected_terms = {
+    CHATSERVER_TEXT("hello"), CHATSERVER_TEXT("world"),
+    CHATSERVER_TEXT("2020"), CHATSERVER_TEXT("hello")};
+  EXPECT_EQ(expected_terms, terms);
+
+  // Too long terms are not indexed.
+  terms.clear();
+  ChatSearchIndex::Tokenize(
+      ChatString(ChatSearchIndex::kMaxTermSize + 1, CHATSERVER_TEXT('x')) +
+          CHATSERVER_TEXT(" ok"),
+      &terms);
+  ASSERT_EQ(1, terms.size());
+  EXPECT_EQ(CHATSERVER_TEXT("ok"), terms[0]);
+}
+
+TEST(ChatSearchIndex, ParseQuery_Success_Phrase) {
+  ChatSearchQuery query;
+  ASSERT_EQ(true, ChatSearchIndex::ParseQuery(
+      CHATSERVER_TEXT("kaist \"Good Morning\" \"one\""), &query));
+  const vector<ChatString> expected_terms = {
+    CHATSERVER_TEXT("kaist"), CHATSERVER_TEXT("good"),
+    CHATSERVER_TEXT("morning"), CHATSERVER_TEXT("one")};
+  EXPECT_EQ(expected_terms, query.terms);
+  // A phrase of one term is only a term.
+  ASSERT_EQ(1, query.phrases.size());
+  const vector<ChatString> expected_phrase = {
+    CHATSERVER_TEXT("good"), CHATSERVER_TEXT("morning")};
+  EXPECT_EQ(expected_phrase, query.phrases[0]);
+}
+
+TEST(ChatSearchIndex, ParseQuery_Fail_NoTerm) {
+  ChatSearchQuery query;
+  EXPECT_EQ(false, ChatSearchIndex::ParseQuery(CHATSERVER_TEXT(""), &query));
+  EXPECT_EQ(false,
+            ChatSearchIndex::ParseQuery(CHATSERVER_TEXT(" \"!?\" "), &query));
+}
+
+TEST(ChatSearchIndex, Search_Success_And) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  ChatSearchIndex search_index;
+  AppendAndIndex(&chat_room_log, &search_index);
+  const auto snapshot = chat_room_log.GetSnapshot();
+  EXPECT_EQ(vector<uint64_t>({1, 2, 4, 5}),
+            Search(search_index, *snapshot, CHATSERVER_TEXT("MORNING")));
+  EXPECT_EQ(vector<uint64_t>({1, 4, 5}),
+            Search(search_index, *snapshot, CHATSERVER_TEXT("good morning")));
+  EXPECT_EQ(vector<uint64_t>(),
+            Search(search_index, *snapshot, CHATSERVER_TEXT("good evening")));
+  // The latest ones, oldest first.
+  EXPECT_EQ(vector<uint64_t>({4, 5}),
+            Search(search_index, *snapshot, CHATSERVER_TEXT("good morning"),
+                   2));
+}
+
+TEST(ChatSearchIndex, Search_Success_Phrase) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  ChatSearchIndex search_index;
+  AppendAndIndex(&chat_room_log, &search_index);
+  EXPECT_EQ(vector<uint64_t>({1, 4}),
+            Search(search_index, *chat_room_log.GetSnapshot(),
+                   CHATSERVER_TEXT("\"good morning\"")));
+}
+
+TEST(ChatSearchIndex, IndexChatRoom_Success_Incremental) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  ChatSearchIndex search_index;
+  AppendAndIndex(&chat_room_log, &search_index);
+  const auto old_snapshot = chat_room_log.GetSnapshot();
+  EXPECT_EQ(5, search_index.GetIndexedCount(kChatRoom));
+
+  chat_room_log.Append(ChatMessage(1583581784, CHATSERVER_TEXT("wsp"),
+                                   kChatRoom, CHATSERVER_TEXT("night owl")));
+  search_index.IndexChatRoom(kChatRoom, *chat_room_log.GetSnapshot());
+  EXPECT_EQ(6, search_index.GetIndexedCount(kChatRoom));
+  EXPECT_EQ(vector<uint64_t>({3, 6}),
+            Search(search_index, *chat_room_log.GetSnapshot(),
+                   CHATSERVER_TEXT("night")));
+  // A chat message indexed after the snapshot is not in it.
+  EXPECT_EQ(vector<uint64_t>({3}),
+            Search(search_index, *old_snapshot, CHATSERVER_TEXT("night")));
+}
+
+TEST(ChatSearchIndex, Load_Success_SavedIndex) {
+  const utility::string_t index_file = UU("search_index_test.index");
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  {
+    ChatSearchIndex search_index;
+    AppendAndIndex(&chat_room_log, &search_index);
+    ASSERT_EQ(true, search_index.Save(index_file));
+  }
+
+  ChatSearchIndex search_index;
+  ASSERT_EQ(true, search_index.Load(index_file));
+  EXPECT_EQ(5, search_index.GetIndexedCount(kChatRoom));
+  // Only the chat messages after the saved ones are indexed.
+  chat_room_log.Append(ChatMessage(1583581784, CHATSERVER_TEXT("wsp"),
+                                   kChatRoom, CHATSERVER_TEXT("good day")));
+  search_index.IndexChatRoom(kChatRoom, *chat_room_log.GetSnapshot());
+  EXPECT_EQ(vector<uint64_t>({1, 3, 4, 5, 6}),
+            Search(search_index, *chat_room_log.GetSnapshot(),
+                   CHATSERVER_TEXT("good")));
+  remove("search_index_test.index");
+}
+
+TEST(ChatSearchIndex, LoadChatRoom_Success_SavedChatRoom) {
+  const utility::string_t index_file = UU("search_index_test.index");
+  const ChatString other_chat_room = CHATSERVER_TEXT("b");
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  ChatRoomLog other_chat_room_log(make_shared<ChatMessageChunkPool>());
+  other_chat_room_log.Append(ChatMessage(1583581790, CHATSERVER_TEXT("wsp"),
+                                         other_chat_room,
+                                         CHATSERVER_TEXT("good bye")));
+  {
+    ChatSearchIndex search_index;
+    AppendAndIndex(&chat_room_log, &search_index);
+    EXPECT_EQ(false, search_index.SaveChatRoom(other_chat_room, index_file));
+    ASSERT_EQ(true, search_index.SaveChatRoom(kChatRoom, index_file));
+  }
+
+  // Only the given chat room is replaced.
+  ChatSearchIndex search_index;
+  search_index.IndexChatRoom(other_chat_room,
+                             *other_chat_room_log.GetSnapshot());
+  EXPECT_EQ(false, search_index.LoadChatRoom(other_chat_room, index_file));
+  ASSERT_EQ(true, search_index.LoadChatRoom(kChatRoom, index_file));
+  EXPECT_EQ(5, search_index.GetIndexedCount(kChatRoom));
+  EXPECT_EQ(1, search_index.GetIndexedCount(other_chat_room));
+  EXPECT_EQ(vector<uint64_t>({1, 3, 4, 5}),
+            Search(search_index, *chat_room_log.GetSnapshot(),
+                   CHATSERVER_TEXT("good")));
+  remove("search_index_test.index");
+}
+
+TEST(ChatSearchIndex, Load_Fail_Malformed) {
+  const utility::string_t index_file = UU("search_index_test.index");
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  ChatSearchIndex search_index;
+  AppendAndIndex(&chat_room_log, &search_index);
+  EXPECT_EQ(false, search_index.Load(UU("no_search_index.index")));
+
+  ofstream file("search_index_test.index", ios::binary | ios::trunc);
+  file << "CSIX\x01\x05";
+  file.close();
+  EXPECT_EQ(false, search_index.Load(index_file));
+  // The index is kept.
+  EXPECT_EQ(5, search_index.GetIndexedCount(kChatRoom));
+  remove("search_index_test.index");
+}
+
+TEST(ChatSearchIndex, Load_Fail_CorruptCount) {
+  const utility::string_t index_file = UU("search_index_test.index");
+  // Room "a" with one chat message, and term "x" whose posting list of one
+  // id claims 2^63 ids.
+  const char bytes[] = "CSIX\x01\x01\x01" "a" "\x01\x00\x01\x01" "x"
+                       "\x80\x80\x80\x80\x80\x80\x80\x80\x80\x01"
+                       "\x01\x01\x01";
+  ofstream file("search_index_test.index", ios::binary | ios::trunc);
+  file.write(bytes, sizeof(bytes) - 1);
+  file.close();
+  ChatSearchIndex search_index;
+  EXPECT_EQ(false, search_index.Load(index_file));
+  remove("search_index_test.index");
+}
+
+TEST(ChatSearchIndex, Load_Fail_CorruptDelta) {
+  const utility::string_t index_file = UU("search_index_test.index");
+  // Room "a" with one chat message, and term "x" whose posting list of one
+  // id has a delta of 0, so it decodes to id 0.
+  const char bytes[] = "CSIX\x01\x01\x01" "a" "\x01\x00\x01\x01" "x"
+                       "\x01\x00\x01\x00";
+  ofstream file("search_index_test.index", ios::binary | ios::trunc);
+  file.write(bytes, sizeof(bytes) - 1);
+  file.close();
+  ChatSearchIndex search_index;
+  EXPECT_EQ(false, search_index.Load(index_file));
+  remove("search_index_test.index");
+}
+
+TEST(ChatSearchIndex, IndexChatRoom_Success_ReplacedLog) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  ChatSearchIndex search_index;
+  AppendAndIndex(&chat_room_log, &search_index);
+
+  // Another log with as many chat messages: the index is rebuilt.
+  ChatRoomLog other_chat_room_log(make_shared<ChatMessageChunkPool>());
+  for (size_t i = 0; i < 5; ++i) {
+    other_chat_room_log.Append(ChatMessage(1583581790, CHATSERVER_TEXT("wsp"),
+                                           kChatRoom,
+                                           CHATSERVER_TEXT("hello")));
+  }
+  search_index.IndexChatRoom(kChatRoom, *other_chat_room_log.GetSnapshot());
+  EXPECT_EQ(vector<uint64_t>(),
+            Search(search_index, *other_chat_room_log.GetSnapshot(),
+                   CHATSERVER_TEXT("good")));
+  EXPECT_EQ(vector<uint64_t>({1, 2, 3, 4, 5}),
+            Search(search_index, *other_chat_room_log.GetSnapshot(),
+                   CHATSERVER_TEXT("hello")));
+}
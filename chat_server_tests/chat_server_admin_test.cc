@@ -191,7 +191,8 @@ TEST_F(ChatServerAdminTest, Delete_Logout_Success) {
 TEST_F(ChatServerAdminTest, Session_Expire_Test) {
   const string_t session_id = PerformSuccessfulLogin();
   // Check session existence.
-  EXPECT_EQ(true, session_manager_->IsExistSessionId(session_id));
+  EXPECT_EQ(true,
+            session_manager_->IsExistSessionId(ToChatString(session_id)));
 
   // Wait and check if session expired. A better way of doing unit testing is
   // to implement a mock method for erasing sessions and inject this method for
@@ -199,7 +200,8 @@ TEST_F(ChatServerAdminTest, Session_Expire_Test) {
   const time_t wait_time = 2;
   const seconds interval(wait_time);
   this_thread::sleep_for(duration_cast<seconds>(interval));
-  EXPECT_EQ(false, session_manager_->IsExistSessionId(session_id));
+  EXPECT_EQ(false,
+            session_manager_->IsExistSessionId(ToChatString(session_id)));
 }
 
 TEST_F(ChatServerAdminTest, EndToEndTest_OneClient) {
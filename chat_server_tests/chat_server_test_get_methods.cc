@@ -2,6 +2,7 @@
 // Code style follows Google C++ Style Guide.
 // (https://google.github.io/styleguide/cppguide.html)
 
+#include "cbor_codec.h"
 #include "chat_server.h"
 #include "gtest/gtest.h"
 #include "cpprest/http_client.h"
@@ -62,6 +63,82 @@ TEST_F(ChatServerTest, Get_ChatMessage_Success) {
   EXPECT_GT(chat_list.size(), static_cast<size_t>(0));
 }
 
+TEST_F(ChatServerTest, Get_ChatMessage_Success_Cbor) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for getting chat messages in the CBOR wire format.
+  ostringstream_t buf;
+  buf << "chatmessage" << UU("?chat_room=") << "abc"
+      << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  const size_t json_size = response.extract_json().get().as_array().size();
+
+  http::http_request request(http::methods::GET);
+  request.set_request_uri(uri::encode_uri(buf.str()));
+  request.headers().add(http::header_names::accept, CborCodec::kMediaType);
+  response = http_client_->request(request).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  EXPECT_EQ(true,
+            CborCodec::IsCborMediaType(response.headers().content_type()));
+  vector<ChatMessage> chat_messages;
+  EXPECT_EQ(true, CborCodec::DecodeChatMessages(
+      response.extract_vector().get(), &chat_messages));
+  EXPECT_EQ(json_size, chat_messages.size());
+}
+
+TEST_F(ChatServerTest, Get_ChatMessage_Success_Gzip) {
+  const string_t session_id = PerformSuccessfulLogin();
+  if (!http::compression::builtin::supported()) {
+    return;
+  }
+  // Store enough chat messages to pass the compression threshold.
+  value body_data;
+  for (size_t i = 0; i < 50; ++i) {
+    body_data[UU("chat_messages")][i][UU("chat_message")] =
+        value::string(UU("a highly compressible chat message"));
+    body_data[UU("chat_messages")][i][UU("chat_room")] =
+        value::string(UU("abc"));
+  }
+  body_data[UU("session_id")] = value::string(session_id);
+  http_response response = http_client_->request(http::methods::POST,
+      uri::encode_uri(UU("chatmessage/batch")), body_data).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+
+  // Test for getting chat messages with gzip content coding.
+  ostringstream_t buf;
+  buf << "chatmessage" << UU("?chat_room=") << "abc"
+      << UU("&session_id=") << session_id;
+  http::http_request request(http::methods::GET);
+  request.set_request_uri(uri::encode_uri(buf.str()));
+  request.headers().add(http::header_names::accept_encoding, UU("gzip"));
+  response = http_client_->request(request).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  string_t content_encoding;
+  response.headers().match(http::header_names::content_encoding,
+                           content_encoding);
+  EXPECT_EQ(UU("gzip"), content_encoding);
+  // The gzip body has its own entity tag.
+  string_t gzip_entity_tag;
+  EXPECT_EQ(true, response.headers().match(http::header_names::etag,
+                                           gzip_entity_tag));
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  string_t entity_tag;
+  EXPECT_EQ(true, response.headers().match(http::header_names::etag,
+                                           entity_tag));
+  EXPECT_NE(entity_tag, gzip_entity_tag);
+
+  // The client decodes it with request_compressed_response.
+  http::client::http_client_config config;
+  config.set_request_compressed_response(true);
+  http_client compressed_client(http_client_->base_uri(), config);
+  response = compressed_client.request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  EXPECT_GE(response.extract_json().get().as_array().size(),
+            static_cast<size_t>(50));
+}
+
 TEST_F(ChatServerTest, Get_ChatMessage_Fail_Invalid_RoomName) {
   const string_t session_id = PerformSuccessfulLogin();
   // Test for invalid room name
@@ -118,6 +195,372 @@ TEST_F(ChatServerTest, Get_ChatMessage_Fail_Missing_SessionId) {
   EXPECT_EQ(body, UU("Not a valid session ID"));
 }
 
+TEST_F(ChatServerTest, Get_ChatMessage_Success_SinceId) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for getting only the chat messages after a given id.
+  ostringstream_t buf;
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  const json::array chat_messages = response.extract_json().get().as_array();
+  ASSERT_LT(static_cast<size_t>(1), chat_messages.size());
+  // Ids are sequence numbers in the chat room.
+  for (size_t i = 0; i < chat_messages.size(); ++i) {
+    EXPECT_EQ(i + 1, chat_messages.at(i).at(UU("id")).as_number().to_uint64());
+  }
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&since_id=") << chat_messages.size() - 1
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  json::array chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(static_cast<size_t>(1), chat_list.size());
+  EXPECT_EQ(chat_messages.at(chat_messages.size() - 1).serialize(),
+            chat_list.at(0).serialize());
+
+  // The first "limit" chat messages after since_id.
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&since_id=") << 0 << UU("&limit=") << 1
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(static_cast<size_t>(1), chat_list.size());
+  EXPECT_EQ(chat_messages.at(0).serialize(), chat_list.at(0).serialize());
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&since_id=") << "abc" << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&since_id=") << 0 << UU("&limit=") << 0
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+}
+
+TEST_F(ChatServerTest, Get_ChatMessage_Success_Limit) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for getting the latest chat messages with limit alone.
+  ostringstream_t buf;
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  const json::array chat_messages = response.extract_json().get().as_array();
+  ASSERT_LT(static_cast<size_t>(1), chat_messages.size());
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage" << UU("?chat_room=") << "1" << UU("&limit=") << 1
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  // A page of the chat room is not the cached full body.
+  EXPECT_EQ(false, response.headers().has(http::header_names::etag));
+  const json::array chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(static_cast<size_t>(1), chat_list.size());
+  EXPECT_EQ(chat_messages.at(chat_messages.size() - 1).serialize(),
+            chat_list.at(0).serialize());
+}
+
+TEST_F(ChatServerTest, Get_ChatMessage_Success_TimeRange) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for getting only the chat messages in a time range.
+  ostringstream_t buf;
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  const json::array chat_messages = response.extract_json().get().as_array();
+  ASSERT_LT(static_cast<size_t>(1), chat_messages.size());
+  const int64_t from =
+      chat_messages.at(1).at(UU("timestamp")).as_number().to_int64();
+  size_t expected_size = 0;
+  for (const json::value& chat_message : chat_messages) {
+    const int64_t timestamp =
+        chat_message.at(UU("timestamp")).as_number().to_int64();
+    if (timestamp >= from && timestamp < from + 1) {
+      ++expected_size;
+    }
+  }
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&from=") << from << UU("&to=") << from + 1
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  json::array chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(expected_size, chat_list.size());
+  EXPECT_EQ(from, chat_list.at(0).at(UU("timestamp")).as_number().to_int64());
+
+  // An empty time range.
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&from=") << from << UU("&to=") << from
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  EXPECT_EQ(0, response.extract_json().get().as_array().size());
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&to=") << "abc" << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+}
+
+TEST_F(ChatServerTest, Get_Search_Success) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for searching chat messages of every chat room.
+  ostringstream_t buf;
+  buf << "search" << UU("?q=") << "HELLO" << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  json::array chat_list = response.extract_json().get().as_array();
+  EXPECT_EQ(5, chat_list.size());
+
+  // Of one chat room, with a phrase.
+  buf.str(UU(""));
+  buf.clear();
+  buf << "search" << UU("?q=") << "\"nice to meet\"" << UU("&room=") << "1"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(1, chat_list.size());
+  EXPECT_EQ(UU("nice to meet you"),
+            chat_list.at(0).at(UU("message")).as_string());
+
+  // At most limit chat messages.
+  buf.str(UU(""));
+  buf.clear();
+  buf << "search" << UU("?q=") << "hello" << UU("&limit=") << "2"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  EXPECT_EQ(2, response.extract_json().get().as_array().size());
+
+  // The latest ones across the chat rooms, oldest first.
+  buf.str(UU(""));
+  buf.clear();
+  buf << "search" << UU("?q=") << "hello" << UU("&limit=") << "3"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(3, chat_list.size());
+  EXPECT_EQ(UU("hello :)"), chat_list.at(0).at(UU("message")).as_string());
+  EXPECT_EQ(UU("hello!!! hihi"),
+            chat_list.at(1).at(UU("message")).as_string());
+  EXPECT_EQ(UU("hello!!!"), chat_list.at(2).at(UU("message")).as_string());
+}
+
+TEST_F(ChatServerTest, Get_Search_Fail_InvalidQuery) {
+  const string_t session_id = PerformSuccessfulLogin();
+  ostringstream_t buf;
+  buf << "search" << UU("?session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "search" << UU("?q=") << "hello" << UU("&limit=") << "0"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "search" << UU("?q=") << "hello" << UU("&room=") << "zzz"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+}
+
+TEST_F(ChatServerTest, Get_UserChatMessages_Success) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for getting the latest chat messages of a user in every chat room.
+  ostringstream_t buf;
+  buf << "user/messages" << UU("?user_id=") << "kaist"
+      << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  json::array chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(3, chat_list.size());
+  EXPECT_EQ(UU("hello"), chat_list.at(0).at(UU("message")).as_string());
+  EXPECT_EQ(UU("hello~!"), chat_list.at(1).at(UU("message")).as_string());
+  EXPECT_EQ(UU("hello!!! hihi"),
+            chat_list.at(2).at(UU("message")).as_string());
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "user/messages" << UU("?user_id=") << "kaist" << UU("&limit=") << "2"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(2, chat_list.size());
+  EXPECT_EQ(UU("hello~!"), chat_list.at(0).at(UU("message")).as_string());
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "user/messages" << UU("?user_id=") << "nobody"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  EXPECT_EQ(0, response.extract_json().get().as_array().size());
+}
+
+TEST_F(ChatServerTest, Get_UserChatMessages_Fail_NoUserId) {
+  const string_t session_id = PerformSuccessfulLogin();
+  ostringstream_t buf;
+  buf << "user/messages" << UU("?session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+}
+
+TEST_F(ChatServerTest, Get_ChatMessageMulti_Success) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for getting chat messages of several chat rooms at once.
+  size_t expected_size = 0;
+  ostringstream_t buf;
+  http_response response;
+  for (const string_t chat_room : {UU("1"), UU("2")}) {
+    buf.str(UU(""));
+    buf.clear();
+    buf << "chatmessage" << UU("?chat_room=") << chat_room
+        << UU("&session_id=") << session_id;
+    response = http_client_->request(http::methods::GET,
+        uri::encode_uri(buf.str())).get();
+    expected_size += response.extract_json().get().as_array().size();
+  }
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage/multi" << UU("?rooms=") << "1,2"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  json::array chat_list = response.extract_json().get().as_array();
+  EXPECT_EQ(expected_size, chat_list.size());
+
+  // No chat message has a timestamp in the far future.
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage/multi" << UU("?rooms=") << "1,2"
+      << UU("&since=") << "9999999999999999" << UU("&session_id=")
+      << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  chat_list = response.extract_json().get().as_array();
+  EXPECT_EQ(static_cast<size_t>(0), chat_list.size());
+}
+
+TEST_F(ChatServerTest, Get_ChatMessageMulti_Success_SinceId) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for resuming each chat room from its own since_id.
+  ostringstream_t buf;
+  buf << "chatmessage/multi" << UU("?rooms=") << "1:3,2:0"
+      << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  json::array chat_list = response.extract_json().get().as_array();
+  ASSERT_EQ(static_cast<size_t>(2), chat_list.size());
+  EXPECT_EQ(4, chat_list.at(0).at(UU("id")).as_integer());
+  EXPECT_EQ(UU("1"), chat_list.at(0).at(UU("room")).as_string());
+  EXPECT_EQ(1, chat_list.at(1).at(UU("id")).as_integer());
+  EXPECT_EQ(UU("2"), chat_list.at(1).at(UU("room")).as_string());
+
+  // The first chat messages after since_id, or else the latest ones.
+  for (const string_t rooms : {UU("1:0"), UU("1")}) {
+    buf.str(UU(""));
+    buf.clear();
+    buf << "chatmessage/multi" << UU("?rooms=") << rooms
+        << UU("&limit=") << "2" << UU("&session_id=") << session_id;
+    response = http_client_->request(http::methods::GET,
+        uri::encode_uri(buf.str())).get();
+    EXPECT_EQ(response.status_code(), http::status_codes::OK);
+    chat_list = response.extract_json().get().as_array();
+    ASSERT_EQ(static_cast<size_t>(2), chat_list.size());
+    EXPECT_EQ(rooms == UU("1") ? 3 : 1,
+              chat_list.at(0).at(UU("id")).as_integer());
+  }
+}
+
+TEST_F(ChatServerTest, Get_ChatMessageMulti_Fail_Invalid_RoomName) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for an invalid room name in the room list.
+  ostringstream_t buf;
+  buf << "chatmessage/multi" << UU("?rooms=") << "1,invalid_room"
+      << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage/multi" << UU("?rooms=") << "1"
+      << UU("&since=") << "abc" << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage/multi" << UU("?rooms=") << "1:abc"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+
+  // A chat room listed twice is ambiguous.
+  buf.str(UU(""));
+  buf.clear();
+  buf << "chatmessage/multi" << UU("?rooms=") << "1:1,2,1:2"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+}
+
 TEST_F(ChatServerTest, Get_ChatRoom_Success) {
   const string_t session_id = PerformSuccessfulLogin();
   // Test for success to get chat rooms
@@ -160,4 +603,140 @@ TEST_F(ChatServerTest, Get_ChatRoom_Fail_Missing_SessionId) {
       response.content_ready().get().extract_utf16string(true).get();
   EXPECT_EQ(response.status_code(), http::status_codes::Forbidden);
   EXPECT_EQ(body, UU("Not a valid session ID"));
-}
\ No newline at end of file
+}
+
+TEST_F(ChatServerTest, Get_ChatMessage_NotModified_Success) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for revalidating chat messages with the entity tag.
+  ostringstream_t buf;
+  buf << "chatmessage" << UU("?chat_room=") << "1"
+      << UU("&session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  string_t entity_tag;
+  EXPECT_EQ(true, response.headers().match(http::header_names::etag,
+                                           entity_tag));
+
+  http::http_request request(http::methods::GET);
+  request.set_request_uri(uri::encode_uri(buf.str()));
+  request.headers().add(http::header_names::if_none_match, entity_tag);
+  response = http_client_->request(request).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::NotModified);
+  // It has the Vary of the 200 reply.
+  string_t vary;
+  EXPECT_EQ(true, response.headers().match(http::header_names::vary, vary));
+  EXPECT_EQ(UU("Accept, Accept-Encoding"), vary);
+
+  // A new chat message changes the entity tag.
+  value body_data;
+  body_data[UU("chat_message")] = value::string(UU("etag"));
+  body_data[UU("chat_room")] = value::string(UU("1"));
+  body_data[UU("session_id")] = value::string(session_id);
+  response = http_client_->request(http::methods::POST,
+      uri::encode_uri(UU("chatmessage")), body_data).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+
+  request = http::http_request(http::methods::GET);
+  request.set_request_uri(uri::encode_uri(buf.str()));
+  request.headers().add(http::header_names::if_none_match, entity_tag);
+  response = http_client_->request(request).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  string_t new_entity_tag;
+  response.headers().match(http::header_names::etag, new_entity_tag);
+  EXPECT_NE(entity_tag, new_entity_tag);
+}
+
+TEST_F(ChatServerTest, Get_ChatRoom_NotModified_Success) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // Test for revalidating the chat room list with the entity tag.
+  ostringstream_t buf;
+  buf << "chatroom" << UU("?session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  string_t entity_tag;
+  EXPECT_EQ(true, response.headers().match(http::header_names::etag,
+                                           entity_tag));
+
+  http::http_request request(http::methods::GET);
+  request.set_request_uri(uri::encode_uri(buf.str()));
+  request.headers().add(http::header_names::if_none_match,
+                        UU("\"other\", ") + entity_tag);
+  response = http_client_->request(request).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::NotModified);
+
+  request = http::http_request(http::methods::GET);
+  request.set_request_uri(uri::encode_uri(buf.str()));
+  request.headers().add(http::header_names::if_none_match, UU("\"other\""));
+  response = http_client_->request(request).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+}
+
+TEST_F(ChatServerTest, Get_Metrics_Success) {
+  const string_t session_id = PerformSuccessfulLogin();
+  ostringstream_t buf;
+  buf << "chatroom" << UU("?session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+
+  // Metrics need no session ID.
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(UU("metrics"))).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  const string body = response.extract_utf8string().get();
+  EXPECT_NE(string::npos, body.find(
+      "chat_server_request_duration_seconds_count{route=\"GET chatroom\"}"));
+  EXPECT_NE(string::npos, body.find("chat_server_sessions 1\n"));
+  EXPECT_NE(string::npos, body.find("chat_server_chat_rooms 4\n"));
+  EXPECT_NE(string::npos, body.find("chat_server_chat_memory_bytes "));
+}
+
+TEST_F(ChatServerTest, Get_MemoryUsage_Success) {
+  const string_t session_id = PerformSuccessfulLogin();
+  ostringstream_t buf;
+  buf << "metrics/memory" << UU("?session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  const value body = response.extract_json().get();
+  EXPECT_EQ(0, body.at(UU("budget")).as_number().to_uint64());
+  const uint64_t bytes = body.at(UU("bytes")).as_number().to_uint64();
+  EXPECT_LT(0, bytes);
+  uint64_t room_bytes = 0;
+  for (const value& room : body.at(UU("rooms")).as_array()) {
+    room_bytes += room.at(UU("bytes")).as_number().to_uint64();
+  }
+  EXPECT_EQ(bytes, room_bytes);
+  EXPECT_EQ(chatserver::ResponseCache::kDefaultCapacity,
+            body.at(UU("cache_capacity")).as_number().to_uint64());
+  EXPECT_EQ(0, body.at(UU("cache_bytes")).as_number().to_uint64());
+}
+
+TEST_F(ChatServerTest, Get_MemoryUsage_Success_Budget) {
+  const string_t session_id = PerformSuccessfulLogin();
+  // A quarter of the budget goes to the response cache.
+  chat_server_->SetMemoryBudget(4 * 1024 * 1024);
+  ostringstream_t buf;
+  buf << "metrics/memory" << UU("?session_id=") << session_id;
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+  const value body = response.extract_json().get();
+  EXPECT_EQ(3 * 1024 * 1024, body.at(UU("budget")).as_number().to_uint64());
+  EXPECT_EQ(1024 * 1024,
+            body.at(UU("cache_capacity")).as_number().to_uint64());
+  chat_server_->SetMemoryBudget(0);
+}
+
+TEST_F(ChatServerTest, Get_MemoryUsage_Fail_InvalidSession) {
+  // Memory usage names the loaded chat rooms, so it needs a session ID.
+  http_response response = http_client_->request(http::methods::GET,
+      uri::encode_uri(UU("metrics/memory"))).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::Forbidden);
+
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(UU("metrics/memory?session_id=invalid"))).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::Forbidden);
+}
@@ -2,6 +2,7 @@
 // Code style follows Google C++ Style Guide.
 // (https://google.github.io/styleguide/cppguide.html)
 
+#include "cbor_codec.h"
 #include "chat_server.h"
 #include "gtest/gtest.h"
 #include "cpprest/http_client.h"
@@ -387,6 +388,99 @@ TEST_F(ChatServerTest, Post_InputChatMessage_Success) {
   EXPECT_EQ(response.status_code(), http::status_codes::OK);
 }
 
+TEST_F(ChatServerTest, Post_ChatMessageBatch_Success) {
+  string_t session_id = PerformSuccessfulLogin();
+  // Test for success to input several chat messages at once.
+  value item;
+  item[UU("chat_message")] = value::string(UU("batch 1"));
+  item[UU("chat_room")] = value::string(UU("1"));
+  value body_data;
+  body_data[UU("chat_messages")][0] = item;
+  item[UU("chat_message")] = value::string(UU("batch 2"));
+  item[UU("chat_room")] = value::string(UU("2"));
+  body_data[UU("chat_messages")][1] = item;
+  body_data[UU("session_id")] = value::string(session_id);
+  http_response response = http_client_->request(http::methods::POST,
+      uri::encode_uri(UU("chatmessage/batch")), body_data).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+
+  // Both chat messages are stored.
+  ostringstream_t buf;
+  buf << "chatmessage/multi" << UU("?rooms=") << "1,2"
+      << UU("&session_id=") << session_id;
+  response = http_client_->request(http::methods::GET,
+      uri::encode_uri(buf.str())).get();
+  size_t batch_size = 0;
+  for (const value& chat_message :
+       response.extract_json().get().as_array()) {
+    const string_t text = chat_message.at(UU("message")).as_string();
+    if (text == UU("batch 1") || text == UU("batch 2")) {
+      ++batch_size;
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(2), batch_size);
+}
+
+TEST_F(ChatServerTest, Post_InputChatMessage_Success_Cbor) {
+  string_t session_id = PerformSuccessfulLogin();
+  // Test for success to input a chat message in the CBOR wire format.
+  value body_data;
+  body_data[UU("chat_message")] = value::string(UU("cbor"));
+  body_data[UU("chat_room")] = value::string(UU("1"));
+  body_data[UU("session_id")] = value::string(session_id);
+  http::http_request request(http::methods::POST);
+  request.set_request_uri(uri::encode_uri(UU("chatmessage")));
+  request.set_body(CborCodec::EncodeJson(body_data));
+  request.headers().set_content_type(CborCodec::kMediaType);
+  http_response response = http_client_->request(request).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::OK);
+
+  // Malformed CBOR body data.
+  request = http::http_request(http::methods::POST);
+  request.set_request_uri(uri::encode_uri(UU("chatmessage")));
+  request.set_body(vector<unsigned char>{0x63, 'a'});
+  request.headers().set_content_type(CborCodec::kMediaType);
+  response = http_client_->request(request).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+}
+
+TEST_F(ChatServerTest, Post_ChatMessageBatch_Fail_MissingField) {
+  string_t session_id = PerformSuccessfulLogin();
+  // Test for failure when a chat message has no chat room.
+  value item;
+  item[UU("chat_message")] = value::string(UU("batch"));
+  value body_data;
+  body_data[UU("chat_messages")][0] = item;
+  body_data[UU("session_id")] = value::string(session_id);
+  http_response response = http_client_->request(http::methods::POST,
+      uri::encode_uri(UU("chatmessage/batch")), body_data).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+
+  body_data[UU("chat_messages")] = value::array();
+  response = http_client_->request(http::methods::POST,
+      uri::encode_uri(UU("chatmessage/batch")), body_data).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+}
+
+TEST_F(ChatServerTest, Post_ChatMessageBatch_Fail_UnknownChatRoom) {
+  string_t session_id = PerformSuccessfulLogin();
+  // Test that nothing is stored if a chat room was never created.
+  value body_data;
+  body_data[UU("chat_messages")][0][UU("chat_room")] = value::string(UU("1"));
+  body_data[UU("chat_messages")][0][UU("chat_message")] =
+      value::string(UU("batch"));
+  body_data[UU("chat_messages")][1][UU("chat_room")] =
+      value::string(UU("987"));
+  body_data[UU("chat_messages")][1][UU("chat_message")] =
+      value::string(UU("batch"));
+  body_data[UU("session_id")] = value::string(session_id);
+  http_response response = http_client_->request(http::methods::POST,
+      uri::encode_uri(UU("chatmessage/batch")), body_data).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+  EXPECT_EQ(UU("There are no chat rooms: 987"),
+            response.extract_string().get());
+}
+
 TEST_F(ChatServerTest, Post_InputChatMessage_Success_Whitespace) {
   string_t session_id = PerformSuccessfulLogin();
   // Test for success to input a chat message with whitespace.
@@ -443,6 +537,20 @@ TEST_F(ChatServerTest, Post_InputChatMessage_Fail_NoChatRoom) {
   EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
 }
 
+TEST_F(ChatServerTest, Post_InputChatMessage_Fail_UnknownChatRoom) {
+  string_t session_id = PerformSuccessfulLogin();
+  // Test for a chat room that was never created.
+  value body_data;
+  body_data[UU("chat_message")] = value::string(UU("good day~!"));
+  body_data[UU("chat_room")] = value::string(UU("987"));
+  body_data[UU("session_id")] = value::string(session_id);
+  http_response response = http_client_->request(http::methods::POST,
+      uri::encode_uri(UU("chatmessage")), body_data).get();
+  EXPECT_EQ(response.status_code(), http::status_codes::BadRequest);
+  EXPECT_EQ(UU("There are no chat rooms: 987"),
+            response.extract_string().get());
+}
+
 TEST_F(ChatServerTest, Post_InputChatMessage_Fail_NoSessionId) {
   string_t session_id = PerformSuccessfulLogin();
   // Test for missing session id.
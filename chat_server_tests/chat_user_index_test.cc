@@ -0,0 +1,108 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "chat_user_index.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace {
+
+  // Append a chat message of the given user to the log.
+  void AppendChatMessage(ChatRoomLog* chat_room_log,
+                         const ChatString& chat_room,
+                         const ChatString& user_id) {
+    chat_room_log->Append(ChatMessage(1583581783, user_id, chat_room,
+                                      CHATSERVER_TEXT("hihi")));
+  }
+
+} // namespace
+
+TEST(ChatUserIndex, GetLatestIds_Success) {
+  const auto chunk_pool = make_shared<ChatMessageChunkPool>();
+  ChatRoomLog first_chat_room_log(chunk_pool);
+  ChatRoomLog second_chat_room_log(chunk_pool);
+  const ChatString first_chat_room = CHATSERVER_TEXT("a");
+  const ChatString second_chat_room = CHATSERVER_TEXT("b");
+  for (const ChatString user_id : {CHATSERVER_TEXT("kaist"),
+                                   CHATSERVER_TEXT("kaist"),
+                                   CHATSERVER_TEXT("wsp"),
+                                   CHATSERVER_TEXT("kaist")}) {
+    AppendChatMessage(&first_chat_room_log, first_chat_room, user_id);
+  }
+  AppendChatMessage(&second_chat_room_log, second_chat_room,
+                    CHATSERVER_TEXT("kaist"));
+
+  ChatUserIndex user_index;
+  user_index.IndexChatRoom(first_chat_room,
+                           *first_chat_room_log.GetSnapshot());
+  user_index.IndexChatRoom(second_chat_room,
+                           *second_chat_room_log.GetSnapshot());
+
+  EXPECT_EQ(vector<ChatString>({first_chat_room, second_chat_room}),
+            user_index.GetChatRooms(CHATSERVER_TEXT("kaist")));
+  vector<uint64_t> ids;
+  ASSERT_EQ(true, user_index.GetLatestIds(CHATSERVER_TEXT("kaist"),
+                                          first_chat_room, 10, &ids));
+  EXPECT_EQ(vector<uint64_t>({1, 2, 4}), ids);
+  ASSERT_EQ(true, user_index.GetLatestIds(CHATSERVER_TEXT("kaist"),
+                                          second_chat_room, 10, &ids));
+  EXPECT_EQ(vector<uint64_t>({1}), ids);
+
+  // The latest limit ids of the chat room.
+  ASSERT_EQ(true, user_index.GetLatestIds(CHATSERVER_TEXT("kaist"),
+                                          first_chat_room, 2, &ids));
+  EXPECT_EQ(vector<uint64_t>({2, 4}), ids);
+
+  EXPECT_EQ(true, user_index.GetChatRooms(CHATSERVER_TEXT("gsis")).empty());
+  ids.clear();
+  ASSERT_EQ(true, user_index.GetLatestIds(CHATSERVER_TEXT("gsis"),
+                                          first_chat_room, 10, &ids));
+  EXPECT_EQ(true, ids.empty());
+}
+
+TEST(ChatUserIndex, IndexChatRoom_Success_Incremental) {
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  const ChatString chat_room = CHATSERVER_TEXT("a");
+  ChatUserIndex user_index;
+  AppendChatMessage(&chat_room_log, chat_room, CHATSERVER_TEXT("wsp"));
+  user_index.IndexChatRoom(chat_room, *chat_room_log.GetSnapshot());
+  AppendChatMessage(&chat_room_log, chat_room, CHATSERVER_TEXT("wsp"));
+  user_index.IndexChatRoom(chat_room, *chat_room_log.GetSnapshot());
+  // Indexing the same snapshot again adds nothing.
+  user_index.IndexChatRoom(chat_room, *chat_room_log.GetSnapshot());
+
+  vector<uint64_t> ids;
+  ASSERT_EQ(true, user_index.GetLatestIds(CHATSERVER_TEXT("wsp"), chat_room,
+                                          10, &ids));
+  EXPECT_EQ(vector<uint64_t>({1, 2}), ids);
+}
+
+TEST(ChatUserIndex, AddChatRoom_Success_NotIndexed) {
+  // A chat room that is not loaded is known, but has no ids yet.
+  ChatUserIndex user_index;
+  const ChatString chat_room = CHATSERVER_TEXT("a");
+  EXPECT_EQ(false, user_index.HasChatRoom(CHATSERVER_TEXT("wsp"), chat_room));
+  EXPECT_EQ(true, user_index.AddChatRoom(CHATSERVER_TEXT("wsp"), chat_room));
+  EXPECT_EQ(false, user_index.AddChatRoom(CHATSERVER_TEXT("wsp"), chat_room));
+  EXPECT_EQ(true, user_index.HasChatRoom(CHATSERVER_TEXT("wsp"), chat_room));
+  EXPECT_EQ(vector<ChatString>({chat_room}),
+            user_index.GetChatRooms(CHATSERVER_TEXT("wsp")));
+  vector<uint64_t> ids;
+  EXPECT_EQ(false, user_index.GetLatestIds(CHATSERVER_TEXT("wsp"), chat_room,
+                                           10, &ids));
+
+  // Indexing the chat room doesn't add it twice.
+  ChatRoomLog chat_room_log(make_shared<ChatMessageChunkPool>());
+  AppendChatMessage(&chat_room_log, chat_room, CHATSERVER_TEXT("wsp"));
+  user_index.IndexChatRoom(chat_room, *chat_room_log.GetSnapshot());
+  EXPECT_EQ(1, user_index.GetChatRooms(CHATSERVER_TEXT("wsp")).size());
+  EXPECT_EQ(true, user_index.GetLatestIds(CHATSERVER_TEXT("wsp"), chat_room,
+                                          10, &ids));
+  EXPECT_EQ(vector<uint64_t>({1}), ids);
+}
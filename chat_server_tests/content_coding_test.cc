@@ -0,0 +1,68 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "gtest/gtest.h"
+#include "content_coding.h"
+#include "cpprest/http_msg.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+namespace compression = ::web::http::compression;
+
+TEST(ContentCoding, Select_Success) {
+  if (!compression::builtin::supported()) {
+    EXPECT_EQ(UU(""), ContentCoding::Select(UU("gzip")));
+    return;
+  }
+  EXPECT_EQ(UU("gzip"), ContentCoding::Select(UU("gzip, deflate")));
+  EXPECT_EQ(UU("gzip"), ContentCoding::Select(UU("deflate, GZIP")));
+  EXPECT_EQ(UU("deflate"), ContentCoding::Select(UU("deflate")));
+  EXPECT_EQ(UU("deflate"),
+            ContentCoding::Select(UU("gzip;q=0.5, deflate;q=0.8")));
+  EXPECT_EQ(UU("gzip"), ContentCoding::Select(UU("*")));
+  // "*" does not override an explicit refusal, in either order.
+  EXPECT_EQ(UU("deflate"), ContentCoding::Select(UU("gzip;q=0, *")));
+  EXPECT_EQ(UU("deflate"), ContentCoding::Select(UU("*, gzip;q=0")));
+}
+
+TEST(ContentCoding, Select_Fail_NotAcceptable) {
+  EXPECT_EQ(UU(""), ContentCoding::Select(UU("")));
+  EXPECT_EQ(UU(""), ContentCoding::Select(UU("identity")));
+  EXPECT_EQ(UU(""), ContentCoding::Select(UU("br")));
+  EXPECT_EQ(UU(""), ContentCoding::Select(UU("gzip;q=0, deflate;q=0")));
+  EXPECT_EQ(UU(""), ContentCoding::Select(UU("gzip;q=0, deflate;q=0, *")));
+  EXPECT_EQ(UU(""), ContentCoding::Select(UU("*;q=0")));
+}
+
+TEST(ContentCoding, Compress_Success_RoundTrip) {
+  if (!compression::builtin::supported()) {
+    return;
+  }
+  const string text(10000, 'a');
+  const vector<unsigned char> input(text.begin(), text.end());
+  for (const string_t content_coding : {UU("gzip"), UU("deflate")}) {
+    vector<unsigned char> output;
+    EXPECT_EQ(true, ContentCoding::Compress(content_coding, input, &output));
+    EXPECT_LT(output.size(), input.size());
+
+    // Decompress with cpprestsdk to check the output.
+    auto decompressor = compression::builtin::make_decompressor(content_coding);
+    vector<unsigned char> decompressed(input.size() + 1);
+    size_t input_bytes_processed = 0;
+    bool is_done = false;
+    const size_t decompressed_size = decompressor->decompress(
+        output.data(), output.size(), decompressed.data(),
+        decompressed.size(), compression::operation_hint::is_last,
+        input_bytes_processed, is_done);
+    decompressed.resize(decompressed_size);
+    EXPECT_EQ(input, decompressed);
+  }
+}
+
+TEST(ContentCoding, Compress_Fail_Unsupported) {
+  vector<unsigned char> output;
+  EXPECT_EQ(false, ContentCoding::Compress(UU("identity"), {'a'}, &output));
+  EXPECT_EQ(false, ContentCoding::Compress(UU("gzip"), {'a'}, nullptr));
+}
@@ -0,0 +1,98 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <algorithm>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "delimiter_scanner.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+
+namespace {
+
+  // Check Find and FindEither with the delimiter at every position of every
+  // length up to 100, which covers the vector loops and their tails.
+  template <typename Char>
+  void CheckEveryPosition(Char filler, Char a, Char b) {
+    for (size_t length = 0; length <= 100; ++length) {
+      basic_string<Char> text(length, filler);
+      const Char* begin = text.data();
+      const Char* end = begin + length;
+      ASSERT_EQ(end, DelimiterScanner::Find(begin, end, a));
+      ASSERT_EQ(end, DelimiterScanner::FindEither(begin, end, a, b));
+      for (size_t position = 0; position < length; ++position) {
+        text[position] = a;
+        ASSERT_EQ(begin + position, DelimiterScanner::Find(begin, end, a));
+        text[position] = b;
+        ASSERT_EQ(end, DelimiterScanner::Find(begin, end, a));
+        ASSERT_EQ(begin + position,
+                  DelimiterScanner::FindEither(begin, end, a, b));
+        // The first one is found if there are more.
+        if (position + 1 < length) {
+          text[length - 1] = a;
+          ASSERT_EQ(begin + position,
+                    DelimiterScanner::FindEither(begin, end, a, b));
+          text[length - 1] = filler;
+        }
+        text[position] = filler;
+      }
+    }
+  }
+
+} // namespace
+
+TEST(DelimiterScanner, Find_Success_Narrow) {
+  CheckEveryPosition<char>('a', '|', ',');
+  // Bytes of multibyte text must not match the delimiter.
+  CheckEveryPosition<char>('\xEA', '\n', '\r');
+}
+
+TEST(DelimiterScanner, Find_Success_Wide) {
+  CheckEveryPosition<wchar_t>(L'a', L'|', L',');
+  // Only the whole character must match. 0x7C7C has '|' in both bytes.
+  CheckEveryPosition<wchar_t>(static_cast<wchar_t>(0x7C7C), L'|', L',');
+}
+
+TEST(DelimiterScanner, Find_Success_Sse2) {
+  // The SSE2 path is checked on AVX2 CPUs as well.
+  DelimiterScanner::SetAvx2DisabledForTesting(true);
+  EXPECT_NE(string("avx2"), DelimiterScanner::GetInstructionSet());
+  CheckEveryPosition<char>('a', '|', ',');
+  CheckEveryPosition<char>('\xEA', '\n', '\r');
+  CheckEveryPosition<wchar_t>(L'a', L'|', L',');
+  CheckEveryPosition<wchar_t>(static_cast<wchar_t>(0x7C7C), L'|', L',');
+  DelimiterScanner::SetAvx2DisabledForTesting(false);
+}
+
+TEST(DelimiterScanner, Find_Success_Unaligned) {
+  const string text = string(200, 'a') + "|";
+  for (size_t offset = 0; offset < 64; ++offset) {
+    EXPECT_EQ(text.data() + 200,
+              DelimiterScanner::Find(text.data() + offset,
+                                     text.data() + text.size(), '|'));
+  }
+}
+
+TEST(DelimiterScanner, Contains_Success) {
+  EXPECT_EQ(true, DelimiterScanner::Contains(CHATSERVER_TEXT("hello|world"),
+                                             '|'));
+  EXPECT_EQ(false, DelimiterScanner::Contains(CHATSERVER_TEXT("hello world"),
+                                              '|'));
+  EXPECT_EQ(false, DelimiterScanner::Contains(CHATSERVER_TEXT(""), '|'));
+  EXPECT_EQ(true, DelimiterScanner::ContainsEither(CHATSERVER_TEXT("kaist,"),
+                                                   ',', '|'));
+  EXPECT_EQ(true, DelimiterScanner::ContainsEither(CHATSERVER_TEXT("|kaist"),
+                                                   ',', '|'));
+  EXPECT_EQ(false, DelimiterScanner::ContainsEither(CHATSERVER_TEXT("kaist"),
+                                                    ',', '|'));
+}
+
+TEST(DelimiterScanner, GetInstructionSet_Success) {
+  const string instruction_set = DelimiterScanner::GetInstructionSet();
+  EXPECT_EQ(true, instruction_set == "avx2" || instruction_set == "sse2" ||
+                  instruction_set == "scalar");
+}
@@ -0,0 +1,55 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <mutex>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "instrumented_mutex.h"
+
+using namespace std;
+using namespace chatserver;
+
+TEST(LockProfiler, GetProfile_Success_SameName) {
+  LockProfile* profile = LockProfiler::GetProfile("LockProfilerTest::a");
+  ASSERT_NE(nullptr, profile);
+  EXPECT_EQ("LockProfilerTest::a", profile->name);
+  EXPECT_EQ(profile, LockProfiler::GetProfile("LockProfilerTest::a"));
+  EXPECT_NE(profile, LockProfiler::GetProfile("LockProfilerTest::b"));
+
+  bool is_found = false;
+  for (const LockProfile* listed_profile : LockProfiler::GetProfiles()) {
+    is_found = is_found || listed_profile == profile;
+  }
+  EXPECT_EQ(true, is_found);
+}
+
+TEST(InstrumentedMutex, Lock_Success) {
+  InstrumentedMutex mutex_test("InstrumentedMutexTest::mutex_test");
+  int counter = 0;
+  thread other_thread([&]() {
+    for (int i = 0; i < 1000; ++i) {
+      const lock_guard<InstrumentedMutex> lock(mutex_test);
+      ++counter;
+    }
+  });
+  for (int i = 0; i < 1000; ++i) {
+    const lock_guard<InstrumentedMutex> lock(mutex_test);
+    ++counter;
+  }
+  other_thread.join();
+  EXPECT_EQ(2000, counter);
+
+  EXPECT_EQ(true, mutex_test.try_lock());
+  mutex_test.unlock();
+
+#if defined(CHATSERVER_ENABLE_LOCK_PROFILING)
+  const LockProfile* profile =
+      LockProfiler::GetProfile("InstrumentedMutexTest::mutex_test");
+  EXPECT_EQ(static_cast<uint64_t>(2001), profile->hold_time.GetCount());
+  EXPECT_EQ(static_cast<uint64_t>(2001), profile->wait_time.GetCount());
+  EXPECT_GE(static_cast<uint64_t>(2001),
+            profile->contention_count.load());
+#endif
+}
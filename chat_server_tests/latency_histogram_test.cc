@@ -0,0 +1,60 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "gtest/gtest.h"
+#include "latency_histogram.h"
+
+using namespace std;
+using namespace chatserver;
+
+TEST(LatencyHistogram, GetBucketIndex_Success_BoundsContainValue) {
+  const uint64_t values[] = {0, 1, 7, 8, 15, 16, 17, 1000, 123456789,
+                             UINT64_MAX};
+  for (const uint64_t value : values) {
+    const size_t index = LatencyHistogram::GetBucketIndex(value);
+    EXPECT_LT(index, LatencyHistogram::kBucketCount);
+    EXPECT_LE(LatencyHistogram::GetBucketLowerBound(index), value);
+    EXPECT_GE(LatencyHistogram::GetBucketUpperBound(index), value);
+  }
+  // Small values are exact.
+  EXPECT_EQ(static_cast<size_t>(15), LatencyHistogram::GetBucketIndex(15));
+}
+
+TEST(LatencyHistogram, Record_Success_CountAndSum) {
+  LatencyHistogram histogram;
+  histogram.Record(100);
+  histogram.Record(200);
+  histogram.Record(300);
+  EXPECT_EQ(static_cast<uint64_t>(3), histogram.GetCount());
+  EXPECT_EQ(static_cast<uint64_t>(600), histogram.GetSum());
+
+  histogram.Reset();
+  EXPECT_EQ(static_cast<uint64_t>(0), histogram.GetCount());
+  EXPECT_EQ(static_cast<uint64_t>(0), histogram.GetSum());
+}
+
+TEST(LatencyHistogram, GetPercentile_Success_WithinRelativeError) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(static_cast<uint64_t>(0), histogram.GetPercentile(0.5));
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    histogram.Record(i * 1000);
+  }
+  const uint64_t p50 = histogram.GetPercentile(0.5);
+  EXPECT_GE(p50, static_cast<uint64_t>(500000));
+  EXPECT_LE(p50, static_cast<uint64_t>(500000 * 9 / 8));
+  const uint64_t p99 = histogram.GetPercentile(0.99);
+  EXPECT_GE(p99, static_cast<uint64_t>(990000));
+  EXPECT_LE(p99, static_cast<uint64_t>(990000 * 9 / 8));
+  EXPECT_GE(histogram.GetPercentile(1.0), static_cast<uint64_t>(1000000));
+}
+
+TEST(LatencyHistogram, GetCountAtOrBelow_Success) {
+  LatencyHistogram histogram;
+  histogram.Record(5);
+  histogram.Record(1000);
+  histogram.Record(1000000);
+  EXPECT_EQ(static_cast<uint64_t>(1), histogram.GetCountAtOrBelow(5));
+  EXPECT_EQ(static_cast<uint64_t>(2), histogram.GetCountAtOrBelow(2000));
+  EXPECT_EQ(static_cast<uint64_t>(3), histogram.GetCountAtOrBelow(UINT64_MAX));
+}
@@ -0,0 +1,41 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "gtest/gtest.h"
+#include "load_generator.h"
+
+using namespace std;
+using ::chatserverloadgen::LoadGenerator;
+
+TEST(LoadGenerator, ParseOperationMix_Success) {
+  double weights[LoadGenerator::kOperationSize] = {};
+  ASSERT_EQ(true, LoadGenerator::ParseOperationMix("poll:60,post:30.5",
+                                                   weights));
+  // Operations that are not given get the weight 0.
+  EXPECT_EQ(0.0, weights[static_cast<size_t>(
+                     LoadGenerator::Operation::kSignUp)]);
+  EXPECT_EQ(0.0, weights[static_cast<size_t>(
+                     LoadGenerator::Operation::kLogin)]);
+  EXPECT_EQ(60.0, weights[static_cast<size_t>(
+                      LoadGenerator::Operation::kPoll)]);
+  EXPECT_EQ(30.5, weights[static_cast<size_t>(
+                      LoadGenerator::Operation::kPost)]);
+  EXPECT_EQ(0.0, weights[static_cast<size_t>(
+                     LoadGenerator::Operation::kCreateChatRoom)]);
+}
+
+TEST(LoadGenerator, ParseOperationMix_Fail) {
+  // The weights are kept on failure.
+  double weights[LoadGenerator::kOperationSize] = {1.0, 2.0, 3.0, 4.0, 5.0};
+  EXPECT_EQ(false, LoadGenerator::ParseOperationMix("poll:60,vote:1",
+                                                    weights));
+  EXPECT_EQ(false, LoadGenerator::ParseOperationMix("poll:0,post:0",
+                                                    weights));
+  EXPECT_EQ(false, LoadGenerator::ParseOperationMix("poll:abc", weights));
+  EXPECT_EQ(false, LoadGenerator::ParseOperationMix("poll:-1", weights));
+  EXPECT_EQ(false, LoadGenerator::ParseOperationMix("poll", weights));
+  EXPECT_EQ(false, LoadGenerator::ParseOperationMix("", weights));
+  EXPECT_EQ(3.0, weights[static_cast<size_t>(
+                     LoadGenerator::Operation::kPoll)]);
+}
@@ -0,0 +1,49 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "metrics_registry.h"
+
+using namespace std;
+using namespace chatserver;
+
+TEST(MetricsRegistry, ExportPrometheusText_Success) {
+  MetricsRegistry metrics;
+  metrics.GetRouteLatency(Route::kGetChatRoom)->Record(30000);
+  metrics.GetRouteLatency(Route::kGetChatRoom)->Record(2000000);
+  metrics.AddResponseBytes(100);
+  metrics.AddResponseBytes(23);
+  EXPECT_EQ(static_cast<uint64_t>(123), metrics.GetResponseBytes());
+
+  MetricsRegistry::Gauges gauges;
+  gauges.session_count = 2;
+  gauges.chat_room_count = 4;
+  gauges.chat_message_count = 10;
+  gauges.chat_memory_bytes = 2048;
+  const string text = metrics.ExportPrometheusText(gauges);
+
+  EXPECT_NE(string::npos, text.find(
+      "# TYPE chat_server_request_duration_seconds histogram\n"));
+  EXPECT_NE(string::npos, text.find(
+      "chat_server_request_duration_seconds_bucket"
+      "{route=\"GET chatroom\",le=\"0.00005\"} 1\n"));
+  EXPECT_NE(string::npos, text.find(
+      "chat_server_request_duration_seconds_bucket"
+      "{route=\"GET chatroom\",le=\"+Inf\"} 2\n"));
+  EXPECT_NE(string::npos, text.find(
+      "chat_server_request_duration_seconds_count"
+      "{route=\"GET chatroom\"} 2\n"));
+  EXPECT_NE(string::npos, text.find(
+      "chat_server_request_duration_seconds_count"
+      "{route=\"POST login\"} 0\n"));
+  EXPECT_EQ(string::npos, text.find("not found"));
+  EXPECT_NE(string::npos, text.find("chat_server_response_bytes_total 123\n"));
+  EXPECT_NE(string::npos, text.find("chat_server_sessions 2\n"));
+  EXPECT_NE(string::npos, text.find("chat_server_chat_rooms 4\n"));
+  EXPECT_NE(string::npos, text.find("chat_server_chat_messages 10\n"));
+  EXPECT_NE(string::npos,
+            text.find("chat_server_chat_memory_bytes 2048\n"));
+}
@@ -0,0 +1,76 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mpsc_queue.h"
+
+using namespace std;
+using namespace chatserver;
+
+TEST(MpscQueue, Pop_Fail_Empty) {
+  MpscQueue<int> queue;
+  int value = 0;
+  EXPECT_EQ(true, queue.IsEmpty());
+  EXPECT_EQ(false, queue.Pop(&value));
+}
+
+TEST(MpscQueue, Pop_Success_InOrder) {
+  MpscQueue<int> queue;
+  for (int i = 0; i < 10; ++i) {
+    queue.Push(i);
+  }
+  EXPECT_EQ(false, queue.IsEmpty());
+  int value = -1;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(true, queue.Pop(&value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_EQ(false, queue.Pop(&value));
+}
+
+TEST(MpscQueue, Push_Success_MoveOnly) {
+  MpscQueue<unique_ptr<int>> queue;
+  queue.Push(make_unique<int>(7));
+  // Values left in the queue are deleted with it.
+  queue.Push(make_unique<int>(8));
+  unique_ptr<int> value;
+  ASSERT_EQ(true, queue.Pop(&value));
+  EXPECT_EQ(7, *value);
+}
+
+TEST(MpscQueue, Push_Success_ManyProducers) {
+  MpscQueue<int> queue;
+  const int kProducerCount = 4;
+  const int kPushCount = 20000;
+  vector<thread> producers;
+  for (int producer = 0; producer < kProducerCount; ++producer) {
+    producers.emplace_back([&queue, producer]() {
+      for (int i = 0; i < kPushCount; ++i) {
+        queue.Push(producer * kPushCount + i);
+      }
+    });
+  }
+
+  // Every value arrives once, in push order for each producer.
+  vector<int> next_values(kProducerCount);
+  int pop_count = 0;
+  int value = 0;
+  while (pop_count < kProducerCount * kPushCount) {
+    if (!queue.Pop(&value)) {
+      continue;
+    }
+    const int producer = value / kPushCount;
+    ASSERT_EQ(next_values[producer], value % kPushCount);
+    ++next_values[producer];
+    ++pop_count;
+  }
+  for (thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(false, queue.Pop(&value));
+}
@@ -0,0 +1,164 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "chat_message_loader.h"
+#include "partitioned_chat_log.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+
+// Fixture class for partitioned_chat_log.h testing.
+class PartitionedChatLogTest : public ::testing::Test {
+ protected:
+  const string_t kChatLogDirectory = UU("partitioned_chat_log");
+
+  void SetUp() override {
+    filesystem::remove_all(kChatLogDirectory);
+  }
+
+  void TearDown() override {
+    filesystem::remove_all(kChatLogDirectory);
+  }
+
+  // Append a chat message of the given chat room with the given id.
+  static bool AppendChatMessage(PartitionedChatLog::Partition* partition,
+                                const ChatString& chat_room,
+                                uint64_t id) {
+    ChatOutputStringStream lines;
+    ChatMessageLoader::FormatLine(
+        ChatMessage(1583581783, CHATSERVER_TEXT("kaist"), chat_room,
+                    CHATSERVER_TEXT("hihi")),
+        id, &lines);
+    const lock_guard<InstrumentedMutex> lock(partition->mutex_append);
+    return PartitionedChatLog::AppendLines(*partition, lines.str());
+  }
+};
+
+TEST_F(PartitionedChatLogTest, Open_Success_Created) {
+  EXPECT_EQ(false, PartitionedChatLog::Exists(kChatLogDirectory));
+  PartitionedChatLog partitioned_log;
+  EXPECT_EQ(true, partitioned_log.Open(kChatLogDirectory));
+  EXPECT_EQ(true, PartitionedChatLog::Exists(kChatLogDirectory));
+  EXPECT_EQ(true, partitioned_log.GetChatRooms().empty());
+}
+
+TEST_F(PartitionedChatLogTest, LoadChatRoom_Success_Reopened) {
+  const ChatString first_chat_room = CHATSERVER_TEXT("a");
+  const ChatString second_chat_room = CHATSERVER_TEXT("b c");
+  {
+    PartitionedChatLog partitioned_log;
+    ASSERT_EQ(true, partitioned_log.Open(kChatLogDirectory));
+    PartitionedChatLog::Partition* const first_partition =
+        partitioned_log.GetPartition(first_chat_room);
+    PartitionedChatLog::Partition* const second_partition =
+        partitioned_log.GetPartition(second_chat_room);
+    ASSERT_NE(nullptr, first_partition);
+    ASSERT_NE(nullptr, second_partition);
+    EXPECT_NE(first_partition->file, second_partition->file);
+    EXPECT_EQ(first_partition, partitioned_log.GetPartition(first_chat_room));
+    EXPECT_EQ(true, AppendChatMessage(first_partition, first_chat_room, 1));
+    EXPECT_EQ(true, AppendChatMessage(first_partition, first_chat_room, 2));
+  }
+
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(kChatLogDirectory));
+  EXPECT_EQ(vector<ChatString>({first_chat_room, second_chat_room}),
+            partitioned_log.GetChatRooms());
+  vector<ChatMessage> chat_messages;
+  EXPECT_EQ(true, partitioned_log.LoadChatRoom(first_chat_room,
+                                               &chat_messages));
+  EXPECT_EQ(2, chat_messages.size());
+
+  // A partition without a log file, or no partition, has no chat messages.
+  chat_messages.clear();
+  EXPECT_EQ(true, partitioned_log.LoadChatRoom(second_chat_room,
+                                               &chat_messages));
+  EXPECT_EQ(true, partitioned_log.LoadChatRoom(CHATSERVER_TEXT("d"),
+                                               &chat_messages));
+  EXPECT_EQ(true, chat_messages.empty());
+}
+
+TEST_F(PartitionedChatLogTest, GetLogFileSize_Success) {
+  const ChatString chat_room = CHATSERVER_TEXT("a");
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(kChatLogDirectory));
+  EXPECT_EQ(0, partitioned_log.GetLogFileSize(chat_room));
+  PartitionedChatLog::Partition* const partition =
+      partitioned_log.GetPartition(chat_room);
+  ASSERT_NE(nullptr, partition);
+  EXPECT_EQ(0, partitioned_log.GetLogFileSize(chat_room));
+  EXPECT_EQ(true, AppendChatMessage(partition, chat_room, 1));
+  EXPECT_EQ(filesystem::file_size(partition->file),
+            partitioned_log.GetLogFileSize(chat_room));
+  EXPECT_LT(0, partitioned_log.GetLogFileSize(chat_room));
+}
+
+TEST_F(PartitionedChatLogTest, LoadChatRoom_Fail_OtherChatRoom) {
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(kChatLogDirectory));
+  PartitionedChatLog::Partition* const partition =
+      partitioned_log.GetPartition(CHATSERVER_TEXT("a"));
+  ASSERT_NE(nullptr, partition);
+  EXPECT_EQ(true, AppendChatMessage(partition, CHATSERVER_TEXT("b"), 1));
+  vector<ChatMessage> chat_messages;
+  EXPECT_EQ(false, partitioned_log.LoadChatRoom(CHATSERVER_TEXT("a"),
+                                                &chat_messages));
+}
+
+TEST_F(PartitionedChatLogTest, LoadUserChatRooms_Success) {
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(kChatLogDirectory));
+  vector<PartitionedChatLog::UserChatRoom> user_chat_rooms;
+  EXPECT_EQ(false, partitioned_log.LoadUserChatRooms(&user_chat_rooms));
+
+  EXPECT_EQ(true, partitioned_log.AppendUserChatRooms(
+                      {{CHATSERVER_TEXT("kaist"), CHATSERVER_TEXT("a")}}));
+  EXPECT_EQ(true, partitioned_log.AppendUserChatRooms(
+                      {{CHATSERVER_TEXT("wsp"), CHATSERVER_TEXT("b c")}}));
+  ASSERT_EQ(true, partitioned_log.LoadUserChatRooms(&user_chat_rooms));
+  ASSERT_EQ(2, user_chat_rooms.size());
+  EXPECT_EQ(CHATSERVER_TEXT("kaist"), user_chat_rooms[0].user_id);
+  EXPECT_EQ(CHATSERVER_TEXT("a"), user_chat_rooms[0].chat_room);
+  EXPECT_EQ(CHATSERVER_TEXT("wsp"), user_chat_rooms[1].user_id);
+  EXPECT_EQ(CHATSERVER_TEXT("b c"), user_chat_rooms[1].chat_room);
+
+  // Rewritten, the file has the given chat rooms only.
+  EXPECT_EQ(true, partitioned_log.RewriteUserChatRooms(
+                      {{CHATSERVER_TEXT("gsis"), CHATSERVER_TEXT("a")}}));
+  user_chat_rooms.clear();
+  ASSERT_EQ(true, partitioned_log.LoadUserChatRooms(&user_chat_rooms));
+  ASSERT_EQ(1, user_chat_rooms.size());
+  EXPECT_EQ(CHATSERVER_TEXT("gsis"), user_chat_rooms[0].user_id);
+}
+
+TEST_F(PartitionedChatLogTest, Convert_Success) {
+  const string_t chat_message_file = UU("partitioned_chat_messages.txt");
+  ChatOutputFileStream file(chat_message_file, ChatOutputFileStream::trunc);
+  file << CHATSERVER_TEXT("1583581783|kaist|a|hihi") << endl;
+  file << CHATSERVER_TEXT("1583581785|kaist|b|hello world") << endl;
+  file << CHATSERVER_TEXT("1583581784|wsp|a|hello") << endl;
+  file.close();
+
+  ASSERT_EQ(true, PartitionedChatLog::Convert(chat_message_file,
+                                              kChatLogDirectory));
+  PartitionedChatLog partitioned_log;
+  ASSERT_EQ(true, partitioned_log.Open(kChatLogDirectory));
+  vector<ChatMessage> chat_messages;
+  ASSERT_EQ(true, partitioned_log.LoadChatRoom(CHATSERVER_TEXT("a"),
+                                               &chat_messages));
+  ASSERT_EQ(2, chat_messages.size());
+  EXPECT_EQ(CHATSERVER_TEXT("hello"), chat_messages[1].chat_message);
+  EXPECT_EQ(1583581784000000, chat_messages[1].timestamp);
+
+  // A directory with partitions is not overwritten.
+  EXPECT_EQ(false, PartitionedChatLog::Convert(chat_message_file,
+                                               kChatLogDirectory));
+  filesystem::remove(chat_message_file);
+}
@@ -0,0 +1,40 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <chrono>
+
+#include "gtest/gtest.h"
+#include "rate_limited_log.h"
+
+using namespace std;
+using namespace chatserver;
+
+TEST(RateLimitedLog, ShouldLog_Success_Burst) {
+  RateLimitedLog rate_limited_log(2, chrono::hours(1), 0);
+  uint64_t suppressed_count = 100;
+  EXPECT_EQ(true, rate_limited_log.ShouldLog(&suppressed_count));
+  EXPECT_EQ(static_cast<uint64_t>(0), suppressed_count);
+  EXPECT_EQ(true, rate_limited_log.ShouldLog(&suppressed_count));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(false, rate_limited_log.ShouldLog(&suppressed_count));
+  }
+}
+
+TEST(RateLimitedLog, ShouldLog_Success_Sampling) {
+  RateLimitedLog rate_limited_log(1, chrono::hours(1), 3);
+  uint64_t suppressed_count = 0;
+  EXPECT_EQ(true, rate_limited_log.ShouldLog(&suppressed_count));
+  EXPECT_EQ(false, rate_limited_log.ShouldLog(&suppressed_count));
+  EXPECT_EQ(false, rate_limited_log.ShouldLog(&suppressed_count));
+  EXPECT_EQ(true, rate_limited_log.ShouldLog(&suppressed_count));
+  EXPECT_EQ(static_cast<uint64_t>(2), suppressed_count);
+}
+
+TEST(RateLimitedLog, ShouldLog_Success_NewInterval) {
+  RateLimitedLog rate_limited_log(1, chrono::milliseconds(0), 0);
+  uint64_t suppressed_count = 0;
+  // Every message starts a new interval.
+  EXPECT_EQ(true, rate_limited_log.ShouldLog(&suppressed_count));
+  EXPECT_EQ(true, rate_limited_log.ShouldLog(&suppressed_count));
+}
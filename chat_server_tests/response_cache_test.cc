@@ -0,0 +1,119 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "gtest/gtest.h"
+#include "cpprest/http_msg.h"
+#include "response_cache.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+
+TEST(ResponseCache, GetBody_Success_SerializeOncePerVersion) {
+  ResponseCache response_cache;
+  int serialize_count = 0;
+  const auto serialize = [&]() {
+    ++serialize_count;
+    return vector<unsigned char>(serialize_count, 'a');
+  };
+
+  ResponseCache::Body body =
+      response_cache.GetBody(UU("a"), false, 1, serialize);
+  EXPECT_EQ(1, serialize_count);
+  EXPECT_EQ(body, response_cache.GetBody(UU("a"), false, 1, serialize));
+  EXPECT_EQ(1, serialize_count);
+
+  // Another version, room, or wire format is serialized again.
+  response_cache.GetBody(UU("a"), false, 2, serialize);
+  EXPECT_EQ(2, serialize_count);
+  response_cache.GetBody(UU("b"), false, 2, serialize);
+  EXPECT_EQ(3, serialize_count);
+  response_cache.GetBody(UU("a"), true, 2, serialize);
+  EXPECT_EQ(4, serialize_count);
+  response_cache.GetBody(UU("a"), false, 2, serialize);
+  EXPECT_EQ(4, serialize_count);
+}
+
+TEST(ResponseCache, Erase_Success) {
+  ResponseCache response_cache;
+  int serialize_count = 0;
+  const auto serialize = [&]() {
+    ++serialize_count;
+    return vector<unsigned char>(1, 'a');
+  };
+  response_cache.GetBody(UU("a"), false, 1, serialize);
+  response_cache.GetBody(UU("a"), true, 1, serialize);
+  response_cache.GetBody(UU("b"), false, 1, serialize);
+
+  // Both wire formats of the chat room are serialized again.
+  response_cache.Erase(UU("a"));
+  response_cache.GetBody(UU("a"), false, 1, serialize);
+  response_cache.GetBody(UU("a"), true, 1, serialize);
+  EXPECT_EQ(5, serialize_count);
+  response_cache.GetBody(UU("b"), false, 1, serialize);
+  EXPECT_EQ(5, serialize_count);
+
+  response_cache.Erase(UU("a"));
+  EXPECT_EQ(1, response_cache.GetMemoryUsage());
+}
+
+TEST(ResponseCache, GetBody_Success_LeastRecentlyUsedDropped) {
+  ResponseCache response_cache;
+  response_cache.SetCapacity(20);
+  int serialize_count = 0;
+  const auto serialize = [&]() {
+    ++serialize_count;
+    return vector<unsigned char>(8, 'a');
+  };
+  response_cache.GetBody(UU("a"), false, 1, serialize);
+  response_cache.GetBody(UU("b"), false, 1, serialize);
+  EXPECT_EQ(16, response_cache.GetMemoryUsage());
+
+  // a is used after b, so b is dropped for c.
+  response_cache.GetBody(UU("a"), false, 1, serialize);
+  response_cache.GetBody(UU("c"), false, 1, serialize);
+  EXPECT_EQ(3, serialize_count);
+  EXPECT_EQ(16, response_cache.GetMemoryUsage());
+  response_cache.GetBody(UU("a"), false, 1, serialize);
+  EXPECT_EQ(3, serialize_count);
+  response_cache.GetBody(UU("b"), false, 1, serialize);
+  EXPECT_EQ(4, serialize_count);
+
+  // A body larger than the capacity is returned without being cached.
+  EXPECT_EQ(21, response_cache.GetBody(UU("d"), false, 1, []() {
+    return vector<unsigned char>(21, 'a');
+  })->size());
+  EXPECT_EQ(0, response_cache.GetMemoryUsage());
+
+  response_cache.GetBody(UU("a"), false, 1, serialize);
+  response_cache.SetCapacity(0);
+  EXPECT_EQ(0, response_cache.GetMemoryUsage());
+}
+
+TEST(ResponseCache, GetCompressedBody_Success_CompressOncePerVersion) {
+  if (!web::http::compression::builtin::supported()) {
+    return;
+  }
+  ResponseCache response_cache;
+  const ResponseCache::Body body = response_cache.GetBody(
+      UU("a"), false, 1,
+      []() { return vector<unsigned char>(4096, 'a'); });
+
+  const ResponseCache::Body compressed_body =
+      response_cache.GetCompressedBody(UU("a"), false, 1, UU("gzip"), body);
+  ASSERT_NE(nullptr, compressed_body);
+  EXPECT_LT(compressed_body->size(), body->size());
+  EXPECT_EQ(compressed_body, response_cache.GetCompressedBody(
+      UU("a"), false, 1, UU("gzip"), body));
+  EXPECT_NE(compressed_body, response_cache.GetCompressedBody(
+      UU("a"), false, 1, UU("deflate"), body));
+}
+
+TEST(ResponseCache, GetCompressedBody_Fail_Unsupported) {
+  ResponseCache response_cache;
+  const ResponseCache::Body body = response_cache.GetBody(
+      UU("a"), false, 1, []() { return vector<unsigned char>(10, 'a'); });
+  EXPECT_EQ(nullptr, response_cache.GetCompressedBody(
+      UU("a"), false, 1, UU("identity"), body));
+}
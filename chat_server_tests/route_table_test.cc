@@ -0,0 +1,75 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include "gtest/gtest.h"
+#include "route_table.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+
+TEST(RouteTable, Resolve_Success) {
+  EXPECT_EQ(Route::kGetChatMessage,
+            RouteTable::Resolve(UU("GET"), UU("/chatmessage")));
+  EXPECT_EQ(Route::kGetChatRoom,
+            RouteTable::Resolve(UU("GET"), UU("/chatroom")));
+  EXPECT_EQ(Route::kPostSignUp,
+            RouteTable::Resolve(UU("POST"), UU("/account")));
+  EXPECT_EQ(Route::kPostLogin,
+            RouteTable::Resolve(UU("POST"), UU("/login")));
+  EXPECT_EQ(Route::kPostChatMessage,
+            RouteTable::Resolve(UU("POST"), UU("/chatmessage")));
+  EXPECT_EQ(Route::kPostChatRoom,
+            RouteTable::Resolve(UU("POST"), UU("/chatroom")));
+  EXPECT_EQ(Route::kDeleteSession,
+            RouteTable::Resolve(UU("DELETE"), UU("/session")));
+  EXPECT_EQ(Route::kPostChatMessageBatch,
+            RouteTable::Resolve(UU("POST"), UU("/chatmessage/batch")));
+  EXPECT_EQ(Route::kGetChatMessageMulti,
+            RouteTable::Resolve(UU("GET"), UU("/chatmessage/multi")));
+  EXPECT_EQ(Route::kGetSearch,
+            RouteTable::Resolve(UU("GET"), UU("/search")));
+  EXPECT_EQ(Route::kGetUserChatMessages,
+            RouteTable::Resolve(UU("GET"), UU("/user/messages")));
+  EXPECT_EQ(Route::kGetMetrics,
+            RouteTable::Resolve(UU("GET"), UU("/metrics")));
+  EXPECT_EQ(Route::kGetMemoryUsage,
+            RouteTable::Resolve(UU("GET"), UU("/metrics/memory")));
+}
+
+TEST(RouteTable, Resolve_Success_Slashes) {
+  // Leading and trailing slashes are ignored.
+  EXPECT_EQ(Route::kGetChatRoom,
+            RouteTable::Resolve(UU("GET"), UU("chatroom")));
+  EXPECT_EQ(Route::kGetChatRoom,
+            RouteTable::Resolve(UU("GET"), UU("//chatroom/")));
+}
+
+TEST(RouteTable, Resolve_Success_FirstSegment) {
+  // Unknown sub paths are resolved by the first segment.
+  EXPECT_EQ(Route::kGetChatRoom,
+            RouteTable::Resolve(UU("GET"), UU("/chatroom/abc")));
+}
+
+TEST(RouteTable, Resolve_Success_EncodedPath) {
+  EXPECT_EQ(Route::kGetChatRoom,
+            RouteTable::Resolve(UU("GET"), UU("/%63hatroom")));
+}
+
+TEST(RouteTable, Resolve_Fail_EmptyPath) {
+  EXPECT_EQ(Route::kNotFound, RouteTable::Resolve(UU("GET"), UU("")));
+  EXPECT_EQ(Route::kNotFound, RouteTable::Resolve(UU("POST"), UU("/")));
+  EXPECT_EQ(Route::kNotFound, RouteTable::Resolve(UU("DELETE"), UU("//")));
+}
+
+TEST(RouteTable, Resolve_Fail_UnknownRoute) {
+  EXPECT_EQ(Route::kNotFound,
+            RouteTable::Resolve(UU("GET"), UU("/chatmessages")));
+  EXPECT_EQ(Route::kNotFound,
+            RouteTable::Resolve(UU("GET"), UU("/account")));
+  EXPECT_EQ(Route::kNotFound,
+            RouteTable::Resolve(UU("PUT"), UU("/chatroom")));
+  EXPECT_EQ(Route::kNotFound,
+            RouteTable::Resolve(UU("GE"), UU("/chatroom")));
+}
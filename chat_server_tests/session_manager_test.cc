@@ -23,9 +23,9 @@ class SessionManagerTest : public ::testing::Test {
   Session gsis_session;
 
   void SetUp() override {
-    kaist_session = session_manager_.CreateSession(UU("kaist"));
-    wsp_session = session_manager_.CreateSession(UU("wsp"));
-    gsis_session = session_manager_.CreateSession(UU("gsis"));
+    kaist_session = session_manager_.CreateSession(CHATSERVER_TEXT("kaist"));
+    wsp_session = session_manager_.CreateSession(CHATSERVER_TEXT("wsp"));
+    gsis_session = session_manager_.CreateSession(CHATSERVER_TEXT("gsis"));
   }
 };
 
@@ -38,12 +38,13 @@ TEST_F(SessionManagerTest, IsExistSessionId_Success) {
 
 TEST_F(SessionManagerTest, IsExistSessionId_Fail) {
   // Check given id is not exist in the server session.
-  EXPECT_EQ(false, session_manager_.IsExistSessionId(UU("ABCDEFG")));
+  EXPECT_EQ(false,
+            session_manager_.IsExistSessionId(CHATSERVER_TEXT("ABCDEFG")));
 }
 
 TEST_F(SessionManagerTest, CreateSession_Success) {
-  const Session session = session_manager_.CreateSession(UU("n5"));
-  const string_t empty = UU("");
+  const Session session = session_manager_.CreateSession(CHATSERVER_TEXT("n5"));
+  const ChatString empty = CHATSERVER_TEXT("");
 
   // Check created session.
   EXPECT_STRNE(session.session_id.c_str(), empty.c_str());
@@ -51,17 +52,12 @@ TEST_F(SessionManagerTest, CreateSession_Success) {
   EXPECT_NE(session.last_activity_time, 0);
 
   // Re-create existing sessions.
-  string_t session_id = kaist_session.session_id;
-  EXPECT_STREQ(session_id.c_str(),
-               session_manager_.CreateSession(UU("kaist")).session_id.c_str());
-
-  session_id = wsp_session.session_id;
-  EXPECT_STREQ(session_id.c_str(),
-               session_manager_.CreateSession(UU("wsp")).session_id.c_str());
-
-  session_id = gsis_session.session_id;
-  EXPECT_STREQ(session_id.c_str(),
-               session_manager_.CreateSession(UU("gsis")).session_id.c_str());
+  EXPECT_EQ(kaist_session.session_id,
+            session_manager_.CreateSession(kaist_session.user_id).session_id);
+  EXPECT_EQ(wsp_session.session_id,
+            session_manager_.CreateSession(wsp_session.user_id).session_id);
+  EXPECT_EQ(gsis_session.session_id,
+            session_manager_.CreateSession(gsis_session.user_id).session_id);
 }
 
 TEST_F(SessionManagerTest, DeleteSession_Success_And_Fail) {
@@ -77,7 +73,8 @@ TEST_F(SessionManagerTest, DeleteSession_Success_And_Fail) {
 TEST_F(SessionManagerTest, DeleteSession_Fail_NoSessionExist) {
   // Delete the session that does not exist.
   EXPECT_EQ(
-      false, session_manager_.DeleteSession(UU("ABC123890jfiuw1``78fsd9j823r98")));
+      false, session_manager_.DeleteSession(
+          CHATSERVER_TEXT("ABC123890jfiuw1``78fsd9j823r98")));
 }
 
 TEST_F(SessionManagerTest, RenewLastAcitvityTime_Success) {
@@ -93,11 +90,12 @@ TEST_F(SessionManagerTest, RenewLastAcitvityTime_Success) {
 TEST_F(SessionManagerTest, RenewLastAcitvityTime_Fail) {
   // Renew nonexistent sessions.
   EXPECT_EQ(
-      false, session_manager_.DeleteSession(UU("ABC123890jfiuw1278fsd9j823r98")));
+      false, session_manager_.DeleteSession(
+          CHATSERVER_TEXT("ABC123890jfiuw1278fsd9j823r98")));
 }
 
 TEST_F(SessionManagerTest, GetAccountIdFromSessionId_Success) {
-  string_t session_id;
+  ChatString session_id;
   // Get a user ID from a session ID.
   // Check the ID is correct.
   EXPECT_EQ(
@@ -142,9 +140,9 @@ TEST_F(SessionManagerTest, RunSessionExpireThread) {
 // even if a large number of session IDs are generated
 // Create 10,000 session IDs and check if they have the same ID
 TEST_F(SessionManagerTest, GenerateSessionID) {
-  set<string_t> session_id_set;
+  set<ChatString> session_id_set;
   for (auto i = 0; i < 1000; i++) {
-    Session session = session_manager_.CreateSession(to_wstring(i));
+    Session session = session_manager_.CreateSession(FromUtf8(to_string(i)));
     EXPECT_EQ(true,
               session_id_set.find(session.session_id) == session_id_set.end());
     session_id_set.insert(session.session_id);
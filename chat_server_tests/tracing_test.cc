@@ -0,0 +1,85 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "tracing.h"
+
+using namespace std;
+using namespace chatserver;
+
+namespace {
+
+  string ReadFile(const string& file_name) {
+    ifstream file(file_name);
+    stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+  }
+
+} // namespace
+
+TEST(Tracing, Start_Success_WriteSampledSpans) {
+  const string trace_file = "tracing_test_trace.json";
+  ASSERT_EQ(true, Tracing::Start(trace_file, 1.0));
+  EXPECT_EQ(false, Tracing::Start(trace_file, 1.0));
+  {
+    const TraceRequest trace_request("TracingTest::Request");
+    EXPECT_EQ(true, Tracing::IsSampled());
+    const TraceSpan trace_span("TracingTest::Span");
+  }
+  EXPECT_EQ(false, Tracing::IsSampled());
+  Tracing::Stop();
+
+  const string trace = ReadFile(trace_file);
+  EXPECT_EQ('[', trace.front());
+  EXPECT_NE(string::npos, trace.rfind("]\n"));
+  EXPECT_NE(string::npos, trace.find("\"name\":\"TracingTest::Request\""));
+  EXPECT_NE(string::npos, trace.find("\"name\":\"TracingTest::Span\""));
+  EXPECT_NE(string::npos, trace.find("\"ph\":\"X\""));
+}
+
+TEST(Tracing, Start_Success_NoSample) {
+  const string trace_file = "tracing_test_trace.json";
+  ASSERT_EQ(true, Tracing::Start(trace_file, 0.0));
+  {
+    const TraceRequest trace_request("TracingTest::Request");
+    EXPECT_EQ(false, Tracing::IsSampled());
+    const TraceSpan trace_span("TracingTest::Span");
+  }
+  Tracing::Stop();
+  EXPECT_EQ(string::npos, ReadFile(trace_file).find("TracingTest::Span"));
+}
+
+TEST(Tracing, Span_Success_WithoutStart) {
+  // A span outside of a sampled request records nothing.
+  const TraceRequest trace_request("TracingTest::Request");
+  const TraceSpan trace_span("TracingTest::Span");
+  EXPECT_EQ(false, Tracing::IsSampled());
+}
+
+TEST(Tracing, ContinuedRequest_Success_SampledElsewhere) {
+  const string trace_file = "tracing_test_trace.json";
+  // The sampling of a continued request was decided by the earlier request.
+  ASSERT_EQ(true, Tracing::Start(trace_file, 0.0));
+  {
+    const TraceRequest trace_request("TracingTest::Batch", true);
+    EXPECT_EQ(true, Tracing::IsSampled());
+    const TraceSpan trace_span("TracingTest::Span");
+  }
+  EXPECT_EQ(false, Tracing::IsSampled());
+  {
+    const TraceRequest trace_request("TracingTest::Skipped", false);
+    const TraceSpan trace_span("TracingTest::SkippedSpan");
+  }
+  Tracing::Stop();
+
+  const string trace = ReadFile(trace_file);
+  EXPECT_NE(string::npos, trace.find("\"name\":\"TracingTest::Batch\""));
+  EXPECT_NE(string::npos, trace.find("\"name\":\"TracingTest::Span\""));
+  EXPECT_EQ(string::npos, trace.find("TracingTest::Skipped"));
+}
@@ -0,0 +1,87 @@
+// Code review content development project.
+// Code style follows Google C++ Style Guide.
+// (https://google.github.io/styleguide/cppguide.html)
+
+#include <memory_resource>
+
+#include "gtest/gtest.h"
+#include "url_query.h"
+
+using namespace std;
+using namespace utility;
+using namespace chatserver;
+
+TEST(UrlQuery, Find_Success) {
+  const UrlQuery url_query(UU("chat_room=abc&session_id=123"));
+  string_t value;
+  EXPECT_EQ(true, url_query.Find(UU("chat_room"), &value));
+  EXPECT_EQ(UU("abc"), value);
+  EXPECT_EQ(true, url_query.Find(UU("session_id"), &value));
+  EXPECT_EQ(UU("123"), value);
+}
+
+TEST(UrlQuery, Find_Success_Decode) {
+  const UrlQuery url_query(UU("chat_room=hello%20world"));
+  string_t value;
+  EXPECT_EQ(true, url_query.Find(UU("chat_room"), &value));
+  EXPECT_EQ(UU("hello world"), value);
+}
+
+TEST(UrlQuery, Find_Success_DuplicateKey) {
+  // The last value is used.
+  const UrlQuery url_query(UU("chat_room=a&chat_room=b"));
+  string_t value;
+  EXPECT_EQ(true, url_query.Find(UU("chat_room"), &value));
+  EXPECT_EQ(UU("b"), value);
+}
+
+TEST(UrlQuery, Find_Success_ManyParameters) {
+  // Parameters past the reserved ones are kept.
+  const UrlQuery url_query(
+      UU("a=1&b=2&c=3&d=4&e=5&f=6&g=7&h=8&session_id=123"));
+  string_t value;
+  EXPECT_EQ(true, url_query.Find(UU("a"), &value));
+  EXPECT_EQ(UU("1"), value);
+  EXPECT_EQ(true, url_query.Find(UU("session_id"), &value));
+  EXPECT_EQ(UU("123"), value);
+}
+
+TEST(UrlQuery, FindView_Success) {
+  const UrlQuery url_query(UU("chat_room=abc&session_id=123"));
+  UrlQuery::StringView value;
+  EXPECT_EQ(true, url_query.FindView(UU("session_id"), &value));
+  EXPECT_EQ(UU("123"), value);
+  EXPECT_EQ(false, url_query.FindView(UU("user_id"), &value));
+}
+
+TEST(UrlQuery, FindView_Success_InArena) {
+  // The arena has no upstream, so any allocation past the buffer throws.
+  alignas(max_align_t) unsigned char buffer[2048];
+  pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+                                       pmr::null_memory_resource());
+  const UrlQuery url_query(
+      UU("chat_room=hello%20world&session_id=abcdefghijklmnopqrstuvwxyz"),
+      &arena);
+  UrlQuery::StringView value;
+  EXPECT_EQ(true, url_query.FindView(UU("chat_room"), &value));
+  EXPECT_EQ(UU("hello world"), value);
+  EXPECT_EQ(true, url_query.FindView(UU("session_id"), &value));
+  EXPECT_EQ(UU("abcdefghijklmnopqrstuvwxyz"), value);
+}
+
+TEST(UrlQuery, Find_Fail) {
+  const UrlQuery url_query(UU("chat_room&session_id=123"));
+  string_t value;
+  // A pair without '=' is ignored.
+  EXPECT_EQ(false, url_query.Find(UU("chat_room"), &value));
+  EXPECT_EQ(false, url_query.Find(UU("user_id"), &value));
+  EXPECT_EQ(false, url_query.Find(UU("session_id"), nullptr));
+}
+
+TEST(UrlQuery, Contains) {
+  const UrlQuery empty_query(UU(""));
+  EXPECT_EQ(false, empty_query.Contains(UU("session_id")));
+
+  const UrlQuery url_query(UU("session_id="));
+  EXPECT_EQ(true, url_query.Contains(UU("session_id")));
+}